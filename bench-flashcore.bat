@@ -0,0 +1,22 @@
+@echo off
+REM Benchmark script for FlashCore (run build-flashcore.bat first for the native library)
+
+echo ========================================
+echo Benchmarking FlashCore
+echo ========================================
+
+if not exist benchmarks mkdir benchmarks
+
+REM Timestamped results so runs can be compared for regressions
+for /f %%i in ('python -c "import time; print(time.strftime('%%Y%%m%%d-%%H%%M%%S'))"') do set STAMP=%%i
+
+python bench-flashcore.py --json benchmarks\flashcore-%STAMP%.json --trace benchmarks\flashcore-%STAMP%.trace.json %*
+if %ERRORLEVEL% NEQ 0 (
+    echo ERROR: Benchmark failed
+    exit /b 1
+)
+
+echo.
+echo Results: benchmarks\flashcore-%STAMP%.json
+echo Trace:   benchmarks\flashcore-%STAMP%.trace.json (open in chrome://tracing or ui.perfetto.dev)
+echo.
@@ -0,0 +1,345 @@
+#!/usr/bin/env python3
+"""
+Benchmark script for FlashCore vector search, inference and encryption
+"""
+
+import io
+import sys
+import os
+import json
+import time
+import platform
+import argparse
+import threading
+import numpy as np
+
+# Add the FlashCore bindings and the FlashFlow package to the path
+sys.path.append(os.path.join(os.path.dirname(__file__), 'flashcore', 'bindings', 'python'))
+sys.path.append(os.path.dirname(os.path.abspath(__file__)))
+
+from flashflow_cli.services.vector_index import VectorIndex
+
+# Index methods the vector suites call
+INDEX_METHODS = ("add_vectors", "search_batch", "memory_usage")
+
+def get_index_class():
+    """Return the native HNSWIndex if it has the batch API the suites use, else the NumPy VectorIndex"""
+    try:
+        import flashcore
+    except ImportError:
+        print("FlashCore not available, using flashflow_cli VectorIndex")
+        return VectorIndex
+
+    missing = [name for name in INDEX_METHODS if not hasattr(flashcore.HNSWIndex, name)]
+    if missing:
+        print(f"flashcore.HNSWIndex has no {', '.join(missing)}, using flashflow_cli VectorIndex")
+        return VectorIndex
+    print("Using native flashcore.HNSWIndex")
+    return flashcore.HNSWIndex
+
+def bench_insert_scaling(index_class, dim, count, batch_size, max_threads):
+    """Measure insert throughput with 1..max_threads concurrent writers"""
+    vectors = np.random.rand(count, dim).astype(np.float32)
+    ids = np.arange(count, dtype=np.int64)
+    results = []
+
+    thread_counts = sorted({1, *[t for t in (2, 4, 8, 16, 32) if t < max_threads], max_threads})
+    for num_threads in thread_counts:
+        index = index_class(dim, count)
+        batches = [(start, min(start + batch_size, count)) for start in range(0, count, batch_size)]
+
+        def writer(worker):
+            for start, end in batches[worker::num_threads]:
+                index.add_vectors(vectors[start:end], ids[start:end])
+
+        threads = [threading.Thread(target=writer, args=(worker,)) for worker in range(num_threads)]
+        started = time.perf_counter()
+        for thread in threads:
+            thread.start()
+        for thread in threads:
+            thread.join()
+        elapsed = time.perf_counter() - started
+
+        throughput = count / elapsed if elapsed > 0 else float("inf")
+        speedup = throughput / results[0]["throughput"] if results else 1.0
+        results.append({"threads": num_threads, "seconds": elapsed, "throughput": throughput})
+        print(f"  {num_threads:3d} threads: {throughput:12.0f} inserts/s  ({speedup:.2f}x)")
+
+    return results
+
+def recall_at_k(labels, truth):
+    """Fraction of the true k nearest neighbours found, averaged over queries"""
+    hits = sum(len(set(found) & set(expected)) for found, expected in zip(labels.tolist(), truth.tolist()))
+    return hits / truth.size
+
+def bench_quantization_recall(index_class, dim, count, num_queries, k):
+    """Measure memory use and recall@k for each vector storage configuration"""
+    vectors = np.random.rand(count, dim).astype(np.float32)
+    ids = np.arange(count, dtype=np.int64)
+    queries = np.random.rand(num_queries, dim).astype(np.float32)
+
+    exact = index_class(dim, count)
+    exact.add_vectors(vectors, ids)
+    truth, _ = exact.search_batch(queries, k)
+
+    configs = [
+        ("float32", {}),
+        ("sq8", {"quantization": "sq8"}),
+        ("sq8 + rerank", {"quantization": "sq8", "rerank": 4 * k}),
+        ("pq", {"quantization": "pq", "pq_subvectors": dim // 8}),
+        ("pq + rerank", {"quantization": "pq", "pq_subvectors": dim // 8, "rerank": 10 * k}),
+    ]
+
+    results = []
+    for name, options in configs:
+        index = index_class(dim, count, **options)
+        index.add_vectors(vectors, ids)
+
+        started = time.perf_counter()
+        labels, _ = index.search_batch(queries, k)
+        elapsed = time.perf_counter() - started
+
+        recall = recall_at_k(labels, truth)
+        bytes_per_vector = index.memory_usage() / count
+        results.append({"config": name, "recall": recall, "bytes_per_vector": bytes_per_vector, "seconds": elapsed})
+        print(f"  {name:14s} recall@{k}={recall:.3f}  {bytes_per_vector:8.1f} bytes/vector  {num_queries / elapsed:10.0f} queries/s")
+
+    return results
+
+def brute_force_knn(vectors, queries, k, chunk=256):
+    """Exact L2 nearest neighbours by matrix product, a chunk of queries at a time"""
+    sq_norms = np.einsum("ij,ij->i", vectors, vectors)
+    truth = np.empty((len(queries), k), dtype=np.int64)
+    for start in range(0, len(queries), chunk):
+        block = queries[start:start + chunk]
+        distances = sq_norms[None, :] - 2.0 * (block @ vectors.T)
+        nearest = np.argpartition(distances, k - 1, axis=1)[:, :k]
+        order = np.take_along_axis(distances, nearest, axis=1).argsort(axis=1)
+        truth[start:start + chunk] = np.take_along_axis(nearest, order, axis=1)
+    return truth
+
+def latency_stats(samples):
+    """p50/p99/mean of per-call latencies in milliseconds"""
+    ordered = np.sort(np.asarray(samples)) * 1000
+    return {
+        "p50_ms": float(np.percentile(ordered, 50)),
+        "p99_ms": float(np.percentile(ordered, 99)),
+        "mean_ms": float(ordered.mean()),
+    }
+
+def repeat(fn, min_seconds, min_runs=5):
+    """Per-call durations of fn, run until both min_runs and min_seconds are reached"""
+    samples = []
+    started = time.perf_counter()
+    while len(samples) < min_runs or time.perf_counter() - started < min_seconds:
+        call_started = time.perf_counter()
+        fn()
+        samples.append(time.perf_counter() - call_started)
+    return samples
+
+def bench_hnsw(index_class, dim, sizes, num_queries, k, batch_size, min_seconds):
+    """Build time, query latency/throughput and recall@k at each index size"""
+    results = []
+    for count in sizes:
+        vectors = np.random.rand(count, dim).astype(np.float32)
+        ids = np.arange(count, dtype=np.int64)
+        queries = np.random.rand(num_queries, dim).astype(np.float32)
+        truth = brute_force_knn(vectors, queries, k)
+
+        index = index_class(dim, count)
+        started = time.perf_counter()
+        for start in range(0, count, batch_size):
+            index.add_vectors(vectors[start:start + batch_size], ids[start:start + batch_size])
+        build_seconds = time.perf_counter() - started
+
+        labels, _ = index.search_batch(queries, k)
+        recall = recall_at_k(labels, truth)
+
+        samples = repeat(lambda: index.search_batch(queries, k), min_seconds, min_runs=3)
+        single = repeat(lambda: index.search_batch(queries[:1], k), min_seconds / 4, min_runs=20)
+        result = {
+            "count": count,
+            "build_seconds": build_seconds,
+            "build_throughput": count / build_seconds if build_seconds > 0 else float("inf"),
+            f"recall@{k}": recall,
+            "batch_queries_per_second": num_queries * len(samples) / sum(samples),
+            "single_query": latency_stats(single),
+            "bytes_per_vector": index.memory_usage() / count,
+        }
+        results.append(result)
+        print(f"  {count:9d} vectors: build {result['build_throughput']:10.0f} vectors/s  recall@{k}={recall:.3f}  "
+              f"{result['batch_queries_per_second']:10.0f} queries/s batched  "
+              f"p50 {result['single_query']['p50_ms']:.3f} ms single")
+    return results
+
+def tiny_onnx_model(path, dim, out_dim=16):
+    """Write a one-MatMul ONNX model with a dynamic batch axis; None if the onnx package is missing"""
+    try:
+        import onnx
+        from onnx import helper, numpy_helper, TensorProto
+    except ImportError:
+        return None
+
+    weights = numpy_helper.from_array(np.random.rand(dim, out_dim).astype(np.float32), name="weights")
+    graph = helper.make_graph(
+        [helper.make_node("MatMul", ["input", "weights"], ["output"])], "flashflow_bench",
+        [helper.make_tensor_value_info("input", TensorProto.FLOAT, ["batch", dim])],
+        [helper.make_tensor_value_info("output", TensorProto.FLOAT, ["batch", out_dim])],
+        initializer=[weights])
+    onnx.save(helper.make_model(graph), path)
+    return path
+
+def bench_onnx(model_path, dim, output_size, batch_sizes, min_seconds):
+    """Latency and rows/s of ModelSession.run at each batch size"""
+    from flashflow_cli.services.inference_runtime import ModelSession
+
+    session = ModelSession(model_path, output_size=output_size)
+    name = session.input_names[0]
+    results = []
+    for batch in batch_sizes:
+        inputs = {name: np.random.rand(batch, dim).astype(np.float32)}
+        session.run(inputs)  # Warm up allocations for this shape
+        samples = repeat(lambda: session.run(inputs), min_seconds)
+        result = {"batch_size": batch, **latency_stats(samples), "rows_per_second": batch * len(samples) / sum(samples)}
+        results.append(result)
+        print(f"  batch {batch:5d}: p50 {result['p50_ms']:8.3f} ms  p99 {result['p99_ms']:8.3f} ms  "
+              f"{result['rows_per_second']:12.0f} rows/s")
+    return results
+
+def bench_vault(buffer_sizes, stream_bytes, min_seconds):
+    """AES-256-GCM MB/s for one-shot encrypt/decrypt at each buffer size, and for streams chunked at it"""
+    from flashflow_cli.services.crypto_vault import AESVault
+
+    vault = AESVault(AESVault.generate_key())
+    payload = os.urandom(stream_bytes)
+    results = []
+    for size in buffer_sizes:
+        plaintext = payload[:size] if size <= len(payload) else os.urandom(size)
+        ciphertext = vault.encrypt(plaintext)
+        encrypt = repeat(lambda: vault.encrypt(plaintext), min_seconds)
+        decrypt = repeat(lambda: vault.decrypt(ciphertext), min_seconds)
+
+        sealed = io.BytesIO()
+        vault.encrypt_stream(io.BytesIO(payload), sealed, chunk_size=size)
+        stream_encrypt = repeat(lambda: vault.encrypt_stream(io.BytesIO(payload), io.BytesIO(), chunk_size=size),
+                                min_seconds, min_runs=2)
+        stream_decrypt = repeat(lambda: vault.decrypt_stream(io.BytesIO(sealed.getvalue()), io.BytesIO(), chunk_size=size),
+                                min_seconds, min_runs=2)
+
+        megabytes = size / (1 << 20)
+        stream_megabytes = stream_bytes / (1 << 20)
+        result = {
+            "buffer_bytes": size,
+            "encrypt_mb_per_second": megabytes * len(encrypt) / sum(encrypt),
+            "decrypt_mb_per_second": megabytes * len(decrypt) / sum(decrypt),
+            "encrypt_p50_us": float(np.percentile(encrypt, 50) * 1e6),
+            "stream_encrypt_mb_per_second": stream_megabytes * len(stream_encrypt) / sum(stream_encrypt),
+            "stream_decrypt_mb_per_second": stream_megabytes * len(stream_decrypt) / sum(stream_decrypt),
+        }
+        results.append(result)
+        print(f"  {size:9d} bytes: encrypt {result['encrypt_mb_per_second']:9.1f} MB/s  "
+              f"decrypt {result['decrypt_mb_per_second']:9.1f} MB/s  "
+              f"stream {result['stream_encrypt_mb_per_second']:9.1f} / {result['stream_decrypt_mb_per_second']:9.1f} MB/s")
+    return results
+
+def environment(index_class):
+    """Machine and build details stored with each JSON result set"""
+    return {
+        "timestamp": time.strftime("%Y-%m-%dT%H:%M:%S%z"),
+        "python": platform.python_version(),
+        "platform": platform.platform(),
+        "machine": platform.machine(),
+        "cpu_count": os.cpu_count(),
+        "numpy": np.__version__,
+        "index": f"{index_class.__module__}.{index_class.__name__}",
+    }
+
+def int_list(value):
+    return [int(item) for item in value.split(",") if item]
+
+SUITES = ("insert", "quantization", "hnsw", "onnx", "vault")
+
+def main():
+    """Main benchmark function"""
+    parser = argparse.ArgumentParser(description="Benchmark FlashCore vector search, inference and encryption")
+    parser.add_argument("--suite", action="append", choices=SUITES, help="Suite to run (repeatable, default: all)")
+    parser.add_argument("--dim", type=int, default=128, help="Vector dimension")
+    parser.add_argument("--count", type=int, default=100000, help="Vectors inserted per run")
+    parser.add_argument("--batch-size", type=int, default=1000, help="Rows per add_vectors call")
+    parser.add_argument("--max-threads", type=int, default=os.cpu_count() or 1, help="Largest writer count")
+    parser.add_argument("--queries", type=int, default=1000, help="Queries per recall run")
+    parser.add_argument("--k", type=int, default=10, help="Neighbours per query")
+    parser.add_argument("--sizes", type=int_list, default=[1000, 10000, 100000], help="Index sizes for the hnsw suite")
+    parser.add_argument("--onnx-model", help="ONNX model taking a [batch, dim] float input (default: generated MatMul model)")
+    parser.add_argument("--onnx-outputs", type=int, default=16, help="Output width of the ONNX model")
+    parser.add_argument("--onnx-batches", type=int_list, default=[1, 8, 32, 128], help="Batch sizes for the onnx suite")
+    parser.add_argument("--vault-buffers", type=int_list, default=[64, 1024, 16384, 262144, 4194304],
+                        help="Buffer sizes in bytes for the vault suite")
+    parser.add_argument("--vault-stream-bytes", type=int, default=16 << 20, help="Payload per vault stream run")
+    parser.add_argument("--min-seconds", type=float, default=1.0, help="Minimum measuring time per data point")
+    parser.add_argument("--json", dest="json_path", help="Write results as JSON for regression tracking")
+    parser.add_argument("--trace", dest="trace_path", help="Write a Chrome trace (or *.otlp.json) of the run")
+    args = parser.parse_args()
+    suites = args.suite or list(SUITES)
+
+    from flashflow_cli.services import tracing
+    if args.trace_path:
+        tracing.enable()
+
+    print("========================================")
+    print("Benchmarking FlashCore")
+    print("========================================")
+
+    index_class = get_index_class()
+    results = {}
+
+    def run(suite, title, fn, *fn_args):
+        print(f"\n{title}:")
+        with tracing.span(suite, cat="bench"):
+            try:
+                results[suite] = fn(*fn_args)
+            except ImportError as e:
+                print(f"  skipped: {e}")
+                results[suite] = {"skipped": str(e)}
+
+    if "insert" in suites:
+        run("insert", f"Insert scaling (dim={args.dim}, count={args.count}, batch={args.batch_size})",
+            bench_insert_scaling, index_class, args.dim, args.count, args.batch_size, args.max_threads)
+
+    if "quantization" in suites:
+        # sq8/pq storage and re-ranking are options of VectorIndex only
+        run("quantization", f"Quantization recall (dim={args.dim}, count={args.count}, queries={args.queries})",
+            bench_quantization_recall, VectorIndex, args.dim, args.count, args.queries, args.k)
+
+    if "hnsw" in suites:
+        run("hnsw", f"Index build/query (dim={args.dim}, queries={args.queries}, k={args.k})",
+            bench_hnsw, index_class, args.dim, args.sizes, args.queries, args.k, args.batch_size, args.min_seconds)
+
+    if "onnx" in suites:
+        model_path = args.onnx_model
+        if model_path is None:
+            import tempfile
+            model_path = tiny_onnx_model(os.path.join(tempfile.mkdtemp(prefix="flashflow-bench-"), "matmul.onnx"), args.dim, args.onnx_outputs)
+        if model_path is None:
+            print("\nONNX inference:\n  skipped: pass --onnx-model or install onnx to generate a test model")
+            results["onnx"] = {"skipped": "no model"}
+        else:
+            run("onnx", f"ONNX inference ({os.path.basename(model_path)}, dim={args.dim})",
+                bench_onnx, model_path, args.dim, args.onnx_outputs, args.onnx_batches, args.min_seconds)
+
+    if "vault" in suites:
+        run("vault", f"AESVault throughput (stream={args.vault_stream_bytes} bytes)",
+            bench_vault, args.vault_buffers, args.vault_stream_bytes, args.min_seconds)
+
+    print("========================================")
+
+    if args.json_path:
+        with open(args.json_path, "w", encoding="utf-8") as f:
+            json.dump({"environment": environment(index_class), "config": vars(args), "results": results}, f, indent=2)
+        print(f"Results written to {args.json_path}")
+
+    if args.trace_path:
+        print(f"{tracing.export(args.trace_path)} spans written to {args.trace_path}")
+
+if __name__ == "__main__":
+    main()
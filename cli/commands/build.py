@@ -7,14 +7,14 @@ import os
 import json
 import subprocess
 import sys
+import time
 from pathlib import Path
 from core.framework import FlashFlowProject, FlashFlowIR
 from core.parser.parser import FlowParser
-# Temporarily remove backend generator import to avoid errors
-# from generators.backend.backend import BackendGenerator
-from generators.web.flet_frontend import FletFrontendGenerator
-from generators.mobile.mobile import MobileGenerator
-from generators.desktop.simple_desktop import SimpleDesktopGenerator
+from core.parser.build_cache import IRBuildCache
+from flashflow_cli.generators import BackendGenerator, FrontendGenerator, MobileGenerator, DesktopGenerator
+from flashflow_cli.generators.scheduler import BuildScheduler
+from flashflow_cli.services import tracing
 
 def check_go_service_available(service_name):
     """Check if a Go service executable is available."""
@@ -59,7 +59,9 @@ def run_go_build_service(target, env, watch):
 @click.option('--target', '-t', default='all', help='Build target (all, backend, frontend, mobile, ios, android, desktop, windows, macos, linux)')
 @click.option('--env', '-e', default='development', help='Build environment (development, production)')
 @click.option('--watch', '-w', is_flag=True, help='Watch for file changes and rebuild')
-def build(target, env, watch):
+@click.option('--jobs', '-j', default=None, type=int, help='Parallel generation workers (default: CPU count)')
+@click.option('--trace', 'trace_path', default=None, type=click.Path(), help='Write parser and generator spans to this Chrome trace (or *.otlp.json) file')
+def build(target, env, watch, jobs, trace_path):
     """Generate application code from .flow files"""
     
     # Check if we're in a FlashFlow project
@@ -81,73 +83,133 @@ def build(target, env, watch):
         click.echo(f"📦 Target: {target}")
         click.echo(f"🌍 Environment: {env}")
         
+        if trace_path:
+            tracing.enable()
+        
         if watch:
             click.echo("👀 Watch mode enabled - building on file changes...")
-            build_with_watch(project, target, env)
+            build_with_watch(project, target, env, jobs)
         else:
-            build_once(project, target, env)
+            build_once(project, target, env, jobs=jobs)
             
     except Exception as e:
         click.echo(f"❌ Build failed: {str(e)}")
+    finally:
+        if trace_path:
+            click.echo(f"   🧭 {tracing.export(trace_path)} spans written to {trace_path}")
 
-def build_once(project: FlashFlowProject, target: str, env: str):
-    """Build the project once"""
+@tracing.traced("build", cat="build")
+def build_once(project: FlashFlowProject, target: str, env: str, cache: IRBuildCache = None, jobs: int = None):
+    """Build the project once
+    
+    Pass the same cache across rebuilds so only changed files are reparsed
+    and re-merged into the IR. Generation runs as a task graph on `jobs`
+    workers, with per-task timings written to .flashflow/build-trace.json.
+    """
     
     # Parse all .flow files
     click.echo("📖 Parsing .flow files...")
     parser = FlowParser()
-    ir = FlashFlowIR()
+    cache = cache or IRBuildCache(project.root_path)
     
     flow_files = project.get_flow_files()
     if not flow_files:
         click.echo("⚠️  No .flow files found in src/flows/")
         return
     
-    for flow_file in flow_files:
-        click.echo(f"   📄 {flow_file.name}")
-        try:
-            parsed_data = parser.parse_file(flow_file)
-            merge_parsed_data_to_ir(ir, parsed_data)
-        except Exception as e:
-            click.echo(f"   ❌ Error parsing {flow_file.name}: {str(e)}")
-            return
+    try:
+        ir = parser.parse_project(project.root_path, cache)
+    except Exception as e:
+        click.echo(f"   ❌ Error parsing: {str(e)}")
+        return
     
-    click.echo(f"✅ Parsed {len(flow_files)} .flow files")
+    for changed_file in cache.changed_files:
+        click.echo(f"   📄 {Path(changed_file).name}")
+    
+    cached = len(cache.order) - len(cache.changed_files)
+    click.echo(f"✅ Parsed {len(cache.order)} flow files ({max(cached, 0)} unchanged, from cache)")
+    
+    # Queue generation tasks based on target
+    scheduler = BuildScheduler(jobs, trace_path=project.root_path / ".flashflow" / "build-trace.json")
     
-    # Generate code based on target
     if target in ['all', 'backend']:
-        generate_backend(project, ir, env)
+        generate_backend(project, ir, env, scheduler)
     
     if target in ['all', 'frontend']:
-        generate_frontend(project, ir, env)
+        generate_frontend(project, ir, env, scheduler)
     
     if target in ['all', 'mobile', 'ios', 'android']:
-        generate_mobile(project, ir, env, target)
+        generate_mobile(project, ir, env, target, scheduler)
     
     if target in ['all', 'desktop', 'windows', 'macos', 'linux']:
-        generate_desktop(project, ir, env, target)
+        generate_desktop(project, ir, env, target, scheduler)
+    
+    started = time.perf_counter()
+    results = scheduler.run(raise_on_error=False)
+    elapsed = time.perf_counter() - started
+    
+    failed = report_generation(results)
+    summary = scheduler.summary()
+    click.echo(f"⏱️  {len(results)} tasks on {scheduler.jobs} workers in {elapsed:.2f}s "
+               f"({summary['written']} files written, {summary['unchanged']} unchanged)")
+    click.echo(f"   📈 Trace: {scheduler.trace_path}")
+    
+    if failed:
+        click.echo("⚠️  Build completed with errors")
+        return
+    
+    # Generators have emitted every dirty entity; the next rebuild starts clean
+    ir.clear_changes()
     
     click.echo("✅ Build completed successfully!")
 
-def build_with_watch(project: FlashFlowProject, target: str, env: str):
+def add_generator_tasks(scheduler: BuildScheduler, name: str, generator):
+    """Queue per-entity tasks when a generator provides them, else one task for the whole generator"""
+    if hasattr(generator, 'tasks'):
+        scheduler.extend(generator.tasks())
+    else:
+        scheduler.add_task(name, generator.generate, category=name)
+
+def report_generation(results) -> bool:
+    """Echo one line per generator category; returns True if any task failed"""
+    categories = {}
+    for result in results.values():
+        if result.category != "io":
+            categories.setdefault(result.category, []).append(result)
+    
+    failed = False
+    for category, category_results in categories.items():
+        failures = [result for result in category_results if result.status != "ok"]
+        if failures:
+            failed = True
+            for result in failures:
+                reason = str(result.error) if result.error else "a task it depends on failed"
+                click.echo(f"   ❌ {result.name} {result.status}: {reason}")
+        else:
+            click.echo(f"   ✅ {category} generated ({len(category_results)} tasks)")
+    return failed
+
+def build_with_watch(project: FlashFlowProject, target: str, env: str, jobs: int = None):
     """Build with file watching"""
     import time
     from watchdog.observers import Observer
     from watchdog.events import FileSystemEventHandler
     
     class FlowFileHandler(FileSystemEventHandler):
-        def __init__(self, project, target, env):
+        def __init__(self, project, target, env, cache):
             self.project = project
             self.target = target
             self.env = env
+            self.cache = cache
+            self.jobs = jobs
             self.last_build = 0
         
         def on_modified(self, event):
             if event.is_directory:
                 return
             
-            # Only rebuild for .flow files
-            if not str(event.src_path).endswith('.flow'):
+            # Only rebuild for .flow, .liveflow, .jobflow and .testflow files
+            if not str(event.src_path).endswith(('.flow', '.liveflow', '.jobflow', '.testflow')):
                 return
             
             # Debounce builds (max once per second)
@@ -158,16 +220,17 @@ def build_with_watch(project: FlashFlowProject, target: str, env: str):
             self.last_build = now
             click.echo(f"\n🔄 File changed: {event.src_path}")
             try:
-                build_once(self.project, self.target, self.env)
+                build_once(self.project, self.target, self.env, self.cache, self.jobs)
                 click.echo("👀 Watching for changes... (Ctrl+C to stop)")
             except Exception as e:
                 click.echo(f"❌ Build error: {str(e)}")
     
-    # Initial build
-    build_once(project, target, env)
+    # Initial build; the cache keeps the IR in memory between rebuilds
+    cache = IRBuildCache(project.root_path)
+    build_once(project, target, env, cache, jobs)
     
     # Setup file watcher
-    event_handler = FlowFileHandler(project, target, env)
+    event_handler = FlowFileHandler(project, target, env, cache)
     observer = Observer()
     observer.schedule(event_handler, str(project.flows_path), recursive=True)
     observer.start()
@@ -214,33 +277,25 @@ def merge_parsed_data_to_ir(ir: FlashFlowIR, parsed_data: dict):
     if 'theme' in parsed_data:
         ir.set_theme(parsed_data['theme'])
 
-def generate_backend(project: FlashFlowProject, ir: FlashFlowIR, env: str):
-    """Generate backend code"""
+def generate_backend(project: FlashFlowProject, ir: FlashFlowIR, env: str, scheduler: BuildScheduler):
+    """Queue backend code generation"""
     click.echo("🔧 Generating backend...")
     
     try:
-        # Import backend generator here to avoid import errors
-        from generators.backend.backend import BackendGenerator
-        
         backend_gen = BackendGenerator(project, ir, env)
-        backend_gen.generate()
-        
-        click.echo("   ✅ Backend code generated")
+        add_generator_tasks(scheduler, 'backend', backend_gen)
     except Exception as e:
         click.echo(f"   ❌ Backend generation failed: {str(e)}")
         click.echo("   ⚠️  Backend generation skipped due to errors")
 
-def generate_frontend(project: FlashFlowProject, ir: FlashFlowIR, env: str):
-    """Generate frontend code using Flet"""
+def generate_frontend(project: FlashFlowProject, ir: FlashFlowIR, env: str, scheduler: BuildScheduler):
+    """Queue frontend code generation, one task per dirty page"""
     click.echo("🎨 Generating frontend...")
     
-    frontend_gen = FletFrontendGenerator(project, ir, env)
-    frontend_gen.generate()
-    
-    click.echo("   ✅ Flet web app generated")
-    click.echo("   ✅ Build configuration created")
+    frontend_gen = FrontendGenerator(project, ir, env)
+    add_generator_tasks(scheduler, 'frontend', frontend_gen)
 
-def generate_mobile(project: FlashFlowProject, ir: FlashFlowIR, env: str, target: str):
+def generate_mobile(project: FlashFlowProject, ir: FlashFlowIR, env: str, target: str, scheduler: BuildScheduler):
     """Generate mobile app code"""
     if target == 'ios':
         click.echo("📱 Generating iOS app...")
@@ -251,20 +306,17 @@ def generate_mobile(project: FlashFlowProject, ir: FlashFlowIR, env: str, target
     
     mobile_gen = MobileGenerator(project, ir, env)
     
+    # iOS and Android write to separate trees and can run side by side
     if target in ['all', 'mobile', 'ios']:
-        mobile_gen.generate_ios()
-        click.echo("   ✅ iOS app generated")
+        scheduler.add_task('mobile:ios', mobile_gen.generate_ios, category='mobile')
     
     if target in ['all', 'mobile', 'android']:
-        mobile_gen.generate_android()
-        click.echo("   ✅ Android app generated")
+        scheduler.add_task('mobile:android', mobile_gen.generate_android, category='mobile')
 
-def generate_desktop(project: FlashFlowProject, ir: FlashFlowIR, env: str, target: str):
-    """Generate desktop app code"""
+def generate_desktop(project: FlashFlowProject, ir: FlashFlowIR, env: str, target: str, scheduler: BuildScheduler):
+    """Queue desktop app code generation"""
     click.echo("🖥️  Generating desktop app...")
     
-    desktop_gen = SimpleDesktopGenerator(str(project.root_path), project.config.name)
-    desktop_gen.generate(ir.to_dict())
-    
-    click.echo("   ✅ Desktop app generated")
-    click.echo("   ✅ Build scripts created")
\ No newline at end of file
+    desktop_gen = DesktopGenerator(str(project.root_path), project.config.name)
+    ir_data = ir.to_dict()
+    scheduler.add_task('desktop', lambda: desktop_gen.generate(ir_data), category='desktop')
\ No newline at end of file
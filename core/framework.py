@@ -4,8 +4,9 @@ FlashFlow Core Classes
 
 import json
 import os
+from contextlib import contextmanager
 from pathlib import Path
-from typing import Dict, List, Optional, Any
+from typing import Dict, List, Optional, Any, Set
 from dataclasses import dataclass
 
 @dataclass
@@ -98,6 +99,17 @@ class FlashFlowProject:
 class FlashFlowIR:
     """FlashFlow Intermediate Representation"""
     
+    # Configuration sections a later .flow file replaces wholesale; every other
+    # dict section merges entity by entity, and list sections concatenate
+    REPLACED_SECTIONS = (
+        'auth', 'theme', 'i18n', 'serverless', 'desktop', 'social_auth', 'payments',
+        'sms', 'push_notifications', 'file_storage', 'email', 'search', 'analytics',
+        'admin_panel', 'icons'
+    )
+    
+    # Entity sections with per-key change tracking for selective regeneration
+    TRACKED_SECTIONS = ('models', 'pages', 'endpoints')
+    
     def __init__(self):
         self.models: Dict[str, Dict] = {}
         self.pages: Dict[str, Dict] = {}
@@ -145,19 +157,81 @@ class FlashFlowIR:
         self.vector_databases: Dict[str, Any] = {}
         self.webrtc_streams: Dict[str, Any] = {}
         self.lazy_imports: Dict[str, Any] = {}
+        
+        # Entities changed or removed since generators last ran (see clear_changes)
+        self._changed: Dict[str, Set[str]] = {name: set() for name in self.TRACKED_SECTIONS}
+        self._removed: Dict[str, Set[str]] = {name: set() for name in self.TRACKED_SECTIONS}
+        self._tracking = True
+    
+    def _track(self, section: str, key: str, definition: Dict):
+        if self._tracking and getattr(self, section).get(key) != definition:
+            self._changed[section].add(key)
+            self._removed[section].discard(key)
     
     def add_model(self, name: str, definition: Dict):
         """Add a model definition to the IR"""
+        self._track('models', name, definition)
         self.models[name] = definition
     
     def add_page(self, path: str, definition: Dict):
         """Add a page definition to the IR"""
+        self._track('pages', path, definition)
         self.pages[path] = definition
     
     def add_endpoint(self, path: str, definition: Dict):
         """Add an API endpoint definition to the IR"""
+        self._track('endpoints', path, definition)
         self.endpoints[path] = definition
     
+    def is_dirty(self, section: str, key: str) -> bool:
+        """Whether an entity changed since generators last ran"""
+        return key in self._changed.get(section, ())
+    
+    def changed(self, section: str) -> Set[str]:
+        """Keys of entities in a tracked section that changed since generators last ran"""
+        return set(self._changed.get(section, ()))
+    
+    def removed(self, section: str) -> Set[str]:
+        """Keys of entities in a tracked section removed since generators last ran"""
+        return set(self._removed.get(section, ()))
+    
+    def record_changes(self, section: str, previous: Dict[str, Any]):
+        """Diff a tracked section against its previous contents and record the changes"""
+        current = getattr(self, section)
+        for key in previous.keys() | current.keys():
+            if key not in current:
+                self._changed[section].discard(key)
+                self._removed[section].add(key)
+            elif previous.get(key) != current[key]:
+                self._changed[section].add(key)
+                self._removed[section].discard(key)
+    
+    def carry_changes(self, other: 'FlashFlowIR'):
+        """Adopt changes another IR recorded that generators have not consumed yet"""
+        for section in self.TRACKED_SECTIONS:
+            self._changed[section] |= other.changed(section)
+            self._removed[section] |= other.removed(section)
+    
+    def mark_all_changed(self):
+        """Treat every entity as changed, forcing full regeneration"""
+        for section in self.TRACKED_SECTIONS:
+            self._changed[section] = set(getattr(self, section))
+    
+    def clear_changes(self):
+        """Forget recorded changes once generators have consumed them"""
+        for section in self.TRACKED_SECTIONS:
+            self._changed[section].clear()
+            self._removed[section].clear()
+    
+    @contextmanager
+    def untracked(self):
+        """Suspend change tracking, e.g. while sections are rebuilt and diffed afterwards"""
+        tracking, self._tracking = self._tracking, False
+        try:
+            yield self
+        finally:
+            self._tracking = tracking
+    
     def set_auth(self, auth_config: Dict):
         """Set authentication configuration"""
         self.auth = auth_config
@@ -178,6 +252,25 @@ class FlashFlowIR:
         """Set desktop configuration"""
         self.desktop = desktop_config
     
+    def sections(self) -> Dict[str, Any]:
+        """Non-empty IR sections by attribute name"""
+        return {name: value for name, value in vars(self).items()
+                if not name.startswith('_') and isinstance(value, (dict, list)) and value}
+    
+    def reset_section(self, name: str):
+        """Empty one IR section"""
+        setattr(self, name, [] if isinstance(getattr(self, name, None), list) else {})
+    
+    def merge_section(self, name: str, value: Any):
+        """Fold one file's contribution to a section into the IR"""
+        current = getattr(self, name, None)
+        if isinstance(value, list):
+            setattr(self, name, (current or []) + value)
+        elif name in self.REPLACED_SECTIONS or not isinstance(current, dict):
+            setattr(self, name, dict(value))
+        else:
+            current.update(value)
+    
     def to_dict(self) -> Dict:
         """Convert IR to dictionary"""
         return {
@@ -0,0 +1,182 @@
+"""
+Incremental IR build cache for FlowParser.parse_project
+Caches each source file's parsed fragment by content hash and re-merges only what changed
+"""
+
+import json
+import hashlib
+import logging
+from pathlib import Path
+from typing import Dict, Any, List, Optional, Set, Tuple
+
+from core.framework import FlashFlowIR
+
+logger = logging.getLogger(__name__)
+
+CACHE_VERSION = 2  # 2: JSON instead of pickle
+
+# (glob, FlowParser parse method, FlowParser merge method) in merge order
+SOURCE_KINDS = (
+    ('*.flow', 'parse_file', '_merge_into_ir'),
+    ('*.liveflow', 'parse_liveflow_file', '_merge_liveflow_into_ir'),
+    ('*.jobflow', 'parse_jobflow_file', '_merge_jobflow_into_ir'),
+    ('*.testflow', 'parse_testflow_file', '_merge_testflow_into_ir'),
+)
+
+# Sections the default UI pass reads or writes; they are recomposed together
+DEFAULT_PAGE_INPUTS = {'models', 'pages'}
+
+
+class Fragment:
+    """One source file's parsed data and the IR sections it contributes"""
+
+    __slots__ = ('digest', 'data', 'sections')
+
+    def __init__(self, digest: str, data: Dict[str, Any], sections: Dict[str, Any]):
+        self.digest = digest
+        self.data = data
+        self.sections = sections
+
+
+class IRBuildCache:
+    """Persistent content-hashed fragment cache for a project's flows.
+
+    Each file's fragment records which IR sections it contributes to, so
+    after an edit only the sections touched by the old or new version of
+    that file are rebuilt, by folding the cached contributions of every file
+    that feeds them. Keep one instance alive (e.g. in watch mode) to reuse
+    the previous IR in memory; it is also saved as JSON under .flashflow/ so
+    the next process skips parsing unchanged files. A cache file that cannot
+    be read back for any reason is treated as empty.
+    """
+
+    def __init__(self, project_path: Path, cache_path: Optional[Path] = None):
+        self.project_path = Path(project_path)
+        self.cache_path = cache_path or self.project_path / ".flashflow" / "ir_cache.json"
+        self.fragments: Dict[str, Fragment] = {}
+        self.order: List[str] = []
+        self.ir: Optional[FlashFlowIR] = None
+        self.changed_files: List[str] = []  # Files reparsed by the last build
+        self.dirty_sections: Set[str] = set()  # IR sections rebuilt by the last build
+        self._load()
+
+    def _load(self):
+        try:
+            with open(self.cache_path, 'r', encoding='utf-8') as f:
+                state = json.load(f)
+            if state.get('version') != CACHE_VERSION:
+                return
+            fragments = {}
+            for key, (digest, data, sections) in state['fragments'].items():
+                if not isinstance(digest, str) or not isinstance(sections, dict):
+                    raise ValueError(f"Malformed fragment {key}")
+                fragments[key] = Fragment(digest, data, sections)
+            self.fragments = fragments
+        except Exception:
+            # Missing, truncated, hand-edited or from another version: every file is a miss
+            self.fragments = {}
+
+    def save(self):
+        """Write the fragment cache to disk, skipping it when a fragment holds a non-JSON value"""
+        state = {
+            'version': CACHE_VERSION,
+            'fragments': {key: [fragment.digest, fragment.data, fragment.sections]
+                          for key, fragment in self.fragments.items()},
+        }
+        try:
+            content = json.dumps(state, separators=(',', ':'))
+        except (TypeError, ValueError) as e:
+            logger.warning(f"IR build cache not saved: {e}")
+            return
+
+        self.cache_path.parent.mkdir(parents=True, exist_ok=True)
+        temp_path = self.cache_path.with_suffix('.tmp')
+        with open(temp_path, 'w', encoding='utf-8') as f:
+            f.write(content)
+        temp_path.replace(self.cache_path)
+
+    def _sources(self, flows_path: Path) -> List[Tuple[str, Path, str, str]]:
+        sources = []
+        for pattern, parse_method, merge_method in SOURCE_KINDS:
+            for path in flows_path.glob(pattern):
+                sources.append((path.relative_to(self.project_path).as_posix(), path, parse_method, merge_method))
+        return sources
+
+    def _parse(self, parser, path: Path, parse_method: str, merge_method: str, digest: str) -> Fragment:
+        """Parse one file and merge it alone into a scratch IR to capture its contribution"""
+        data = getattr(parser, parse_method)(path)
+
+        scratch_ir, parser.ir = parser.ir, FlashFlowIR()
+        try:
+            getattr(parser, merge_method)(data)
+            sections = parser.ir.sections()
+        finally:
+            parser.ir = scratch_ir
+        return Fragment(digest, data, sections)
+
+    def build(self, parser, flows_path: Path) -> FlashFlowIR:
+        """Bring the IR up to date with the files under flows_path"""
+        from flashflow_cli.services.default_ui_service import default_ui_service
+
+        order = []
+        dirty: Set[str] = set()
+        changed = []
+        seen = set()
+        for key, path, parse_method, merge_method in self._sources(flows_path):
+            digest = hashlib.blake2b(path.read_bytes(), digest_size=16).hexdigest()
+            fragment = self.fragments.get(key)
+            if fragment is None or fragment.digest != digest:
+                new_fragment = self._parse(parser, path, parse_method, merge_method, digest)
+                if fragment is not None:
+                    dirty.update(fragment.sections)
+                dirty.update(new_fragment.sections)
+                self.fragments[key] = new_fragment
+                changed.append(key)
+            order.append(key)
+            seen.add(key)
+
+        for key in [key for key in self.fragments if key not in seen]:
+            dirty.update(self.fragments.pop(key).sections)
+            changed.append(key)
+
+        previous_ir = self.ir
+        if previous_ir is None or order != self.order:
+            # First build in this process, or files were added/removed/reordered
+            ir = FlashFlowIR()
+            sections = None
+            dirty = {name for key in order for name in self.fragments[key].sections}
+            previous = {name: getattr(previous_ir, name) for name in ir.TRACKED_SECTIONS} if previous_ir else None
+        else:
+            ir = previous_ir
+            sections = set(dirty)
+            if sections & DEFAULT_PAGE_INPUTS:
+                sections |= DEFAULT_PAGE_INPUTS
+            previous = {name: dict(getattr(ir, name)) for name in ir.TRACKED_SECTIONS if name in sections}
+            for name in sections:
+                ir.reset_section(name)
+
+        # Rebuild untracked, then record entity changes by diffing against the previous IR
+        with ir.untracked():
+            for key in order:
+                for name, value in self.fragments[key].sections.items():
+                    if sections is None or name in sections:
+                        ir.merge_section(name, value)
+
+            if sections is None or sections & DEFAULT_PAGE_INPUTS:
+                default_ui_service.generate_default_pages(ir)
+
+        if previous is None:
+            ir.mark_all_changed()
+        else:
+            if ir is not previous_ir:
+                ir.carry_changes(previous_ir)
+            for name, section in previous.items():
+                ir.record_changes(name, section)
+
+        self.ir = ir
+        self.order = order
+        self.changed_files = changed
+        self.dirty_sections = dirty
+        if changed:
+            self.save()
+        return ir
@@ -0,0 +1,94 @@
+"""
+Fast loader for .flow-family files
+Strips comments in one pass and builds the dict tree with the fastest available parser
+"""
+
+import re
+import yaml
+from pathlib import Path
+from typing import Dict, Any, Optional
+
+# Native parsers in preference order: FlashCore's tokenizer, then libyaml
+try:
+    import flashcore
+    _native_parse = getattr(flashcore, 'parse_flow', None)
+except ImportError:
+    _native_parse = None
+
+_Loader = getattr(yaml, 'CSafeLoader', yaml.SafeLoader)
+
+# Whole-line comments, the same lines FlowParser has always dropped before parsing
+_COMMENT_LINE = re.compile(r'^[ \t\r\f\v]*#[^\n]*(?:\n|\Z)', re.MULTILINE)
+
+
+class FlowParseError(ValueError):
+    """A .flow file failed to parse; line and column are 1-based"""
+
+    def __init__(self, message: str, path: Optional[str] = None,
+                 line: Optional[int] = None, column: Optional[int] = None):
+        self.message = message
+        self.path = path
+        self.line = line
+        self.column = column
+        location = ":".join(str(part) for part in (path, line, column) if part is not None)
+        super().__init__(f"{location}: {message}" if location else message)
+
+
+def backend() -> str:
+    """Name of the parser load_flow will use"""
+    if _native_parse is not None:
+        return 'flashcore'
+    return 'libyaml' if _Loader is not yaml.SafeLoader else 'python'
+
+
+def strip_comments(content: str) -> str:
+    """Drop whole-line # comments in a single regex pass"""
+    if '#' not in content:
+        return content
+    return _COMMENT_LINE.sub('', content)
+
+
+def _original_line(content: str, stripped_line: int) -> int:
+    """Map a 0-based line in the comment-stripped text back to the source"""
+    kept = 0
+    for number, line in enumerate(content.split('\n')):
+        if not line.lstrip().startswith('#'):
+            if kept == stripped_line:
+                return number
+            kept += 1
+    return stripped_line
+
+
+def load_flow(content: str, path: Optional[Path] = None, strip: bool = True) -> Dict[str, Any]:
+    """Parse .flow content into a dict ({} for an empty file).
+
+    Raises FlowParseError carrying the source line and column on failure.
+    """
+    source = str(path) if path is not None else None
+
+    if _native_parse is not None:
+        try:
+            return _native_parse(content) or {}
+        except Exception as e:
+            raise FlowParseError(str(e), source, getattr(e, 'line', None), getattr(e, 'column', None)) from e
+
+    cleaned = strip_comments(content) if strip else content
+    try:
+        parsed = yaml.load(cleaned, Loader=_Loader)
+    except yaml.MarkedYAMLError as e:
+        mark = e.problem_mark or e.context_mark
+        line = column = None
+        if mark is not None:
+            line = (_original_line(content, mark.line) if strip else mark.line) + 1
+            column = mark.column + 1
+        raise FlowParseError(e.problem or e.context or str(e), source, line, column) from e
+    except yaml.YAMLError as e:
+        raise FlowParseError(str(e), source) from e
+
+    return parsed if parsed is not None else {}
+
+
+def load_flow_file(path: Path, strip: bool = True) -> Dict[str, Any]:
+    """Read and parse a .flow-family file"""
+    with open(path, 'r', encoding='utf-8') as f:
+        return load_flow(f.read(), path, strip)
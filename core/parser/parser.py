@@ -3,12 +3,14 @@ FlashFlow .flow file parser
 Converts .flow syntax into FlashFlow IR (Intermediate Representation)
 """
 
-import yaml
 import re
 from pathlib import Path
-from typing import Dict, Any, List
+from typing import Dict, Any, List, Optional
 from core.framework import FlashFlowIR
+from core.parser.flow_loader import load_flow
+from core.parser.build_cache import IRBuildCache
 from flashflow_cli.services.default_ui_service import default_ui_service
+from flashflow_cli.services.tracing import traced
 
 class FlowParser:
     """Parser for .flow files"""
@@ -16,6 +18,7 @@ class FlowParser:
     def __init__(self):
         self.ir = FlashFlowIR()
     
+    @traced("FlowParser.parse_file", cat="parser")
     def parse_file(self, file_path: Path) -> Dict[str, Any]:
         """Parse a single .flow file"""
         
@@ -25,42 +28,34 @@ class FlowParser:
         with open(file_path, 'r', encoding='utf-8') as f:
             content = f.read()
         
-        return self.parse_content(content)
+        return self.parse_content(content, file_path)
     
-    def parse_content(self, content: str) -> Dict[str, Any]:
-        """Parse .flow content string"""
+    def parse_content(self, content: str, file_path: Path = None) -> Dict[str, Any]:
+        """Parse .flow content string
         
-        # Remove comments (lines starting with #)
-        lines = content.split('\n')
-        cleaned_lines = []
-        
-        for line in lines:
-            # Keep lines that don't start with # (after stripping whitespace)
-            stripped = line.lstrip()
-            if not stripped.startswith('#'):
-                cleaned_lines.append(line)
-        
-        cleaned_content = '\n'.join(cleaned_lines)
-        
-        try:
-            # Parse as YAML (since .flow syntax is YAML-like)
-            parsed_data = yaml.safe_load(cleaned_content)
-            
-            if parsed_data is None:
-                return {}
-            
-            return parsed_data
-            
-        except yaml.YAMLError as e:
-            raise ValueError(f"Failed to parse .flow file: {str(e)}")
+        Comment lines are stripped in one pass and the tree is built by the
+        native FlashCore parser or libyaml when available. Errors raise
+        FlowParseError (a ValueError) with the source line and column.
+        """
+        return load_flow(content, file_path)
     
-    def parse_project(self, project_path: Path) -> FlashFlowIR:
-        """Parse all .flow files in a project and return unified IR"""
+    @traced("FlowParser.parse_project", cat="parser")
+    def parse_project(self, project_path: Path, cache: Optional[IRBuildCache] = None) -> FlashFlowIR:
+        """Parse all .flow files in a project and return unified IR
+        
+        With a cache, files whose content hash is unchanged are not reparsed
+        and only the IR sections fed by changed files are re-merged; the
+        returned IR replaces self.ir.
+        """
         
         flows_path = project_path / "src" / "flows"
         if not flows_path.exists():
             return self.ir
         
+        if cache is not None:
+            self.ir = cache.build(self, flows_path)
+            return self.ir
+        
         # Parse different types of flow files
         flow_files = list(flows_path.glob("*.flow"))
         liveflow_files = list(flows_path.glob("*.liveflow"))
@@ -87,11 +82,6 @@ class FlowParser:
             parsed_data = self.parse_testflow_file(testflow_file)
             self._merge_testflow_into_ir(parsed_data)
         
-        # Parse .testflow files (tests)
-        for testflow_file in testflow_files:
-            parsed_data = self.parse_testflow_file(testflow_file)
-            self._merge_testflow_into_ir(parsed_data)
-        
         # Generate default pages for models that don't have explicit page definitions
         default_ui_service.generate_default_pages(self.ir)
         
@@ -474,17 +464,14 @@ class FlowParser:
         with open(file_path, 'r', encoding='utf-8') as f:
             content = f.read()
         
-        # Parse YAML content
-        try:
-            parsed_data = yaml.safe_load(content) or {}
-            
-            # Add file type marker
-            parsed_data['_file_type'] = 'liveflow'
-            parsed_data['_file_name'] = file_path.stem
-            
-            return parsed_data
-        except yaml.YAMLError as e:
-            raise ValueError(f"Failed to parse .liveflow file {file_path}: {str(e)}")
+        # Parse YAML content (comment lines are left to the YAML parser)
+        parsed_data = load_flow(content, file_path, strip=False)
+        
+        # Add file type marker
+        parsed_data['_file_type'] = 'liveflow'
+        parsed_data['_file_name'] = file_path.stem
+        
+        return parsed_data
     
     def parse_jobflow_file(self, file_path: Path) -> Dict[str, Any]:
         """Parse a .jobflow file for background jobs"""
@@ -492,17 +479,14 @@ class FlowParser:
         with open(file_path, 'r', encoding='utf-8') as f:
             content = f.read()
         
-        # Parse YAML content
-        try:
-            parsed_data = yaml.safe_load(content) or {}
-            
-            # Add file type marker
-            parsed_data['_file_type'] = 'jobflow'
-            parsed_data['_file_name'] = file_path.stem
-            
-            return parsed_data
-        except yaml.YAMLError as e:
-            raise ValueError(f"Failed to parse .jobflow file {file_path}: {str(e)}")
+        # Parse YAML content (comment lines are left to the YAML parser)
+        parsed_data = load_flow(content, file_path, strip=False)
+        
+        # Add file type marker
+        parsed_data['_file_type'] = 'jobflow'
+        parsed_data['_file_name'] = file_path.stem
+        
+        return parsed_data
     
     def parse_testflow_file(self, file_path: Path) -> Dict[str, Any]:
         """Parse a .testflow file for tests"""
@@ -510,17 +494,14 @@ class FlowParser:
         with open(file_path, 'r', encoding='utf-8') as f:
             content = f.read()
         
-        # Parse YAML content
-        try:
-            parsed_data = yaml.safe_load(content) or {}
-            
-            # Add file type marker
-            parsed_data['_file_type'] = 'testflow'
-            parsed_data['_file_name'] = file_path.stem
-            
-            return parsed_data
-        except yaml.YAMLError as e:
-            raise ValueError(f"Failed to parse .testflow file {file_path}: {str(e)}")
+        # Parse YAML content (comment lines are left to the YAML parser)
+        parsed_data = load_flow(content, file_path, strip=False)
+        
+        # Add file type marker
+        parsed_data['_file_type'] = 'testflow'
+        parsed_data['_file_name'] = file_path.stem
+        
+        return parsed_data
     
     def _merge_liveflow_into_ir(self, parsed_data: Dict[str, Any]):
         """Merge .liveflow data into IR"""
@@ -645,21 +626,14 @@ class FlowParser:
 class TestFlowParser:
     """Parser for .testflow files"""
     
+    @traced("TestFlowParser.parse_file", cat="parser")
     def parse_file(self, file_path: Path) -> Dict[str, Any]:
         """Parse a .testflow file"""
         
         with open(file_path, 'r', encoding='utf-8') as f:
             content = f.read()
         
-        # Remove comments
-        lines = content.split('\n')
-        cleaned_lines = [line for line in lines if not line.lstrip().startswith('#')]
-        cleaned_content = '\n'.join(cleaned_lines)
-        
-        try:
-            return yaml.safe_load(cleaned_content) or {}
-        except yaml.YAMLError as e:
-            raise ValueError(f"Failed to parse .testflow file: {str(e)}")
+        return load_flow(content, file_path)
 
 # Utility functions for parsing specific .flow components
 
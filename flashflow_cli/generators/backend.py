@@ -9,6 +9,7 @@ from typing import Dict, Any
 from jinja2 import Template
 
 from ..core import FlashFlowProject, FlashFlowIR
+from .base import normalize_fields
 
 class BackendGenerator:
     """Generates backend code from FlashFlow IR"""
@@ -272,7 +273,7 @@ class {{ model_name }} extends Model
         timestamps = False
         methods = model_data.get('methods', [])
         
-        for field in model_data.get('fields', []):
+        for field in normalize_fields(model_data.get('fields')):
             if not field.get('auto', False):
                 fillable_fields.append(field)
             
@@ -374,7 +375,7 @@ class {{ model_name }}Controller
         required_fields = []
         optional_fields = []
         
-        for field in model_data.get('fields', []):
+        for field in normalize_fields(model_data.get('fields')):
             if field.get('auto'):
                 continue
                 
@@ -583,7 +584,7 @@ CREATE UNIQUE INDEX idx_{{ table_name }}_{{ field.name }} ON {{ table_name }}({{
         unique_fields = []
         has_timestamps = False
         
-        for field in model_data.get('fields', []):
+        for field in normalize_fields(model_data.get('fields')):
             if field.get('auto') and field['name'] in ['created_at', 'updated_at']:
                 has_timestamps = True
                 continue
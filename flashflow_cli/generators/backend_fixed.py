@@ -5,10 +5,12 @@ Backend Generator - Generates Laravel/PHP backend code
 import os
 import json
 from pathlib import Path
-from typing import Dict, Any
+from typing import Dict, Any, List
 from jinja2 import Template
 
 from ..core import FlashFlowProject, FlashFlowIR
+from .base import normalize_fields, write_if_changed
+from .scheduler import BuildTask
 
 
 class BackendGenerator:
@@ -23,14 +25,51 @@ class BackendGenerator:
     def generate(self):
         """Generate complete backend"""
         
+        for task in self.tasks():
+            task.run()
+    
+    def tasks(self) -> List[BuildTask]:
+        """Build tasks for this generator: setup, shared files, then one per dirty model"""
+        
+        tasks = [
+            BuildTask("backend:setup", self._generate_setup, category="backend"),
+            BuildTask("backend:shared", self._generate_shared, ("backend:setup",), "backend"),
+        ]
+        for model_name, model_data in self.ir.models.items():
+            model_file, controller_file = self._model_outputs(model_name)
+            if self._is_clean('models', model_name, model_file) and controller_file.exists():
+                continue
+            tasks.append(BuildTask(
+                f"backend:model:{model_name}",
+                lambda model_name=model_name, model_data=model_data: self._generate_model_files(model_name, model_data),
+                ("backend:setup",),
+                "backend"
+            ))
+        return tasks
+    
+    def _generate_setup(self):
+        """Create the directory tree and drop outputs of removed models"""
+        
         # Create backend directory structure
         self._create_directory_structure()
         
-        # Generate models
-        self._generate_models()
+        # Drop outputs of models removed since the last generation
+        for model_name in self.ir.removed('models'):
+            for output in self._model_outputs(model_name):
+                if output.exists():
+                    output.unlink()
+    
+    def _generate_model_files(self, model_name: str, model_data: Dict):
+        """Generate the model and REST controller owned by one model"""
         
-        # Generate controllers
-        self._generate_controllers()
+        self._generate_single_model(model_name, model_data)
+        self._generate_model_controller(model_name, model_data)
+    
+    def _generate_shared(self):
+        """Generate files shared by all models"""
+        
+        # Generate controllers for custom endpoints
+        self._generate_custom_controllers()
         
         # Generate routes
         self._generate_routes()
@@ -84,11 +123,20 @@ class BackendGenerator:
         for dir_path in dirs:
             dir_path.mkdir(parents=True, exist_ok=True)
     
+    def _is_clean(self, section: str, key: str, output: Path) -> bool:
+        """Entity unchanged since the last generation and its output still on disk"""
+        return not self.ir.is_dirty(section, key) and output.exists()
+    
+    def _model_outputs(self, model_name: str):
+        return (self.backend_path / "app" / "Models" / f"{model_name}.php",
+                self.backend_path / "app" / "Http" / "Controllers" / f"{model_name}Controller.php")
+    
     def _generate_models(self):
         """Generate Eloquent models"""
         
         for model_name, model_data in self.ir.models.items():
-            self._generate_single_model(model_name, model_data)
+            if not self._is_clean('models', model_name, self._model_outputs(model_name)[0]):
+                self._generate_single_model(model_name, model_data)
     
     def _generate_single_model(self, model_name: str, model_data: Dict):
         """Generate a single Eloquent model"""
@@ -141,7 +189,7 @@ class {{ model_name }} extends Model
         timestamps = False
         methods = model_data.get('methods', [])
         
-        for field in model_data.get('fields', []):
+        for field in normalize_fields(model_data.get('fields')):
             if not field.get('auto', False):
                 fillable_fields.append(field)
             
@@ -166,16 +214,16 @@ class {{ model_name }} extends Model
             methods=methods
         )
         
-        model_file = self.backend_path / "app" / "Models" / f"{model_name}.php"
-        with open(model_file, 'w') as f:
-            f.write(model_content)
+        model_file = self._model_outputs(model_name)[0]
+        write_if_changed(model_file, model_content)
     
     def _generate_controllers(self):
         """Generate API controllers"""
         
-        # Generate a controller for each model
+        # Generate a controller for each changed model
         for model_name, model_data in self.ir.models.items():
-            self._generate_model_controller(model_name, model_data)
+            if not self._is_clean('models', model_name, self._model_outputs(model_name)[1]):
+                self._generate_model_controller(model_name, model_data)
         
         # Generate controllers for custom endpoints
         self._generate_custom_controllers()
@@ -241,9 +289,8 @@ class {{ model_name }}Controller
             model_var=model_name.lower()
         )
         
-        controller_file = self.backend_path / "app" / "Http" / "Controllers" / f"{model_name}Controller.php"
-        with open(controller_file, 'w') as f:
-            f.write(controller_content)
+        controller_file = self._model_outputs(model_name)[1]
+        write_if_changed(controller_file, controller_content)
     
     def _generate_custom_controllers(self):
         """Generate controllers for custom endpoints"""
@@ -283,8 +330,7 @@ use App\\Http\\Controllers;
         routes_content += "\n"
         
         routes_file = self.backend_path / "routes" / "api.php"
-        with open(routes_file, 'w') as f:
-            f.write(routes_content)
+        write_if_changed(routes_file, routes_content)
     
     def _generate_migrations(self):
         """Generate database migrations"""
@@ -394,8 +440,7 @@ redis_port = 6379
 """
         
         config_path = franklinphp_dir / "franklinphp.conf"
-        with open(config_path, 'w') as f:
-            f.write(franklinphp_config)
+        write_if_changed(config_path, franklinphp_config)
         
         # Create FranklinPHP Dockerfile with GoFastHTTP support
         dockerfile_content = """# FranklinPHP Dockerfile for Laravel
@@ -450,5 +495,4 @@ CMD ["franklinphp", "server:start", "--listen", ":8000", "--gofasthttp"]
 """
         
         dockerfile_path = self.backend_path / "Dockerfile.franklinphp"
-        with open(dockerfile_path, 'w') as f:
-            f.write(dockerfile_content)
\ No newline at end of file
+        write_if_changed(dockerfile_path, dockerfile_content)
\ No newline at end of file
@@ -2,8 +2,11 @@
 Base Generator for FlashFlow
 """
 
+import threading
+from concurrent.futures import ThreadPoolExecutor
+from contextlib import contextmanager
 from pathlib import Path
-from typing import Dict, Any
+from typing import Dict, Any, List, Optional, Tuple
 
 
 class BaseGenerator:
@@ -27,4 +30,97 @@ class BaseGenerator:
         Args:
             ir: Intermediate representation of the application
         """
-        raise NotImplementedError("Subclasses must implement generate method")
\ No newline at end of file
+        raise NotImplementedError("Subclasses must implement generate method")
+
+
+def normalize_fields(fields: Any) -> List[Dict[str, Any]]:
+    """
+    Field definitions as a list of dicts that each carry a 'name'.
+    
+    The parser keeps fields as written in the .flow file, usually a mapping
+    ({title: string} or {title: {type: string, required: true}}); form
+    components may instead list field names or dicts with a 'name'.
+    
+    Args:
+        fields: A mapping of name to type or definition, or a list of names or definitions
+        
+    Returns:
+        One dict per field, in definition order
+    """
+    if isinstance(fields, dict):
+        return [{'name': name, **(spec if isinstance(spec, dict) else {'type': spec} if spec else {})}
+                for name, spec in fields.items()]
+    return [{'name': field} if isinstance(field, str) else dict(field) for field in fields or []]
+
+
+class WriteBatch:
+    """Generated files collected in memory and written together by flush()"""
+    
+    _active: Optional['WriteBatch'] = None
+    
+    def __init__(self):
+        self._files: Dict[Path, bytes] = {}
+        self._lock = threading.Lock()
+    
+    @classmethod
+    @contextmanager
+    def activate(cls, batch: Optional['WriteBatch']):
+        """Route write_if_changed into batch (None leaves writes direct) while the block runs"""
+        previous, cls._active = cls._active, batch
+        try:
+            yield batch
+        finally:
+            cls._active = previous
+    
+    def add(self, path: Path, data: bytes):
+        """Queue a file; a later add for the same path replaces it"""
+        with self._lock:
+            self._files[Path(path)] = data
+    
+    def flush(self, workers: int = 1) -> Tuple[int, int]:
+        """Write queued files, skipping unchanged ones; returns (written, unchanged)"""
+        with self._lock:
+            files, self._files = self._files, {}
+        
+        with ThreadPoolExecutor(max_workers=max(1, workers)) as pool:
+            results = list(pool.map(lambda item: _write_bytes_if_changed(*item), files.items()))
+        written = sum(results)
+        return written, len(results) - written
+
+
+def _write_bytes_if_changed(path: Path, data: bytes) -> bool:
+    try:
+        if path.stat().st_size == len(data) and path.read_bytes() == data:
+            return False
+    except FileNotFoundError:
+        path.parent.mkdir(parents=True, exist_ok=True)
+    
+    path.write_bytes(data)
+    return True
+
+
+def write_if_changed(path: Path, content: str, encoding: str = 'utf-8') -> bool:
+    """
+    Write a generated file only when its bytes differ from what is on disk.
+    
+    Leaving unchanged outputs untouched keeps their mtimes, so dev servers and
+    bundlers watching dist/ don't rebuild for files that didn't change.
+    
+    Args:
+        path: File to write
+        content: Generated text
+        encoding: Text encoding
+        
+    Inside WriteBatch.activate() the file is queued for the batch instead.
+    
+    Returns:
+        True if the file was written (or queued)
+    """
+    path = Path(path)
+    data = content.encode(encoding)
+    batch = WriteBatch._active
+    if batch is not None:
+        batch.add(path, data)
+        return True
+    
+    return _write_bytes_if_changed(path, data)
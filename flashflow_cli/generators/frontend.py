@@ -6,10 +6,12 @@ import os
 import json
 import re
 from pathlib import Path
-from typing import Dict, Any
+from typing import Dict, Any, List
 from jinja2 import Template
 
 from ..core import FlashFlowProject, FlashFlowIR
+from .base import write_if_changed
+from .scheduler import BuildTask
 from flashflow_cli.components.slider import SliderComponent
 from flashflow_cli.components.animations import AnimationUtils
 from flashflow_cli.components.micro_interactions import MicroInteractions
@@ -31,12 +33,40 @@ class FrontendGenerator:
     def generate(self):
         """Generate complete frontend"""
 
+        for task in self.tasks():
+            task.run()
+
+    def tasks(self) -> List[BuildTask]:
+        """Build tasks for this generator: setup, shared files, then one per dirty page"""
+
+        tasks = [
+            BuildTask("frontend:setup", self._generate_setup, category="frontend"),
+            BuildTask("frontend:shared", self._generate_shared, ("frontend:setup",), "frontend"),
+        ]
+        for page_path, page_data in self._pages_to_generate():
+            tasks.append(BuildTask(
+                f"frontend:page:{page_path}",
+                lambda page_path=page_path, page_data=page_data: self._generate_single_page(page_path, page_data),
+                ("frontend:setup",),
+                "frontend"
+            ))
+        return tasks
+
+    def _generate_setup(self):
+        """Create the directory tree and package config every other task writes into"""
+
         # Create frontend directory structure
         self._create_directory_structure()
 
+        # Drop page components no current page writes any more
+        self._remove_stale_pages()
+
         # Generate package.json and configs
         self._generate_package_config()
 
+    def _generate_shared(self):
+        """Generate files shared by all pages"""
+
         # Generate main app files
         self._generate_app_files()
 
@@ -70,9 +100,6 @@ class FrontendGenerator:
         # Generate UX helper components
         self._generate_ux_helper_components()
 
-        # Generate pages
-        self._generate_pages()
-
         # Generate PWA configuration
         self._generate_pwa_config()
 
@@ -130,8 +157,7 @@ class FrontendGenerator:
             }
         }
 
-        with open(self.frontend_path / "package.json", 'w', encoding='utf-8') as f:
-            json.dump(package_json, f, indent=2)
+        write_if_changed(self.frontend_path / "package.json", json.dumps(package_json, indent=2))
 
     def _generate_app_files(self):
         """Generate main application files"""
@@ -192,8 +218,7 @@ class FrontendGenerator:
             theme_color=self.ir.theme.get('colors', {}).get('primary', '#3B82F6')
         )
 
-        with open(self.frontend_path / "index.html", 'w', encoding='utf-8') as f:
-            f.write(index_html)
+        write_if_changed(self.frontend_path / "index.html", index_html)
 
         # main.tsx
         main_tsx = """import React from 'react'
@@ -208,8 +233,7 @@ ReactDOM.createRoot(document.getElementById('root')!).render(
 )
 """
 
-        with open(self.frontend_path / "src" / "main.tsx", 'w', encoding='utf-8') as f:
-            f.write(main_tsx)
+        write_if_changed(self.frontend_path / "src" / "main.tsx", main_tsx)
 
         # App.tsx
         app_tsx = Template("""import React from 'react'
@@ -243,8 +267,7 @@ export default App
             }
         )
 
-        with open(self.frontend_path / "src" / "App.tsx", 'w', encoding='utf-8') as f:
-            f.write(app_tsx)
+        write_if_changed(self.frontend_path / "src" / "App.tsx", app_tsx)
 
         # Copy icon utility
         self._copy_icon_utils()
@@ -388,8 +411,7 @@ body {{
 }}
 """
 
-        with open(self.frontend_path / "src" / "styles" / "index.css", 'w', encoding='utf-8') as f:
-            f.write(css_content)
+        write_if_changed(self.frontend_path / "src" / "styles" / "index.css", css_content)
 
         # App-specific CSS
         app_css = """.app {
@@ -426,15 +448,69 @@ body {{
 }
 """
 
-        with open(self.frontend_path / "src" / "styles" / "App.css", 'w', encoding='utf-8') as f:
-            f.write(app_css)
+        write_if_changed(self.frontend_path / "src" / "styles" / "App.css", app_css)
 
     def _generate_pages(self):
-        """Generate page components"""
+        """Generate page components for pages changed since the last generation"""
 
-        for page_path, page_data in self.ir.pages.items():
+        for page_path, page_data in self._pages_to_generate():
             self._generate_single_page(page_path, page_data)
 
+    def _pages_to_generate(self):
+        """Pages that changed, use a changed or removed model, or whose output is missing"""
+
+        models = {name.lower() for name in self.ir.changed('models') | self.ir.removed('models')}
+        models |= {f"{name}s" for name in models}
+        return [(page_path, page_data) for page_path, page_data in self.ir.pages.items()
+                if self.ir.is_dirty('pages', page_path)
+                or self._page_models(page_data) & models
+                or not self._page_file(page_path, page_data).exists()]
+
+    def _page_models(self, page_data: Dict) -> set:
+        """Lower-cased model names (or plurals) a page's components read through model or data_source"""
+
+        referenced = set()
+        stack = [page_data.get('body', [])]
+        while stack:
+            node = stack.pop()
+            if isinstance(node, list):
+                stack.extend(node)
+            elif isinstance(node, dict):
+                for key in ('model', 'data_source'):
+                    if isinstance(node.get(key), str):
+                        referenced.add(node[key].lower())
+                stack.extend(value for value in node.values() if isinstance(value, (list, dict)))
+        return referenced
+
+    def _remove_stale_pages(self):
+        """Delete page components left by removed or renamed pages and record the current ones.
+
+        Page file names come from titles, so a removed page's file can't be
+        derived from the IR; the manifest remembers what each build wrote.
+        """
+
+        manifest_path = self.frontend_path / ".flashflow-pages.json"
+        try:
+            previous = json.loads(manifest_path.read_text(encoding='utf-8'))
+        except (FileNotFoundError, ValueError):
+            previous = {}
+
+        current = {page_path: self._page_file(page_path, page_data).name
+                   for page_path, page_data in self.ir.pages.items()}
+        pages_dir = self.frontend_path / "src" / "pages"
+        for file_name in set(previous.values()) - set(current.values()):
+            stale = pages_dir / file_name
+            if stale.exists():
+                stale.unlink()
+
+        write_if_changed(manifest_path, json.dumps(current, indent=2, sort_keys=True))
+
+    def _page_file(self, page_path: str, page_data: Dict) -> Path:
+        """Output file owned by a page"""
+
+        component_name = self._path_to_component_name(page_path, page_data)
+        return self.frontend_path / "src" / "pages" / f"{component_name}.tsx"
+
     def _generate_single_page(self, page_path: str, page_data: Dict):
         """Generate a single page component"""
 
@@ -579,9 +655,8 @@ export default {{ component_name }}
             components=components
         )
 
-        page_file = self.frontend_path / "src" / "pages" / f"{component_name}.tsx"
-        with open(page_file, 'w', encoding='utf-8') as f:
-            f.write(page_content)
+        page_file = self._page_file(page_path, page_data)
+        write_if_changed(page_file, page_content)
 
     def _generate_component_jsx(self, component_def: Dict) -> str:
         """Generate JSX for a component definition"""
@@ -768,8 +843,7 @@ export const {{ model_name.lower() }}Api = {
 export default api
 """).render(models=list(self.ir.models.keys()))
 
-        with open(self.frontend_path / "src" / "services" / "api.ts", 'w', encoding='utf-8') as f:
-            f.write(api_service)
+        write_if_changed(self.frontend_path / "src" / "services" / "api.ts", api_service)
 
         # Generate common hooks
         hooks_content = """import { useState, useEffect } from 'react'
@@ -822,8 +896,7 @@ export const useLocalStorage = (key: string, initialValue: any) => {
 }
 """
 
-        with open(self.frontend_path / "src" / "hooks" / "useApi.ts", 'w', encoding='utf-8') as f:
-            f.write(hooks_content)
+        write_if_changed(self.frontend_path / "src" / "hooks" / "useApi.ts", hooks_content)
 
     def _generate_pwa_config(self):
         """Generate PWA configuration"""
@@ -851,8 +924,7 @@ export const useLocalStorage = (key: string, initialValue: any) => {
             ]
         }
 
-        with open(self.frontend_path / "public" / "manifest.json", 'w', encoding='utf-8') as f:
-            json.dump(manifest, f, indent=2)
+        write_if_changed(self.frontend_path / "public" / "manifest.json", json.dumps(manifest, indent=2))
 
         # Create placeholder icons directory
         icons_dir = self.frontend_path / "public" / "icons"
@@ -884,8 +956,7 @@ self.addEventListener('fetch', (event) => {
 })
 """
 
-        with open(self.frontend_path / "public" / "sw.js", 'w', encoding='utf-8') as f:
-            f.write(sw_content)
+        write_if_changed(self.frontend_path / "public" / "sw.js", sw_content)
 
     def _generate_build_config(self):
         """Generate Vite build configuration"""
@@ -933,8 +1004,7 @@ export default defineConfig({
 })
 """
 
-        with open(self.frontend_path / "vite.config.ts", 'w', encoding='utf-8') as f:
-            f.write(vite_config)
+        write_if_changed(self.frontend_path / "vite.config.ts", vite_config)
 
         # TypeScript config
         ts_config = {
@@ -959,8 +1029,7 @@ export default defineConfig({
             "references": [{"path": "./tsconfig.node.json"}]
         }
 
-        with open(self.frontend_path / "tsconfig.json", 'w', encoding='utf-8') as f:
-            json.dump(ts_config, f, indent=2)
+        write_if_changed(self.frontend_path / "tsconfig.json", json.dumps(ts_config, indent=2))
 
     def _path_to_component_name(self, path: str, page_data: Dict) -> str:
         """Convert page path to React component name"""
@@ -1146,8 +1215,7 @@ export default SocialButtons;
         components_dir.mkdir(parents=True, exist_ok=True)
 
         component_file = components_dir / "SocialButtons.jsx"
-        with open(component_file, 'w', encoding='utf-8') as f:
-            f.write(component_content)
+        write_if_changed(component_file, component_content)
 
         # Generate CSS for social buttons
         css_template = Template(""".social-buttons {
@@ -1227,8 +1295,7 @@ export default SocialButtons;
         css_content = css_template.render()
 
         css_file = components_dir / "SocialButtons.css"
-        with open(css_file, 'w', encoding='utf-8') as f:
-            f.write(css_content)
+        write_if_changed(css_file, css_content)
 
     def _generate_enhanced_auth_pages(self):
         """Generate enhanced authentication pages with social login"""
@@ -1345,8 +1412,7 @@ export default Login;
         pages_dir.mkdir(parents=True, exist_ok=True)
 
         login_file = pages_dir / "Login.jsx"
-        with open(login_file, 'w', encoding='utf-8') as f:
-            f.write(login_content)
+        write_if_changed(login_file, login_content)
 
     def _generate_social_auth_service(self):
         """Generate social authentication service"""
@@ -1449,8 +1515,7 @@ export default new SocialAuthService();
         services_dir.mkdir(parents=True, exist_ok=True)
 
         service_file = services_dir / "socialAuth.js"
-        with open(service_file, 'w', encoding='utf-8') as f:
-            f.write(service_content)
+        write_if_changed(service_file, service_content)
 
         return service_content
 
@@ -1736,8 +1801,7 @@ export default new PushNotificationService();
 
         services_dir = self.frontend_path / "src" / "services"
         service_file = services_dir / "pushNotificationService.js"
-        with open(service_file, 'w', encoding='utf-8') as f:
-            f.write(service_content)
+        write_if_changed(service_file, service_content)
 
         return service_content
 
@@ -1893,8 +1957,7 @@ export default AiChatInterface;
 
         components_dir = self.frontend_path / "src" / "components"
         chat_file = components_dir / "AiChatInterface.jsx"
-        with open(chat_file, 'w', encoding='utf-8') as f:
-            f.write(chat_content)
+        write_if_changed(chat_file, chat_content)
 
         return chat_content
 
@@ -2021,8 +2084,7 @@ export default new AiService();
 
         services_dir = self.frontend_path / "src" / "services"
         service_file = services_dir / "aiService.js"
-        with open(service_file, 'w', encoding='utf-8') as f:
-            f.write(service_content)
+        write_if_changed(service_file, service_content)
 
         return service_content
 
@@ -2326,8 +2388,7 @@ export default PaymentForm;
         components_dir.mkdir(parents=True, exist_ok=True)
 
         payment_form_file = components_dir / "PaymentForm.jsx"
-        with open(payment_form_file, 'w', encoding='utf-8') as f:
-            f.write(payment_form_content)
+        write_if_changed(payment_form_file, payment_form_content)
 
         return payment_form_content
 
@@ -2406,8 +2467,7 @@ export default PaymentMethodSelector;
 
         components_dir = self.frontend_path / "src" / "components"
         selector_file = components_dir / "PaymentMethodSelector.jsx"
-        with open(selector_file, 'w', encoding='utf-8') as f:
-            f.write(selector_content)
+        write_if_changed(selector_file, selector_content)
 
     def _generate_payment_summary_component(self):
         """Generate payment summary component"""
@@ -2501,8 +2561,7 @@ export default PaymentSummary;
 
         components_dir = self.frontend_path / "src" / "components"
         summary_file = components_dir / "PaymentSummary.jsx"
-        with open(summary_file, 'w', encoding='utf-8') as f:
-            f.write(summary_content)
+        write_if_changed(summary_file, summary_content)
 
     def _generate_payment_service(self):
         """Generate payment service for frontend"""
@@ -2741,8 +2800,7 @@ export default new PaymentService();
 
         services_dir = self.frontend_path / "src" / "services"
         service_file = services_dir / "paymentService.js"
-        with open(service_file, 'w', encoding='utf-8') as f:
-            f.write(service_content)
+        write_if_changed(service_file, service_content)
 
         return service_content
 
@@ -2945,8 +3003,7 @@ export default new FileStorageService();
 
         services_dir = self.frontend_path / "src" / "services"
         service_file = services_dir / "fileStorageService.js"
-        with open(service_file, 'w', encoding='utf-8') as f:
-            f.write(service_content)
+        write_if_changed(service_file, service_content)
 
         return service_content
 
@@ -3076,8 +3133,7 @@ export default new AdminService();
 
         services_dir = self.frontend_path / "src" / "services"
         service_file = services_dir / "adminService.js"
-        with open(service_file, 'w', encoding='utf-8') as f:
-            f.write(service_content)
+        write_if_changed(service_file, service_content)
 
         return service_content
 
@@ -3300,8 +3356,7 @@ export default SmartPhoneInput;
 
         components_dir = self.frontend_path / "src" / "components"
         component_file = components_dir / "SmartPhoneInput.jsx"
-        with open(component_file, 'w', encoding='utf-8') as f:
-            f.write(component_content)
+        write_if_changed(component_file, component_content)
 
         # Generate CSS for smart phone input
         css_content = """.smart-phone-input-wrapper {
@@ -3376,8 +3431,7 @@ export default SmartPhoneInput;
 """
 
         css_file = components_dir / "SmartPhoneInput.css"
-        with open(css_file, 'w', encoding='utf-8') as f:
-            f.write(css_content)
+        write_if_changed(css_file, css_content)
 
     def _generate_smart_password_input(self):
         """Generate smart password input with strength meter and breach checking"""
@@ -3572,8 +3626,7 @@ export default SmartPasswordInput;
 
         components_dir = self.frontend_path / "src" / "components"
         component_file = components_dir / "SmartPasswordInput.jsx"
-        with open(component_file, 'w', encoding='utf-8') as f:
-            f.write(component_content)
+        write_if_changed(component_file, component_content)
 
         # Generate CSS for smart password input
         css_content = """.smart-password-input-wrapper {
@@ -3680,8 +3733,7 @@ export default SmartPasswordInput;
 """
 
         css_file = components_dir / "SmartPasswordInput.css"
-        with open(css_file, 'w', encoding='utf-8') as f:
-            f.write(css_content)
+        write_if_changed(css_file, css_content)
 
     def _generate_smart_otp_input(self):
         """Generate smart OTP input with auto-detection and auto-fill"""
@@ -3779,8 +3831,7 @@ export default SmartOtpInput;
 
         components_dir = self.frontend_path / "src" / "components"
         component_file = components_dir / "SmartOtpInput.jsx"
-        with open(component_file, 'w', encoding='utf-8') as f:
-            f.write(component_content)
+        write_if_changed(component_file, component_content)
 
         # Generate CSS for OTP input
         css_content = """.smart-otp-input {
@@ -3817,8 +3868,7 @@ export default SmartOtpInput;
 """
 
         css_file = components_dir / "SmartOtpInput.css"
-        with open(css_file, 'w', encoding='utf-8') as f:
-            f.write(css_content)
+        write_if_changed(css_file, css_content)
 
     def _generate_smart_credit_card_input(self):
         """Generate smart credit card input with auto-formatting and validation"""
@@ -4125,8 +4175,7 @@ export default SmartSearchInput;
 
         components_dir = self.frontend_path / "src" / "components"
         component_file = components_dir / "SmartSearchInput.jsx"
-        with open(component_file, 'w', encoding='utf-8') as f:
-            f.write(component_content)
+        write_if_changed(component_file, component_content)
 
         # Generate CSS for smart search input
         css_content = """.smart-search-input-wrapper {
@@ -4320,8 +4369,7 @@ export default SmartSearchInput;
 """
 
         css_file = components_dir / "SmartSearchInput.css"
-        with open(css_file, 'w', encoding='utf-8') as f:
-            f.write(css_content)
+        write_if_changed(css_file, css_content)
 
     def _generate_smart_address_input(self):
         """Generate smart address input with geocoding and auto-complete"""
@@ -4671,8 +4719,7 @@ export default SmartAddressInput;
 
         components_dir = self.frontend_path / "src" / "components"
         component_file = components_dir / "SmartAddressInput.jsx"
-        with open(component_file, 'w', encoding='utf-8') as f:
-            f.write(component_content)
+        write_if_changed(component_file, component_content)
 
         # Generate CSS for smart address input
         css_content = """.smart-address-input-wrapper {
@@ -4871,8 +4918,7 @@ export default SmartAddressInput;
 """
 
         css_file = components_dir / "SmartAddressInput.css"
-        with open(css_file, 'w', encoding='utf-8') as f:
-            f.write(css_content)
+        write_if_changed(css_file, css_content)
 
 
 
@@ -5011,8 +5057,7 @@ export const useFormState = (initialState = {}) => {
 
         hooks_dir = self.frontend_path / "src" / "hooks"
         hook_file = hooks_dir / "useSmartValidation.js"
-        with open(hook_file, 'w', encoding='utf-8') as f:
-            f.write(hook_content)
+        write_if_changed(hook_file, hook_content)
 
     def _generate_smart_form_service(self):
         """Generate smart form service for API communication"""
@@ -5205,8 +5250,7 @@ export default new SmartFormService();
 
         services_dir = self.frontend_path / "src" / "services"
         service_file = services_dir / "smartFormService.js"
-        with open(service_file, 'w', encoding='utf-8') as f:
-            f.write(service_content)
+        write_if_changed(service_file, service_content)
 
     def _generate_form_utilities(self):
         """Generate utility functions for smart forms"""
@@ -5459,8 +5503,7 @@ export const clearLocalDraft = (formId) => {
 
         utils_dir = self.frontend_path / "src" / "utils"
         utils_file = utils_dir / "formUtils.js"
-        with open(utils_file, 'w', encoding='utf-8') as f:
-            f.write(utils_content)
+        write_if_changed(utils_file, utils_content)
 
     def _generate_smart_form_wrapper(self):
         """Generate smart form wrapper component"""
@@ -5681,8 +5724,7 @@ export default SmartForm;
 
         components_dir = self.frontend_path / "src" / "components"
         component_file = components_dir / "SmartForm.jsx"
-        with open(component_file, 'w', encoding='utf-8') as f:
-            f.write(component_content)
+        write_if_changed(component_file, component_content)
 
         # Generate CSS for smart form
         css_content = """.smart-form-wrapper {
@@ -5796,8 +5838,7 @@ export default SmartForm;
 """
 
         css_file = components_dir / "SmartForm.css"
-        with open(css_file, 'w', encoding='utf-8') as f:
-            f.write(css_content)
+        write_if_changed(css_file, css_content)
 
     def _generate_ux_helper_components(self):
         """Generate UX helper components for better user experience"""
@@ -5982,8 +6023,7 @@ export default Tooltip;
 
         components_dir = self.frontend_path / "src" / "components"
         component_file = components_dir / "Tooltip.jsx"
-        with open(component_file, 'w', encoding='utf-8') as f:
-            f.write(component_content)
+        write_if_changed(component_file, component_content)
 
         # Generate CSS for tooltip
         css_content = """.tooltip {
@@ -6062,8 +6102,7 @@ export default Tooltip;
 """
 
         css_file = components_dir / "Tooltip.css"
-        with open(css_file, 'w', encoding='utf-8') as f:
-            f.write(css_content)
+        write_if_changed(css_file, css_content)
 
     def _generate_progressive_disclosure_component(self):
         """Generate progressive disclosure component for advanced form fields"""
@@ -6123,8 +6162,7 @@ export default ProgressiveDisclosure;
         components_dir.mkdir(parents=True, exist_ok=True)
         
         component_file = components_dir / "ProgressiveDisclosure.jsx"
-        with open(component_file, 'w', encoding='utf-8') as f:
-            f.write(component_content)
+        write_if_changed(component_file, component_content)
 
         # Generate CSS for progressive disclosure
         css_content = """.progressive-disclosure {
@@ -6259,8 +6297,7 @@ export default ProgressiveDisclosure;
 """
 
         css_file = components_dir / "ProgressiveDisclosure.css"
-        with open(css_file, 'w', encoding='utf-8') as f:
-            f.write(css_content)
+        write_if_changed(css_file, css_content)
 
     def _generate_session_timeout_component(self):
         """Generate session timeout warning component"""
@@ -6340,8 +6377,7 @@ export default SessionTimeout;
         components_dir.mkdir(parents=True, exist_ok=True)
         
         component_file = components_dir / "SessionTimeout.jsx"
-        with open(component_file, 'w', encoding='utf-8') as f:
-            f.write(component_content)
+        write_if_changed(component_file, component_content)
 
     def _generate_quick_login_component(self):
         """Generate quick login component for authentication"""
@@ -6414,8 +6450,7 @@ export default QuickLogin;
         components_dir.mkdir(parents=True, exist_ok=True)
         
         component_file = components_dir / "QuickLogin.jsx"
-        with open(component_file, 'w', encoding='utf-8') as f:
-            f.write(component_content)
+        write_if_changed(component_file, component_content)
 
         # Generate CSS for quick login
         css_content = """.quick-login {
@@ -6502,8 +6537,7 @@ export default QuickLogin;
 """
 
         css_file = components_dir / "QuickLogin.css"
-        with open(css_file, 'w', encoding='utf-8') as f:
-            f.write(css_content)
+        write_if_changed(css_file, css_content)
 
     def _generate_help_panel_component(self):
         """Generate help panel component for contextual assistance"""
@@ -6577,8 +6611,7 @@ export default HelpPanel;
         components_dir.mkdir(parents=True, exist_ok=True)
         
         component_file = components_dir / "HelpPanel.jsx"
-        with open(component_file, 'w', encoding='utf-8') as f:
-            f.write(component_content)
+        write_if_changed(component_file, component_content)
 
         # Generate CSS for help panel
         css_content = """.help-panel {
@@ -6738,8 +6771,7 @@ export default HelpPanel;
 """
 
         css_file = components_dir / "HelpPanel.css"
-        with open(css_file, 'w', encoding='utf-8') as f:
-            f.write(css_content)
+        write_if_changed(css_file, css_content)
 
     def _generate_micro_interactions(self):
         """Generate micro-interactions components"""
@@ -6763,8 +6795,7 @@ export default HelpPanel;
         styles_dir.mkdir(parents=True, exist_ok=True)
         
         css_file = styles_dir / "micro-interactions.css"
-        with open(css_file, 'w', encoding='utf-8') as f:
-            f.write(css_content)
+        write_if_changed(css_file, css_content)
             
     def _generate_micro_interactions_js(self):
         """Generate JavaScript for micro-interactions"""
@@ -6776,8 +6807,7 @@ export default HelpPanel;
         utils_dir.mkdir(parents=True, exist_ok=True)
         
         js_file = utils_dir / "micro-interactions.js"
-        with open(js_file, 'w', encoding='utf-8') as f:
-            f.write(js_content)
+        write_if_changed(js_file, js_content)
 
     def _generate_page_loading_component(self):
         """Generate page loading animation component"""
@@ -6794,8 +6824,7 @@ export default HelpPanel;
         components_dir.mkdir(parents=True, exist_ok=True)
         
         loading_file = components_dir / "PageLoading.html"
-        with open(loading_file, 'w', encoding='utf-8') as f:
-            f.write(page_loading_html)
+        write_if_changed(loading_file, page_loading_html)
 
     def _generate_serverless_components(self):
         """Generate serverless components"""
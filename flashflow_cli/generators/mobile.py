@@ -9,6 +9,7 @@ from typing import Dict, Any
 from jinja2 import Template
 
 from ..core import FlashFlowProject, FlashFlowIR
+from .base import normalize_fields
 
 class MobileGenerator:
     """Generates mobile app code from FlashFlow IR"""
@@ -373,10 +374,9 @@ class {{ view_class }}:
         ])'''
         
         elif component_type == 'form':
-            fields = component_def.get('fields', [])
             field_controls = []
             
-            for field in fields:
+            for field in normalize_fields(component_def.get('fields')):
                 field_name = field.get('name', 'field')
                 field_type = field.get('type', 'text')
                 placeholder = field.get('placeholder', '')
@@ -0,0 +1,194 @@
+"""
+Build Scheduler for FlashFlow generators
+Runs (generator, entity) tasks as a dependency graph on a bounded worker pool
+"""
+
+import json
+import os
+import threading
+import time
+from concurrent.futures import ThreadPoolExecutor, FIRST_COMPLETED, wait
+from dataclasses import dataclass, field
+from pathlib import Path
+from typing import Any, Callable, Dict, List, Optional, Tuple
+
+from .base import WriteBatch
+from flashflow_cli.services import tracing
+
+
+@dataclass
+class BuildTask:
+    """One unit of generation work, e.g. ('frontend:page:/home', render that page)"""
+    name: str
+    run: Callable[[], Any]
+    deps: Tuple[str, ...] = ()
+    category: str = ""
+
+
+@dataclass
+class TaskResult:
+    """Outcome and timing of one task"""
+    name: str
+    category: str
+    status: str = "pending"  # ok, failed, skipped
+    error: Optional[BaseException] = None
+    start: float = 0.0
+    duration: float = 0.0
+    thread: int = 0
+
+
+class BuildError(Exception):
+    """One or more build tasks failed"""
+
+    def __init__(self, failures: List[TaskResult]):
+        self.failures = failures
+        super().__init__("; ".join(f"{result.name}: {result.error}" for result in failures))
+
+
+class BuildScheduler:
+    """Dependency-ordered parallel execution of generator tasks.
+
+    A task starts once all of its deps have succeeded; dependents of a failed
+    task are skipped. Generated files are collected in a WriteBatch while the
+    tasks run and written in one pass at the end. Template rendering holds
+    the GIL, so the speedup comes mostly from overlapping file I/O and
+    avoiding redundant work; jobs=1 reproduces the serial build.
+    """
+
+    def __init__(self, jobs: Optional[int] = None, trace_path: Optional[Path] = None, batch_writes: bool = True):
+        self.jobs = max(1, jobs or os.cpu_count() or 1)
+        self.trace_path = Path(trace_path) if trace_path else None
+        self.batch_writes = batch_writes
+        self.tasks: Dict[str, BuildTask] = {}
+        self.results: Dict[str, TaskResult] = {}
+        self.write_stats: Tuple[int, int] = (0, 0)  # (written, unchanged) by the last run
+
+    def add(self, task: BuildTask):
+        """Register a task; names must be unique"""
+        if task.name in self.tasks:
+            raise ValueError(f"Duplicate build task: {task.name}")
+        self.tasks[task.name] = task
+
+    def add_task(self, name: str, run: Callable[[], Any], deps: Tuple[str, ...] = (), category: str = ""):
+        """Register a task from its parts"""
+        self.add(BuildTask(name, run, tuple(deps), category))
+
+    def extend(self, tasks: List[BuildTask]):
+        """Register several tasks"""
+        for task in tasks:
+            self.add(task)
+
+    def _validate(self):
+        for task in self.tasks.values():
+            missing = [dep for dep in task.deps if dep not in self.tasks]
+            if missing:
+                raise ValueError(f"Task {task.name} depends on unknown tasks: {missing}")
+
+    def _execute(self, task: BuildTask, result: TaskResult, epoch: float):
+        result.thread = threading.get_ident()
+        started = time.perf_counter()
+        result.start = started - epoch
+        try:
+            with tracing.span(task.name, cat=task.category or "build"):
+                task.run()
+            result.status = "ok"
+        except Exception as e:
+            result.status = "failed"
+            result.error = e
+        finally:
+            result.duration = time.perf_counter() - started
+        return result
+
+    def run(self, raise_on_error: bool = True) -> Dict[str, TaskResult]:
+        """Run every registered task, then flush batched writes and the trace"""
+        self._validate()
+        epoch = time.perf_counter()
+        results = {name: TaskResult(name, task.category) for name, task in self.tasks.items()}
+        remaining = {name: set(task.deps) for name, task in self.tasks.items()}
+        dependents: Dict[str, List[str]] = {name: [] for name in self.tasks}
+        for name, task in self.tasks.items():
+            for dep in task.deps:
+                dependents[dep].append(name)
+
+        batch = WriteBatch() if self.batch_writes else None
+        with ThreadPoolExecutor(max_workers=self.jobs, thread_name_prefix="flashflow-build") as pool, \
+                WriteBatch.activate(batch):
+            running = {}
+            ready = [name for name, deps in remaining.items() if not deps]
+
+            while ready or running:
+                for name in ready:
+                    running[pool.submit(self._execute, self.tasks[name], results[name], epoch)] = name
+                ready = []
+
+                done, _ = wait(running, return_when=FIRST_COMPLETED)
+                for future in done:
+                    name = running.pop(future)
+                    if results[name].status == "ok":
+                        for dependent in dependents[name]:
+                            remaining[dependent].discard(name)
+                            if not remaining[dependent]:
+                                ready.append(dependent)
+                    else:
+                        self._skip_dependents(name, dependents, results)
+
+            if batch is not None:
+                flush_started = time.perf_counter()
+                with tracing.span("write:flush", cat="io") as flush_span:
+                    self.write_stats = batch.flush(self.jobs)
+                    flush_span.set(written=self.write_stats[0], unchanged=self.write_stats[1])
+                flush = TaskResult("write:flush", "io", "ok", None, flush_started - epoch,
+                                   time.perf_counter() - flush_started, threading.get_ident())
+                results[flush.name] = flush
+
+        self.results = results
+        if self.trace_path:
+            self.write_trace()
+
+        failures = [result for result in results.values() if result.status == "failed"]
+        if failures and raise_on_error:
+            raise BuildError(failures)
+        return results
+
+    def _skip_dependents(self, name: str, dependents: Dict[str, List[str]], results: Dict[str, TaskResult]):
+        stack = list(dependents[name])
+        while stack:
+            dependent = stack.pop()
+            if results[dependent].status == "pending":
+                results[dependent].status = "skipped"
+                stack.extend(dependents[dependent])
+
+    def write_trace(self):
+        """Write per-task timings in Chrome trace event format (chrome://tracing, Perfetto)"""
+        threads: Dict[int, int] = {}
+        events = []
+        for result in self.results.values():
+            if result.status == "pending" or result.status == "skipped":
+                continue
+            events.append({
+                "name": result.name,
+                "cat": result.category or "build",
+                "ph": "X",
+                "ts": round(result.start * 1e6, 1),
+                "dur": round(result.duration * 1e6, 1),
+                "pid": os.getpid(),
+                "tid": threads.setdefault(result.thread, len(threads) + 1),
+                "args": {"status": result.status, "error": str(result.error) if result.error else None},
+            })
+
+        self.trace_path.parent.mkdir(parents=True, exist_ok=True)
+        with open(self.trace_path, 'w', encoding='utf-8') as f:
+            json.dump({"traceEvents": events, "displayTimeUnit": "ms"}, f, indent=2)
+
+    def summary(self) -> Dict[str, Any]:
+        """Task counts and the slowest tasks of the last run"""
+        counts: Dict[str, int] = {}
+        for result in self.results.values():
+            counts[result.status] = counts.get(result.status, 0) + 1
+        slowest = sorted(self.results.values(), key=lambda result: result.duration, reverse=True)[:5]
+        return {
+            "counts": counts,
+            "written": self.write_stats[0],
+            "unchanged": self.write_stats[1],
+            "slowest": [(result.name, result.duration) for result in slowest],
+        }
@@ -967,6 +967,9 @@ def create_cron_job():
         for field in required_fields:
             if field not in data:
                 return jsonify({'message': f'Missing required field: {field}'}), 400
+        max_instances = data.get('max_instances', 1)
+        if isinstance(max_instances, bool) or not isinstance(max_instances, int) or max_instances < 1:
+            return jsonify({'message': 'max_instances must be a positive integer'}), 400
         
         # Create a sample job function (in a real app, you'd define actual functions)
         def sample_job():
@@ -979,13 +982,17 @@ def create_cron_job():
             schedule=data['schedule'],
             func=sample_job,
             description=data.get('description', ''),
-            enabled=data.get('enabled', True)
+            enabled=data.get('enabled', True),
+            max_instances=max_instances,
+            misfire_policy=data.get('misfire_policy', 'run_once')
         )
         
         # Get the created job
         job = cron_manager.get_job(job_id)
         
         return jsonify(asdict(job)), 201
+    except ValueError as e:
+        return jsonify({'message': str(e)}), 400
     except Exception as e:
         logger.error(f"Create cron job error: {e}")
         return jsonify({'message': 'Internal server error'}), 500'''
@@ -998,6 +1005,10 @@ def create_cron_job():
 def update_cron_job(job_id):
     try:
         data = request.get_json()
+        if 'max_instances' in data:
+            max_instances = data['max_instances']
+            if isinstance(max_instances, bool) or not isinstance(max_instances, int) or max_instances < 1:
+                return jsonify({'message': 'max_instances must be a positive integer'}), 400
         
         # Update job
         if cron_manager.update_job(job_id, **data):
@@ -1005,6 +1016,8 @@ def update_cron_job(job_id):
             return jsonify(asdict(job))
         else:
             return jsonify({'message': 'Job not found or update failed'}), 404
+    except ValueError as e:
+        return jsonify({'message': str(e)}), 400
     except Exception as e:
         logger.error(f"Update cron job error: {e}")
         return jsonify({'message': 'Internal server error'}), 500'''
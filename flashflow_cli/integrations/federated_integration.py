@@ -134,7 +134,9 @@ def register_federated_routes(app: Flask):
             # Start training round
             round_id = federated_service.start_training_round(
                 model_id=model_id,
-                num_clients=data.get('num_clients', 5)
+                num_clients=data.get('num_clients', 5),
+                algorithm=data.get('algorithm', 'fedavg'),
+                proximal_mu=data.get('proximal_mu', 0.0)
             )
             
             return jsonify({
@@ -149,6 +151,85 @@ def register_federated_routes(app: Flask):
                 "error": str(e)
             }), 500
 
+    
+    @app.route('/api/v1/federated/models/<model_id>/updates', methods=['POST'])
+    def submit_client_update(model_id):
+        """Submit a client update as JSON weights or a binary weights file"""
+        try:
+            if request.mimetype == 'application/octet-stream':
+                # Binary weights file; client_id and num_samples travel in the query string
+                client_id = request.args.get('client_id')
+                weights = request.get_data()
+                metrics = {}
+                num_samples = request.args.get('num_samples', type=int)
+            else:
+                data = request.get_json()
+                client_id = data.get('client_id')
+                weights = data.get('weights')
+                metrics = data.get('metrics', {})
+                num_samples = data.get('num_samples')
+            
+            if not client_id or weights is None:
+                return jsonify({
+                    "success": False,
+                    "error": "Missing required field: client_id or weights"
+                }), 400
+            
+            success = federated_service.submit_client_update(
+                model_id=model_id,
+                client_id=client_id,
+                weights=weights,
+                metrics=metrics,
+                num_samples=num_samples
+            )
+            
+            if success:
+                return jsonify({
+                    "success": True,
+                    "message": "Update submitted successfully"
+                }), 201
+            else:
+                return jsonify({
+                    "success": False,
+                    "error": "Model not found"
+                }), 404
+        except ValueError as e:
+            return jsonify({
+                "success": False,
+                "error": str(e)
+            }), 400
+        except Exception as e:
+            return jsonify({
+                "success": False,
+                "error": str(e)
+            }), 500
+    
+    @app.route('/api/v1/federated/rounds/<round_id>/aggregate', methods=['POST'])
+    def aggregate_round(round_id):
+        """Aggregate a round's client updates into new global weights"""
+        try:
+            data = request.get_json(silent=True) or {}
+            
+            success = federated_service.aggregate_updates(
+                round_id,
+                server_lr=data.get('server_lr', 1.0)
+            )
+            
+            if success:
+                return jsonify({
+                    "success": True,
+                    "message": "Round aggregated successfully"
+                })
+            else:
+                return jsonify({
+                    "success": False,
+                    "error": "Round not found or has no client updates"
+                }), 400
+        except Exception as e:
+            return jsonify({
+                "success": False,
+                "error": str(e)
+            }), 500
 
 def get_federated_dashboard_data() -> Dict[str, Any]:
     """
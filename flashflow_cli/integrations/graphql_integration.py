@@ -33,6 +33,9 @@ class GraphQLIntegration:
             # Create database tables
             self.graphql_manager.create_tables()
             
+            # Index existing rows so search resolvers can use full-text search
+            self.graphql_manager.rebuild_search_index()
+            
             logger.info("GraphQL integration initialized successfully")
             return True
             
@@ -251,8 +254,7 @@ export default GraphQLPlayground;'''
     
     def _generate_graphql_endpoint(self) -> str:
         """Generate main GraphQL endpoint"""
-        return '''from flask import Blueprint, request, jsonify
-from graphql import execute
+        return '''from flask import Blueprint, current_app, request, jsonify
 import json
 
 graphql_bp = Blueprint('graphql', __name__)
@@ -260,24 +262,24 @@ graphql_bp = Blueprint('graphql', __name__)
 @graphql_bp.route('/graphql', methods=['GET', 'POST'])
 def graphql_endpoint():
     try:
-        from flashflow_cli.integrations.graphql_integration import get_graphql_schema
-        schema = get_graphql_schema()
+        from flashflow_cli.integrations.graphql_integration import get_graphql_manager
+        manager = get_graphql_manager()
         
         if request.method == 'GET':
             query = request.args.get('query')
             variables = request.args.get('variables')
+            operation_name = request.args.get('operationName')
         else:
             data = request.get_json()
             query = data.get('query')
             variables = data.get('variables')
+            operation_name = data.get('operationName')
         
-        result = execute(schema, query, variable_values=variables)
-        
-        response_data = {'data': result.data}
-        if result.errors:
-            response_data['errors'] = [str(error) for error in result.errors]
+        if isinstance(variables, str):
+            variables = json.loads(variables) if variables else None
         
-        return jsonify(response_data)
+        # Batched resolvers; the query report (with its SQL) is only returned in debug mode
+        return jsonify(manager.execute(query, variables, operation_name, include_report=current_app.debug))
         
     except Exception as e:
         return jsonify({'error': str(e)}), 500
@@ -341,6 +343,12 @@ def initialize_graphql_integration(models: Dict[str, Any], database_url: str = "
     _integration_instance = GraphQLIntegration()
     return _integration_instance.initialize(models, database_url)
 
+def get_graphql_manager():
+    """Get the GraphQL service manager from global integration"""
+    if _integration_instance:
+        return _integration_instance.graphql_manager
+    return None
+
 def get_graphql_schema():
     """Get GraphQL schema from global integration"""
     if _integration_instance and _integration_instance.graphql_manager:
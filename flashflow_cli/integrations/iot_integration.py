@@ -173,12 +173,42 @@ def register_iot_routes(app: Flask):
                 "error": str(e)
             }), 500
     
+    @app.route('/api/v1/iot/devices/<device_id>/telemetry/batch', methods=['POST'])
+    def record_telemetry_batch(device_id):
+        """Record many telemetry points from device"""
+        try:
+            data = request.get_json()
+            
+            if 'records' not in data:
+                return jsonify({
+                    "success": False,
+                    "error": "Missing required field: records"
+                }), 400
+            
+            count = iot_service.record_telemetry_batch(device_id, data['records'])
+            return jsonify({
+                "success": True,
+                "message": f"{count} telemetry records recorded"
+            })
+        except Exception as e:
+            return jsonify({
+                "success": False,
+                "error": str(e)
+            }), 500
+    
     @app.route('/api/v1/iot/devices/<device_id>/telemetry', methods=['GET'])
     def get_telemetry(device_id):
-        """Get telemetry data for device"""
+        """Get telemetry data for device, optionally in a start/end time range"""
         try:
             limit = int(request.args.get('limit', 100))
-            telemetry = iot_service.get_telemetry(device_id, limit)
+            start = request.args.get('start')
+            end = request.args.get('end')
+            if start or end:
+                fields = request.args.get('fields')
+                telemetry = iot_service.query_telemetry(device_id, start, end,
+                                                        fields.split(',') if fields else None, limit)
+            else:
+                telemetry = iot_service.get_telemetry(device_id, limit)
             
             return jsonify({
                 "success": True,
@@ -687,6 +687,7 @@ def upload_media():
             'media_type': media_file.media_type,
             'width': media_file.width,
             'height': media_file.height,
+            'processing': (media_file.metadata or {}).get('processing'),
             'url': f'/api/media/{media_file.id}'
         })
         
@@ -241,6 +241,12 @@ def register_scientific_routes(app: Flask):
                     "measurement_id": measurement_id
                 }
             }), 201
+        except (TypeError, ValueError) as e:
+            # Unparseable or non-finite values (json accepts NaN and Infinity)
+            return jsonify({
+                "success": False,
+                "error": str(e)
+            }), 400
         except Exception as e:
             return jsonify({
                 "success": False,
@@ -309,13 +315,22 @@ def register_scientific_routes(app: Flask):
         try:
             data = request.get_json()
             
-            if 'measurement_ids' not in data:
+            filters = ['measurement_ids', 'experiment_id', 'instrument_id', 'measurement_type']
+            if not any(field in data for field in filters):
                 return jsonify({
                     "success": False,
-                    "error": "Missing required field: measurement_ids"
+                    "error": "Missing required field: measurement_ids or experiment_id"
                 }), 400
             
-            analysis = scientific_service.analyze_data(data['measurement_ids'])
+            analysis = scientific_service.analyze_data(
+                measurement_ids=data.get('measurement_ids'),
+                experiment_id=data.get('experiment_id'),
+                instrument_id=data.get('instrument_id'),
+                measurement_type=data.get('measurement_type'),
+                start=data.get('start'),
+                end=data.get('end'),
+                window_seconds=data.get('window_seconds')
+            )
             
             return jsonify({
                 "success": True,
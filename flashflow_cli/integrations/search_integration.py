@@ -345,9 +345,10 @@ def search():
         query = request.args.get('q', '')
         page = int(request.args.get('page', 0))
         per_page = int(request.args.get('per_page', 20))
+        cursor = request.args.get('cursor')
         
         # Perform search
-        results, stats = search_manager.search(query=query, page=page, per_page=per_page)
+        results, stats = search_manager.search(query=query, page=page, per_page=per_page, cursor=cursor)
         
         # Convert results to JSON
         results_data = []
@@ -366,7 +367,8 @@ def search():
         stats_data = {
             'total_results': stats.total_results,
             'query_time': stats.query_time,
-            'facets': stats.facets
+            'facets': stats.facets,
+            'next_cursor': stats.next_cursor
         }
         
         return jsonify({
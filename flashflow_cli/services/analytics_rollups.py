@@ -0,0 +1,307 @@
+"""
+Analytics Rollup Services for FlashFlow
+Incremental minute/hour/day aggregates and HyperLogLog user sketches for analytics dashboards
+"""
+
+import hashlib
+import logging
+import math
+import sqlite3
+import struct
+from collections import Counter, defaultdict
+from datetime import datetime, timedelta
+from typing import Any, Dict, Iterable, List, Optional, Sequence, Tuple
+
+logger = logging.getLogger(__name__)
+
+GRANULARITIES = ('minute', 'hour', 'day')
+HLL_PRECISION = 12                      # 4096 registers, ~1.6% standard error
+HLL_REGISTERS = 1 << HLL_PRECISION
+HLL_DENSE, HLL_SPARSE = b'D', b'S'      # Sketch encodings; sparse stores (index, rank) pairs
+HLL_PAIR = struct.Struct('>HB')
+
+ROLLUP_TABLES = '''
+    CREATE TABLE IF NOT EXISTS rollup_events (
+        granularity TEXT, bucket TEXT, event_type TEXT, count INTEGER,
+        PRIMARY KEY (granularity, bucket, event_type)
+    ) WITHOUT ROWID;
+    CREATE TABLE IF NOT EXISTS rollup_page_views (
+        granularity TEXT, bucket TEXT, page_url TEXT, count INTEGER,
+        PRIMARY KEY (granularity, bucket, page_url)
+    ) WITHOUT ROWID;
+    CREATE TABLE IF NOT EXISTS rollup_users (
+        granularity TEXT, bucket TEXT, sketch BLOB,
+        PRIMARY KEY (granularity, bucket)
+    ) WITHOUT ROWID;
+    CREATE TABLE IF NOT EXISTS rollup_conversions (
+        granularity TEXT, bucket TEXT, experiment_id TEXT, count INTEGER, value REAL,
+        PRIMARY KEY (granularity, bucket, experiment_id)
+    ) WITHOUT ROWID;
+    CREATE TABLE IF NOT EXISTS rollup_sessions (
+        granularity TEXT, bucket TEXT, count INTEGER, duration REAL,
+        PRIMARY KEY (granularity, bucket)
+    ) WITHOUT ROWID;
+'''
+
+
+class HyperLogLog:
+    """HyperLogLog distinct counter; sketches of any buckets merge by register-wise max.
+
+    Sketches with few set registers (most minute buckets) are stored sparse,
+    so they cost a few bytes per user instead of 4 KiB.
+    """
+
+    __slots__ = ('registers',)
+
+    def __init__(self, sketch: Optional[bytes] = None):
+        self.registers = bytearray(HLL_REGISTERS)
+        if sketch:
+            self.merge(sketch)
+
+    def add(self, value: str):
+        hashed = int.from_bytes(hashlib.blake2b(value.encode('utf-8'), digest_size=8).digest(), 'big')
+        index = hashed >> (64 - HLL_PRECISION)
+        remainder = hashed & ((1 << (64 - HLL_PRECISION)) - 1)
+        rank = (64 - HLL_PRECISION) - remainder.bit_length() + 1
+        if rank > self.registers[index]:
+            self.registers[index] = rank
+
+    def merge(self, sketch: bytes):
+        """Fold in a sketch produced by to_bytes()"""
+        registers = self.registers
+        if sketch[:1] == HLL_SPARSE:
+            for index, rank in HLL_PAIR.iter_unpack(memoryview(sketch)[1:]):
+                if rank > registers[index]:
+                    registers[index] = rank
+        else:
+            self.registers = bytearray(map(max, registers, memoryview(sketch)[1:]))
+
+    def count(self) -> int:
+        m = HLL_REGISTERS
+        estimate = (0.7213 / (1 + 1.079 / m)) * m * m / sum(2.0 ** -r for r in self.registers)
+        zeros = self.registers.count(0)
+        if estimate <= 2.5 * m and zeros:
+            estimate = m * math.log(m / zeros)  # Linear counting for small cardinalities
+        return int(round(estimate))
+
+    def to_bytes(self) -> bytes:
+        pairs = [(index, rank) for index, rank in enumerate(self.registers) if rank]
+        if len(pairs) * HLL_PAIR.size < HLL_REGISTERS:
+            return HLL_SPARSE + b''.join(HLL_PAIR.pack(index, rank) for index, rank in pairs)
+        return HLL_DENSE + bytes(self.registers)
+
+
+def buckets(timestamp: Any) -> List[Tuple[str, str]]:
+    """(granularity, bucket) keys for a datetime or SQLite timestamp string"""
+    text = timestamp if isinstance(timestamp, str) else str(timestamp)
+    return [('minute', text[:16]), ('hour', text[:13]), ('day', text[:10])]
+
+
+def _bucket(granularity: str, moment: datetime) -> str:
+    return buckets(moment)[GRANULARITIES.index(granularity)][1]
+
+
+def rollup_ranges(start: datetime, end: datetime) -> List[Tuple[str, str, str]]:
+    """Cover [start, end] with the fewest rollup buckets, as (granularity, first, last).
+
+    Whole days are read from day buckets and the ragged edges from hour and
+    then minute buckets, so results are exact to the minute.
+    """
+    start = start.replace(second=0, microsecond=0)
+    end = end.replace(second=0, microsecond=0) + timedelta(minutes=1)  # Exclusive
+    if start >= end:
+        return []
+
+    def ceil_hour(moment):
+        floor = moment.replace(minute=0)
+        return floor if floor == moment else floor + timedelta(hours=1)
+
+    def ceil_day(moment):
+        floor = moment.replace(hour=0, minute=0)
+        return floor if floor == moment else floor + timedelta(days=1)
+
+    ranges = []
+
+    def add(granularity, low, high, step):
+        if low < high:
+            ranges.append((granularity, _bucket(granularity, low), _bucket(granularity, high - step)))
+
+    minute, hour, day = timedelta(minutes=1), timedelta(hours=1), timedelta(days=1)
+    hour_start, hour_end = ceil_hour(start), end.replace(minute=0)
+    if hour_start >= hour_end:
+        add('minute', start, end, minute)
+        return ranges
+
+    add('minute', start, hour_start, minute)
+    day_start, day_end = ceil_day(hour_start), hour_end.replace(hour=0)
+    if day_start >= day_end:
+        add('hour', hour_start, hour_end, hour)
+    else:
+        add('hour', hour_start, day_start, hour)
+        add('day', day_start, day_end, day)
+        add('hour', day_end, hour_end, hour)
+    add('minute', hour_end, end, minute)
+    return ranges
+
+
+class AnalyticsRollups:
+    """Maintains rollup tables inside the caller's transaction and answers range queries from them.
+
+    Row layouts match the INSERT statements in analytics_services: events
+    (id, event_type, user_id, session_id, properties, timestamp, ...), page
+    views (id, user_id, session_id, page_url, referrer, timestamp, duration),
+    conversions (id, user_id, type, value, currency, properties, timestamp,
+    campaign_id, experiment_id) and sessions (start_time, duration).
+    """
+
+    def setup(self, conn: sqlite3.Connection) -> bool:
+        """Create rollup tables; returns True if they were new and need a rebuild"""
+        existed = conn.execute(
+            "SELECT 1 FROM sqlite_master WHERE type='table' AND name='rollup_events'").fetchone()
+        conn.executescript(ROLLUP_TABLES)
+        return existed is None
+
+    def add_events(self, conn: sqlite3.Connection, rows: Sequence[tuple]):
+        counts = Counter()
+        users = defaultdict(set)
+        for row in rows:
+            for key in buckets(row[5]):
+                counts[(*key, row[1])] += 1
+                if row[2] is not None:
+                    users[key].add(str(row[2]))
+
+        conn.executemany('''
+            INSERT INTO rollup_events (granularity, bucket, event_type, count) VALUES (?, ?, ?, ?)
+            ON CONFLICT (granularity, bucket, event_type) DO UPDATE SET count = count + excluded.count
+        ''', [(*key, count) for key, count in counts.items()])
+        self._add_users(conn, users)
+
+    def _add_users(self, conn: sqlite3.Connection, users: Dict[Tuple[str, str], set]):
+        if not users:
+            return
+        updates = []
+        for (granularity, bucket), ids in users.items():
+            stored = conn.execute('SELECT sketch FROM rollup_users WHERE granularity = ? AND bucket = ?',
+                                  (granularity, bucket)).fetchone()
+            sketch = HyperLogLog(stored[0] if stored else None)
+            for user_id in ids:
+                sketch.add(user_id)
+            updates.append((granularity, bucket, sketch.to_bytes()))
+        conn.executemany('INSERT OR REPLACE INTO rollup_users (granularity, bucket, sketch) VALUES (?, ?, ?)',
+                         updates)
+
+    def add_page_views(self, conn: sqlite3.Connection, rows: Sequence[tuple]):
+        counts = Counter()
+        for row in rows:
+            if row[3] is not None:
+                for key in buckets(row[5]):
+                    counts[(*key, row[3])] += 1
+        conn.executemany('''
+            INSERT INTO rollup_page_views (granularity, bucket, page_url, count) VALUES (?, ?, ?, ?)
+            ON CONFLICT (granularity, bucket, page_url) DO UPDATE SET count = count + excluded.count
+        ''', [(*key, count) for key, count in counts.items()])
+
+    def add_conversions(self, conn: sqlite3.Connection, rows: Sequence[tuple]):
+        totals = defaultdict(lambda: [0, 0.0])
+        for row in rows:
+            for key in buckets(row[6]):
+                total = totals[(*key, row[8] or '')]
+                total[0] += 1
+                total[1] += row[3] or 0.0
+        conn.executemany('''
+            INSERT INTO rollup_conversions (granularity, bucket, experiment_id, count, value) VALUES (?, ?, ?, ?, ?)
+            ON CONFLICT (granularity, bucket, experiment_id)
+            DO UPDATE SET count = count + excluded.count, value = value + excluded.value
+        ''', [(*key, count, value) for key, (count, value) in totals.items()])
+
+    def add_sessions(self, conn: sqlite3.Connection, rows: Sequence[tuple]):
+        totals = defaultdict(lambda: [0, 0.0])
+        for start_time, duration in rows:
+            for key in buckets(start_time):
+                total = totals[key]
+                total[0] += 1
+                total[1] += duration or 0.0
+        conn.executemany('''
+            INSERT INTO rollup_sessions (granularity, bucket, count, duration) VALUES (?, ?, ?, ?)
+            ON CONFLICT (granularity, bucket)
+            DO UPDATE SET count = count + excluded.count, duration = duration + excluded.duration
+        ''', [(*key, count, duration) for key, (count, duration) in totals.items()])
+
+    def rebuild(self, conn: sqlite3.Connection, chunk_size: int = 10000):
+        """Recompute every rollup from the raw tables, e.g. for a database that predates them"""
+        for table in ('rollup_events', 'rollup_page_views', 'rollup_users', 'rollup_conversions', 'rollup_sessions'):
+            conn.execute(f'DELETE FROM {table}')
+
+        sources = (
+            ('SELECT id, event_type, user_id, session_id, NULL, timestamp FROM events', self.add_events),
+            ('SELECT id, user_id, session_id, page_url, referrer, timestamp FROM page_views', self.add_page_views),
+            ('SELECT id, user_id, conversion_type, value, currency, NULL, timestamp, campaign_id, experiment_id '
+             'FROM conversions', self.add_conversions),
+            ('SELECT start_time, duration FROM user_sessions', self.add_sessions),
+        )
+        for query, add in sources:
+            cursor = conn.execute(query)
+            while True:
+                rows = cursor.fetchmany(chunk_size)
+                if not rows:
+                    break
+                add(conn, rows)
+        logger.info("Analytics rollups rebuilt from raw tables")
+
+    # Queries
+
+    def _sum(self, conn: sqlite3.Connection, sql: str, ranges: Iterable[Tuple[str, str, str]],
+             params: tuple = ()) -> List[tuple]:
+        rows = []
+        for granularity, first, last in ranges:
+            rows.extend(conn.execute(sql, (granularity, first, last, *params)).fetchall())
+        return rows
+
+    def summary(self, conn: sqlite3.Connection, start: datetime, end: datetime) -> Dict[str, Any]:
+        """Totals and top lists for [start, end] read only from rollups"""
+        ranges = rollup_ranges(start, end)
+        where = 'WHERE granularity = ? AND bucket BETWEEN ? AND ?'
+
+        events = Counter()
+        for event_type, count in self._sum(
+                conn, f'SELECT event_type, SUM(count) FROM rollup_events {where} GROUP BY event_type', ranges):
+            events[event_type] += count
+
+        pages = Counter()
+        for page_url, count in self._sum(
+                conn, f'SELECT page_url, SUM(count) FROM rollup_page_views {where} GROUP BY page_url', ranges):
+            pages[page_url] += count
+
+        users = HyperLogLog()
+        for (sketch,) in self._sum(conn, f'SELECT sketch FROM rollup_users {where}', ranges):
+            users.merge(sketch)
+
+        conversions, revenue = 0, 0.0
+        for count, value in self._sum(conn, f'SELECT SUM(count), SUM(value) FROM rollup_conversions {where}', ranges):
+            conversions += count or 0
+            revenue += value or 0.0
+
+        sessions, duration = 0, 0.0
+        for count, total in self._sum(conn, f'SELECT SUM(count), SUM(duration) FROM rollup_sessions {where}', ranges):
+            sessions += count or 0
+            duration += total or 0.0
+
+        return {
+            'total_events': sum(events.values()),
+            'total_page_views': sum(pages.values()),
+            'unique_users': users.count(),
+            'total_conversions': conversions,
+            'total_revenue': revenue,
+            'total_sessions': sessions,
+            'avg_session_duration': duration / sessions if sessions else 0.0,
+            'popular_pages': [{'url': url, 'count': count} for url, count in pages.most_common(10)],
+            'popular_events': [{'event': event, 'count': count} for event, count in events.most_common(10)],
+        }
+
+    def experiment_conversions(self, conn: sqlite3.Connection, experiment_id: str) -> List[Dict[str, Any]]:
+        """Daily conversion counts and value for one experiment"""
+        rows = conn.execute('''
+            SELECT bucket, count, value FROM rollup_conversions
+            WHERE granularity = 'day' AND experiment_id = ? ORDER BY bucket
+        ''', (experiment_id,)).fetchall()
+        return [{'day': day, 'conversions': count, 'value': round(value, 2)} for day, count, value in rows]
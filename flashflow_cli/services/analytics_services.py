@@ -14,13 +14,35 @@ import sqlite3
 from typing import Dict, Any, List, Optional, Union
 from dataclasses import dataclass, asdict
 from datetime import datetime, timedelta
-from collections import defaultdict, Counter
+from collections import defaultdict, Counter, deque
 import hashlib
 import threading
 import uuid
 
+from .analytics_rollups import AnalyticsRollups
+
 logger = logging.getLogger(__name__)
 
+DEFAULT_BUFFER_CAPACITY = 65536   # Events held in memory before backpressure applies
+DEFAULT_BATCH_SIZE = 1000         # Rows per executemany; reaching it wakes the writer
+DEFAULT_FLUSH_INTERVAL = 1.0      # Seconds between flushes when traffic is light
+
+# Backpressure policies for a full EventRingBuffer
+DROP_OLDEST = "drop_oldest"       # Evict the oldest buffered event (default; tracking never blocks)
+DROP_NEWEST = "drop_newest"       # Reject the incoming event
+BLOCK = "block"                   # Wait for the writer to make room, up to put()'s timeout
+
+EVENT_INSERT = '''
+    INSERT OR IGNORE INTO events
+    (id, event_type, user_id, session_id, properties, timestamp, page_url, referrer, user_agent, ip_address)
+    VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?)
+'''
+PAGE_VIEW_INSERT = '''
+    INSERT OR IGNORE INTO page_views
+    (id, user_id, session_id, page_url, referrer, timestamp, duration)
+    VALUES (?, ?, ?, ?, ?, ?, ?)
+'''
+
 @dataclass
 class Event:
     """Represents a tracked event"""
@@ -98,14 +120,97 @@ class ExperimentVariant:
     conversion_rate: float = 0.0
     revenue: float = 0.0
 
+class EventRingBuffer:
+    """Bounded multi-producer, single-consumer buffer of (table, row) pairs.
+    
+    Producers only hold the lock for an append, and the writer drains a
+    whole batch per acquisition, so tracking calls never wait on SQLite.
+    When full, `policy` decides whether the oldest row is evicted, the new
+    row is rejected, or the producer blocks.
+    """
+    
+    def __init__(self, capacity: int = DEFAULT_BUFFER_CAPACITY, policy: str = DROP_OLDEST,
+                 batch_size: int = DEFAULT_BATCH_SIZE):
+        if policy not in (DROP_OLDEST, DROP_NEWEST, BLOCK):
+            raise ValueError(f"Unknown backpressure policy: {policy}")
+        self.capacity = max(1, capacity)
+        self.policy = policy
+        self.batch_size = max(1, batch_size)
+        self._items = deque()
+        self._lock = threading.Condition(threading.Lock())
+        self.batch_ready = threading.Event()  # Set once batch_size rows are waiting
+        self.enqueued = 0
+        self.dropped = 0
+        self.high_water = 0
+    
+    def __len__(self) -> int:
+        return len(self._items)
+    
+    def put(self, item: Any, timeout: Optional[float] = None) -> bool:
+        """Buffer an item; returns False if it was rejected by backpressure"""
+        with self._lock:
+            if len(self._items) >= self.capacity:
+                if self.policy == DROP_NEWEST:
+                    self.dropped += 1
+                    return False
+                if self.policy == DROP_OLDEST:
+                    self._items.popleft()
+                    self.dropped += 1
+                else:
+                    self.batch_ready.set()
+                    if not self._lock.wait_for(lambda: len(self._items) < self.capacity, timeout):
+                        self.dropped += 1
+                        return False
+            
+            self._items.append(item)
+            self.enqueued += 1
+            depth = len(self._items)
+            if depth > self.high_water:
+                self.high_water = depth
+        
+        if depth >= self.batch_size:
+            self.batch_ready.set()
+        return True
+    
+    def drain(self, max_items: int) -> List[Any]:
+        """Remove and return up to max_items in FIFO order"""
+        with self._lock:
+            count = min(max_items, len(self._items))
+            popleft = self._items.popleft
+            batch = [popleft() for _ in range(count)]
+            if len(self._items) < self.batch_size:
+                self.batch_ready.clear()
+            if count and self.policy == BLOCK:
+                self._lock.notify_all()
+        return batch
+
+
 class AnalyticsEngine:
-    """Main analytics engine for tracking user behavior and business metrics"""
+    """Main analytics engine for tracking user behavior and business metrics
+    
+    Events and page views are buffered in an EventRingBuffer and written by
+    one background thread over a persistent WAL-mode connection, with one
+    executemany per table whenever batch_size rows are waiting or
+    flush_interval has passed.
+    """
     
-    def __init__(self, db_path: str = "analytics.db"):
+    def __init__(self, db_path: str = "analytics.db",
+                 buffer_capacity: int = DEFAULT_BUFFER_CAPACITY,
+                 batch_size: int = DEFAULT_BATCH_SIZE,
+                 flush_interval: float = DEFAULT_FLUSH_INTERVAL,
+                 backpressure: str = DROP_OLDEST):
         self.db_path = db_path
+        self.rollups = AnalyticsRollups()  # Pre-aggregated dashboard tables
         self.setup_database()
-        self.event_queue = []
+        self.batch_size = max(1, batch_size)
+        self.flush_interval = flush_interval
+        self.event_queue = EventRingBuffer(buffer_capacity, backpressure, self.batch_size)
         self.session_cache = {}
+        self._writer_conn = None
+        self._write_lock = threading.Lock()
+        self._pending: List[tuple] = []  # Drained rows whose write failed, retried first
+        self._flush_metrics = {'flushes': 0, 'flushed': 0, 'errors': 0,
+                               'last_latency_ms': 0.0, 'max_latency_ms': 0.0, 'total_latency_ms': 0.0}
         self._flush_thread = None
         self._flush_active = False
         self._start_flush_thread()
@@ -116,6 +221,9 @@ class AnalyticsEngine:
             conn = sqlite3.connect(self.db_path)
             cursor = conn.cursor()
             
+            # WAL lets dashboards read while the event writer appends
+            cursor.execute('PRAGMA journal_mode=WAL')
+            
             # Events table
             cursor.execute('''
                 CREATE TABLE IF NOT EXISTS events (
@@ -202,6 +310,10 @@ class AnalyticsEngine:
                 )
             ''')
             
+            # Rollup tables; backfill them when an existing database predates them
+            if self.rollups.setup(conn):
+                self.rollups.rebuild(conn)
+            
             conn.commit()
             conn.close()
             logger.info("Analytics database initialized")
@@ -236,8 +348,21 @@ class AnalyticsEngine:
                 ip_address=ip_address
             )
             
-            # Add to queue for batch processing
-            self.event_queue.append(event)
+            # Add to the ring buffer for the batched writer
+            if not self.event_queue.put((EVENT_INSERT, (
+                event.id,
+                event.event_type,
+                event.user_id,
+                event.session_id,
+                json.dumps(event.properties),
+                event.timestamp,
+                event.page_url,
+                event.referrer,
+                event.user_agent,
+                event.ip_address
+            ))):
+                logger.debug(f"Event dropped by backpressure: {event_type} - {event_id}")
+                return ""
             
             logger.debug(f"Event tracked: {event_type} - {event_id}")
             return event_id
@@ -256,15 +381,8 @@ class AnalyticsEngine:
         try:
             view_id = str(uuid.uuid4())
             
-            # Store in database
-            conn = sqlite3.connect(self.db_path)
-            cursor = conn.cursor()
-            
-            cursor.execute('''
-                INSERT INTO page_views 
-                (id, user_id, session_id, page_url, referrer, timestamp, duration)
-                VALUES (?, ?, ?, ?, ?, ?, ?)
-            ''', (
+            # Add to the ring buffer for the batched writer
+            if not self.event_queue.put((PAGE_VIEW_INSERT, (
                 view_id,
                 user_id,
                 session_id,
@@ -272,10 +390,9 @@ class AnalyticsEngine:
                 referrer,
                 datetime.now(),
                 duration
-            ))
-            
-            conn.commit()
-            conn.close()
+            ))):
+                logger.debug(f"Page view dropped by backpressure: {page_url} - {view_id}")
+                return ""
             
             logger.debug(f"Page view tracked: {page_url} - {view_id}")
             return view_id
@@ -362,11 +479,7 @@ class AnalyticsEngine:
             conn = sqlite3.connect(self.db_path)
             cursor = conn.cursor()
             
-            cursor.execute('''
-                INSERT INTO conversions 
-                (id, user_id, conversion_type, value, currency, properties, timestamp, campaign_id, experiment_id)
-                VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?)
-            ''', (
+            row = (
                 conversion.id,
                 conversion.user_id,
                 conversion.conversion_type,
@@ -376,7 +489,13 @@ class AnalyticsEngine:
                 conversion.timestamp,
                 conversion.campaign_id,
                 conversion.experiment_id
-            ))
+            )
+            cursor.execute('''
+                INSERT INTO conversions 
+                (id, user_id, conversion_type, value, currency, properties, timestamp, campaign_id, experiment_id)
+                VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?)
+            ''', row)
+            self.rollups.add_conversions(conn, [row])
             
             conn.commit()
             conn.close()
@@ -563,6 +682,7 @@ class AnalyticsEngine:
             ''', (experiment_id,))
             variant_results = cursor.fetchall()
             
+            daily_conversions = self.rollups.experiment_conversions(conn, experiment_id)
             conn.close()
             
             variants_data = []
@@ -584,7 +704,8 @@ class AnalyticsEngine:
                 'start_date': exp_result[5],
                 'end_date': exp_result[6],
                 'metrics': json.loads(exp_result[7]) if exp_result[7] else {},
-                'results': variants_data
+                'results': variants_data,
+                'daily_conversions': daily_conversions
             }
             
         except Exception as e:
@@ -592,84 +713,36 @@ class AnalyticsEngine:
             return {}
     
     def get_analytics_summary(self, days: int = 30) -> Dict[str, Any]:
-        """Get comprehensive analytics summary"""
+        """Get comprehensive analytics summary
+        
+        Read from the minute/hour/day rollups, so the cost depends on the
+        number of buckets in the window rather than the raw row count.
+        Unique users is a HyperLogLog estimate (~1.6% error).
+        """
         try:
-            cutoff = datetime.now() - timedelta(days=days)
-            conn = sqlite3.connect(self.db_path)
-            cursor = conn.cursor()
-            
-            # Total events
-            cursor.execute('''
-                SELECT COUNT(*) FROM events WHERE timestamp > ?
-            ''', (cutoff,))
-            total_events = cursor.fetchone()[0]
-            
-            # Total page views
-            cursor.execute('''
-                SELECT COUNT(*) FROM page_views WHERE timestamp > ?
-            ''', (cutoff,))
-            total_page_views = cursor.fetchone()[0]
-            
-            # Unique users
-            cursor.execute('''
-                SELECT COUNT(DISTINCT user_id) FROM events WHERE timestamp > ? AND user_id IS NOT NULL
-            ''', (cutoff,))
-            unique_users = cursor.fetchone()[0]
-            
-            # Conversions
-            cursor.execute('''
-                SELECT COUNT(*), SUM(value) FROM conversions WHERE timestamp > ?
-            ''', (cutoff,))
-            conv_result = cursor.fetchone()
-            total_conversions = conv_result[0] or 0
-            total_revenue = conv_result[1] or 0.0
-            
-            # Popular pages
-            cursor.execute('''
-                SELECT page_url, COUNT(*) as count 
-                FROM page_views 
-                WHERE timestamp > ? AND page_url IS NOT NULL
-                GROUP BY page_url 
-                ORDER BY count DESC 
-                LIMIT 10
-            ''', (cutoff,))
-            popular_pages = [{'url': row[0], 'count': row[1]} for row in cursor.fetchall()]
-            
-            # Popular events
-            cursor.execute('''
-                SELECT event_type, COUNT(*) as count 
-                FROM events 
-                WHERE timestamp > ?
-                GROUP BY event_type 
-                ORDER BY count DESC 
-                LIMIT 10
-            ''', (cutoff,))
-            popular_events = [{'event': row[0], 'count': row[1]} for row in cursor.fetchall()]
-            
-            # User sessions
-            cursor.execute('''
-                SELECT COUNT(*), AVG(duration) 
-                FROM user_sessions 
-                WHERE start_time > ?
-            ''', (cutoff,))
-            session_result = cursor.fetchone()
-            total_sessions = session_result[0] or 0
-            avg_session_duration = session_result[1] or 0.0
+            # Include events still sitting in the buffer
+            self.flush()
             
+            now = datetime.now()
+            conn = sqlite3.connect(self.db_path)
+            totals = self.rollups.summary(conn, now - timedelta(days=days), now)
             conn.close()
             
+            unique_users = totals['unique_users']
+            total_conversions = totals['total_conversions']
+            
             return {
                 'period_days': days,
-                'total_events': total_events,
-                'total_page_views': total_page_views,
+                'total_events': totals['total_events'],
+                'total_page_views': totals['total_page_views'],
                 'unique_users': unique_users,
-                'total_sessions': total_sessions,
-                'avg_session_duration': round(avg_session_duration, 2),
+                'total_sessions': totals['total_sessions'],
+                'avg_session_duration': round(totals['avg_session_duration'], 2),
                 'total_conversions': total_conversions,
                 'conversion_rate': round((total_conversions / max(unique_users, 1)) * 100, 2) if unique_users > 0 else 0,
-                'total_revenue': round(total_revenue, 2),
-                'popular_pages': popular_pages,
-                'popular_events': popular_events
+                'total_revenue': round(totals['total_revenue'], 2),
+                'popular_pages': totals['popular_pages'],
+                'popular_events': totals['popular_events']
             }
             
         except Exception as e:
@@ -697,6 +770,7 @@ class AnalyticsEngine:
                 json.dumps(session.device_info),
                 json.dumps(session.utm_params)
             ))
+            self.rollups.add_sessions(conn, [(session.start_time, session.duration)])
             
             conn.commit()
             conn.close()
@@ -708,78 +782,107 @@ class AnalyticsEngine:
         """Start background thread for flushing events"""
         if not self._flush_active:
             self._flush_active = True
-            self._flush_thread = threading.Thread(target=self._flush_events, daemon=True)
+            self._flush_thread = threading.Thread(target=self._flush_events, name="analytics-writer", daemon=True)
             self._flush_thread.start()
     
+    def _connection(self) -> sqlite3.Connection:
+        """The writer's persistent connection, opened on first use"""
+        if self._writer_conn is None:
+            conn = sqlite3.connect(self.db_path, check_same_thread=False)
+            conn.execute('PRAGMA journal_mode=WAL')
+            conn.execute('PRAGMA synchronous=NORMAL')
+            self._writer_conn = conn
+        return self._writer_conn
+    
+    def flush(self) -> int:
+        """Write every buffered row now; returns the number of rows written"""
+        written = 0
+        with self._write_lock:
+            while True:
+                batch = self._pending or self.event_queue.drain(self.batch_size)
+                if not batch:
+                    return written
+                self._pending = batch
+                self._write_batch(batch)
+                self._pending = []
+                written += len(batch)
+    
+    def _write_batch(self, batch: List[tuple]):
+        """Insert one drained batch with an executemany per table, in a single transaction"""
+        started = time.perf_counter()
+        by_statement = defaultdict(list)
+        for statement, row in batch:
+            by_statement[statement].append(row)
+        
+        conn = self._connection()
+        try:
+            with conn:
+                for statement, rows in by_statement.items():
+                    conn.executemany(statement, rows)
+                # Rollups commit or roll back together with the rows they count
+                self.rollups.add_events(conn, by_statement.get(EVENT_INSERT, ()))
+                self.rollups.add_page_views(conn, by_statement.get(PAGE_VIEW_INSERT, ()))
+        except Exception:
+            self._flush_metrics['errors'] += 1
+            raise
+        
+        latency_ms = (time.perf_counter() - started) * 1000.0
+        metrics = self._flush_metrics
+        metrics['flushes'] += 1
+        metrics['flushed'] += len(batch)
+        metrics['last_latency_ms'] = latency_ms
+        metrics['max_latency_ms'] = max(metrics['max_latency_ms'], latency_ms)
+        metrics['total_latency_ms'] += latency_ms
+    
     def _flush_events(self):
-        """Background thread to flush events to database"""
+        """Background writer: flush when a batch fills up or flush_interval passes"""
         while self._flush_active:
+            self.event_queue.batch_ready.wait(self.flush_interval)
+            if not self._flush_active:
+                break
             try:
-                if self.event_queue:
-                    # Process events in batches
-                    batch = self.event_queue[:100]
-                    self.event_queue = self.event_queue[100:]
-                    
-                    conn = sqlite3.connect(self.db_path)
-                    cursor = conn.cursor()
-                    
-                    for event in batch:
-                        cursor.execute('''
-                            INSERT INTO events 
-                            (id, event_type, user_id, session_id, properties, timestamp, page_url, referrer, user_agent, ip_address)
-                            VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?)
-                        ''', (
-                            event.id,
-                            event.event_type,
-                            event.user_id,
-                            event.session_id,
-                            json.dumps(event.properties),
-                            event.timestamp,
-                            event.page_url,
-                            event.referrer,
-                            event.user_agent,
-                            event.ip_address
-                        ))
-                    
-                    conn.commit()
-                    conn.close()
-                
-                time.sleep(5)  # Flush every 5 seconds
-                
+                self.flush()
             except Exception as e:
+                # Rows stay in _pending and are retried on the next pass
                 logger.error(f"Failed to flush events: {e}")
-                time.sleep(10)  # Wait longer on error
+                time.sleep(min(10.0, self.flush_interval * 5))
+    
+    def get_metrics(self) -> Dict[str, Any]:
+        """Event buffer and writer metrics"""
+        metrics = self._flush_metrics
+        return {
+            'queue_depth': len(self.event_queue) + len(self._pending),
+            'queue_capacity': self.event_queue.capacity,
+            'queue_high_water': self.event_queue.high_water,
+            'backpressure_policy': self.event_queue.policy,
+            'enqueued': self.event_queue.enqueued,
+            'dropped': self.event_queue.dropped,
+            'flushed': metrics['flushed'],
+            'flushes': metrics['flushes'],
+            'flush_errors': metrics['errors'],
+            'last_flush_latency_ms': round(metrics['last_latency_ms'], 3),
+            'max_flush_latency_ms': round(metrics['max_latency_ms'], 3),
+            'avg_flush_latency_ms': round(metrics['total_latency_ms'] / metrics['flushes'], 3) if metrics['flushes'] else 0.0,
+        }
     
     def shutdown(self):
         """Shutdown analytics engine and flush remaining events"""
         self._flush_active = False
+        self.event_queue.batch_ready.set()
+        if self._flush_thread is not None:
+            self._flush_thread.join()
+            self._flush_thread = None
+        
         # Flush remaining events
-        if self.event_queue:
-            conn = sqlite3.connect(self.db_path)
-            cursor = conn.cursor()
-            
-            for event in self.event_queue:
-                cursor.execute('''
-                    INSERT INTO events 
-                    (id, event_type, user_id, session_id, properties, timestamp, page_url, referrer, user_agent, ip_address)
-                    VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?)
-                ''', (
-                    event.id,
-                    event.event_type,
-                    event.user_id,
-                    event.session_id,
-                    json.dumps(event.properties),
-                    event.timestamp,
-                    event.page_url,
-                    event.referrer,
-                    event.user_agent,
-                    event.ip_address
-                ))
-            
-            conn.commit()
-            conn.close()
-            self.event_queue = []
+        try:
+            self.flush()
+        except Exception as e:
+            logger.error(f"Failed to flush events on shutdown: {e}")
+        
+        if self._writer_conn is not None:
+            self._writer_conn.close()
+            self._writer_conn = None
 
-def create_analytics_engine(db_path: str = "analytics.db") -> AnalyticsEngine:
+def create_analytics_engine(db_path: str = "analytics.db", **options) -> AnalyticsEngine:
     """Factory function to create analytics engine"""
-    return AnalyticsEngine(db_path)
\ No newline at end of file
+    return AnalyticsEngine(db_path, **options)
\ No newline at end of file
@@ -10,16 +10,171 @@ import os
 import json
 import time
 import logging
+import heapq
 import threading
-import schedule
+from concurrent.futures import ThreadPoolExecutor
 from typing import Dict, Any, List, Optional, Callable
 from dataclasses import dataclass, asdict
 from datetime import datetime, timedelta
 import sqlite3
 import secrets
 
+from .analytics_services import EventRingBuffer, BLOCK
+
 logger = logging.getLogger(__name__)
 
+MISFIRE_RUN_ONCE = "run_once"     # A late job runs once, however many fire times it missed
+MISFIRE_SKIP = "skip"             # A job later than misfire_grace_seconds waits for its next fire time
+DEFAULT_WORKERS = 8               # Threads running due jobs
+DEFAULT_MISFIRE_GRACE = 60.0      # Seconds late a job may still start under MISFIRE_SKIP
+DEFAULT_LOG_FLUSH_INTERVAL = 1.0  # Seconds between batched execution log writes
+
+CRON_MACROS = {
+    "@yearly": "0 0 1 1 *",
+    "@annually": "0 0 1 1 *",
+    "@monthly": "0 0 1 * *",
+    "@weekly": "0 0 * * 0",
+    "@daily": "0 0 * * *",
+    "@midnight": "0 0 * * *",
+    "@hourly": "0 * * * *",
+}
+CRON_NAMES = {
+    "jan": 1, "feb": 2, "mar": 3, "apr": 4, "may": 5, "jun": 6,
+    "jul": 7, "aug": 8, "sep": 9, "oct": 10, "nov": 11, "dec": 12,
+    "sun": 0, "mon": 1, "tue": 2, "wed": 3, "thu": 4, "fri": 5, "sat": 6,
+}
+INTERVAL_NAMES = {"every_minute": 60, "every_hour": 3600, "every_day": 86400, "every_week": 604800}
+INTERVAL_UNITS = {"seconds": 1, "minutes": 60, "hours": 3600, "days": 86400}
+
+LOG_UPSERT = '''
+    INSERT OR REPLACE INTO job_execution_logs
+    (id, job_id, started_at, finished_at, status, output, error)
+    VALUES (?, ?, ?, ?, ?, ?, ?)
+'''
+STATS_UPDATE = '''
+    UPDATE cron_jobs
+    SET last_run = ?, next_run = ?, success_count = ?, failure_count = ?, last_error = ?, updated_at = ?
+    WHERE id = ?
+'''
+
+def check_max_instances(value: Any) -> int:
+    """max_instances as a positive int; raises ValueError otherwise"""
+    if isinstance(value, bool) or not isinstance(value, int) or value < 1:
+        raise ValueError(f"max_instances must be a positive integer, got {value!r}")
+    return value
+
+class SystemClock:
+    """Wall-clock and monotonic time read by the scheduler; tests substitute a manual clock"""
+    
+    def now(self) -> datetime:
+        return datetime.now()
+    
+    def monotonic(self) -> float:
+        return time.monotonic()
+
+class IntervalSchedule:
+    """Fires every `seconds`, counted from the previous fire time"""
+    
+    def __init__(self, seconds: float):
+        if seconds <= 0:
+            raise ValueError("Interval must be positive")
+        self.interval = timedelta(seconds=seconds)
+    
+    def next_after(self, after: datetime) -> datetime:
+        return after + self.interval
+
+class CronSchedule:
+    """Five-field cron expression (minute hour day-of-month month day-of-week).
+    
+    Fields accept *, lists, ranges, steps and month/day names; @hourly,
+    @daily and the other macros are expanded. As in cron, a job fires when
+    either day field matches if both are restricted.
+    """
+    
+    FIELDS = ((0, 59), (0, 23), (1, 31), (1, 12), (0, 6))
+    
+    def __init__(self, expression: str):
+        expression = CRON_MACROS.get(expression.strip().lower(), expression)
+        parts = expression.split()
+        if len(parts) != 5:
+            raise ValueError(f"Cron expression needs 5 fields: {expression!r}")
+        
+        parsed = [self._field(part, low, high) for part, (low, high) in zip(parts, self.FIELDS)]
+        self.minutes, self.hours, self.days, self.months, weekdays = parsed
+        self.weekdays = {day % 7 for day in weekdays} if parts[4] != "*" else set(range(7))
+        self.any_day = parts[2] == "*"
+        self.any_weekday = parts[4] == "*"
+        self._minutes = sorted(self.minutes)
+    
+    @staticmethod
+    def _value(text: str, low: int, high: int) -> int:
+        value = CRON_NAMES.get(text.lower()) if not text.isdigit() else int(text)
+        if value is None or not low <= value <= (7 if high == 6 else high):
+            raise ValueError(f"Cron value {text!r} outside {low}-{high}")
+        return value
+    
+    def _field(self, text: str, low: int, high: int) -> set:
+        values = set()
+        for part in text.split(","):
+            part, _, step = part.partition("/")
+            step = int(step) if step else 1
+            if step < 1:
+                raise ValueError(f"Cron step must be positive: {text!r}")
+            if part == "*":
+                start, end = low, high
+            elif "-" in part:
+                start, end = (self._value(bound, low, high) for bound in part.split("-", 1))
+            else:
+                start = self._value(part, low, high)
+                end = high if step > 1 else start
+            values.update(range(start, end + 1, step))
+        return values
+    
+    def _day_matches(self, day: datetime) -> bool:
+        in_month = day.day in self.days
+        in_week = (day.weekday() + 1) % 7 in self.weekdays  # cron counts Sunday as 0
+        if self.any_day:
+            return in_week
+        if self.any_weekday:
+            return in_month
+        return in_month or in_week
+    
+    def next_after(self, after: datetime) -> datetime:
+        """First fire time strictly after `after`"""
+        candidate = after.replace(second=0, microsecond=0) + timedelta(minutes=1)
+        limit = candidate + timedelta(days=366 * 5)
+        while candidate < limit:
+            if candidate.month not in self.months:
+                year, month = divmod(candidate.month, 12)
+                candidate = candidate.replace(year=candidate.year + year, month=month + 1, day=1, hour=0, minute=0)
+                continue
+            if not self._day_matches(candidate):
+                candidate = (candidate + timedelta(days=1)).replace(hour=0, minute=0)
+                continue
+            if candidate.hour not in self.hours:
+                candidate = (candidate + timedelta(hours=1)).replace(minute=0)
+                continue
+            later = [minute for minute in self._minutes if minute >= candidate.minute]
+            if not later:
+                candidate = (candidate + timedelta(hours=1)).replace(minute=0)
+                continue
+            return candidate.replace(minute=later[0])
+        raise ValueError("Cron expression never fires")
+
+def parse_schedule(text: str):
+    """A schedule object with next_after() for a cron expression, macro or every_* interval"""
+    text = text.strip()
+    if text in INTERVAL_NAMES:
+        return IntervalSchedule(INTERVAL_NAMES[text])
+    
+    parts = text.split("_")
+    if len(parts) == 3 and parts[0] == "every" and parts[2] in INTERVAL_UNITS:
+        try:
+            return IntervalSchedule(float(parts[1]) * INTERVAL_UNITS[parts[2]])
+        except ValueError:
+            raise ValueError(f"Unrecognized schedule: {text!r}")
+    return CronSchedule(text)
+
 @dataclass
 class CronJob:
     """Represents a scheduled cron job"""
@@ -33,6 +188,8 @@ class CronJob:
     success_count: int = 0
     failure_count: int = 0
     last_error: Optional[str] = None
+    max_instances: int = 1  # Runs of this job allowed at once; a due run beyond that is skipped
+    misfire_policy: str = MISFIRE_RUN_ONCE
     created_at: datetime = None
     updated_at: datetime = None
     
@@ -54,16 +211,47 @@ class JobExecutionLog:
     error: Optional[str]
 
 class CronJobManager:
-    """Main cron job manager for FlashFlow applications"""
+    """Main cron job manager for FlashFlow applications
     
-    def __init__(self, db_path: str = "cron.db"):
+    Schedules are parsed once when a job is added. The scheduler thread
+    keeps each job's next fire time on a min-heap keyed by monotonic
+    deadline and sleeps until the earliest one, so timing doesn't depend on
+    a polling interval. Due jobs run on a bounded worker pool, so a slow
+    job only holds up its own next run. Execution logs and job stats are
+    queued and written in batches over one connection. Fire times are read
+    from clock (now() and monotonic()); with a manual clock, advance it and
+    call run_pending() instead of waiting on the scheduler thread.
+    """
+    
+    def __init__(self, db_path: str = "cron.db", workers: int = DEFAULT_WORKERS,
+                 misfire_grace: float = DEFAULT_MISFIRE_GRACE,
+                 log_flush_interval: float = DEFAULT_LOG_FLUSH_INTERVAL, clock: Any = None):
         self.db_path = db_path
+        self.clock = clock or SystemClock()
         self.jobs: Dict[str, CronJob] = {}
         self.job_functions: Dict[str, Callable] = {}
         self.running = False
         self.scheduler_thread = None
+        self.workers = max(1, workers)
+        self.misfire_grace = misfire_grace
+        self.log_flush_interval = log_flush_interval
+        self.misfires = 0  # Runs skipped by MISFIRE_SKIP
+        self.overlaps = 0  # Runs skipped by max_instances
+        self._executor: Optional[ThreadPoolExecutor] = None
+        self._wakeup = threading.Condition()
+        self._heap: List[tuple] = []  # (deadline, sequence, job_id, fire_time, generation)
+        self._sequence = 0
+        self._schedules: Dict[str, Any] = {}
+        self._generations: Dict[str, int] = {}  # Bumped on reschedule so stale heap entries are dropped
+        self._active: Dict[str, int] = {}
+        self._writer_conn = None
+        self._log_lock = threading.Lock()
+        self._log_queue = EventRingBuffer(100000, BLOCK, 500)
         self.setup_database()
         self.load_jobs()
+        self._log_active = True
+        self._log_thread = threading.Thread(target=self._flush_logs_loop, daemon=True, name="flashflow-cron-log")
+        self._log_thread.start()
     
     def setup_database(self):
         """Initialize cron database"""
@@ -84,11 +272,20 @@ class CronJobManager:
                     success_count INTEGER DEFAULT 0,
                     failure_count INTEGER DEFAULT 0,
                     last_error TEXT,
+                    max_instances INTEGER DEFAULT 1,
+                    misfire_policy TEXT DEFAULT 'run_once',
                     created_at TIMESTAMP,
                     updated_at TIMESTAMP
                 )
             ''')
             
+            # Databases created before max_instances and misfire_policy were stored
+            columns = {row[1] for row in cursor.execute('PRAGMA table_info(cron_jobs)')}
+            for column, definition in (('max_instances', "INTEGER DEFAULT 1"),
+                                       ('misfire_policy', f"TEXT DEFAULT '{MISFIRE_RUN_ONCE}'")):
+                if column not in columns:
+                    cursor.execute(f'ALTER TABLE cron_jobs ADD COLUMN {column} {definition}')
+            
             # Job execution logs table
             cursor.execute('''
                 CREATE TABLE IF NOT EXISTS job_execution_logs (
@@ -119,7 +316,8 @@ class CronJobManager:
             
             cursor.execute('''
                 SELECT id, name, description, schedule, enabled, last_run, next_run, 
-                       success_count, failure_count, last_error, created_at, updated_at
+                       success_count, failure_count, last_error, created_at, updated_at,
+                       max_instances, misfire_policy
                 FROM cron_jobs
             ''')
             rows = cursor.fetchall()
@@ -139,7 +337,9 @@ class CronJobManager:
                     failure_count=row[8],
                     last_error=row[9],
                     created_at=datetime.fromisoformat(row[10]) if row[10] else None,
-                    updated_at=datetime.fromisoformat(row[11]) if row[11] else None
+                    updated_at=datetime.fromisoformat(row[11]) if row[11] else None,
+                    max_instances=row[12] if row[12] is not None else 1,
+                    misfire_policy=row[13] or MISFIRE_RUN_ONCE
                 )
                 self.jobs[job.id] = job
             
@@ -148,9 +348,14 @@ class CronJobManager:
         except Exception as e:
             logger.error(f"Error loading jobs: {e}")
     
-    def add_job(self, name: str, schedule: str, func: Callable, description: str = "", enabled: bool = True) -> str:
-        """Add a new cron job"""
+    def add_job(self, name: str, schedule: str, func: Callable, description: str = "", enabled: bool = True,
+                max_instances: int = 1, misfire_policy: str = MISFIRE_RUN_ONCE) -> str:
+        """Add a new cron job; raises ValueError for a schedule, policy or max_instances that doesn't parse"""
         try:
+            if misfire_policy not in (MISFIRE_RUN_ONCE, MISFIRE_SKIP):
+                raise ValueError(f"Unknown misfire policy: {misfire_policy}")
+            check_max_instances(max_instances)
+            job_schedule = parse_schedule(schedule)
             job_id = secrets.token_urlsafe(16)
             
             job = CronJob(
@@ -160,7 +365,9 @@ class CronJobManager:
                 schedule=schedule,
                 enabled=enabled,
                 last_run=None,
-                next_run=None
+                next_run=None,
+                max_instances=max_instances,
+                misfire_policy=misfire_policy
             )
             
             # Store job function
@@ -172,8 +379,9 @@ class CronJobManager:
             
             cursor.execute('''
                 INSERT INTO cron_jobs 
-                (id, name, description, schedule, enabled, last_run, next_run, created_at, updated_at)
-                VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?)
+                (id, name, description, schedule, enabled, last_run, next_run, max_instances, misfire_policy,
+                 created_at, updated_at)
+                VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)
             ''', (
                 job.id,
                 job.name,
@@ -182,6 +390,8 @@ class CronJobManager:
                 job.enabled,
                 job.last_run,
                 job.next_run,
+                job.max_instances,
+                job.misfire_policy,
                 job.created_at,
                 job.updated_at
             ))
@@ -191,6 +401,9 @@ class CronJobManager:
             
             # Add to memory
             self.jobs[job_id] = job
+            self._schedules[job_id] = job_schedule
+            if self.running and enabled:
+                self._schedule_job(job)
             
             logger.info(f"Added cron job: {name} with schedule: {schedule}")
             return job_id
@@ -206,8 +419,7 @@ class CronJobManager:
                 return False
             
             # Remove from schedule
-            if self.running:
-                schedule.clear(job_id)
+            self._unschedule(job_id)
             
             # Remove from database
             conn = sqlite3.connect(self.db_path)
@@ -224,6 +436,7 @@ class CronJobManager:
                 del self.jobs[job_id]
             if job_id in self.job_functions:
                 del self.job_functions[job_id]
+            self._schedules.pop(job_id, None)
             
             logger.info(f"Removed cron job: {job_id}")
             return True
@@ -233,12 +446,21 @@ class CronJobManager:
             return False
     
     def update_job(self, job_id: str, **kwargs) -> bool:
-        """Update a cron job"""
+        """Update a cron job; raises ValueError for a schedule, misfire policy or max_instances that doesn't parse"""
+        if job_id not in self.jobs:
+            return False
+        
+        # Parse a new schedule before changing anything
+        schedule = parse_schedule(kwargs['schedule']) if 'schedule' in kwargs else None
+        if kwargs.get('misfire_policy', MISFIRE_RUN_ONCE) not in (MISFIRE_RUN_ONCE, MISFIRE_SKIP):
+            raise ValueError(f"Unknown misfire policy: {kwargs['misfire_policy']}")
+        if 'max_instances' in kwargs:
+            check_max_instances(kwargs['max_instances'])
+        
         try:
-            if job_id not in self.jobs:
-                return False
-            
             job = self.jobs[job_id]
+            if schedule is not None:
+                self._schedules[job_id] = schedule
             
             # Update fields
             if 'name' in kwargs:
@@ -249,6 +471,10 @@ class CronJobManager:
                 job.schedule = kwargs['schedule']
             if 'enabled' in kwargs:
                 job.enabled = kwargs['enabled']
+            if 'max_instances' in kwargs:
+                job.max_instances = kwargs['max_instances']
+            if 'misfire_policy' in kwargs:
+                job.misfire_policy = kwargs['misfire_policy']
             
             job.updated_at = datetime.now()
             
@@ -258,13 +484,16 @@ class CronJobManager:
             
             cursor.execute('''
                 UPDATE cron_jobs 
-                SET name = ?, description = ?, schedule = ?, enabled = ?, updated_at = ?
+                SET name = ?, description = ?, schedule = ?, enabled = ?, max_instances = ?, misfire_policy = ?,
+                    updated_at = ?
                 WHERE id = ?
             ''', (
                 job.name,
                 job.description,
                 job.schedule,
                 job.enabled,
+                job.max_instances,
+                job.misfire_policy,
                 job.updated_at,
                 job.id
             ))
@@ -272,6 +501,12 @@ class CronJobManager:
             conn.commit()
             conn.close()
             
+            if self.running and ('schedule' in kwargs or 'enabled' in kwargs):
+                if job.enabled:
+                    self._schedule_job(job)
+                else:
+                    self._unschedule(job_id)
+            
             logger.info(f"Updated cron job: {job_id}")
             return True
             
@@ -302,6 +537,7 @@ class CronJobManager:
             return
         
         self.running = True
+        self._executor = ThreadPoolExecutor(max_workers=self.workers, thread_name_prefix="flashflow-cron")
         self.scheduler_thread = threading.Thread(target=self._scheduler_loop, daemon=True)
         self.scheduler_thread.start()
         
@@ -313,60 +549,138 @@ class CronJobManager:
         logger.info("Cron job scheduler started")
     
     def stop_scheduler(self):
-        """Stop the cron job scheduler"""
+        """Stop the cron job scheduler, letting running jobs finish"""
         if not self.running:
             logger.warning("Scheduler is not running")
             return
         
-        self.running = False
-        schedule.clear()
+        with self._wakeup:
+            self.running = False
+            self._heap.clear()
+            self._wakeup.notify_all()
         
         if self.scheduler_thread:
             self.scheduler_thread.join(timeout=5)
+        if self._executor:
+            self._executor.shutdown(wait=True)
+            self._executor = None
+        self.flush_logs()
         
         logger.info("Cron job scheduler stopped")
     
     def _scheduler_loop(self):
-        """Main scheduler loop"""
+        """Main scheduler loop: sleep until the earliest deadline, then hand due jobs to the pool"""
         while self.running:
             try:
-                schedule.run_pending()
-                time.sleep(1)
+                with self._wakeup:
+                    while self.running and (not self._heap or self._heap[0][0] > self.clock.monotonic()):
+                        self._wakeup.wait(self._heap[0][0] - self.clock.monotonic() if self._heap else None)
+                    if not self.running:
+                        break
+                self.run_pending()
             except Exception as e:
                 logger.error(f"Error in scheduler loop: {e}")
-                time.sleep(5)  # Wait before retrying
+                time.sleep(1)  # Wait before retrying
+    
+    def run_pending(self) -> int:
+        """Hand every job due by the clock to the worker pool; returns how many were started"""
+        due = []
+        with self._wakeup:
+            now = self.clock.monotonic()
+            while self._heap and self._heap[0][0] <= now:
+                _, _, job_id, fire_time, generation = heapq.heappop(self._heap)
+                if self._generations.get(job_id) != generation:
+                    continue  # Rescheduled or removed since this entry was pushed
+                if self._advance(job_id, fire_time):
+                    due.append(job_id)
+        return sum(self._dispatch(job_id) for job_id in due)
+    
+    def _push(self, job_id: str, fire_time: datetime):
+        """Queue a job's next fire time; caller holds _wakeup"""
+        delay = max(0.0, (fire_time - self.clock.now()).total_seconds())
+        self._sequence += 1
+        heapq.heappush(self._heap, (self.clock.monotonic() + delay, self._sequence, job_id, fire_time,
+                                    self._generations[job_id]))
+        self.jobs[job_id].next_run = fire_time
+        self._wakeup.notify()
+    
+    def _advance(self, job_id: str, fire_time: datetime) -> bool:
+        """Schedule the job's next run and decide whether this one runs; caller holds _wakeup"""
+        job = self.jobs.get(job_id)
+        job_schedule = self._schedules.get(job_id)
+        if job is None or job_schedule is None or not job.enabled:
+            return False
+        
+        now = self.clock.now()
+        next_fire = job_schedule.next_after(fire_time)
+        if next_fire <= now:
+            # Fire times were missed (overload, suspend or clock change); never queue a backlog
+            next_fire = job_schedule.next_after(now)
+        self._push(job_id, next_fire)
+        
+        late = (now - fire_time).total_seconds()
+        if job.misfire_policy == MISFIRE_SKIP and late > self.misfire_grace:
+            logger.warning(f"Job {job.name} skipped: {late:.1f}s past its fire time")
+            self.misfires += 1
+            return False
+        return True
     
     def _schedule_job(self, job: CronJob):
-        """Schedule a job using the schedule library"""
+        """Put a job on the scheduler heap at its next fire time"""
         if not job.enabled:
             return
         
         try:
-            # Parse schedule and create job
-            # This is a simplified implementation - in a real system, you'd parse cron expressions
-            if job.schedule == "every_minute":
-                schedule.every().minute.do(self._execute_job, job.id).tag(job.id)
-            elif job.schedule == "every_hour":
-                schedule.every().hour.do(self._execute_job, job.id).tag(job.id)
-            elif job.schedule == "every_day":
-                schedule.every().day.do(self._execute_job, job.id).tag(job.id)
-            elif job.schedule == "every_week":
-                schedule.every().week.do(self._execute_job, job.id).tag(job.id)
-            elif job.schedule.startswith("every_") and job.schedule.endswith("_minutes"):
-                minutes = int(job.schedule.split("_")[1])
-                schedule.every(minutes).minutes.do(self._execute_job, job.id).tag(job.id)
-            elif job.schedule.startswith("every_") and job.schedule.endswith("_hours"):
-                hours = int(job.schedule.split("_")[1])
-                schedule.every(hours).hours.do(self._execute_job, job.id).tag(job.id)
-            else:
-                # Default to every hour if schedule not recognized
-                schedule.every().hour.do(self._execute_job, job.id).tag(job.id)
+            job_schedule = self._schedules.get(job.id) or parse_schedule(job.schedule)
+            with self._wakeup:
+                self._schedules[job.id] = job_schedule
+                self._generations[job.id] = self._generations.get(job.id, 0) + 1
+                self._push(job.id, job_schedule.next_after(self.clock.now()))
             
             logger.info(f"Scheduled job: {job.name} with schedule: {job.schedule}")
-            
+        
         except Exception as e:
             logger.error(f"Error scheduling job {job.name}: {e}")
     
+    def _unschedule(self, job_id: str):
+        """Drop a job's queued fire time; its heap entry is discarded when popped"""
+        with self._wakeup:
+            self._generations[job_id] = self._generations.get(job_id, 0) + 1
+            if job_id in self.jobs:
+                self.jobs[job_id].next_run = None
+    
+    def _dispatch(self, job_id: str) -> bool:
+        """Submit a due job to the worker pool unless max_instances runs are in progress"""
+        job = self.jobs.get(job_id)
+        executor = self._executor
+        if job is None or executor is None:
+            return False
+        
+        with self._wakeup:
+            active = self._active.get(job_id, 0)
+            if active >= max(1, job.max_instances):
+                logger.info(f"Job {job.name} skipped: {active} run(s) still in progress")
+                self.overlaps += 1
+                return False
+            self._active[job_id] = active + 1
+        
+        try:
+            executor.submit(self._run_job, job_id)
+            return True
+        except RuntimeError:  # Pool shut down by stop_scheduler
+            self._finish_run(job_id)
+            return False
+    
+    def _run_job(self, job_id: str):
+        try:
+            self._execute_job(job_id)
+        finally:
+            self._finish_run(job_id)
+    
+    def _finish_run(self, job_id: str):
+        with self._wakeup:
+            self._active[job_id] = max(0, self._active.get(job_id, 1) - 1)
+
     def _execute_job(self, job_id: str):
         """Execute a scheduled job"""
         if job_id not in self.jobs or job_id not in self.job_functions:
@@ -430,59 +744,82 @@ class CronJobManager:
             self._log_execution(execution_log)
     
     def _log_execution(self, execution_log: JobExecutionLog):
-        """Log job execution to database"""
-        try:
-            conn = sqlite3.connect(self.db_path)
-            cursor = conn.cursor()
-            
-            cursor.execute('''
-                INSERT OR REPLACE INTO job_execution_logs 
-                (id, job_id, started_at, finished_at, status, output, error)
-                VALUES (?, ?, ?, ?, ?, ?, ?)
-            ''', (
-                execution_log.id,
-                execution_log.job_id,
-                execution_log.started_at,
-                execution_log.finished_at,
-                execution_log.status,
-                execution_log.output,
-                execution_log.error
-            ))
-            
-            conn.commit()
-            conn.close()
-            
-        except Exception as e:
-            logger.error(f"Error logging execution: {e}")
+        """Queue a job execution log row for the next batched write"""
+        self._log_queue.put((LOG_UPSERT, (
+            execution_log.id,
+            execution_log.job_id,
+            execution_log.started_at,
+            execution_log.finished_at,
+            execution_log.status,
+            execution_log.output,
+            execution_log.error
+        )))
     
     def _update_job_stats(self, job: CronJob):
-        """Update job statistics in database"""
-        try:
-            conn = sqlite3.connect(self.db_path)
-            cursor = conn.cursor()
-            
-            cursor.execute('''
-                UPDATE cron_jobs 
-                SET last_run = ?, success_count = ?, failure_count = ?, last_error = ?, updated_at = ?
-                WHERE id = ?
-            ''', (
-                job.last_run,
-                job.success_count,
-                job.failure_count,
-                job.last_error,
-                datetime.now(),
-                job.id
-            ))
-            
-            conn.commit()
-            conn.close()
-            
-        except Exception as e:
-            logger.error(f"Error updating job stats: {e}")
+        """Queue a job statistics update for the next batched write"""
+        self._log_queue.put((STATS_UPDATE, (
+            job.last_run,
+            job.next_run,
+            job.success_count,
+            job.failure_count,
+            job.last_error,
+            datetime.now(),
+            job.id
+        )))
     
+    def _writer(self) -> sqlite3.Connection:
+        if self._writer_conn is None:
+            conn = sqlite3.connect(self.db_path, check_same_thread=False)
+            conn.execute('PRAGMA journal_mode=WAL')
+            conn.execute('PRAGMA synchronous=NORMAL')
+            self._writer_conn = conn
+        return self._writer_conn
+    
+    def flush_logs(self) -> int:
+        """Write queued execution logs and job stats in one transaction per batch"""
+        written = 0
+        with self._log_lock:
+            while True:
+                batch = self._log_queue.drain(self._log_queue.batch_size)
+                if not batch:
+                    return written
+                
+                by_statement: Dict[str, List[tuple]] = {}
+                for statement, row in batch:
+                    by_statement.setdefault(statement, []).append(row)
+                try:
+                    conn = self._writer()
+                    with conn:
+                        for statement, rows in by_statement.items():
+                            conn.executemany(statement, rows)
+                    written += len(batch)
+                except Exception as e:
+                    logger.error(f"Error logging execution: {e}")
+    
+    def _flush_logs_loop(self):
+        """Background writer for execution logs and job stats"""
+        while self._log_active:
+            self._log_queue.batch_ready.wait(self.log_flush_interval)
+            if self._log_active:
+                self.flush_logs()
+    
+    def close(self):
+        """Stop the scheduler if running, write pending logs and close the database"""
+        if self.running:
+            self.stop_scheduler()
+        self._log_active = False
+        self._log_queue.batch_ready.set()
+        self._log_thread.join()
+        self.flush_logs()
+        with self._log_lock:
+            if self._writer_conn is not None:
+                self._writer_conn.close()
+                self._writer_conn = None
+
     def get_execution_logs(self, job_id: str = None, limit: int = 100) -> List[JobExecutionLog]:
         """Get execution logs"""
         try:
+            self.flush_logs()
             conn = sqlite3.connect(self.db_path)
             cursor = conn.cursor()
             
@@ -0,0 +1,252 @@
+"""
+Crypto Vault Services for FlashFlow
+AES-256-GCM encryption for records and streams, API-compatible with flashcore.AESVault
+"""
+
+import os
+import hashlib
+import logging
+import struct
+from typing import Any, BinaryIO, List, Optional, Sequence, Union
+
+from cryptography.hazmat.primitives.ciphers import Cipher, algorithms, modes
+from cryptography.hazmat.primitives.ciphers.aead import AESGCM
+
+logger = logging.getLogger(__name__)
+
+KEY_SIZE = 32                    # AES-256
+NONCE_SIZE = 12                  # 96-bit GCM nonce
+TAG_SIZE = 16                    # 128-bit GCM tag
+BLOCK_SIZE = 16                  # update_into needs this much slack minus one
+DEFAULT_CHUNK_SIZE = 1 << 20     # 1 MiB per streamed read
+KDF_ITERATIONS = 200_000         # PBKDF2-SHA256 rounds for passphrase keys
+DEFAULT_SALT = b"flashflow-aesvault"
+
+# Stream layout: STREAM_HEADER (magic, version) | nonce | ciphertext | tag
+STREAM_MAGIC = b"FFAE"
+STREAM_VERSION = 1
+STREAM_HEADER = struct.Struct("<4sB")
+STREAM_HEADER_SIZE = STREAM_HEADER.size + NONCE_SIZE
+
+Buffer = Union[bytes, bytearray, memoryview]
+
+
+class StreamEncryptor:
+    """Incremental AES-GCM encryption; write `header`, every update(), then finalize()'s tag"""
+
+    def __init__(self, key: bytes, associated_data: Optional[bytes] = None):
+        self.nonce = os.urandom(NONCE_SIZE)
+        self.header = STREAM_HEADER.pack(STREAM_MAGIC, STREAM_VERSION) + self.nonce
+        self._context = Cipher(algorithms.AES(key), modes.GCM(self.nonce)).encryptor()
+        if associated_data:
+            self._context.authenticate_additional_data(associated_data)
+
+    def update(self, chunk: Buffer) -> bytes:
+        """Encrypt a chunk, returning new bytes"""
+        return self._context.update(chunk)
+
+    def update_into(self, chunk: Buffer, out: Union[bytearray, memoryview]) -> int:
+        """Encrypt a chunk into a caller-owned buffer of at least len(chunk) + 15 bytes"""
+        return self._context.update_into(chunk, out)
+
+    def finalize(self) -> bytes:
+        """Finish the stream and return the authentication tag"""
+        self._context.finalize()
+        return self._context.tag
+
+
+class StreamDecryptor:
+    """Incremental AES-GCM decryption of a stream produced by StreamEncryptor.
+
+    Plaintext from update() is unauthenticated until finalize(tag) succeeds,
+    so callers must not act on it before then.
+    """
+
+    def __init__(self, key: bytes, header: Buffer, associated_data: Optional[bytes] = None):
+        header = bytes(header[:STREAM_HEADER_SIZE])
+        if len(header) < STREAM_HEADER_SIZE:
+            raise ValueError("Truncated encrypted stream header")
+        magic, version = STREAM_HEADER.unpack_from(header)
+        if magic != STREAM_MAGIC:
+            raise ValueError("Not a FlashFlow encrypted stream")
+        if version != STREAM_VERSION:
+            raise ValueError(f"Unsupported encrypted stream version {version}")
+
+        self.nonce = header[STREAM_HEADER.size:]
+        self._context = Cipher(algorithms.AES(key), modes.GCM(self.nonce)).decryptor()
+        if associated_data:
+            self._context.authenticate_additional_data(associated_data)
+
+    def update(self, chunk: Buffer) -> bytes:
+        """Decrypt a chunk, returning new bytes"""
+        return self._context.update(chunk)
+
+    def update_into(self, chunk: Buffer, out: Union[bytearray, memoryview]) -> int:
+        """Decrypt a chunk into a caller-owned buffer of at least len(chunk) + 15 bytes"""
+        return self._context.update_into(chunk, out)
+
+    def finalize(self, tag: Buffer):
+        """Verify the tag; raises cryptography.exceptions.InvalidTag on tampering"""
+        self._context.finalize_with_tag(bytes(tag))
+
+
+class AESVault:
+    """AES-256-GCM vault.
+
+    encrypt()/decrypt() match flashcore.AESVault for whole records (nonce |
+    ciphertext | tag). encryptor()/decryptor() and the *_stream helpers handle
+    payloads of any size in fixed-size chunks. The cipher runs in OpenSSL,
+    which uses AES-NI / ARMv8 crypto extensions when the CPU has them.
+    """
+
+    def __init__(self, key: Union[str, bytes], salt: bytes = DEFAULT_SALT, iterations: int = KDF_ITERATIONS):
+        """
+        Args:
+            key: 32 raw key bytes, or a passphrase stretched with PBKDF2-SHA256
+            salt: KDF salt for passphrase keys
+            iterations: KDF rounds for passphrase keys
+        """
+        if isinstance(key, (bytes, bytearray)) and len(key) == KEY_SIZE:
+            self._key = bytes(key)
+        else:
+            passphrase = key.encode("utf-8") if isinstance(key, str) else bytes(key)
+            self._key = hashlib.pbkdf2_hmac("sha256", passphrase, salt, iterations, dklen=KEY_SIZE)
+        self._aead = AESGCM(self._key)
+
+    @staticmethod
+    def generate_key() -> bytes:
+        """Random 256-bit key for use as AESVault(key)"""
+        return AESGCM.generate_key(bit_length=KEY_SIZE * 8)
+
+    # Records
+
+    def encrypt(self, plaintext: Buffer, associated_data: Optional[bytes] = None) -> bytes:
+        """Encrypt one record as nonce | ciphertext | tag"""
+        nonce = os.urandom(NONCE_SIZE)
+        return nonce + self._aead.encrypt(nonce, plaintext, associated_data)
+
+    def decrypt(self, ciphertext: Buffer, associated_data: Optional[bytes] = None) -> bytes:
+        """Decrypt one record; raises cryptography.exceptions.InvalidTag on tampering"""
+        view = memoryview(ciphertext)
+        if len(view) < NONCE_SIZE + TAG_SIZE:
+            raise ValueError("Ciphertext is too short")
+        return self._aead.decrypt(view[:NONCE_SIZE], view[NONCE_SIZE:], associated_data)
+
+    def encrypt_many(self, records: Sequence[Buffer], associated_data: Optional[bytes] = None) -> List[bytes]:
+        """Encrypt many small records in one call.
+
+        The key schedule is shared and all nonces come from a single
+        os.urandom() call, so per-record overhead is a single AEAD pass.
+        """
+        nonces = memoryview(os.urandom(NONCE_SIZE * len(records)))
+        encrypt = self._aead.encrypt
+        results = []
+        for i, record in enumerate(records):
+            nonce = bytes(nonces[i * NONCE_SIZE:(i + 1) * NONCE_SIZE])
+            results.append(nonce + encrypt(nonce, record, associated_data))
+        return results
+
+    def decrypt_many(self, records: Sequence[Buffer], associated_data: Optional[bytes] = None) -> List[bytes]:
+        """Decrypt records produced by encrypt() or encrypt_many()"""
+        decrypt = self._aead.decrypt
+        results = []
+        for record in records:
+            view = memoryview(record)
+            results.append(decrypt(view[:NONCE_SIZE], view[NONCE_SIZE:], associated_data))
+        return results
+
+    # Streams
+
+    def encryptor(self, associated_data: Optional[bytes] = None) -> StreamEncryptor:
+        """Start an incremental encryption stream"""
+        return StreamEncryptor(self._key, associated_data)
+
+    def decryptor(self, header: Buffer, associated_data: Optional[bytes] = None) -> StreamDecryptor:
+        """Start decrypting a stream from its header"""
+        return StreamDecryptor(self._key, header, associated_data)
+
+    def encrypt_stream(self, source: BinaryIO, destination: BinaryIO, chunk_size: int = DEFAULT_CHUNK_SIZE,
+                       associated_data: Optional[bytes] = None) -> int:
+        """Encrypt source into destination chunk by chunk, returning plaintext bytes read.
+
+        Two buffers are reused for the whole stream, so memory use is
+        independent of the payload size. GCM limits one stream to ~64 GiB.
+        """
+        encryptor = self.encryptor(associated_data)
+        destination.write(encryptor.header)
+
+        chunk = bytearray(chunk_size)
+        out = bytearray(chunk_size + BLOCK_SIZE - 1)
+        chunk_view, out_view = memoryview(chunk), memoryview(out)
+        total = 0
+        while True:
+            read = source.readinto(chunk)
+            if not read:
+                break
+            written = encryptor.update_into(chunk_view[:read], out)
+            destination.write(out_view[:written])
+            total += read
+
+        destination.write(encryptor.finalize())
+        return total
+
+    def decrypt_stream(self, source: BinaryIO, destination: BinaryIO, chunk_size: int = DEFAULT_CHUNK_SIZE,
+                       associated_data: Optional[bytes] = None) -> int:
+        """Decrypt a seekable source into destination, returning plaintext bytes written.
+
+        The tag is verified after the last chunk; on failure InvalidTag is
+        raised and whatever was written to destination must be discarded.
+        """
+        start = source.tell()
+        end = source.seek(0, os.SEEK_END)
+        if end - start < STREAM_HEADER_SIZE + TAG_SIZE:
+            raise ValueError("Truncated encrypted stream")
+        source.seek(end - TAG_SIZE)
+        tag = source.read(TAG_SIZE)
+        source.seek(start)
+
+        decryptor = self.decryptor(source.read(STREAM_HEADER_SIZE), associated_data)
+        remaining = end - start - STREAM_HEADER_SIZE - TAG_SIZE
+
+        chunk = bytearray(chunk_size)
+        out = bytearray(chunk_size + BLOCK_SIZE - 1)
+        chunk_view, out_view = memoryview(chunk), memoryview(out)
+        total = 0
+        while remaining:
+            read = source.readinto(chunk_view[:min(chunk_size, remaining)])
+            if not read:
+                raise ValueError("Truncated encrypted stream")
+            written = decryptor.update_into(chunk_view[:read], out)
+            destination.write(out_view[:written])
+            remaining -= read
+            total += written
+
+        decryptor.finalize(tag)
+        return total
+
+    def encrypt_file(self, source_path: str, destination_path: str, chunk_size: int = DEFAULT_CHUNK_SIZE) -> int:
+        """Encrypt a file of any size to destination_path"""
+        with open(source_path, "rb") as source, open(destination_path, "wb") as destination:
+            return self.encrypt_stream(source, destination, chunk_size)
+
+    def decrypt_file(self, source_path: str, destination_path: str, chunk_size: int = DEFAULT_CHUNK_SIZE) -> int:
+        """Decrypt a file to destination_path, which only appears once the tag has verified"""
+        temp_path = f"{destination_path}.tmp"
+        try:
+            with open(source_path, "rb") as source, open(temp_path, "wb") as destination:
+                total = self.decrypt_stream(source, destination, chunk_size)
+            os.replace(temp_path, destination_path)
+            return total
+        finally:
+            if os.path.exists(temp_path):
+                os.remove(temp_path)
+
+
+def create_vault(config: Optional[Any]) -> Optional[AESVault]:
+    """Vault from an {'key': ...} config block (or FLASHFLOW_VAULT_KEY), None if unconfigured"""
+    config = config or {}
+    key = config.get("key") or os.environ.get(config.get("key_env", "FLASHFLOW_VAULT_KEY"))
+    if not key:
+        return None
+    salt = config.get("salt", DEFAULT_SALT)
+    return AESVault(key, salt.encode("utf-8") if isinstance(salt, str) else salt)
@@ -0,0 +1,205 @@
+"""
+Federated Aggregation for FlashFlow
+Streams client weight files through memory maps into one weighted-average buffer
+"""
+
+import os
+import json
+import time
+import struct
+import logging
+from concurrent.futures import ThreadPoolExecutor
+from typing import Any, Dict, List, Optional, Sequence, Tuple
+
+logger = logging.getLogger(__name__)
+
+WEIGHTS_MAGIC = b"FFW1"
+WEIGHTS_HEADER = struct.Struct("<4sI")  # magic, JSON header length
+WEIGHTS_ALIGN = 64                      # Tensor data offsets are 64-byte aligned for SIMD loads
+DEFAULT_CHUNK = 1 << 20                 # Elements per aggregation task (4 MiB of float32)
+
+
+def _aligned(offset: int) -> int:
+    return (offset + WEIGHTS_ALIGN - 1) // WEIGHTS_ALIGN * WEIGHTS_ALIGN
+
+
+def _layout(tensors: Dict[str, Tuple[str, Tuple[int, ...]]], meta: Optional[Dict[str, Any]] = None) -> Tuple[bytes, List[Dict[str, Any]], int]:
+    """Header bytes, per-tensor entries and total file size for a weights file"""
+    import numpy as np
+
+    def encode(entries):
+        header = json.dumps({"tensors": entries, "meta": meta or {}}, separators=(",", ":")).encode("utf-8")
+        return header, _aligned(WEIGHTS_HEADER.size + len(header))
+
+    entries = [{"name": name, "dtype": dtype, "shape": list(shape), "offset": 0,
+                "nbytes": int(np.dtype(dtype).itemsize * int(np.prod(shape, dtype=np.int64)))}
+               for name, (dtype, shape) in tensors.items()]
+    # Offsets are part of the header, so lay out until the header length settles
+    data_start = 0
+    while True:
+        offset = data_start
+        for entry in entries:
+            entry["offset"] = offset
+            offset = _aligned(offset + entry["nbytes"])
+        header, needed = encode(entries)
+        if needed <= data_start:
+            return header, entries, offset
+        data_start = needed
+
+
+def read_header(path: str) -> Dict[str, Any]:
+    """The JSON header of a weights file: tensors (name, dtype, shape, offset, nbytes) and meta"""
+    with open(path, "rb") as f:
+        magic, length = WEIGHTS_HEADER.unpack(f.read(WEIGHTS_HEADER.size))
+        if magic != WEIGHTS_MAGIC:
+            raise ValueError(f"{path} is not a FlashFlow weights file")
+        return json.loads(f.read(length))
+
+
+def parse_header(blob) -> Dict[str, Any]:
+    """Validate an in-memory weights file (any bytes-like object) and return its header"""
+    if len(blob) < WEIGHTS_HEADER.size:
+        raise ValueError("Weights blob is truncated")
+    magic, length = WEIGHTS_HEADER.unpack_from(blob)
+    if magic != WEIGHTS_MAGIC:
+        raise ValueError("Weights blob has no FFW1 header")
+    header = json.loads(bytes(blob[WEIGHTS_HEADER.size:WEIGHTS_HEADER.size + length]))
+    for entry in header["tensors"]:
+        if entry["offset"] + entry["nbytes"] > len(blob):
+            raise ValueError(f"Tensor {entry['name']} runs past the end of the blob")
+    return header
+
+
+def _map(path: str, entries: List[Dict[str, Any]], mode: str) -> Tuple[Any, Dict[str, Any]]:
+    """Memory map of a weights file and a view of each tensor in it"""
+    import numpy as np
+
+    if not entries:
+        return None, {}
+    buffer = np.memmap(path, dtype=np.uint8, mode=mode)
+    return buffer, {entry["name"]: buffer[entry["offset"]:entry["offset"] + entry["nbytes"]]
+                    .view(entry["dtype"]).reshape(entry["shape"]) for entry in entries}
+
+
+def create_weights(path: str, tensors: Dict[str, Tuple[str, Tuple[int, ...]]],
+                   meta: Optional[Dict[str, Any]] = None) -> Tuple[Any, Dict[str, Any]]:
+    """Create a zero-filled weights file; returns its memory map and writable tensor views"""
+    header, entries, size = _layout(tensors, meta)
+    with open(path, "wb") as f:
+        f.write(WEIGHTS_HEADER.pack(WEIGHTS_MAGIC, len(header)))
+        f.write(header)
+        f.truncate(size)
+    return _map(path, entries, "r+")
+
+
+def write_weights(path: str, weights: Dict[str, Any], meta: Optional[Dict[str, Any]] = None):
+    """Write named tensors to path atomically"""
+    import numpy as np
+
+    arrays = {name: np.ascontiguousarray(value) for name, value in weights.items()}
+    temp_path = f"{path}.tmp"
+    buffer, views = create_weights(temp_path, {name: (array.dtype.str, array.shape) for name, array in arrays.items()}, meta)
+    for name, view in views.items():
+        view[...] = arrays[name]
+    if buffer is not None:
+        buffer.flush()
+    del buffer, views
+    os.replace(temp_path, path)
+
+
+def read_weights(path: str) -> Dict[str, Any]:
+    """Read-only tensors memory-mapped from a weights file; nothing is copied until used"""
+    return _map(path, read_header(path)["tensors"], "r")[1]
+
+
+class FedAvgAggregator:
+    """Sample-weighted federated averaging over client weight files.
+
+    The output file is created up front and its memory map is the only
+    accumulator, so memory stays at one model however many clients there
+    are; client files are memory-mapped and read a chunk at a time. Work is
+    split into (tensor, chunk) tasks that each loop over every client, so
+    large layers spread across cores and each chunk stays cache-resident
+    while it is summed. NumPy releases the GIL inside these ufuncs.
+    """
+
+    def __init__(self, workers: Optional[int] = None, chunk: int = DEFAULT_CHUNK):
+        self.workers = max(1, workers or os.cpu_count() or 1)
+        self.chunk = max(1024, chunk)
+
+    def _validate(self, headers: List[Dict[str, Any]], paths: Sequence[str]) -> List[Dict[str, Any]]:
+        reference = [(entry["name"], entry["dtype"], entry["shape"]) for entry in headers[0]["tensors"]]
+        for header, path in zip(headers[1:], paths[1:]):
+            tensors = [(entry["name"], entry["dtype"], entry["shape"]) for entry in header["tensors"]]
+            if tensors != reference:
+                raise ValueError(f"Update {path} has different tensors than {paths[0]}")
+        return headers[0]["tensors"]
+
+    def aggregate(self, update_paths: Sequence[str], sample_counts: Sequence[float], output_path: str,
+                  base_path: Optional[str] = None, server_lr: float = 1.0,
+                  meta: Optional[Dict[str, Any]] = None) -> Dict[str, Any]:
+        """Write the weighted average of the updates to output_path.
+
+        With base_path (the previous global model) and server_lr < 1 the
+        result moves only part way from the base towards the average:
+        base + server_lr * (average - base).
+        """
+        import numpy as np
+
+        if not update_paths:
+            raise ValueError("No client updates to aggregate")
+        if len(update_paths) != len(sample_counts):
+            raise ValueError("Need one sample count per update")
+        total = float(sum(sample_counts))
+        if total <= 0:
+            raise ValueError("Sample counts must add up to more than zero")
+
+        started = time.perf_counter()
+        headers = [read_header(path) for path in update_paths]
+        tensors = self._validate(headers, update_paths)
+        for entry in tensors:
+            if np.dtype(entry["dtype"]).kind != "f":
+                raise ValueError(f"Tensor {entry['name']} is {entry['dtype']}; only float tensors can be averaged")
+
+        coefficients = [count / total for count in sample_counts]
+        mix = base_path is not None and server_lr != 1.0
+        if mix:
+            base = read_weights(base_path)
+            coefficients = [coefficient * server_lr for coefficient in coefficients]
+
+        temp_path = f"{output_path}.tmp"
+        buffer, output = create_weights(temp_path, {entry["name"]: (entry["dtype"], tuple(entry["shape"])) for entry in tensors},
+                                {**(meta or {}), "clients": len(update_paths), "samples": total})
+        clients = [read_weights(path) for path in update_paths]
+
+        tasks = []
+        for entry in tensors:
+            size = int(np.prod(entry["shape"], dtype=np.int64))
+            tasks.extend((entry["name"], start, min(size, start + self.chunk)) for start in range(0, size, self.chunk))
+
+        def run(task):
+            name, start, end = task
+            target = output[name].reshape(-1)[start:end]
+            scratch = np.empty_like(target)
+            if mix:
+                np.multiply(base[name].reshape(-1)[start:end], 1.0 - server_lr, out=target)
+            for client, coefficient in zip(clients, coefficients):
+                np.multiply(client[name].reshape(-1)[start:end], coefficient, out=scratch)
+                np.add(target, scratch, out=target)
+
+        if self.workers == 1 or len(tasks) == 1:
+            for task in tasks:
+                run(task)
+        else:
+            with ThreadPoolExecutor(max_workers=self.workers, thread_name_prefix="flashflow-fedavg") as pool:
+                list(pool.map(run, tasks))
+
+        if buffer is not None:
+            buffer.flush()
+        del buffer, output, clients
+        os.replace(temp_path, output_path)
+
+        elapsed = time.perf_counter() - started
+        parameters = sum(int(np.prod(entry["shape"], dtype=np.int64)) for entry in tensors)
+        logger.info(f"Aggregated {len(update_paths)} updates ({parameters} parameters) in {elapsed:.3f}s")
+        return {"clients": len(update_paths), "samples": total, "parameters": parameters, "seconds": elapsed}
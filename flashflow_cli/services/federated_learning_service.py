@@ -5,11 +5,17 @@ Provides distributed machine learning capabilities
 
 import json
 import os
-from typing import Dict, Any, List
+import logging
+import threading
+from typing import Dict, Any, List, Optional
 import uuid
 from datetime import datetime
 import hashlib
 
+from .federated_aggregation import FedAvgAggregator, parse_header, read_weights, write_weights
+
+logger = logging.getLogger(__name__)
+
 
 class FederatedLearningService:
     """Service for managing federated learning processes"""
@@ -25,12 +31,17 @@ class FederatedLearningService:
         self.models_file = os.path.join(storage_path, "models.json")
         self.clients_file = os.path.join(storage_path, "clients.json")
         self.rounds_file = os.path.join(storage_path, "rounds.json")
+        self.updates_path = os.path.join(storage_path, "updates")
+        self.updates_file = os.path.join(storage_path, "updates.jsonl")
+        self.aggregator = FedAvgAggregator()
+        self._lock = threading.Lock()
         self._ensure_storage()
     
     def _ensure_storage(self):
         """Ensure storage directory exists"""
         if not os.path.exists(self.storage_path):
             os.makedirs(self.storage_path)
+        os.makedirs(self.updates_path, exist_ok=True)
         
         # Initialize files if they don't exist
         for file_path in [self.models_file, self.clients_file, self.rounds_file]:
@@ -148,67 +159,99 @@ class FederatedLearningService:
         return True
     
     def submit_client_update(self, model_id: str, client_id: str, 
-                           weights: Dict[str, Any], metrics: Dict[str, float]) -> bool:
+                           weights: Any, metrics: Dict[str, float],
+                           num_samples: Optional[int] = None) -> bool:
         """
         Submit client model updates
         
+        The weights are stored as a binary weights file under
+        updates/<model_id>/ and recorded in the append-only updates.jsonl;
+        models.json is only rewritten when a client joins the model.
+        
         Args:
             model_id (str): Model ID
             client_id (str): Client ID
-            weights (dict): Model weights from client
+            weights: Named tensors (arrays or nested lists), or the bytes of a weights file
             metrics (dict): Training metrics from client
-            
+            num_samples (int): Local training examples, weighting this update in
+                the average (defaults to metrics["num_samples"], else 1)
+        
         Returns:
             bool: True if update submitted successfully
         """
-        # In a real implementation, this would:
-        # 1. Validate the client update
-        # 2. Store the weights securely
-        # 3. Trigger aggregation when enough clients have submitted updates
+        try:
+            model = self.get_model(model_id)
+        except ValueError:
+            return False
+        
+        if num_samples is None:
+            num_samples = metrics.get("num_samples", 1)
+        if num_samples <= 0:
+            raise ValueError("num_samples must be positive")
+        
+        update_dir = os.path.join(self.updates_path, model_id)
+        os.makedirs(update_dir, exist_ok=True)
+        timestamp = datetime.now()
+        digest = hashlib.sha1(client_id.encode("utf-8")).hexdigest()[:16]
+        weights_path = os.path.join(update_dir, f"{digest}-{timestamp.strftime('%Y%m%d%H%M%S%f')}.ffw")
+        
+        if isinstance(weights, (bytes, bytearray, memoryview)):
+            parse_header(weights)
+            temp_path = f"{weights_path}.tmp"
+            with open(temp_path, 'wb') as f:
+                f.write(weights)
+            os.replace(temp_path, weights_path)
+        else:
+            write_weights(weights_path, weights, {"model_id": model_id, "client_id": client_id})
         
-        # For now, we'll just log the update
         update_record = {
             "model_id": model_id,
             "client_id": client_id,
-            "timestamp": datetime.now().isoformat(),
+            "timestamp": timestamp.isoformat(),
+            "num_samples": num_samples,
+            "weights_path": weights_path,
             "metrics": metrics
         }
+        with self._lock:
+            with open(self.updates_file, 'a') as f:
+                f.write(json.dumps(update_record) + "\n")
+            
+            # Only a new participant changes the model record
+            if client_id not in model["participants"]:
+                with open(self.models_file, 'r') as f:
+                    data = json.load(f)
+                for stored in data["data"]:
+                    if stored["id"] == model_id and client_id not in stored["participants"]:
+                        stored["participants"].append(client_id)
+                        stored["updated_at"] = timestamp.isoformat()
+                self._write_json(self.models_file, data)
         
-        # Update model with participant info
-        with open(self.models_file, 'r') as f:
-            data = json.load(f)
-        
-        updated = False
-        for model in data["data"]:
-            if model["id"] == model_id:
-                if client_id not in model["participants"]:
-                    model["participants"].append(client_id)
-                model["updated_at"] = datetime.now().isoformat()
-                updated = True
-                break
-        
-        if updated:
-            with open(self.models_file, 'w') as f:
-                json.dump(data, f, indent=2)
-        
-        return updated
+        return True
     
-    def start_training_round(self, model_id: str, num_clients: int = 5) -> str:
+    def start_training_round(self, model_id: str, num_clients: int = 5,
+                             algorithm: str = "fedavg", proximal_mu: float = 0.0) -> str:
         """
         Start a new federated learning round
         
         Args:
             model_id (str): Model ID
             num_clients (int): Number of clients to participate
+            algorithm (str): "fedavg" or "fedprox"
+            proximal_mu (float): FedProx proximal term weight for client training
             
         Returns:
             str: Round ID
         """
+        if algorithm not in ("fedavg", "fedprox"):
+            raise ValueError(f"Unknown aggregation algorithm: {algorithm}")
+        
         round_id = str(uuid.uuid4())
         training_round = {
             "id": round_id,
             "model_id": model_id,
             "num_clients": num_clients,
+            "algorithm": algorithm,
+            "proximal_mu": proximal_mu if algorithm == "fedprox" else 0.0,
             "status": "started",
             "started_at": datetime.now().isoformat(),
             "completed_at": None,
@@ -259,40 +302,140 @@ class FederatedLearningService:
         
         return updated
     
-    def aggregate_updates(self, round_id: str) -> bool:
+    def aggregate_updates(self, round_id: str, server_lr: float = 1.0) -> bool:
         """
-        Aggregate client updates (simulated)
+        Aggregate client updates with federated averaging
+        
+        Takes each client's latest update submitted since the round started,
+        weights it by its sample count and streams the average into
+        models/<model_id>/global-<round_id>.ffw, which becomes the model's
+        global weights. FedProx rounds aggregate the same way; their
+        proximal term only changes local training on the clients.
         
         Args:
             round_id (str): Round ID
-            
+            server_lr (float): Fraction of the step from the previous global
+                weights towards the average (1.0 replaces them)
+        
         Returns:
             bool: True if aggregation completed successfully
         """
-        # In a real implementation, this would:
-        # 1. Collect all client updates for this round
-        # 2. Perform secure aggregation (e.g., Federated Averaging)
-        # 3. Update the global model weights
-        # 4. Store the aggregated model
+        with open(self.rounds_file, 'r') as f:
+            data = json.load(f)
+        
+        training_round = next((r for r in data["data"] if r["id"] == round_id), None)
+        if training_round is None:
+            return False
+        
+        model_id = training_round["model_id"]
+        updates = self.get_round_updates(round_id)
+        if not updates:
+            logger.warning(f"Round {round_id} has no client updates to aggregate")
+            return False
+        
+        try:
+            model = self.get_model(model_id)
+        except ValueError:
+            return False
+        
+        output_dir = os.path.join(self.storage_path, "models", model_id)
+        os.makedirs(output_dir, exist_ok=True)
+        output_path = os.path.join(output_dir, f"global-{round_id}.ffw")
+        base_path = model.get("global_weights")
+        if not (base_path and os.path.exists(base_path)):
+            base_path = None
+        
+        try:
+            stats = self.aggregator.aggregate(
+                [update["weights_path"] for update in updates],
+                [update["num_samples"] for update in updates],
+                output_path,
+                base_path=base_path,
+                server_lr=server_lr,
+                meta={"model_id": model_id, "round_id": round_id}
+            )
+        except (OSError, ValueError) as e:
+            logger.error(f"Error aggregating round {round_id}: {e}")
+            return False
+        
+        completed_at = datetime.now().isoformat()
+        with self._lock:
+            with open(self.rounds_file, 'r') as f:
+                data = json.load(f)
+            for stored in data["data"]:
+                if stored["id"] == round_id:
+                    stored["status"] = "completed"
+                    stored["completed_at"] = completed_at
+                    stored["aggregated_weights"] = output_path
+                    stored["participants"] = [update["client_id"] for update in updates]
+                    stored["aggregation"] = stats
+            self._write_json(self.rounds_file, data)
+            
+            with open(self.models_file, 'r') as f:
+                data = json.load(f)
+            for stored in data["data"]:
+                if stored["id"] == model_id:
+                    stored["global_weights"] = output_path
+                    stored["status"] = "aggregated"
+                    stored["updated_at"] = completed_at
+            self._write_json(self.models_file, data)
+        
+        return True
+    
+    def get_round_updates(self, round_id: str) -> List[Dict[str, Any]]:
+        """
+        Latest update from each client submitted since a round started
+        
+        Args:
+            round_id (str): Round ID
         
-        # For now, we'll just update the round status
+        Returns:
+            list: Update records (client_id, num_samples, weights_path, metrics, ...)
+        """
         with open(self.rounds_file, 'r') as f:
             data = json.load(f)
         
-        updated = False
-        for training_round in data["data"]:
-            if training_round["id"] == round_id:
-                training_round["status"] = "completed"
-                training_round["completed_at"] = datetime.now().isoformat()
-                training_round["aggregated_weights"] = "simulated_aggregated_weights"
-                updated = True
-                break
+        training_round = next((r for r in data["data"] if r["id"] == round_id), None)
+        if training_round is None or not os.path.exists(self.updates_file):
+            return []
+        
+        ends_at = training_round.get("completed_at")
+        latest = {}
+        with open(self.updates_file, 'r') as f:
+            for line in f:
+                if not line.strip():
+                    continue
+                update = json.loads(line)
+                if update["model_id"] != training_round["model_id"]:
+                    continue
+                if update["timestamp"] < training_round["started_at"]:
+                    continue
+                if ends_at and update["timestamp"] > ends_at:
+                    continue
+                latest[update["client_id"]] = update
+        return list(latest.values())
+    
+    def get_global_weights(self, model_id: str) -> Dict[str, Any]:
+        """
+        Current global weights of a model, memory-mapped read-only
         
-        if updated:
-            with open(self.rounds_file, 'w') as f:
-                json.dump(data, f, indent=2)
+        Args:
+            model_id (str): Model ID
         
-        return updated
+        Returns:
+            dict: Tensor name to array, empty before the first aggregation
+        """
+        path = self.get_model(model_id).get("global_weights")
+        if not path or not os.path.exists(path):
+            return {}
+        return read_weights(path)
+    
+    def _write_json(self, file_path: str, data: Dict[str, Any]):
+        """Replace a JSON store atomically so readers never see a partial file"""
+        temp_path = f"{file_path}.tmp"
+        with open(temp_path, 'w') as f:
+            json.dump(data, f, indent=2)
+        os.replace(temp_path, file_path)
 
 
 # Global instance
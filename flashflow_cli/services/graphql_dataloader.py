@@ -0,0 +1,180 @@
+"""
+GraphQL Request Services for FlashFlow
+Per-request batched loaders, selection-set projection, keyset cursors and query reports
+"""
+
+import time
+import base64
+import logging
+import contextvars
+from typing import Any, Callable, Dict, Iterable, List, Optional, Tuple
+
+logger = logging.getLogger(__name__)
+
+DEFAULT_PAGE_SIZE = 100     # Rows per list page when `first` is not given
+MAX_PAGE_SIZE = 1000        # Upper bound on `first`
+MAX_BATCH_KEYS = 500        # Keys per IN (...) lookup, below SQLite's variable limit
+MAX_REPORTED_STATEMENTS = 50
+
+current_request: contextvars.ContextVar = contextvars.ContextVar("flashflow_graphql_request", default=None)
+
+
+class DataLoader:
+    """Batches and caches lookups by key for the duration of one request.
+
+    load_many() fetches every key it has not seen in one batch call (split
+    into MAX_BATCH_KEYS chunks), so resolving a relation for a page of
+    parents costs one query instead of one per parent, and the same row
+    asked for twice in a request is fetched once.
+    """
+
+    def __init__(self, name: str, batch_load: Callable[[List[Any]], Dict[Any, Any]]):
+        self.name = name
+        self.batch_load = batch_load
+        self._cache: Dict[Any, Any] = {}
+        self.batches = 0
+        self.keys = 0
+        self.hits = 0
+
+    def load(self, key: Any) -> Any:
+        return self.load_many([key])[0]
+
+    def load_many(self, keys: Iterable[Any]) -> List[Any]:
+        keys = list(keys)
+        missing = [key for key in dict.fromkeys(keys) if key is not None and key not in self._cache]
+        self.hits += sum(1 for key in keys if key is not None) - len(missing)
+        for start in range(0, len(missing), MAX_BATCH_KEYS):
+            chunk = missing[start:start + MAX_BATCH_KEYS]
+            found = self.batch_load(chunk)
+            self.batches += 1
+            self.keys += len(chunk)
+            for key in chunk:
+                self._cache[key] = found.get(key)
+        return [self._cache.get(key) if key is not None else None for key in keys]
+
+    def prime(self, key: Any, value: Any):
+        self._cache.setdefault(key, value)
+
+    def clear(self, key: Any):
+        self._cache.pop(key, None)
+
+    def stats(self) -> Dict[str, int]:
+        return {"batches": self.batches, "keys": self.keys, "cache_hits": self.hits}
+
+
+class RequestContext:
+    """Loaders and SQL statistics for one GraphQL request"""
+
+    def __init__(self, loader_factory: Callable[[str], DataLoader], operation: Optional[str] = None):
+        self.loader_factory = loader_factory
+        self.operation = operation
+        self.loaders: Dict[str, DataLoader] = {}
+        self.started = time.perf_counter()
+        self.queries = 0
+        self.db_time = 0.0
+        self.statements: List[Tuple[str, float]] = []
+
+    def loader(self, model_name: str) -> DataLoader:
+        loader = self.loaders.get(model_name)
+        if loader is None:
+            loader = self.loaders[model_name] = self.loader_factory(model_name)
+        return loader
+
+    def record_query(self, statement: str, seconds: float):
+        self.queries += 1
+        self.db_time += seconds
+        if len(self.statements) < MAX_REPORTED_STATEMENTS:
+            self.statements.append((" ".join(statement.split())[:200], seconds))
+
+    def report(self) -> Dict[str, Any]:
+        return {
+            "operation": self.operation,
+            "duration_ms": round((time.perf_counter() - self.started) * 1000, 3),
+            "queries": self.queries,
+            "db_ms": round(self.db_time * 1000, 3),
+            "loaders": {name: loader.stats() for name, loader in self.loaders.items()},
+            "statements": [{"sql": sql, "ms": round(seconds * 1000, 3)} for sql, seconds in self.statements]
+        }
+
+
+def install_query_counter(engine):
+    """Count statements and their time into whichever request is current on the executing thread"""
+    from sqlalchemy import event
+
+    @event.listens_for(engine, "before_cursor_execute")
+    def before_cursor_execute(conn, cursor, statement, parameters, context, executemany):
+        conn.info.setdefault("flashflow_query_started", []).append(time.perf_counter())
+
+    @event.listens_for(engine, "after_cursor_execute")
+    def after_cursor_execute(conn, cursor, statement, parameters, context, executemany):
+        started = conn.info["flashflow_query_started"].pop()
+        request = current_request.get()
+        if request is not None:
+            request.record_query(statement, time.perf_counter() - started)
+
+
+# Selection sets
+
+def _field_nodes(info) -> list:
+    return list(getattr(info, "field_nodes", None) or getattr(info, "field_asts", None) or [])
+
+
+def _collect(selection_set, fragments: Dict[str, Any], tree: Dict[str, Any]):
+    for selection in getattr(selection_set, "selections", None) or []:
+        kind = type(selection).__name__
+        if kind in ("FragmentSpreadNode", "FragmentSpread"):
+            fragment = fragments.get(selection.name.value)
+            if fragment is not None:
+                _collect(fragment.selection_set, fragments, tree)
+        elif kind in ("InlineFragmentNode", "InlineFragment"):
+            _collect(selection.selection_set, fragments, tree)
+        else:
+            subtree = tree.setdefault(selection.name.value, {})
+            if selection.selection_set is not None:
+                _collect(selection.selection_set, fragments, subtree)
+
+
+def selection_tree(info, *path: str) -> Dict[str, Any]:
+    """Requested fields below the resolving field (and then below `path`) as nested dicts"""
+    tree: Dict[str, Any] = {}
+    fragments = getattr(info, "fragments", None) or {}
+    for node in _field_nodes(info):
+        if node.selection_set is not None:
+            _collect(node.selection_set, fragments, tree)
+    for name in path:
+        tree = tree.get(name, {})
+    return tree
+
+
+def pick(tree: Dict[str, Any], name: str) -> Optional[Dict[str, Any]]:
+    """Subtree for a field requested under its Python or camelCase name"""
+    if name in tree:
+        return tree[name]
+    head, *rest = name.split("_")
+    camel = head + "".join(part.title() for part in rest)
+    return tree.get(camel)
+
+
+# Keyset cursors
+
+def encode_cursor(model_name: str, key: Any) -> str:
+    return base64.urlsafe_b64encode(f"{model_name}:{key}".encode("utf-8")).decode("ascii")
+
+
+def decode_cursor(model_name: str, cursor: Optional[str]) -> Optional[int]:
+    """The id a list cursor points after; None for no cursor"""
+    if not cursor:
+        return None
+    try:
+        name, _, key = base64.urlsafe_b64decode(cursor.encode("ascii")).decode("utf-8").rpartition(":")
+        if name == model_name:
+            return int(key)
+    except (ValueError, UnicodeDecodeError):
+        pass
+    raise ValueError(f"Invalid cursor for {model_name}")
+
+
+def page_size(first: Optional[int]) -> int:
+    if first is None:
+        return DEFAULT_PAGE_SIZE
+    return max(0, min(int(first), MAX_PAGE_SIZE))
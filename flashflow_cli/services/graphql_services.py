@@ -8,19 +8,43 @@ import json
 import graphene
 from graphene import Schema, ObjectType, Mutation, Field, List, String, Int, Boolean, DateTime, Float
 from graphene_sqlalchemy import SQLAlchemyObjectType, SQLAlchemyConnectionField
-from sqlalchemy import create_engine, MetaData, Table, Column, Integer, String as SQLString, DateTime as SQLDateTime, Boolean as SQLBoolean, Float as SQLFloat
+from sqlalchemy import create_engine, MetaData, Table, Column, ForeignKey, Integer, String as SQLString, DateTime as SQLDateTime, Boolean as SQLBoolean, Float as SQLFloat
 from sqlalchemy.ext.declarative import declarative_base
-from sqlalchemy.orm import sessionmaker, scoped_session
-from typing import Dict, Any, List as PyList, Optional
+from sqlalchemy.orm import sessionmaker, scoped_session, load_only
+from collections import deque
+from typing import Dict, Any, List as PyList, Optional, Tuple
 import logging
 
+from .graphql_dataloader import (
+    DataLoader, RequestContext, current_request, decode_cursor, encode_cursor,
+    install_query_counter, page_size, pick, selection_tree
+)
+from .search_services import HybridSearchEngine, SearchEngineBase, SearchQuery, SQLiteSearchEngine
+
 logger = logging.getLogger(__name__)
 
+DEFAULT_SEARCH_DB = "graphql_search.db"
+REQUEST_REPORTS_KEPT = 100   # Recent per-request query reports kept for get_request_reports()
+
 class GraphQLServiceManager:
-    """Main GraphQL service management class"""
+    """Main GraphQL service management class
     
-    def __init__(self, database_url: str = "sqlite:///app.db"):
+    Generated resolvers share one DataLoader per model per request, so a
+    row is fetched once per request and relations of a page of parents
+    are loaded with one IN query per level. Lists are keyset-paginated on
+    id and load only the selected columns; search goes through the
+    full-text search engine. execute() records each request's SQL
+    statement count and time in request_reports; the report, which lists
+    the SQL run, is returned to the client only when include_report is set.
+    """
+    
+    def __init__(self, database_url: str = "sqlite:///app.db",
+                 search_engine: Optional[SearchEngineBase] = None,
+                 search_db_path: str = DEFAULT_SEARCH_DB):
         self.database_url = database_url
+        self._search_engine = search_engine
+        self.search_db_path = search_db_path
+        self.request_reports = deque(maxlen=REQUEST_REPORTS_KEPT)
         self.engine = None
         self.session = None
         self.metadata = None
@@ -36,11 +60,54 @@ class GraphQLServiceManager:
             self.metadata = MetaData(bind=self.engine)
             session_factory = sessionmaker(bind=self.engine)
             self.session = scoped_session(session_factory)
+            install_query_counter(self.engine)
             logger.info("GraphQL database connection established")
         except Exception as e:
             logger.error(f"Failed to setup database: {e}")
             raise
     
+    @property
+    def search_engine(self) -> SearchEngineBase:
+        """Full-text engine behind the search resolvers; SQLite FTS unless one was passed in"""
+        if self._search_engine is None:
+            self._search_engine = SQLiteSearchEngine({'db_path': self.search_db_path})
+        return self._search_engine
+    
+    def execute(self, query: str, variables: Optional[Dict[str, Any]] = None,
+                operation_name: Optional[str] = None, include_report: bool = False) -> Dict[str, Any]:
+        """Execute a GraphQL request, returning data and errors
+        
+        Args:
+            include_report: Also return the query report under extensions (debug only, it lists the SQL)
+        """
+        request = RequestContext(self._create_loader, operation_name)
+        token = current_request.set(request)
+        try:
+            result = self.schema.execute(
+                query,
+                variable_values=variables,
+                operation_name=operation_name,
+                context_value=request
+            )
+        finally:
+            current_request.reset(token)
+            self.session.remove()  # Fresh identity map per request
+        
+        report = request.report()
+        self.request_reports.append(report)
+        logger.debug(f"GraphQL request: {report['queries']} queries, {report['duration_ms']} ms")
+        
+        response = {'data': result.data}
+        if include_report:
+            response['extensions'] = {'report': report}
+        if result.errors:
+            response['errors'] = [str(error) for error in result.errors]
+        return response
+    
+    def get_request_reports(self) -> PyList[Dict[str, Any]]:
+        """Query count, SQL time and loader statistics of recent requests run through execute()"""
+        return list(self.request_reports)
+    
     def generate_schema_from_models(self, models: Dict[str, Any]) -> Schema:
         """Generate GraphQL schema from FlashFlow models"""
         try:
@@ -76,14 +143,16 @@ class GraphQLServiceManager:
             try:
                 # Generate SQLAlchemy model
                 sqlalchemy_model = self._create_sqlalchemy_model(model_name, model_config)
+                references = self._references(model_config)
                 
                 # Generate GraphQL type
-                graphql_type = self._create_graphql_type(model_name, sqlalchemy_model)
+                graphql_type = self._create_graphql_type(model_name, sqlalchemy_model, references)
                 
                 self.generated_types[model_name] = {
                     'sqlalchemy_model': sqlalchemy_model,
                     'graphql_type': graphql_type,
-                    'config': model_config
+                    'config': model_config,
+                    'references': references
                 }
                 
             except Exception as e:
@@ -101,6 +170,13 @@ class GraphQLServiceManager:
             field_type = field_config.get('type', 'string')
             required = field_config.get('required', False)
             
+            if field_type == 'reference':
+                # Foreign key to another model's id; the object is exposed through a batched resolver
+                column_name = self._reference_column(field_name)
+                columns[column_name] = Column(Integer, ForeignKey(f"{field_config['model'].lower()}.id"),
+                                              nullable=not required, index=True)
+                continue
+            
             # Map FlashFlow types to SQLAlchemy types
             if field_type == 'string':
                 column_type = SQLString(255)
@@ -129,22 +205,60 @@ class GraphQLServiceManager:
         
         return model_class
     
-    def _create_graphql_type(self, model_name: str, sqlalchemy_model):
+    @staticmethod
+    def _reference_column(field_name: str) -> str:
+        return field_name if field_name.endswith('_id') else f"{field_name}_id"
+    
+    def _references(self, model_config: Dict[str, Any]) -> PyList[Tuple[str, str, str]]:
+        """(relation field, target model, key column) for each reference field"""
+        references = []
+        for field_name, field_config in model_config.get('fields', {}).items():
+            if field_config.get('type') == 'reference':
+                column_name = self._reference_column(field_name)
+                relation = field_name[:-3] if field_name.endswith('_id') else field_name
+                references.append((relation, field_config['model'], column_name))
+        return references
+    
+    def _create_reference_resolver(self, target: str, column_name: str):
+        """Resolve a reference through the request's loader, which _prefetch has usually filled already"""
+        def resolve_reference(root, info):
+            key = getattr(root, column_name, None)
+            if key is None:
+                return None
+            return self._request(info).loader(target).load(key)
+        return resolve_reference
+    
+    def _create_graphql_type(self, model_name: str, sqlalchemy_model, references=()):
         """Create GraphQL type from SQLAlchemy model"""
         
         class Meta:
             model = sqlalchemy_model
             interfaces = (graphene.relay.Node,)
         
+        attributes = {'Meta': Meta}
+        for relation, target, column_name in references:
+            attributes[relation] = Field(
+                lambda target=target: self.generated_types[target]['graphql_type'],
+                resolver=self._create_reference_resolver(target, column_name)
+            )
+        
         # Create dynamic GraphQL type
         graphql_type = type(
             f"{model_name}Type",
             (SQLAlchemyObjectType,),
-            {'Meta': Meta}
+            attributes
         )
         
         return graphql_type
     
+    def _create_page_type(self, model_name: str, graphql_type):
+        """Page of items plus the cursor to pass as `after` for the next page"""
+        return type(f"{model_name}Page", (ObjectType,), {
+            'items': List(graphql_type),
+            'next_cursor': String(),
+            'has_next_page': Boolean()
+        })
+    
     def _create_query_class(self):
         """Create GraphQL Query class with all model queries"""
         query_fields = {}
@@ -157,20 +271,33 @@ class GraphQLServiceManager:
             query_fields[f"get_{model_name.lower()}"] = Field(
                 graphql_type,
                 id=Int(required=True),
-                resolver=self._create_get_resolver(type_info['sqlalchemy_model'])
+                resolver=self._create_get_resolver(model_name)
             )
             
-            # List query
+            # List query, keyset-paginated
             query_fields[f"list_{model_name.lower()}s"] = List(
                 graphql_type,
-                resolver=self._create_list_resolver(type_info['sqlalchemy_model'])
+                first=Int(),
+                after=String(),
+                resolver=self._create_list_resolver(model_name)
+            )
+            
+            # Page query: items plus next cursor, listing or searching
+            query_fields[f"page_{model_name.lower()}s"] = Field(
+                self._create_page_type(model_name, graphql_type),
+                first=Int(),
+                after=String(),
+                query=String(),
+                resolver=self._create_page_resolver(model_name)
             )
             
             # Search query
             query_fields[f"search_{model_name.lower()}s"] = List(
                 graphql_type,
                 query=String(),
-                resolver=self._create_search_resolver(type_info['sqlalchemy_model'])
+                first=Int(),
+                after=String(),
+                resolver=self._create_search_resolver(model_name)
             )
         
         # Create dynamic Query class
@@ -189,20 +316,20 @@ class GraphQLServiceManager:
             # Create mutation
             mutation_fields[f"create_{model_name.lower()}"] = Field(
                 graphql_type,
-                resolver=self._create_create_resolver(sqlalchemy_model, model_config)
+                resolver=self._create_create_resolver(model_name, model_config)
             )
             
             # Update mutation
             mutation_fields[f"update_{model_name.lower()}"] = Field(
                 graphql_type,
                 id=Int(required=True),
-                resolver=self._create_update_resolver(sqlalchemy_model, model_config)
+                resolver=self._create_update_resolver(model_name, model_config)
             )
             
             # Delete mutation
             mutation_fields[f"delete_{model_name.lower()}"] = Boolean(
                 id=Int(required=True),
-                resolver=self._create_delete_resolver(sqlalchemy_model)
+                resolver=self._create_delete_resolver(model_name)
             )
         
         # Create dynamic Mutation class
@@ -238,52 +365,196 @@ class GraphQLServiceManager:
         subscription_class = type('Subscription', (ObjectType,), subscription_fields)
         return subscription_class
     
-    def _create_get_resolver(self, model_class):
+    def _request(self, info) -> RequestContext:
+        """The RequestContext of the executing request, also when the schema is executed directly"""
+        context = info.context
+        if isinstance(context, RequestContext):
+            return context
+        request = current_request.get()
+        if request is not None:
+            return request
+        if isinstance(context, dict):
+            return context.setdefault('flashflow_request', RequestContext(self._create_loader))
+        
+        request = getattr(context, '_flashflow_request', None)
+        if request is None:
+            request = RequestContext(self._create_loader)
+            try:
+                setattr(context, '_flashflow_request', request)
+            except (AttributeError, TypeError):
+                pass  # No per-request storage: batching still works within each resolver
+        return request
+    
+    def _create_loader(self, model_name: str) -> DataLoader:
+        """DataLoader fetching rows of one model by id with a single IN query per batch"""
+        model_class = self.generated_types[model_name]['sqlalchemy_model']
+        
+        def batch_load(ids):
+            rows = self.session.query(model_class).filter(model_class.id.in_(ids)).all()
+            return {row.id: row for row in rows}
+        
+        return DataLoader(model_name, batch_load)
+    
+    def _columns(self, model_name: str, tree: Dict[str, Any]) -> PyList[Any]:
+        """Column attributes to load for a selection: id, requested columns and keys of requested references"""
+        type_info = self.generated_types[model_name]
+        model_class = type_info['sqlalchemy_model']
+        names = {'id'}
+        for column in model_class.__table__.columns:
+            if pick(tree, column.name) is not None:
+                names.add(column.name)
+        for relation, _, column_name in type_info['references']:
+            if pick(tree, relation) is not None:
+                names.add(column_name)
+        return [getattr(model_class, name) for name in sorted(names)]
+    
+    def _prefetch(self, request: RequestContext, model_name: str, rows: PyList[Any], tree: Dict[str, Any]):
+        """Batch-load every requested reference of rows, level by level, before nested resolvers run"""
+        for relation, target, column_name in self.generated_types[model_name]['references']:
+            subtree = pick(tree, relation)
+            if subtree is None or target not in self.generated_types:
+                continue
+            children = request.loader(target).load_many(getattr(row, column_name) for row in rows)
+            self._prefetch(request, target, [child for child in children if child is not None], subtree)
+    
+    def _keyset_page(self, model_name: str, info, first: Optional[int], after: Optional[str],
+                     tree: Dict[str, Any]) -> Tuple[PyList[Any], Optional[str]]:
+        """A page of rows in id order after a cursor, loading only the selected columns"""
+        model_class = self.generated_types[model_name]['sqlalchemy_model']
+        limit = page_size(first)
+        after_id = decode_cursor(model_name, after)
+        
+        query = self.session.query(model_class).options(load_only(*self._columns(model_name, tree)))
+        if after_id is not None:
+            query = query.filter(model_class.id > after_id)
+        rows = query.order_by(model_class.id).limit(limit + 1).all()
+        
+        next_cursor = encode_cursor(model_name, rows[limit - 1].id) if len(rows) > limit and limit else None
+        rows = rows[:limit]
+        self._prefetch(self._request(info), model_name, rows, tree)
+        return rows, next_cursor
+    
+    def _search_page(self, model_name: str, info, query: str, first: Optional[int], after: Optional[str],
+                     tree: Dict[str, Any]) -> Tuple[PyList[Any], Optional[str]]:
+        """A page of rows ranked by the search engine, fetched through the request's loader"""
+        results, stats = self.search_engine.search(SearchQuery(
+            query=query,
+            filters={'type': model_name},
+            sort='relevance',
+            page=0,
+            per_page=page_size(first),
+            facets=[],
+            suggest=False,
+            cursor=after
+        ))
+        ids = []
+        for result in results:
+            _, _, key = result.id.rpartition(':')
+            if key.isdigit():
+                ids.append(int(key))
+        
+        request = self._request(info)
+        rows = [row for row in request.loader(model_name).load_many(ids) if row is not None]
+        self._prefetch(request, model_name, rows, tree)
+        return rows, stats.next_cursor
+    
+    def _create_get_resolver(self, model_name: str):
         """Create resolver for getting single item"""
         def resolve_get(root, info, id):
             try:
-                return self.session.query(model_class).filter(model_class.id == id).first()
+                request = self._request(info)
+                instance = request.loader(model_name).load(id)
+                if instance is not None:
+                    self._prefetch(request, model_name, [instance], selection_tree(info))
+                return instance
             except Exception as e:
                 logger.error(f"Error in get resolver: {e}")
                 return None
         return resolve_get
     
-    def _create_list_resolver(self, model_class):
-        """Create resolver for listing items"""
-        def resolve_list(root, info):
+    def _create_list_resolver(self, model_name: str):
+        """Create resolver for listing items, a keyset page at a time"""
+        def resolve_list(root, info, first=None, after=None):
             try:
-                return self.session.query(model_class).all()
+                rows, _ = self._keyset_page(model_name, info, first, after, selection_tree(info))
+                return rows
             except Exception as e:
                 logger.error(f"Error in list resolver: {e}")
                 return []
         return resolve_list
     
-    def _create_search_resolver(self, model_class):
-        """Create resolver for searching items"""
-        def resolve_search(root, info, query=None):
+    def _create_page_resolver(self, model_name: str):
+        """Create resolver for a page of items with the cursor of the next page"""
+        def resolve_page(root, info, first=None, after=None, query=None):
             try:
+                tree = selection_tree(info, 'items')
+                if query:
+                    rows, next_cursor = self._search_page(model_name, info, query, first, after, tree)
+                else:
+                    rows, next_cursor = self._keyset_page(model_name, info, first, after, tree)
+                return {'items': rows, 'next_cursor': next_cursor, 'has_next_page': next_cursor is not None}
+            except Exception as e:
+                logger.error(f"Error in page resolver: {e}")
+                return {'items': [], 'next_cursor': None, 'has_next_page': False}
+        return resolve_page
+    
+    def _create_search_resolver(self, model_name: str):
+        """Create resolver for searching items through the full-text search engine"""
+        def resolve_search(root, info, query=None, first=None, after=None):
+            try:
+                tree = selection_tree(info)
                 if not query:
-                    return self.session.query(model_class).all()
-                
-                # Simple text search on string fields
-                filters = []
-                for column in model_class.__table__.columns:
-                    if isinstance(column.type, SQLString):
-                        filters.append(getattr(model_class, column.name).ilike(f"%{query}%"))
-                
-                if filters:
-                    from sqlalchemy import or_
-                    return self.session.query(model_class).filter(or_(*filters)).all()
+                    rows, _ = self._keyset_page(model_name, info, first, after, tree)
                 else:
-                    return self.session.query(model_class).all()
-                    
+                    rows, _ = self._search_page(model_name, info, query, first, after, tree)
+                return rows
             except Exception as e:
                 logger.error(f"Error in search resolver: {e}")
                 return []
         return resolve_search
     
-    def _create_create_resolver(self, model_class, model_config):
+    def _search_document(self, model_name: str, instance) -> Dict[str, Any]:
+        """Search engine document for a row: its first string column as title, the rest as content"""
+        texts = [getattr(instance, column.name) for column in instance.__table__.columns
+                 if isinstance(column.type, SQLString)]
+        texts = [str(text) for text in texts if text]
+        doc_id = f"{model_name}:{instance.id}"
+        return {
+            'id': doc_id,
+            'rowid': HybridSearchEngine.vector_id(doc_id),  # Stable rowid, so reindexing replaces the row
+            'title': texts[0] if texts else '',
+            'content': " ".join(texts[1:]),
+            'type': model_name,
+            'metadata': {}
+        }
+    
+    def _index(self, model_name: str, instance):
+        try:
+            self.search_engine.bulk_index([self._search_document(model_name, instance)])
+        except Exception as e:
+            logger.error(f"Failed to index {model_name} {instance.id}: {e}")
+    
+    def rebuild_search_index(self, batch_size: int = 1000) -> int:
+        """Index every row of every model, walking each table in id order"""
+        indexed = 0
+        for model_name, type_info in self.generated_types.items():
+            model_class = type_info['sqlalchemy_model']
+            last_id = 0
+            while True:
+                rows = (self.session.query(model_class).filter(model_class.id > last_id)
+                        .order_by(model_class.id).limit(batch_size).all())
+                if not rows:
+                    break
+                self.search_engine.bulk_index([self._search_document(model_name, row) for row in rows])
+                indexed += len(rows)
+                last_id = rows[-1].id
+        self.session.remove()
+        logger.info(f"Indexed {indexed} rows for GraphQL search")
+        return indexed
+    
+    def _create_create_resolver(self, model_name: str, model_config):
         """Create resolver for creating items"""
+        model_class = self.generated_types[model_name]['sqlalchemy_model']
         def resolve_create(root, info, **kwargs):
             try:
                 # Filter valid fields
@@ -296,17 +567,19 @@ class GraphQLServiceManager:
                 instance = model_class(**valid_fields)
                 self.session.add(instance)
                 self.session.commit()
+                self._index(model_name, instance)
                 
                 return instance
-                
+            
             except Exception as e:
                 logger.error(f"Error in create resolver: {e}")
                 self.session.rollback()
                 return None
         return resolve_create
     
-    def _create_update_resolver(self, model_class, model_config):
+    def _create_update_resolver(self, model_name: str, model_config):
         """Create resolver for updating items"""
+        model_class = self.generated_types[model_name]['sqlalchemy_model']
         def resolve_update(root, info, id, **kwargs):
             try:
                 # Find existing instance
@@ -320,16 +593,19 @@ class GraphQLServiceManager:
                         setattr(instance, field_name, field_value)
                 
                 self.session.commit()
+                self._request(info).loader(model_name).clear(id)
+                self._index(model_name, instance)
                 return instance
-                
+            
             except Exception as e:
                 logger.error(f"Error in update resolver: {e}")
                 self.session.rollback()
                 return None
         return resolve_update
     
-    def _create_delete_resolver(self, model_class):
+    def _create_delete_resolver(self, model_name: str):
         """Create resolver for deleting items"""
+        model_class = self.generated_types[model_name]['sqlalchemy_model']
         def resolve_delete(root, info, id):
             try:
                 instance = self.session.query(model_class).filter(model_class.id == id).first()
@@ -338,8 +614,10 @@ class GraphQLServiceManager:
                 
                 self.session.delete(instance)
                 self.session.commit()
+                self._request(info).loader(model_name).clear(id)
+                self.search_engine.delete_document(f"{model_name}:{id}")
                 return True
-                
+            
             except Exception as e:
                 logger.error(f"Error in delete resolver: {e}")
                 self.session.rollback()
@@ -372,19 +650,31 @@ class GraphQLServiceManager:
                 sdl_parts.append("  id: ID!")
                 
                 for field_name, field_config in fields.items():
-                    field_type = self._map_type_to_graphql(field_config.get('type', 'string'))
                     required = "!" if field_config.get('required', False) else ""
+                    if field_config.get('type') == 'reference':
+                        relation = field_name[:-3] if field_name.endswith('_id') else field_name
+                        sdl_parts.append(f"  {self._reference_column(field_name)}: Int{required}")
+                        sdl_parts.append(f"  {relation}: {field_config['model']}")
+                        continue
+                    field_type = self._map_type_to_graphql(field_config.get('type', 'string'))
                     sdl_parts.append(f"  {field_name}: {field_type}{required}")
                 
                 sdl_parts.append("}\n")
+                
+                sdl_parts.append(f"type {model_name}Page {{")
+                sdl_parts.append(f"  items: [{model_name}]")
+                sdl_parts.append("  next_cursor: String")
+                sdl_parts.append("  has_next_page: Boolean")
+                sdl_parts.append("}\n")
             
             # Add Query type
             sdl_parts.append("type Query {")
             for model_name in self.generated_types.keys():
                 model_lower = model_name.lower()
                 sdl_parts.append(f"  get_{model_lower}(id: ID!): {model_name}")
-                sdl_parts.append(f"  list_{model_lower}s: [{model_name}]")
-                sdl_parts.append(f"  search_{model_lower}s(query: String): [{model_name}]")
+                sdl_parts.append(f"  list_{model_lower}s(first: Int, after: String): [{model_name}]")
+                sdl_parts.append(f"  page_{model_lower}s(first: Int, after: String, query: String): {model_name}Page")
+                sdl_parts.append(f"  search_{model_lower}s(query: String, first: Int, after: String): [{model_name}]")
             sdl_parts.append("}\n")
             
             # Add Mutation type
@@ -401,6 +691,8 @@ class GraphQLServiceManager:
                 for field_name, field_config in fields.items():
                     field_type = self._map_type_to_graphql(field_config.get('type', 'string'))
                     required = "!" if field_config.get('required', False) else ""
+                    if field_config.get('type') == 'reference':
+                        field_name, field_type = self._reference_column(field_name), 'Int'
                     create_args.append(f"{field_name}: {field_type}{required}")
                     update_args.append(f"{field_name}: {field_type}")
                 
@@ -431,7 +723,8 @@ class GraphQLServiceManager:
             'integer': 'Int',
             'boolean': 'Boolean',
             'datetime': 'DateTime',
-            'float': 'Float'
+            'float': 'Float',
+            'reference': 'Int'
         }
         return type_mapping.get(flow_type, 'String')
     
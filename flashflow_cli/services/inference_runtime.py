@@ -0,0 +1,364 @@
+"""
+Inference Runtime Services for FlashFlow
+Pooled ONNX model sessions, IO binding to NumPy buffers and dynamic batching
+"""
+
+import os
+import queue
+import logging
+import threading
+import time
+from concurrent.futures import Future
+from contextlib import contextmanager
+from typing import Dict, Any, List, Optional, Callable, NamedTuple, Union
+
+import numpy as np
+
+logger = logging.getLogger(__name__)
+
+DEFAULT_POOL_SIZE = 2          # Sessions kept per model path
+DEFAULT_MAX_BATCH_SIZE = 32    # Rows gathered into one forward pass
+DEFAULT_MAX_LATENCY_MS = 5.0   # Longest a request waits for others to join its batch
+
+# ONNX tensor element types that can be bound to a preallocated NumPy buffer
+ONNX_DTYPES = {
+    "tensor(float)": np.float32,
+    "tensor(double)": np.float64,
+    "tensor(float16)": np.float16,
+    "tensor(int64)": np.int64,
+    "tensor(int32)": np.int32,
+    "tensor(int8)": np.int8,
+    "tensor(uint8)": np.uint8,
+    "tensor(bool)": np.bool_,
+}
+
+Inputs = Union[np.ndarray, Dict[str, np.ndarray]]
+
+
+class ModelSession:
+    """One loaded model whose inputs and outputs are bound to NumPy memory.
+
+    Uses onnxruntime when installed. Inputs are bound in place (no copy into
+    the runtime) and outputs with a static shape apart from the batch axis are
+    written straight into a preallocated array. Without onnxruntime the
+    native flashcore.ONNXRuntime is used row by row, since it only exposes
+    single-input run_inference(input, output_size).
+    """
+
+    def __init__(self, model_path: str, providers: Optional[List[str]] = None,
+                 intra_op_threads: Optional[int] = None, output_size: Optional[int] = None):
+        self.model_path = model_path
+        self._native = None
+
+        try:
+            import onnxruntime as ort
+        except ImportError:
+            ort = None
+
+        if ort is not None:
+            options = ort.SessionOptions()
+            if intra_op_threads:
+                options.intra_op_num_threads = intra_op_threads
+            self._session = ort.InferenceSession(model_path, sess_options=options,
+                                                 providers=providers or ["CPUExecutionProvider"])
+            inputs = self._session.get_inputs()
+            outputs = self._session.get_outputs()
+            self.input_names = [node.name for node in inputs]
+            self.input_dtypes = {node.name: ONNX_DTYPES.get(node.type) for node in inputs}
+            self.output_names = [node.name for node in outputs]
+            self._output_specs = [(node.name, ONNX_DTYPES.get(node.type), node.shape) for node in outputs]
+        else:
+            import flashcore
+            if output_size is None:
+                raise ValueError("flashcore.ONNXRuntime needs output_size when onnxruntime is not installed")
+            self._native = flashcore.ONNXRuntime(model_path)
+            self._output_size = output_size
+            self.input_names = ["input"]
+            self.input_dtypes = {"input": np.float32}
+            self.output_names = ["output"]
+
+    def _output_buffer(self, dtype, shape, batch: int) -> Optional[np.ndarray]:
+        """Preallocate an output when every axis but the batch axis is known"""
+        if dtype is None or not shape or not all(isinstance(dim, int) for dim in shape[1:]):
+            return None
+        return np.empty((batch, *shape[1:]), dtype=dtype)
+
+    def run(self, inputs: Dict[str, np.ndarray]) -> List[np.ndarray]:
+        """Run one forward pass; every input carries the batch on axis 0"""
+        if self._native is not None:
+            rows = np.ascontiguousarray(inputs[self.input_names[0]], dtype=np.float32)
+            return [np.stack([np.asarray(self._native.run_inference(row, self._output_size)) for row in rows])]
+
+        binding = self._session.io_binding()
+        bound = []  # Keep bound arrays alive until the run completes
+        batch = 0
+        for name in self.input_names:
+            array = np.ascontiguousarray(inputs[name], dtype=self.input_dtypes[name])
+            batch = array.shape[0] if array.ndim else 1
+            binding.bind_input(name, "cpu", 0, array.dtype, array.shape, array.ctypes.data)
+            bound.append(array)
+
+        outputs = []
+        for name, dtype, shape in self._output_specs:
+            buffer = self._output_buffer(dtype, shape, batch)
+            if buffer is None:
+                binding.bind_output(name, "cpu")
+            else:
+                binding.bind_output(name, "cpu", 0, buffer.dtype, buffer.shape, buffer.ctypes.data)
+            outputs.append(buffer)
+
+        self._session.run_with_iobinding(binding)
+        if all(buffer is not None for buffer in outputs):
+            return outputs
+
+        # Runtime-allocated outputs have to be copied out
+        copied = binding.copy_outputs_to_cpu()
+        return [buffer if buffer is not None else copied[i] for i, buffer in enumerate(outputs)]
+
+
+class SessionPool:
+    """Model sessions keyed by model path, at most `size` per model.
+
+    A session runs one forward pass at a time; callers check one out with
+    `with pool.session(path) as session:` and block when all are busy.
+    """
+
+    def __init__(self, size: int = DEFAULT_POOL_SIZE, session_factory: Callable[..., ModelSession] = ModelSession,
+                 **session_options):
+        self.size = max(1, size)
+        self._factory = session_factory
+        self._options = session_options
+        self._lock = threading.Lock()
+        self._idle: Dict[str, queue.Queue] = {}
+        self._created: Dict[str, int] = {}
+        self._sessions: Dict[str, List[ModelSession]] = {}
+
+    @staticmethod
+    def _key(model_path: str) -> str:
+        return os.path.abspath(model_path)
+
+    def _checkout(self, key: str) -> ModelSession:
+        with self._lock:
+            idle = self._idle.setdefault(key, queue.Queue())
+            try:
+                return idle.get_nowait()
+            except queue.Empty:
+                pass
+            create = self._created.get(key, 0) < self.size
+            if create:
+                self._created[key] = self._created.get(key, 0) + 1
+
+        if not create:
+            return idle.get()
+
+        try:
+            session = self._factory(key, **self._options)
+        except Exception:
+            with self._lock:
+                self._created[key] -= 1
+            raise
+        logger.info(f"Loaded model session for {key}")
+        with self._lock:
+            self._sessions.setdefault(key, []).append(session)
+        return session
+
+    @contextmanager
+    def session(self, model_path: str):
+        """Check out a session for model_path, loading one if the pool has room"""
+        key = self._key(model_path)
+        session = self._checkout(key)
+        try:
+            yield session
+        finally:
+            idle = self._idle.get(key)
+            if idle is not None:  # None once the pool was closed while the session was out
+                idle.put(session)
+
+    def close(self, model_path: Optional[str] = None):
+        """Drop pooled sessions for one model, or for all models"""
+        with self._lock:
+            keys = [self._key(model_path)] if model_path else list(self._sessions)
+            for key in keys:
+                self._idle.pop(key, None)
+                self._created.pop(key, None)
+                self._sessions.pop(key, None)
+
+
+class _Request(NamedTuple):
+    inputs: Dict[str, np.ndarray]
+    rows: int
+    future: Future
+
+
+class DynamicBatcher:
+    """Gathers concurrent requests into one batched forward pass.
+
+    A worker takes the first waiting request, then keeps collecting until the
+    batch holds max_batch_size rows or max_latency_ms has passed since it
+    started waiting. A request that would overflow the batch starts the next
+    one instead, and a single request larger than max_batch_size is run in
+    max_batch_size slices. Requests whose inputs don't share trailing shapes
+    and dtypes are run as separate sub-batches.
+    """
+
+    def __init__(self, run_batch: Callable[[Dict[str, np.ndarray]], List[np.ndarray]],
+                 max_batch_size: int = DEFAULT_MAX_BATCH_SIZE, max_latency_ms: float = DEFAULT_MAX_LATENCY_MS,
+                 num_workers: int = 1):
+        self.max_batch_size = max(1, max_batch_size)
+        self.max_latency = max_latency_ms / 1000.0
+        self._run_batch = run_batch
+        self._queue: "queue.Queue[Optional[_Request]]" = queue.Queue()
+        self._closed = False
+        self._workers = [
+            threading.Thread(target=self._loop, name=f"inference-batcher-{i}", daemon=True)
+            for i in range(max(1, num_workers))
+        ]
+        for worker in self._workers:
+            worker.start()
+
+    def submit(self, inputs: Dict[str, np.ndarray]) -> Future:
+        """Queue a request whose inputs carry one or more rows on axis 0"""
+        if self._closed:
+            raise RuntimeError("DynamicBatcher is closed")
+        inputs = {name: np.asarray(value) for name, value in inputs.items()}
+        rows = next(iter(inputs.values())).shape[0] if inputs else 0
+        future = Future()
+        self._queue.put(_Request(inputs, rows, future))
+        return future
+
+    def infer(self, inputs: Dict[str, np.ndarray], timeout: Optional[float] = None) -> List[np.ndarray]:
+        """Submit a request and wait for its slice of the batched outputs"""
+        return self.submit(inputs).result(timeout)
+
+    def _loop(self):
+        carry = None
+        while True:
+            first = carry if carry is not None else self._queue.get()
+            carry = None
+            if first is None:
+                return
+
+            batch = [first]
+            rows = first.rows
+            deadline = time.monotonic() + self.max_latency
+            while rows < self.max_batch_size:
+                remaining = deadline - time.monotonic()
+                if remaining <= 0:
+                    break
+                try:
+                    request = self._queue.get(timeout=remaining)
+                except queue.Empty:
+                    break
+                if request is None:
+                    self._queue.put(None)  # Leave the stop signal for this worker's next pass
+                    break
+                if rows + request.rows > self.max_batch_size:
+                    carry = request  # Opens the next batch so this one stays within max_batch_size
+                    break
+                batch.append(request)
+                rows += request.rows
+
+            self._run(batch)
+
+    @staticmethod
+    def _signature(request: _Request):
+        return tuple((name, value.shape[1:], value.dtype.str) for name, value in sorted(request.inputs.items()))
+
+    def _run(self, batch: List[_Request]):
+        groups: Dict[Any, List[_Request]] = {}
+        for request in batch:
+            groups.setdefault(self._signature(request), []).append(request)
+
+        for requests in groups.values():
+            try:
+                if len(requests) == 1:
+                    merged = requests[0].inputs
+                else:
+                    merged = {name: np.concatenate([request.inputs[name] for request in requests])
+                              for name in requests[0].inputs}
+                outputs = self._run_rows(merged, sum(request.rows for request in requests))
+
+                offset = 0
+                for request in requests:
+                    request.future.set_result([output[offset:offset + request.rows] for output in outputs])
+                    offset += request.rows
+            except Exception as e:
+                logger.error(f"Batched inference failed: {e}")
+                for request in requests:
+                    if not request.future.done():
+                        request.future.set_exception(e)
+
+    def _run_rows(self, inputs: Dict[str, np.ndarray], rows: int) -> List[np.ndarray]:
+        """Run inputs in forward passes of at most max_batch_size rows"""
+        if rows <= self.max_batch_size:
+            return self._run_batch(inputs)
+
+        parts = [self._run_batch({name: value[start:start + self.max_batch_size] for name, value in inputs.items()})
+                 for start in range(0, rows, self.max_batch_size)]
+        return [np.concatenate([part[i] for part in parts]) for i in range(len(parts[0]))]
+
+    def close(self):
+        """Finish queued requests and stop the workers"""
+        if self._closed:
+            return
+        self._closed = True
+        for _ in self._workers:
+            self._queue.put(None)
+        for worker in self._workers:
+            worker.join()
+
+
+class InferenceRuntime:
+    """Pooled, dynamically batched inference over any number of models"""
+
+    def __init__(self, pool_size: int = DEFAULT_POOL_SIZE, max_batch_size: int = DEFAULT_MAX_BATCH_SIZE,
+                 max_latency_ms: float = DEFAULT_MAX_LATENCY_MS, **session_options):
+        self.pool = SessionPool(pool_size, **session_options)
+        self.max_batch_size = max_batch_size
+        self.max_latency_ms = max_latency_ms
+        self._lock = threading.Lock()
+        self._batchers: Dict[str, DynamicBatcher] = {}
+        self._signatures: Dict[str, tuple] = {}
+
+    def _batcher(self, model_path: str) -> DynamicBatcher:
+        key = SessionPool._key(model_path)
+        with self._lock:
+            batcher = self._batchers.get(key)
+            if batcher is None:
+                # One worker per pooled session so every session can run a batch concurrently
+                batcher = DynamicBatcher(lambda inputs: self._run(key, inputs), self.max_batch_size,
+                                         self.max_latency_ms, num_workers=self.pool.size)
+                self._batchers[key] = batcher
+        return batcher
+
+    def _run(self, model_path: str, inputs: Dict[str, np.ndarray]) -> List[np.ndarray]:
+        with self.pool.session(model_path) as session:
+            return session.run(inputs)
+
+    def _names(self, model_path: str) -> tuple:
+        key = SessionPool._key(model_path)
+        if key not in self._signatures:
+            with self.pool.session(model_path) as session:
+                self._signatures[key] = (list(session.input_names), list(session.output_names))
+        return self._signatures[key]
+
+    def infer(self, model_path: str, inputs: Inputs, timeout: Optional[float] = None) -> Dict[str, np.ndarray]:
+        """Run inputs (an array for single-input models, else name -> array) through model_path.
+
+        Rows are on axis 0; concurrent callers are batched together and each
+        gets back only its own rows, keyed by output name.
+        """
+        input_names, output_names = self._names(model_path)
+        if not isinstance(inputs, dict):
+            inputs = {input_names[0]: inputs}
+        outputs = self._batcher(model_path).infer(inputs, timeout)
+        return dict(zip(output_names, outputs))
+
+    def close(self):
+        """Stop all batchers and release the session pool"""
+        with self._lock:
+            batchers = list(self._batchers.values())
+            self._batchers.clear()
+        for batcher in batchers:
+            batcher.close()
+        self.pool.close()
@@ -5,11 +5,16 @@ Provides IoT device registration, management, and monitoring capabilities
 
 import json
 import os
-from typing import Dict, Any, List
+import time
+from typing import Dict, Any, List, Optional
 import uuid
 from datetime import datetime
 import hashlib
 
+from .telemetry_store import TelemetryStore, DEFAULT_BLOCK_RECORDS, to_micros, from_micros
+
+LAST_SEEN_INTERVAL = 30.0  # Seconds between devices.json updates from telemetry
+
 
 class IoTDevice:
     """Represents an IoT device"""
@@ -49,18 +54,22 @@ class IoTDevice:
 class IoTService:
     """Service for managing IoT devices"""
     
-    def __init__(self, storage_path: str = "storage/iot"):
+    def __init__(self, storage_path: str = "storage/iot", block_records: int = DEFAULT_BLOCK_RECORDS):
         """
         Initialize IoT service
         
         Args:
             storage_path (str): Path to store IoT device data
+            block_records (int): Telemetry points per compressed block
         """
         self.storage_path = storage_path
         self.devices_file = os.path.join(storage_path, "devices.json")
         self.telemetry_file = os.path.join(storage_path, "telemetry.json")
         self.commands_file = os.path.join(storage_path, "commands.json")
         self._ensure_storage()
+        self.telemetry = TelemetryStore(os.path.join(storage_path, "telemetry"), block_records)
+        self._last_seen: Dict[str, float] = {}
+        self._migrate_legacy_telemetry()
     
     def _ensure_storage(self):
         """Ensure storage directory exists"""
@@ -68,11 +77,43 @@ class IoTService:
             os.makedirs(self.storage_path)
         
         # Initialize files if they don't exist
-        for file_path in [self.devices_file, self.telemetry_file, self.commands_file]:
+        for file_path in [self.devices_file, self.commands_file]:
             if not os.path.exists(file_path):
                 with open(file_path, 'w') as f:
                     json.dump({"data": []}, f)
     
+    def _migrate_legacy_telemetry(self):
+        """Move records from the old single telemetry.json into the telemetry store"""
+        if not os.path.exists(self.telemetry_file):
+            return
+        
+        with open(self.telemetry_file, 'r') as f:
+            legacy = json.load(f).get("data", [])
+        
+        by_device: Dict[str, List] = {}
+        for record in legacy:
+            by_device.setdefault(record["device_id"], []).append(
+                (to_micros(record.get("timestamp")), record.get("data", {})))
+        for device_id, records in by_device.items():
+            self.telemetry.append_many(device_id, records)
+        
+        os.replace(self.telemetry_file, self.telemetry_file + ".migrated")
+    
+    def _touch_device(self, device_id: str):
+        """Mark a device active, rewriting devices.json at most every LAST_SEEN_INTERVAL"""
+        now = time.monotonic()
+        if now - self._last_seen.get(device_id, float("-inf")) >= LAST_SEEN_INTERVAL:
+            self._last_seen[device_id] = now
+            self.update_device_status(device_id, "active")
+    
+    @staticmethod
+    def _telemetry_record(device_id: str, timestamp: int, data: Dict[str, Any]) -> Dict[str, Any]:
+        return {
+            "device_id": device_id,
+            "data": data,
+            "timestamp": from_micros(timestamp)
+        }
+    
     def register_device(self, name: str, device_type: str, 
                        protocol: str = "MQTT") -> str:
         """
@@ -209,28 +250,30 @@ class IoTService:
         Returns:
             bool: True if recorded successfully
         """
-        telemetry_record = {
-            "device_id": device_id,
-            "data": data,
-            "timestamp": datetime.now().isoformat()
-        }
-        
-        # Load existing telemetry
-        with open(self.telemetry_file, 'r') as f:
-            telemetry_data = json.load(f)
-        
-        # Add new telemetry record
-        telemetry_data["data"].append(telemetry_record)
-        
-        # Save updated telemetry
-        with open(self.telemetry_file, 'w') as f:
-            json.dump(telemetry_data, f, indent=2)
+        self.telemetry.append(device_id, data)
         
         # Update device last seen
-        self.update_device_status(device_id, "active")
+        self._touch_device(device_id)
         
         return True
     
+    def record_telemetry_batch(self, device_id: str, records: List[Dict[str, Any]]) -> int:
+        """
+        Record many telemetry points in one write
+        
+        Args:
+            device_id (str): Device ID
+            records (list): Dicts with "data" and an optional ISO "timestamp"
+            
+        Returns:
+            int: Number of points recorded
+        """
+        points = [(to_micros(record.get("timestamp")), record["data"]) for record in records]
+        self.telemetry.append_many(device_id, points)
+        if points:
+            self._touch_device(device_id)
+        return len(points)
+    
     def get_telemetry(self, device_id: str, limit: int = 100) -> List[Dict[str, Any]]:
         """
         Get telemetry data for device
@@ -242,14 +285,27 @@ class IoTService:
         Returns:
             list: Telemetry data
         """
-        with open(self.telemetry_file, 'r') as f:
-            data = json.load(f)
-        
-        # Filter telemetry for this device
-        device_telemetry = [t for t in data["data"] if t["device_id"] == device_id]
-        
         # Return most recent records up to limit
-        return device_telemetry[-limit:] if len(device_telemetry) > limit else device_telemetry
+        return [self._telemetry_record(device_id, timestamp, data)
+                for timestamp, data in self.telemetry.tail(device_id, limit)]
+    
+    def query_telemetry(self, device_id: str, start: Optional[str] = None, end: Optional[str] = None,
+                        fields: Optional[List[str]] = None, limit: Optional[int] = None) -> List[Dict[str, Any]]:
+        """
+        Get telemetry in a time range
+        
+        Args:
+            device_id (str): Device ID
+            start (str): ISO timestamp to start from (inclusive), or None
+            end (str): ISO timestamp to end at (inclusive), or None
+            fields (list): Data fields to return, or None for all
+            limit (int): Maximum number of records to return
+            
+        Returns:
+            list: Telemetry data ordered by timestamp
+        """
+        return [self._telemetry_record(device_id, timestamp, data)
+                for timestamp, data in self.telemetry.query(device_id, start, end, fields, limit)]
     
     def delete_device(self, device_id: str) -> bool:
         """
@@ -0,0 +1,566 @@
+"""
+Measurement Store Services for FlashFlow
+Chunked columnar storage and mergeable statistics for scientific instrument measurements
+"""
+
+import os
+import sys
+import json
+import math
+import uuid
+import zlib
+import struct
+import bisect
+import hashlib
+import logging
+import threading
+from array import array
+from collections import Counter
+from typing import Any, Dict, Iterable, Iterator, List, Optional, Sequence, Tuple
+
+from .segment_log import SegmentLog, scan_frames
+from .telemetry_store import from_micros, to_micros
+
+logger = logging.getLogger(__name__)
+
+DEFAULT_CHUNK_RECORDS = 4096          # Head measurements sealed into one columnar chunk
+DEFAULT_RELATIVE_ACCURACY = 0.01      # Quantile sketch error, relative to the value
+DEFAULT_PERCENTILES = (50, 90, 95, 99)
+
+CHUNK_MAGIC = b"FFMC"
+CHUNK_VERSION = 1
+CHUNK_SORTED = 0x01                   # Timestamps are non-decreasing, so windows are found by bisection
+# magic, version, flags, count, t_min, t_max (epoch µs), last seq,
+# mean, M2, min, max, sketch bytes, metadata bytes, payload crc32
+CHUNK_HEADER = struct.Struct("<4sBBIqqqddddIII")
+SKETCH_HEADER = struct.Struct("<dQII")  # relative accuracy, zero count, positive bins, negative bins
+SKETCH_BIN = struct.Struct("<iQ")
+
+SERIES_MANIFEST = "series.json"
+SEGMENT_NAME = "chunks.ffm"
+
+Measurement = Tuple[int, float, str, Optional[Dict[str, Any]]]  # (epoch µs, value, measurement id, metadata)
+
+
+def _little_endian(values: array) -> bytes:
+    if sys.byteorder == "big":
+        values = array(values.typecode, values)
+        values.byteswap()
+    return values.tobytes()
+
+
+def _from_little_endian(typecode: str, data) -> array:
+    values = array(typecode)
+    values.frombytes(data)
+    if sys.byteorder == "big":
+        values.byteswap()
+    return values
+
+
+class QuantileSketch:
+    """Mergeable quantile sketch with relative error guarantees (DDSketch).
+
+    Values land in logarithmic bins of ratio gamma, so any quantile is
+    answered within relative_accuracy of the true value, and sketches of
+    different chunks merge by adding bin counts.
+    """
+
+    __slots__ = ('relative_accuracy', 'gamma', '_log_gamma', 'positive', 'negative', 'zero')
+
+    def __init__(self, relative_accuracy: float = DEFAULT_RELATIVE_ACCURACY):
+        self.relative_accuracy = relative_accuracy
+        self.gamma = (1 + relative_accuracy) / (1 - relative_accuracy)
+        self._log_gamma = math.log(self.gamma)
+        self.positive: Counter = Counter()
+        self.negative: Counter = Counter()
+        self.zero = 0
+
+    @property
+    def count(self) -> int:
+        return self.zero + sum(self.positive.values()) + sum(self.negative.values())
+
+    def add_many(self, values: Iterable[float]):
+        log, log_gamma, ceil = math.log, self._log_gamma, math.ceil
+        for value in values:
+            if value > 0:
+                self.positive[ceil(log(value) / log_gamma)] += 1
+            elif value < 0:
+                self.negative[ceil(log(-value) / log_gamma)] += 1
+            elif value == 0:
+                self.zero += 1
+
+    def merge(self, other: 'QuantileSketch'):
+        if other.relative_accuracy != self.relative_accuracy:
+            raise ValueError("Cannot merge sketches with different accuracies")
+        self.positive.update(other.positive)
+        self.negative.update(other.negative)
+        self.zero += other.zero
+
+    def _value(self, index: int) -> float:
+        return 2 * self.gamma ** index / (self.gamma + 1)
+
+    def quantile(self, q: float) -> Optional[float]:
+        total = self.count
+        if not total:
+            return None
+        rank = q * (total - 1)
+        seen = 0
+        for index in sorted(self.negative, reverse=True):
+            seen += self.negative[index]
+            if seen > rank:
+                return -self._value(index)
+        seen += self.zero
+        if seen > rank:
+            return 0.0
+        for index in sorted(self.positive):
+            seen += self.positive[index]
+            if seen > rank:
+                return self._value(index)
+        return self._value(max(self.positive)) if self.positive else 0.0
+
+    def to_bytes(self) -> bytes:
+        parts = [SKETCH_HEADER.pack(self.relative_accuracy, self.zero, len(self.positive), len(self.negative))]
+        parts.extend(SKETCH_BIN.pack(index, count) for index, count in self.positive.items())
+        parts.extend(SKETCH_BIN.pack(index, count) for index, count in self.negative.items())
+        return b"".join(parts)
+
+    @classmethod
+    def from_bytes(cls, data) -> 'QuantileSketch':
+        accuracy, zero, positive, negative = SKETCH_HEADER.unpack_from(data)
+        sketch = cls(accuracy)
+        sketch.zero = zero
+        bins = list(SKETCH_BIN.iter_unpack(bytes(data[SKETCH_HEADER.size:])))
+        sketch.positive.update(dict(bins[:positive]))
+        sketch.negative.update(dict(bins[positive:positive + negative]))
+        return sketch
+
+
+class SeriesStats:
+    """Count, mean, M2 (sum of squared deviations), min, max and a quantile sketch.
+
+    Stats of disjoint sets of values merge exactly (Chan et al.), so a
+    series' statistics come from merging per-chunk summaries computed once
+    when each chunk is sealed.
+    """
+
+    __slots__ = ('count', 'mean', 'm2', 'minimum', 'maximum', 'sketch')
+
+    def __init__(self, count: int = 0, mean: float = 0.0, m2: float = 0.0,
+                 minimum: float = math.inf, maximum: float = -math.inf,
+                 sketch: Optional[QuantileSketch] = None):
+        self.count, self.mean, self.m2 = count, mean, m2
+        self.minimum, self.maximum = minimum, maximum
+        self.sketch = sketch
+
+    @classmethod
+    def of(cls, values: Sequence[float], sketch: bool = True) -> 'SeriesStats':
+        """Stats of in-memory values: fsum for the mean, then one pass for M2"""
+        count = len(values)
+        if not count:
+            return cls(sketch=QuantileSketch() if sketch else None)
+        mean = math.fsum(values) / count
+        m2 = math.fsum((value - mean) ** 2 for value in values)
+        stats = cls(count, mean, m2, min(values), max(values))
+        if sketch:
+            stats.sketch = QuantileSketch()
+            stats.sketch.add_many(values)
+        return stats
+
+    def merge(self, other: 'SeriesStats'):
+        if not other.count:
+            return
+        if not self.count:
+            self.count, self.mean, self.m2 = other.count, other.mean, other.m2
+            self.minimum, self.maximum = other.minimum, other.maximum
+        else:
+            count = self.count + other.count
+            delta = other.mean - self.mean
+            self.mean += delta * other.count / count
+            self.m2 += other.m2 + delta * delta * self.count * other.count / count
+            self.count = count
+            self.minimum = min(self.minimum, other.minimum)
+            self.maximum = max(self.maximum, other.maximum)
+        if other.sketch is not None:
+            if self.sketch is None:
+                self.sketch = QuantileSketch(other.sketch.relative_accuracy)
+            self.sketch.merge(other.sketch)
+
+    @property
+    def variance(self) -> float:
+        return self.m2 / self.count if self.count else 0.0
+
+    def to_dict(self, percentiles: Sequence[float] = ()) -> Dict[str, Any]:
+        if not self.count:
+            return {"count": 0}
+        result = {
+            "count": self.count,
+            "mean": round(self.mean, 4),
+            "variance": round(self.variance, 4),
+            "std_dev": round(math.sqrt(self.variance), 4),
+            "min": self.minimum,
+            "max": self.maximum,
+            "range": self.maximum - self.minimum
+        }
+        if percentiles and self.sketch is not None:
+            # Sketch answers are clamped to the exact extremes
+            result["percentiles"] = {
+                f"p{p:g}": round(min(self.maximum, max(self.minimum, self.sketch.quantile(p / 100))), 6)
+                for p in percentiles
+            }
+        return result
+
+
+def encode_chunk(measurements: Sequence[Measurement], last_seq: int) -> bytes:
+    """One columnar chunk: int64 timestamps, float64 values, 16-byte ids, sketch and sparse metadata"""
+    timestamps = array('q', (m[0] for m in measurements))
+    values = array('d', (m[1] for m in measurements))
+    ids = b"".join(uuid.UUID(m[2]).bytes for m in measurements)
+    metadata = {index: m[3] for index, m in enumerate(measurements) if m[3]}
+    metadata_bytes = json.dumps(metadata, separators=(',', ':'), default=str).encode('utf-8') if metadata else b""
+
+    stats = SeriesStats.of(values)
+    sketch_bytes = stats.sketch.to_bytes()
+    flags = CHUNK_SORTED if all(a <= b for a, b in zip(timestamps, timestamps[1:])) else 0
+    payload = b"".join([_little_endian(timestamps), _little_endian(values), ids, sketch_bytes, metadata_bytes])
+    header = CHUNK_HEADER.pack(CHUNK_MAGIC, CHUNK_VERSION, flags, len(measurements),
+                               min(timestamps), max(timestamps), last_seq,
+                               stats.mean, stats.m2, stats.minimum, stats.maximum,
+                               len(sketch_bytes), len(metadata_bytes), zlib.crc32(payload))
+    return header + payload
+
+
+class _Chunk:
+    """A decoded chunk's columns"""
+
+    __slots__ = ('timestamps', 'values', 'ids', 'metadata', 'sorted')
+
+    def __init__(self, timestamps: array, values: array, ids: bytes,
+                 metadata: Dict[int, Dict[str, Any]], is_sorted: bool):
+        self.timestamps, self.values, self.ids = timestamps, values, ids
+        self.metadata, self.sorted = metadata, is_sorted
+
+    def measurement_id(self, index: int) -> str:
+        return str(uuid.UUID(bytes=self.ids[index * 16:index * 16 + 16]))
+
+
+def _chunk_length(header: tuple) -> int:
+    """Bytes of a chunk, header included: 32 column bytes per measurement, then sketch and metadata"""
+    return CHUNK_HEADER.size + header[3] * 32 + header[11] + header[12]
+
+
+class _ChunkRef:
+    __slots__ = ('t_min', 't_max', 'count', 'last_seq', 'offset', 'length', 'flags', 'stats', 'sketch_length')
+
+    def __init__(self, header: tuple, offset: int):
+        _, _, self.flags, self.count, self.t_min, self.t_max, self.last_seq, mean, m2, minimum, maximum, \
+            self.sketch_length, _, _ = header
+        self.stats = SeriesStats(self.count, mean, m2, minimum, maximum)
+        self.offset = offset
+        self.length = _chunk_length(header)
+
+
+class _Series(SegmentLog):
+    """One (experiment, instrument, measurement type, unit) series: its chunk file, chunk index and head log"""
+
+    item_fields = 4  # timestamp, value, measurement id, metadata
+
+    def __init__(self, directory: str, manifest: Dict[str, Any], chunk_records: int):
+        super().__init__(directory, chunk_records)
+        self.manifest = manifest
+        self.chunks: List[_ChunkRef] = []
+        self.segment_path = os.path.join(directory, SEGMENT_NAME)
+        self._load()
+
+    def _load(self):
+        """Index the intact chunks from their headers, then replay the head log"""
+        if os.path.exists(self.segment_path):
+            self.chunks = [_ChunkRef(header, offset) for offset, header
+                           in scan_frames(self.segment_path, CHUNK_HEADER, CHUNK_MAGIC, _chunk_length)]
+        self._replay_head(self.chunks[-1].last_seq if self.chunks else 0)
+
+    @property
+    def count(self) -> int:
+        return sum(ref.count for ref in self.chunks) + len(self.head)
+
+    def _seal(self, batches: Sequence[Sequence[Tuple[int, Measurement]]]):
+        with open(self.segment_path, 'ab') as f:
+            for batch in batches:
+                chunk = encode_chunk([measurement for _, measurement in batch], batch[-1][0])
+                offset = f.tell()
+                f.write(chunk)
+                self.chunks.append(_ChunkRef(CHUNK_HEADER.unpack_from(chunk), offset))
+            f.flush()
+            os.fsync(f.fileno())
+
+    def _read_raw(self, ref: _ChunkRef) -> memoryview:
+        with open(self.segment_path, 'rb') as f:
+            f.seek(ref.offset)
+            raw = memoryview(f.read(ref.length))
+        payload = raw[CHUNK_HEADER.size:]
+        if zlib.crc32(payload) != CHUNK_HEADER.unpack_from(raw)[-1]:
+            raise ValueError(f"Corrupt measurement chunk in {self.segment_path} at offset {ref.offset}")
+        return payload
+
+    def read_chunk(self, ref: _ChunkRef, with_ids: bool = True) -> _Chunk:
+        payload = self._read_raw(ref)
+        n = ref.count
+        timestamps = _from_little_endian('q', payload[:n * 8])
+        values = _from_little_endian('d', payload[n * 8:n * 16])
+        ids = bytes(payload[n * 16:n * 32]) if with_ids else b""
+        metadata_bytes = payload[n * 32 + ref.sketch_length:]
+        metadata = {int(k): v for k, v in json.loads(bytes(metadata_bytes)).items()} if len(metadata_bytes) else {}
+        return _Chunk(timestamps, values, ids, metadata, bool(ref.flags & CHUNK_SORTED))
+
+    def sketch(self, ref: _ChunkRef) -> QuantileSketch:
+        payload = self._read_raw(ref)
+        start = ref.count * 32
+        return QuantileSketch.from_bytes(payload[start:start + ref.sketch_length])
+
+    def head_chunk(self) -> _Chunk:
+        timestamps = array('q', (m[0] for _, m in self.head))
+        metadata = {index: m[3] for index, (_, m) in enumerate(self.head) if m[3]}
+        ids = b"".join(uuid.UUID(m[2]).bytes for _, m in self.head)
+        is_sorted = all(a <= b for a, b in zip(timestamps, timestamps[1:]))
+        return _Chunk(timestamps, array('d', (m[1] for _, m in self.head)), ids, metadata, is_sorted)
+
+    def chunks_in(self, low: int, high: int, with_ids: bool = True) -> Iterator[Tuple[Optional[_ChunkRef], _Chunk]]:
+        """Decoded chunks (and the head) overlapping [low, high], in write order"""
+        for ref in self.chunks:
+            if ref.t_max >= low and ref.t_min <= high:
+                yield ref, self.read_chunk(ref, with_ids)
+        if self.head:
+            yield None, self.head_chunk()
+
+
+def _slice(chunk: _Chunk, low: int, high: int) -> Tuple[int, int]:
+    """Index range of a sorted chunk's timestamps inside [low, high]"""
+    return bisect.bisect_left(chunk.timestamps, low), bisect.bisect_right(chunk.timestamps, high)
+
+
+class MeasurementStore:
+    """Measurements partitioned by experiment, instrument, measurement type and unit.
+
+    Each series appends to a head log and seals every chunk_records
+    measurements into a columnar chunk: raw little-endian int64 timestamps
+    and float64 values that load with a single frombytes, 16-byte ids, a
+    quantile sketch and sparse metadata. Chunk headers carry the chunk's
+    count, mean, M2, min and max, so statistics over whole chunks merge
+    headers without reading values; only chunks cut by a time range are
+    decoded.
+    """
+
+    def __init__(self, root: str, chunk_records: int = DEFAULT_CHUNK_RECORDS):
+        self.root = root
+        self.chunk_records = max(1, chunk_records)
+        self._lock = threading.Lock()
+        self._series: Dict[Tuple[str, str, str, str], _Series] = {}
+        self._scanned = False
+        os.makedirs(root, exist_ok=True)
+
+    @staticmethod
+    def _safe_name(text: str) -> str:
+        safe = "".join(ch for ch in text if ch.isalnum() or ch in "-_")
+        if safe == text and safe:
+            return safe
+        return f"{safe[:32]}-{hashlib.sha1(text.encode('utf-8')).hexdigest()[:12]}"
+
+    def _open(self, key: Tuple[str, str, str, str], create: bool = True) -> Optional[_Series]:
+        with self._lock:
+            series = self._series.get(key)
+            if series is None:
+                experiment_id, instrument_id, measurement_type, unit = key
+                digest = hashlib.sha1("\0".join((instrument_id, measurement_type, unit)).encode('utf-8')).hexdigest()[:16]
+                directory = os.path.join(self.root, self._safe_name(experiment_id), digest)
+                manifest_path = os.path.join(directory, SERIES_MANIFEST)
+                if not os.path.exists(manifest_path):
+                    if not create:
+                        return None
+                    os.makedirs(directory, exist_ok=True)
+                    with open(manifest_path, 'w') as f:
+                        json.dump({"experiment_id": experiment_id, "instrument_id": instrument_id,
+                                   "measurement_type": measurement_type, "unit": unit}, f)
+                with open(manifest_path, 'r') as f:
+                    series = _Series(directory, json.load(f), self.chunk_records)
+                self._series[key] = series
+            return series
+
+    def _scan(self):
+        """Open every series on disk once, so queries see series written by earlier processes"""
+        if self._scanned:
+            return
+        for experiment_dir in os.listdir(self.root):
+            experiment_path = os.path.join(self.root, experiment_dir)
+            if not os.path.isdir(experiment_path):
+                continue
+            for series_dir in os.listdir(experiment_path):
+                manifest_path = os.path.join(experiment_path, series_dir, SERIES_MANIFEST)
+                if os.path.exists(manifest_path):
+                    with open(manifest_path, 'r') as f:
+                        manifest = json.load(f)
+                    self._open((manifest["experiment_id"], manifest["instrument_id"],
+                                manifest["measurement_type"], manifest["unit"]), create=False)
+        self._scanned = True
+
+    def series(self, experiment_id: Optional[str] = None, instrument_id: Optional[str] = None,
+               measurement_type: Optional[str] = None) -> List[_Series]:
+        self._scan()
+        with self._lock:
+            return [series for (experiment, instrument, kind, _), series in self._series.items()
+                    if (experiment_id is None or experiment == experiment_id)
+                    and (instrument_id is None or instrument == instrument_id)
+                    and (measurement_type is None or kind == measurement_type)]
+
+    def append(self, experiment_id: str, instrument_id: str, measurement_type: str, unit: str,
+               value: float, timestamp: Any = None, metadata: Optional[Dict[str, Any]] = None,
+               measurement_id: Optional[str] = None) -> str:
+        """Record one measurement and return its id"""
+        measurement_id = measurement_id or str(uuid.uuid4())
+        self.append_many(experiment_id, instrument_id, measurement_type, unit,
+                         [(to_micros(timestamp), float(value), measurement_id, metadata or None)])
+        return measurement_id
+
+    def append_many(self, experiment_id: str, instrument_id: str, measurement_type: str, unit: str,
+                    measurements: Sequence[Measurement]):
+        """Record many (epoch µs, value, id, metadata) measurements of one series in one write"""
+        if not measurements:
+            return
+        # A sealed chunk's statistics and sketch need finite values; one inf would fail every later seal
+        for measurement in measurements:
+            if not math.isfinite(measurement[1]):
+                raise ValueError(f"Measurement value must be finite, got {measurement[1]}")
+        series = self._open((experiment_id, instrument_id, measurement_type, unit))
+        with series.lock:
+            series.append(measurements)
+
+    def stats(self, experiment_id: Optional[str] = None, instrument_id: Optional[str] = None,
+              measurement_type: Optional[str] = None, start: Any = None, end: Any = None,
+              sketch: bool = True) -> SeriesStats:
+        """Merged statistics of matching measurements with start <= timestamp <= end"""
+        low = to_micros(start) if start is not None else -(1 << 63)
+        high = to_micros(end) if end is not None else (1 << 63) - 1
+        total = SeriesStats(sketch=QuantileSketch() if sketch else None)
+        for series in self.series(experiment_id, instrument_id, measurement_type):
+            with series.lock:
+                for ref in series.chunks:
+                    if ref.t_max < low or ref.t_min > high:
+                        continue
+                    if low <= ref.t_min and ref.t_max <= high:
+                        # Whole chunk: merge the header summary, reading only the sketch
+                        stats = SeriesStats(ref.stats.count, ref.stats.mean, ref.stats.m2,
+                                            ref.stats.minimum, ref.stats.maximum,
+                                            series.sketch(ref) if sketch else None)
+                        total.merge(stats)
+                    else:
+                        total.merge(self._values_stats(series.read_chunk(ref, with_ids=False), low, high, sketch))
+                if series.head:
+                    total.merge(self._values_stats(series.head_chunk(), low, high, sketch))
+        return total
+
+    @staticmethod
+    def _values_stats(chunk: _Chunk, low: int, high: int, sketch: bool) -> SeriesStats:
+        if chunk.sorted:
+            begin, end = _slice(chunk, low, high)
+            return SeriesStats.of(chunk.values[begin:end], sketch)
+        return SeriesStats.of(array('d', (value for timestamp, value in zip(chunk.timestamps, chunk.values)
+                                          if low <= timestamp <= high)), sketch)
+
+    def windows(self, window_seconds: float, experiment_id: Optional[str] = None,
+                instrument_id: Optional[str] = None, measurement_type: Optional[str] = None,
+                start: Any = None, end: Any = None) -> List[Dict[str, Any]]:
+        """Tumbling-window count/mean/std/min/max, one entry per non-empty window in time order"""
+        width = int(window_seconds * 1_000_000)
+        if width <= 0:
+            raise ValueError("Window must be positive")
+        low = to_micros(start) if start is not None else -(1 << 63)
+        high = to_micros(end) if end is not None else (1 << 63) - 1
+
+        buckets: Dict[int, SeriesStats] = {}
+        for series in self.series(experiment_id, instrument_id, measurement_type):
+            with series.lock:
+                chunks = [chunk for _, chunk in series.chunks_in(low, high, with_ids=False)]
+            for chunk in chunks:
+                if chunk.sorted:
+                    # Window boundaries by bisection; each window's values are a contiguous slice
+                    begin, stop = _slice(chunk, low, high)
+                    while begin < stop:
+                        bucket = chunk.timestamps[begin] // width
+                        edge = min(stop, bisect.bisect_left(chunk.timestamps, (bucket + 1) * width, begin, stop))
+                        buckets.setdefault(bucket, SeriesStats()).merge(SeriesStats.of(chunk.values[begin:edge], False))
+                        begin = edge
+                else:
+                    grouped: Dict[int, array] = {}
+                    for timestamp, value in zip(chunk.timestamps, chunk.values):
+                        if low <= timestamp <= high:
+                            grouped.setdefault(timestamp // width, array('d')).append(value)
+                    for bucket, values in grouped.items():
+                        buckets.setdefault(bucket, SeriesStats()).merge(SeriesStats.of(values, False))
+
+        return [{"start": from_micros(bucket * width), "end": from_micros((bucket + 1) * width),
+                 **buckets[bucket].to_dict()} for bucket in sorted(buckets)]
+
+    def lookup(self, measurement_ids: Iterable[str]) -> array:
+        """Values of the given measurement ids, in no particular order"""
+        wanted = {uuid.UUID(measurement_id).bytes for measurement_id in measurement_ids}
+        found = array('d')
+        for series in self.series():
+            with series.lock:
+                chunks = [chunk for _, chunk in series.chunks_in(-(1 << 63), (1 << 63) - 1)]
+            for chunk in chunks:
+                ids = chunk.ids
+                found.extend(chunk.values[i] for i in range(len(chunk.values)) if ids[i * 16:i * 16 + 16] in wanted)
+        return found
+
+    def rows(self, experiment_id: Optional[str] = None, instrument_id: Optional[str] = None,
+             measurement_type: Optional[str] = None) -> Iterator[Tuple[Dict[str, Any], _Chunk]]:
+        """(series manifest, chunk) pairs, one chunk in memory at a time"""
+        for series in self.series(experiment_id, instrument_id, measurement_type):
+            with series.lock:
+                refs = list(series.chunks)
+                head = series.head_chunk() if series.head else None
+            for ref in refs:
+                yield series.manifest, series.read_chunk(ref)
+            if head is not None:
+                yield series.manifest, head
+
+    def recent(self, experiment_id: Optional[str] = None, instrument_id: Optional[str] = None,
+               limit: int = 100) -> List[Dict[str, Any]]:
+        """The most recent `limit` matching measurements, oldest first, reading only trailing chunks"""
+        candidates = []
+        for series in self.series(experiment_id, instrument_id):
+            with series.lock:
+                taken = len(series.head)
+                chunks = [series.head_chunk()] if series.head else []
+                index = len(series.chunks)
+                while taken < limit and index > 0:
+                    index -= 1
+                    chunks.append(series.read_chunk(series.chunks[index]))
+                    taken += series.chunks[index].count
+            for chunk in chunks:
+                start = max(0, len(chunk.values) - limit)
+                candidates.extend((chunk.timestamps[i], series.manifest, chunk, i) for i in range(start, len(chunk.values)))
+
+        candidates.sort(key=lambda candidate: candidate[0])
+        return [measurement_dict(manifest, chunk, index) for _, manifest, chunk, index in candidates[-limit:]] if limit else []
+
+    def count(self, experiment_id: Optional[str] = None) -> int:
+        return sum(series.count for series in self.series(experiment_id))
+
+    def flush(self):
+        """Seal every partially filled head"""
+        for series in self.series():
+            with series.lock:
+                series.flush()
+
+
+def measurement_dict(manifest: Dict[str, Any], chunk: _Chunk, index: int) -> Dict[str, Any]:
+    """A measurement in the record_measurement dictionary shape"""
+    return {
+        "measurement_id": chunk.measurement_id(index),
+        "experiment_id": manifest["experiment_id"],
+        "instrument_id": manifest["instrument_id"],
+        "measurement_type": manifest["measurement_type"],
+        "value": chunk.values[index],
+        "unit": manifest["unit"],
+        "timestamp": from_micros(chunk.timestamps[index]),
+        "metadata": chunk.metadata.get(index, {})
+    }
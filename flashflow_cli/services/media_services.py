@@ -3,18 +3,34 @@ Media Engine Services for FlashFlow
 Provides comprehensive media handling including upload, processing, optimization, and management
 """
 
+import io
 import os
 import json
+import uuid
 import hashlib
 import shutil
-from typing import Dict, Any, List, Optional, Union, Tuple
+import threading
+import contextlib
+from concurrent.futures import Future, ThreadPoolExecutor, wait
+from typing import Dict, Any, List, Optional, Union, Tuple, BinaryIO
 from dataclasses import dataclass, asdict
 from datetime import datetime
-from PIL import Image, ImageOps
+from PIL import Image, ImageOps, features
 import logging
 
 logger = logging.getLogger(__name__)
 
+DEFAULT_QUALITY = 85            # Encoder quality for image variants
+DEFAULT_REDUCING_GAP = 2.0      # Box-reduce by whole factors before LANCZOS when a step shrinks more than 2x
+DEFAULT_MEDIA_WORKERS = 2       # Uploads whose variants are built concurrently
+
+# variant_format -> (Pillow format, file extension, keeps alpha)
+VARIANT_FORMATS = {
+    'jpeg': ('JPEG', '.jpg', False),
+    'webp': ('WEBP', '.webp', True),
+    'avif': ('AVIF', '.avif', True)
+}
+
 @dataclass
 class MediaFile:
     """Media file data structure"""
@@ -44,7 +60,16 @@ class MediaVariant:
     format: str
 
 class MediaProcessor:
-    """Media processing and optimization"""
+    """Media processing and optimization.
+    
+    An image is decoded once per upload. JPEGs are decoded at the smallest
+    libjpeg scale (1/2, 1/4 or 1/8, applied in the DCT domain) that still
+    covers the largest variant, and each variant is resized from the
+    next-larger one instead of from the original. Pillow releases the GIL
+    while resampling and encoding, so variant encodes overlap on a small
+    thread pool while the cascade carries on; installing pillow-simd in
+    place of Pillow vectorises the resampler without code changes.
+    """
     
     def __init__(self, config: Dict[str, Any] = None):
         self.config = config or {}
@@ -59,56 +84,152 @@ class MediaProcessor:
             'medium': (600, 600),
             'large': (1200, 1200)
         }
+        
+        self.quality = self.config.get('quality', DEFAULT_QUALITY)
+        self.reducing_gap = self.config.get('reducing_gap', DEFAULT_REDUCING_GAP)
+        self.variant_format = self._resolve_format(self.config.get('variant_format', 'jpeg'))
+        # Re-encodes the stored original as web JPEG from the same decode as the variants
+        self.optimize_original = self.config.get('optimize_original', True)
+        encode_workers = max(1, self.config.get('encode_workers', min(4, os.cpu_count() or 1)))
+        self._encoder = ThreadPoolExecutor(max_workers=encode_workers, thread_name_prefix="flashflow-media-encode") \
+            if encode_workers > 1 else None
+    
+    def _resolve_format(self, name: str) -> str:
+        """Variant format to write, falling back to JPEG when Pillow lacks the encoder"""
+        name = (name or 'jpeg').lower()
+        if name not in VARIANT_FORMATS:
+            raise ValueError(f"Unsupported variant format: {name}")
+        if name == 'jpeg':
+            return name
+        try:
+            if features.check(name):
+                return name
+        except Exception:
+            pass
+        if name == 'avif':
+            try:
+                import pillow_avif  # noqa: F401  Registers the AVIF plugin on Pillow < 11.2
+                return name
+            except ImportError:
+                pass
+        logger.warning(f"No {name} encoder available; writing JPEG variants")
+        return 'jpeg'
+    
+    def _variant_sizes(self, size: Tuple[int, int]) -> List[Tuple[str, Tuple[int, int]]]:
+        """Each variant's size fitted inside its box (never upscaled), largest first"""
+        width, height = size
+        targets = []
+        for variant_type, (max_width, max_height) in self.image_variants.items():
+            scale = min(max_width / width, max_height / height, 1.0)
+            targets.append((variant_type, (max(1, round(width * scale)), max(1, round(height * scale)))))
+        return sorted(targets, key=lambda target: target[1][0] * target[1][1], reverse=True)
+    
+    def _flatten(self, img: Image.Image, keep_alpha: bool = False) -> Image.Image:
+        """img in a mode the encoder takes, compositing transparency onto white unless kept"""
+        if img.mode == 'P':
+            img = img.convert('RGBA' if 'transparency' in img.info else 'RGB')
+        if img.mode in ('RGBA', 'LA'):
+            if keep_alpha:
+                return img.convert('RGBA')
+            background = Image.new('RGB', img.size, (255, 255, 255))
+            background.paste(img, mask=img.getchannel('A'))
+            return background
+        return img if img.mode in ('RGB', 'L') else img.convert('RGB')
     
-    def process_image(self, file_path: str, output_dir: str) -> List[MediaVariant]:
-        """Process image and generate variants"""
+    def _encoder_options(self, pil_format: str) -> Dict[str, Any]:
+        if pil_format == 'JPEG':
+            return {'quality': self.quality, 'optimize': True}
+        if pil_format == 'WEBP':
+            return {'quality': self.quality, 'method': self.config.get('webp_method', 4)}
+        return {'quality': self.quality, 'speed': self.config.get('avif_speed', 6)}
+    
+    def _encode(self, fn, *args) -> Future:
+        """Run an encode on the encoder pool, or inline when it has one worker"""
+        if self._encoder is not None:
+            return self._encoder.submit(fn, *args)
+        future = Future()
+        try:
+            future.set_result(fn(*args))
+        except Exception as e:
+            future.set_exception(e)
+        return future
+    
+    def _write_variant(self, image: Image.Image, variant_type: str, base_name: str,
+                       output_dir: str, parent_id: str) -> MediaVariant:
+        pil_format, extension, _ = VARIANT_FORMATS[self.variant_format]
+        variant_path = os.path.join(output_dir, f"{base_name}_{variant_type}{extension}")
+        image.save(variant_path, pil_format, **self._encoder_options(pil_format))
+        return MediaVariant(
+            id=self._generate_id(variant_path),
+            parent_id=parent_id,
+            variant_type=variant_type,
+            file_path=variant_path,
+            width=image.width,
+            height=image.height,
+            file_size=os.path.getsize(variant_path),
+            format=pil_format
+        )
+    
+    def _write_original(self, image: Image.Image, file_path: str):
+        temp_path = f"{file_path}.tmp"
+        image.save(temp_path, 'JPEG', quality=self.quality, optimize=True)
+        os.replace(temp_path, file_path)
+    
+    def process_image(self, file_path: str, output_dir: str, optimize_original: Optional[bool] = None) -> List[MediaVariant]:
+        """Decode the image and generate its variants as a resize cascade.
+        
+        JPEGs are decoded reduced to just above the largest variant. With
+        optimize_original (default: the optimize_original setting) the
+        original is also replaced by its optimized JPEG, as optimize_image
+        would: from the same decode as the variants when the draft can't
+        shrink it, otherwise from a second, full-size decode.
+        """
+        if optimize_original is None:
+            optimize_original = self.optimize_original
         variants = []
         
         try:
-            with Image.open(file_path) as img:
-                # Get original dimensions
-                original_width, original_height = img.size
-                file_size = os.path.getsize(file_path)
+            with contextlib.ExitStack() as stack:
+                img = stack.enter_context(Image.open(file_path))
+                targets = self._variant_sizes(img.size)
+                source = img
+                if img.format == 'JPEG' and targets:
+                    largest = targets[0][1]
+                    if optimize_original and largest[0] * 2 <= img.width and largest[1] * 2 <= img.height:
+                        # The draft would shrink the decode, so the full-size original needs its own
+                        source = stack.enter_context(Image.open(file_path))
+                    source.draft(None, largest)
                 
-                # Generate variants
-                for variant_type, (max_width, max_height) in self.image_variants.items():
+                _, _, keep_alpha = VARIANT_FORMATS[self.variant_format]
+                source.load()  # Before the original is replaced
+                current = self._flatten(source, keep_alpha)
+                if optimize_original:
+                    self._write_original(self._flatten(current if source is img else img), file_path)
+                
+                # Largest first, each variant resized from the previous one
+                base_name = os.path.splitext(os.path.basename(file_path))[0]
+                parent_id = self._generate_id(file_path)
+                jobs = {}
+                for variant_type, size in targets:
+                    if size != current.size:
+                        current = current.resize(size, Image.Resampling.LANCZOS, reducing_gap=self.reducing_gap)
+                    jobs[variant_type] = self._encode(self._write_variant, current, variant_type,
+                                                      base_name, output_dir, parent_id)
+                
+                # Collected inside the with block: closing the images invalidates their pixels
+                for variant_type in self.image_variants:
                     try:
-                        # Calculate new dimensions maintaining aspect ratio
-                        img_copy = img.copy()
-                        img_copy.thumbnail((max_width, max_height), Image.Resampling.LANCZOS)
-                        
-                        # Generate variant filename
-                        base_name = os.path.splitext(os.path.basename(file_path))[0]
-                        variant_filename = f"{base_name}_{variant_type}.jpg"
-                        variant_path = os.path.join(output_dir, variant_filename)
-                        
-                        # Save variant
-                        img_copy.save(variant_path, 'JPEG', quality=85, optimize=True)
-                        
-                        # Create variant object
-                        variant = MediaVariant(
-                            id=self._generate_id(variant_path),
-                            parent_id=self._generate_id(file_path),
-                            variant_type=variant_type,
-                            file_path=variant_path,
-                            width=img_copy.width,
-                            height=img_copy.height,
-                            file_size=os.path.getsize(variant_path),
-                            format='JPEG'
-                        )
-                        variants.append(variant)
-                        
+                        variants.append(jobs[variant_type].result())
                     except Exception as e:
                         logger.error(f"Failed to create {variant_type} variant: {e}")
-                        continue
                 
                 logger.info(f"Generated {len(variants)} image variants")
                 return variants
-                
+        
         except Exception as e:
             logger.error(f"Failed to process image {file_path}: {e}")
             return []
-    
+
     def optimize_image(self, file_path: str, quality: int = 85) -> bool:
         """Optimize image for web"""
         try:
@@ -158,6 +279,11 @@ class MediaProcessor:
     def _generate_id(self, content: str) -> str:
         """Generate unique ID for media content"""
         return hashlib.md5(f"{content}{datetime.now().isoformat()}".encode()).hexdigest()
+    
+    def close(self):
+        """Stop the encoder pool"""
+        if self._encoder is not None:
+            self._encoder.shutdown(wait=True)
 
 class MediaStorage:
     """Media file storage management"""
@@ -167,6 +293,15 @@ class MediaStorage:
         self.storage_type = self.config.get('type', 'local')
         self.base_path = self.config.get('path', 'media')
         self.max_file_size = self.config.get('max_file_size', 10 * 1024 * 1024)  # 10MB
+        self.chunk_size = self.config.get('chunk_size', 1024 * 1024)  # Streaming read size
+        
+        # Encryption at rest: {'encryption': {'key': ...}} stores files as AES-256-GCM streams
+        self.vault = None
+        if self.config.get('encryption'):
+            from .crypto_vault import create_vault
+            self.vault = create_vault(self.config['encryption'])
+            if self.vault is None:
+                raise ValueError("Media encryption is enabled but no key is configured")
         
         # Create storage directories
         self._setup_storage()
@@ -198,7 +333,10 @@ class MediaStorage:
             
             # Store file
             with open(file_path, 'wb') as f:
-                f.write(file_data)
+                if self.vault:
+                    self.vault.encrypt_stream(io.BytesIO(file_data), f, self.chunk_size)
+                else:
+                    f.write(file_data)
             
             # Create media file object
             media_file = MediaFile(
@@ -209,7 +347,8 @@ class MediaStorage:
                 file_size=len(file_data),
                 mime_type=content_type,
                 media_type=media_type,
-                created_at=datetime.now()
+                created_at=datetime.now(),
+                metadata={'encrypted': True} if self.vault else None
             )
             
             logger.info(f"Stored media file: {filename} -> {stored_filename}")
@@ -219,6 +358,88 @@ class MediaStorage:
             logger.error(f"Failed to store file {filename}: {e}")
             raise
     
+    def store_stream(self, stream: BinaryIO, filename: str, content_type: str) -> MediaFile:
+        """Store an upload read from a file object in chunks, never holding it whole in memory"""
+        media_type = self._get_media_type(filename, content_type)
+        storage_dir = os.path.join(self.base_path, f"{media_type}s")
+        temp_path = os.path.join(self.base_path, 'uploads', f"{uuid.uuid4().hex}.part")
+        
+        try:
+            # Hash while writing; the content hash names the file as in store_file
+            digest = hashlib.md5()
+            file_size = 0
+            chunk = bytearray(self.chunk_size)
+            view = memoryview(chunk)
+            encryptor = self.vault.encryptor() if self.vault else None
+            out = None
+            if encryptor:
+                from .crypto_vault import BLOCK_SIZE
+                out = bytearray(self.chunk_size + BLOCK_SIZE - 1)
+            
+            with open(temp_path, 'wb') as f:
+                if encryptor:
+                    f.write(encryptor.header)
+                while True:
+                    read = stream.readinto(chunk)
+                    if not read:
+                        break
+                    file_size += read
+                    if file_size > self.max_file_size:
+                        raise ValueError(f"File size exceeds maximum limit: {self.max_file_size}")
+                    digest.update(view[:read])
+                    if encryptor:
+                        written = encryptor.update_into(view[:read], out)
+                        f.write(memoryview(out)[:written])
+                    else:
+                        f.write(view[:read])
+                if encryptor:
+                    f.write(encryptor.finalize())
+            
+            digest.update(filename.encode())
+            file_id = digest.hexdigest()
+            stored_filename = f"{file_id}{os.path.splitext(filename)[1].lower()}"
+            file_path = os.path.join(storage_dir, stored_filename)
+            os.replace(temp_path, file_path)
+            
+            logger.info(f"Stored media stream: {filename} -> {stored_filename}")
+            return MediaFile(
+                id=file_id,
+                filename=stored_filename,
+                original_filename=filename,
+                file_path=file_path,
+                file_size=file_size,
+                mime_type=content_type,
+                media_type=media_type,
+                created_at=datetime.now(),
+                metadata={'encrypted': True} if self.vault else None
+            )
+            
+        except Exception as e:
+            logger.error(f"Failed to store stream {filename}: {e}")
+            raise
+        finally:
+            if os.path.exists(temp_path):
+                os.remove(temp_path)
+    
+    def read_file(self, file_path: str) -> bytes:
+        """Read a stored file, decrypting it if storage is encrypted"""
+        if not self.vault:
+            with open(file_path, 'rb') as f:
+                return f.read()
+        
+        output = io.BytesIO()
+        with open(file_path, 'rb') as f:
+            self.vault.decrypt_stream(f, output, self.chunk_size)
+        return output.getvalue()
+    
+    def export_file(self, file_path: str, destination: BinaryIO) -> int:
+        """Stream a stored file's plaintext into destination, returning bytes written"""
+        with open(file_path, 'rb') as f:
+            if self.vault:
+                return self.vault.decrypt_stream(f, destination, self.chunk_size)
+            shutil.copyfileobj(f, destination, self.chunk_size)
+        return os.path.getsize(file_path)
+    
     def delete_file(self, file_path: str) -> bool:
         """Delete stored file"""
         try:
@@ -258,9 +479,17 @@ class MediaManager:
     
     def __init__(self, config: Dict[str, Any] = None):
         self.config = config or {}
-        self.storage = MediaStorage(config.get('storage', {}))
-        self.processor = MediaProcessor(config.get('processing', {}))
+        self.storage = MediaStorage(self.config.get('storage', {}))
+        self.processor = MediaProcessor(self.config.get('processing', {}))
         self.media_registry = {}  # In-memory registry (use database in production)
+        
+        # Image variants are built on a worker pool, so uploads return once the original is stored
+        self.async_processing = self.config.get('async_processing', True)
+        workers = max(1, self.config.get('workers', DEFAULT_MEDIA_WORKERS))
+        self._pool = ThreadPoolExecutor(max_workers=workers, thread_name_prefix="flashflow-media") \
+            if self.async_processing else None
+        self._pending: Dict[str, Future] = {}
+        self._lock = threading.Lock()
     
     def upload_media(self, file_data: bytes, filename: str, content_type: str) -> MediaFile:
         """Upload and process media file"""
@@ -268,15 +497,17 @@ class MediaManager:
             # Store original file
             media_file = self.storage.store_file(file_data, filename, content_type)
             
-            # Process based on media type
-            if media_file.media_type == 'image':
+            # Register media file
+            self.media_registry[media_file.id] = media_file
+            
+            # Process based on media type (encrypted files are stored as-is)
+            if self.storage.vault:
+                logger.debug(f"Skipping processing of encrypted media {media_file.id}")
+            elif media_file.media_type == 'image':
                 self._process_image(media_file)
             elif media_file.media_type == 'video':
                 self._process_video(media_file)
             
-            # Register media file
-            self.media_registry[media_file.id] = media_file
-            
             logger.info(f"Successfully uploaded media: {media_file.id}")
             return media_file
             
@@ -285,29 +516,51 @@ class MediaManager:
             raise
     
     def _process_image(self, media_file: MediaFile):
-        """Process uploaded image"""
+        """Read image dimensions now and build variants on the worker pool"""
         try:
-            # Extract metadata
+            # Extract metadata (header only, nothing is decoded yet)
             metadata = self.processor.get_image_metadata(media_file.file_path)
             media_file.width = metadata.get('width')
             media_file.height = metadata.get('height')
+            metadata['processing'] = 'pending'
             media_file.metadata = metadata
             
-            # Optimize original image
-            self.processor.optimize_image(media_file.file_path)
-            
-            # Generate variants
+            if self._pool is None:
+                self._generate_variants(media_file)
+                return
+            # Held across submit so the job cannot finish before it is tracked
+            with self._lock:
+                self._pending[media_file.id] = self._pool.submit(self._generate_variants, media_file)
+        
+        except Exception as e:
+            logger.error(f"Failed to process image {media_file.id}: {e}")
+    
+    def _generate_variants(self, media_file: MediaFile):
+        """Optimize the original and generate its variants from one decode"""
+        try:
             output_dir = os.path.dirname(media_file.file_path)
             variants = self.processor.process_image(media_file.file_path, output_dir)
             
             # Store variants in metadata
-            if not media_file.metadata:
-                media_file.metadata = {}
             media_file.metadata['variants'] = [asdict(v) for v in variants]
-            
+            media_file.metadata['processing'] = 'done' if variants else 'failed'
+        
         except Exception as e:
+            media_file.metadata['processing'] = 'failed'
             logger.error(f"Failed to process image {media_file.id}: {e}")
+        finally:
+            with self._lock:
+                self._pending.pop(media_file.id, None)
     
+    def wait_for_processing(self, media_id: Optional[str] = None, timeout: Optional[float] = None) -> bool:
+        """Block until one upload's (or every pending upload's) variants exist; False on timeout"""
+        with self._lock:
+            if media_id is None:
+                futures = list(self._pending.values())
+            else:
+                futures = [self._pending[media_id]] if media_id in self._pending else []
+        return not wait(futures, timeout=timeout).not_done
+
     def _process_video(self, media_file: MediaFile):
         """Process uploaded video (placeholder)"""
         try:
@@ -341,6 +594,9 @@ class MediaManager:
             if not media_file:
                 return False
             
+            # Let in-flight processing finish so none of its variants are left behind
+            self.wait_for_processing(media_id)
+            
             # Delete original file
             self.storage.delete_file(media_file.file_path)
             
@@ -379,7 +635,8 @@ class MediaManager:
         stats = {
             'total_files': len(self.media_registry),
             'by_type': {},
-            'total_size': 0
+            'total_size': 0,
+            'processing': len(self._pending)
         }
         
         for media_file in self.media_registry.values():
@@ -393,6 +650,12 @@ class MediaManager:
             stats['total_size'] += media_file.file_size
         
         return stats
+    
+    def close(self):
+        """Finish pending processing and stop the worker pools"""
+        if self._pool is not None:
+            self._pool.shutdown(wait=True)
+        self.processor.close()
 
 def create_media_manager(config: Dict[str, Any] = None) -> MediaManager:
     """Factory function to create media manager"""
@@ -9,22 +9,43 @@ from typing import Dict, Any, List
 import uuid
 from datetime import datetime
 import base64
+import threading
 
 
 class ModelServingService:
     """Service for managing model deployment and serving"""
     
-    def __init__(self, storage_path: str = "storage/models"):
+    def __init__(self, storage_path: str = "storage/models", pool_size: int = 2,
+                 max_batch_size: int = 32, max_latency_ms: float = 5.0):
         """
         Initialize Model Serving service
         
         Args:
             storage_path (str): Path to store model serving data
+            pool_size (int): Inference sessions kept per ONNX model
+            max_batch_size (int): Rows gathered into one forward pass
+            max_latency_ms (float): Longest a request waits for a batch to fill
         """
         self.storage_path = storage_path
         self.deployments_file = os.path.join(storage_path, "deployments.json")
+        self.runtime_options = {
+            "pool_size": pool_size,
+            "max_batch_size": max_batch_size,
+            "max_latency_ms": max_latency_ms
+        }
+        self._inference_runtime = None
+        self._runtime_lock = threading.Lock()
         self._ensure_storage()
     
+    @property
+    def inference_runtime(self):
+        """Pooled, batched ONNX runtime, created on first ONNX prediction"""
+        with self._runtime_lock:
+            if self._inference_runtime is None:
+                from .inference_runtime import InferenceRuntime
+                self._inference_runtime = InferenceRuntime(**self.runtime_options)
+            return self._inference_runtime
+    
     def _ensure_storage(self):
         """Ensure storage directory exists"""
         if not os.path.exists(self.storage_path):
@@ -142,7 +163,13 @@ class ModelServingService:
     
     def predict(self, deployment_id: str, input_data: Dict[str, Any]) -> Dict[str, Any]:
         """
-        Make predictions using deployed model (simulated)
+        Make predictions using deployed model
+        
+        ONNX deployments run through the pooled inference runtime, where
+        concurrent predict calls on the same model are batched into one
+        forward pass. input_data["inputs"] holds the rows (axis 0) as a list
+        for single-input models or a dict of input name -> list. Other
+        frameworks are simulated.
         
         Args:
             deployment_id (str): Deployment ID
@@ -151,17 +178,12 @@ class ModelServingService:
         Returns:
             dict: Prediction results
         """
-        # In a real implementation, this would:
-        # 1. Load the model from model_path
-        # 2. Preprocess the input_data
-        # 3. Run inference
-        # 4. Postprocess results
-        # 5. Return predictions
-        
-        # For now, we'll simulate a prediction
         try:
             deployment = self.get_deployment(deployment_id)
             
+            if deployment.get("framework") == "onnx":
+                return self._predict_onnx(deployment, input_data)
+            
             # Simulate prediction based on input size
             import random
             random.seed(sum(hash(str(k)) + hash(str(v)) for k, v in input_data.items()))
@@ -179,6 +201,22 @@ class ModelServingService:
                 "timestamp": datetime.now().isoformat()
             }
     
+    def _predict_onnx(self, deployment: Dict[str, Any], input_data: Dict[str, Any]) -> Dict[str, Any]:
+        """Run an ONNX deployment through the batched inference runtime"""
+        import numpy as np
+        
+        inputs = input_data.get("inputs", [])
+        if isinstance(inputs, dict):
+            inputs = {name: np.asarray(value) for name, value in inputs.items()}
+        else:
+            inputs = np.asarray(inputs)
+        
+        outputs = self.inference_runtime.infer(deployment["model_path"], inputs)
+        return {
+            "outputs": {name: value.tolist() for name, value in outputs.items()},
+            "timestamp": datetime.now().isoformat()
+        }
+    
     def undeploy_model(self, deployment_id: str) -> bool:
         """
         Undeploy a model
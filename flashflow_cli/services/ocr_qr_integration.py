@@ -180,9 +180,6 @@ export const {component_name} = ({{ onCodeScanned, className = '' }}) => {{
         return '''
 # FlashFlow OCR/QR API Routes
 from flask import request, jsonify
-from werkzeug.utils import secure_filename
-import tempfile
-import os
 
 @app.route('/api/ocr/extract', methods=['POST'])
 def ocr_extract():
@@ -195,32 +192,23 @@ def ocr_extract():
         if file.filename == '':
             return jsonify({'success': False, 'error': 'No file selected'})
         
-        # Save uploaded file temporarily
-        filename = secure_filename(file.filename)
-        with tempfile.NamedTemporaryFile(suffix=os.path.splitext(filename)[1], delete=False) as tmp_file:
-            file.save(tmp_file.name)
-            
-            # Process with OCR service
-            from flashflow_cli.services.ocr_qr_service import FlashFlowOCRQRService
-            service = FlashFlowOCRQRService()
-            result = service.process_image(tmp_file.name, ['ocr'])
-            
-            # Cleanup
-            os.unlink(tmp_file.name)
-            
-            if result['results']['ocr']['success']:
-                return jsonify({
-                    'success': True,
-                    'text': result['results']['ocr']['text'],
-                    'confidence': result['results']['ocr']['confidence'],
-                    'words': result['results']['ocr']['words'],
-                    'provider': result['results']['ocr']['provider']
-                })
-            else:
-                return jsonify({
-                    'success': False,
-                    'error': result['results']['ocr']['error']
-                })
+        # Process the upload in memory on the shared service, whose models stay loaded
+        from flashflow_cli.services.ocr_qr_service import get_ocr_qr_service
+        result = get_ocr_qr_service().process_image(file.read(), ['ocr'])
+        
+        if result['results']['ocr']['success']:
+            return jsonify({
+                'success': True,
+                'text': result['results']['ocr']['text'],
+                'confidence': result['results']['ocr']['confidence'],
+                'words': result['results']['ocr']['words'],
+                'provider': result['results']['ocr']['provider']
+            })
+        else:
+            return jsonify({
+                'success': False,
+                'error': result['results']['ocr']['error']
+            })
                 
     except Exception as e:
         return jsonify({'success': False, 'error': str(e)})
@@ -236,31 +224,22 @@ def qr_scan():
         if file.filename == '':
             return jsonify({'success': False, 'error': 'No file selected'})
         
-        # Save uploaded file temporarily
-        filename = secure_filename(file.filename)
-        with tempfile.NamedTemporaryFile(suffix=os.path.splitext(filename)[1], delete=False) as tmp_file:
-            file.save(tmp_file.name)
-            
-            # Process with QR service
-            from flashflow_cli.services.ocr_qr_service import FlashFlowOCRQRService
-            service = FlashFlowOCRQRService()
-            result = service.process_image(tmp_file.name, ['qr'])
-            
-            # Cleanup
-            os.unlink(tmp_file.name)
-            
-            if result['results']['qr']['success']:
-                return jsonify({
-                    'success': True,
-                    'codes': result['results']['qr']['codes'],
-                    'count': result['results']['qr']['count'],
-                    'provider': result['results']['qr']['provider']
-                })
-            else:
-                return jsonify({
-                    'success': False,
-                    'error': result['results']['qr']['error']
-                })
+        # Process the upload in memory on the shared service, whose models stay loaded
+        from flashflow_cli.services.ocr_qr_service import get_ocr_qr_service
+        result = get_ocr_qr_service().process_image(file.read(), ['qr'])
+        
+        if result['results']['qr']['success']:
+            return jsonify({
+                'success': True,
+                'codes': result['results']['qr']['codes'],
+                'count': result['results']['qr']['count'],
+                'provider': result['results']['qr']['provider']
+            })
+        else:
+            return jsonify({
+                'success': False,
+                'error': result['results']['qr']['error']
+            })
                 
     except Exception as e:
         return jsonify({'success': False, 'error': str(e)})
@@ -4,14 +4,221 @@ Provides OCR text recognition and QR/barcode scanning capabilities
 """
 
 import base64
+import io
 import json
 import os
+import queue
 import tempfile
-from typing import Dict, List, Optional, Any
+import threading
+import time
+from concurrent.futures import Future
+from typing import Any, Callable, Dict, List, Optional, Union
 from pathlib import Path
 
+DEFAULT_OCR_WORKERS = 1         # Threads, each pinning its own warm model instance
+DEFAULT_MAX_BATCH_SIZE = 8      # Images handed to the model in one call
+DEFAULT_MAX_LATENCY_MS = 5.0    # How long the first queued image waits for others to join its batch
+GOOGLE_VISION_BATCH = 16        # Images per batch_annotate_images request (API limit)
+
+
+class ImageInput:
+    """One image shared by every OCR and QR pass.
+    
+    Accepts a path or the encoded bytes of an upload. Pixels are decoded
+    lazily and cached per layout (PIL RGB, BGR array), so running OCR and
+    QR over the same input decodes it once. A temporary file is written
+    only for providers that insist on a path (ZXing), and removed by close().
+    """
+    
+    def __init__(self, data: Optional[bytes] = None, path: Optional[str] = None):
+        if data is None and path is None:
+            raise ValueError("ImageInput needs image bytes or a path")
+        self.path = path
+        self._data = data
+        self._pil = None
+        self._bgr = None
+        self._temp_path = None
+        self._lock = threading.RLock()
+    
+    @classmethod
+    def coerce(cls, image: Union['ImageInput', str, Path, bytes, bytearray, memoryview]) -> 'ImageInput':
+        if isinstance(image, ImageInput):
+            return image
+        if isinstance(image, (bytes, bytearray, memoryview)):
+            return cls(data=bytes(image))
+        return cls(path=str(image))
+    
+    def bytes(self) -> bytes:
+        with self._lock:
+            if self._data is None:
+                with open(self.path, 'rb') as f:
+                    self._data = f.read()
+            return self._data
+    
+    def pil(self):
+        """Decoded PIL image in RGB or L mode"""
+        from PIL import Image
+        
+        with self._lock:
+            if self._pil is None:
+                img = Image.open(self.path if self._data is None else io.BytesIO(self._data))
+                img.load()
+                self._pil = img if img.mode in ('RGB', 'L') else img.convert('RGB')
+            return self._pil
+    
+    def bgr(self):
+        """Decoded HxWx3 uint8 array in OpenCV channel order"""
+        import numpy as np
+        
+        with self._lock:
+            if self._bgr is None:
+                if self._pil is None:
+                    try:
+                        import cv2
+                        decoded = cv2.imdecode(np.frombuffer(self.bytes(), dtype=np.uint8), cv2.IMREAD_COLOR)
+                        if decoded is not None:
+                            self._bgr = decoded
+                            return decoded
+                    except ImportError:
+                        pass
+                self._bgr = np.ascontiguousarray(np.asarray(self.pil().convert('RGB'))[:, :, ::-1])
+            return self._bgr
+    
+    def file_path(self) -> str:
+        """A path holding the encoded image, written to a temporary file only when needed"""
+        with self._lock:
+            if self.path is not None:
+                return self.path
+            if self._temp_path is None:
+                with tempfile.NamedTemporaryFile(suffix='.img', delete=False) as tmp_file:
+                    tmp_file.write(self._data)
+                    self._temp_path = tmp_file.name
+            return self._temp_path
+    
+    def close(self):
+        """Drop decoded pixels and any temporary file"""
+        with self._lock:
+            self._pil = None
+            self._bgr = None
+            if self._temp_path is not None:
+                try:
+                    os.unlink(self._temp_path)
+                except OSError:
+                    pass
+                self._temp_path = None
+
+
+class MicroBatcher:
+    """Coalesces concurrent requests into batches for pinned worker threads.
+    
+    Each worker builds its state (a model instance) once and keeps it for
+    its lifetime, so models stay warm. A worker takes the oldest queued
+    request and waits until that request is max_latency_ms old for others
+    to join, up to max_batch_size, then runs process_batch(state, items)
+    and resolves every request's future with its own result.
+    """
+    
+    def __init__(self, process_batch: Callable[[Any, List[Any]], List[Any]],
+                 worker_state: Optional[Callable[[int], Any]] = None, workers: int = DEFAULT_OCR_WORKERS,
+                 max_batch_size: int = DEFAULT_MAX_BATCH_SIZE, max_latency_ms: float = DEFAULT_MAX_LATENCY_MS,
+                 name: str = 'flashflow-batch'):
+        self.process_batch = process_batch
+        self.worker_state = worker_state
+        self.max_batch_size = max(1, max_batch_size)
+        self.max_latency = max(0.0, max_latency_ms) / 1000.0
+        self.batches = 0
+        self.items = 0
+        self._queue = queue.Queue()
+        self._closed = False
+        self._threads = [threading.Thread(target=self._worker, args=(index,), name=f"{name}-{index}", daemon=True)
+                         for index in range(max(1, workers))]
+        for thread in self._threads:
+            thread.start()
+    
+    def submit(self, item: Any) -> Future:
+        if self._closed:
+            raise RuntimeError("Batcher is closed")
+        future = Future()
+        self._queue.put((time.monotonic(), item, future))
+        return future
+    
+    def map(self, items: List[Any]) -> List[Any]:
+        """Submit items (they may share batches with other callers) and wait for their results"""
+        futures = [self.submit(item) for item in items]
+        return [future.result() for future in futures]
+    
+    def _collect(self, first) -> tuple:
+        """The batch starting with first, and whether a stop sentinel was seen"""
+        batch = [first]
+        deadline = first[0] + self.max_latency
+        while len(batch) < self.max_batch_size:
+            remaining = deadline - time.monotonic()
+            try:
+                entry = self._queue.get(timeout=remaining) if remaining > 0 else self._queue.get_nowait()
+            except queue.Empty:
+                break
+            if entry is None:
+                return batch, True
+            batch.append(entry)
+        return batch, False
+    
+    def _worker(self, index: int):
+        state, state_error = None, None
+        try:
+            state = self.worker_state(index) if self.worker_state else None
+        except Exception as e:
+            state_error = e
+        
+        stop = False
+        while not stop:
+            first = self._queue.get()
+            if first is None:
+                break
+            batch, stop = self._collect(first)
+            batch = [entry for entry in batch if entry[2].set_running_or_notify_cancel()]
+            if not batch:
+                continue
+            
+            try:
+                if state_error is not None:
+                    raise state_error
+                results = self.process_batch(state, [item for _, item, _ in batch])
+                for (_, _, future), result in zip(batch, results):
+                    future.set_result(result)
+            except Exception as e:
+                for _, _, future in batch:
+                    if not future.done():
+                        future.set_exception(e)
+            self.batches += 1
+            self.items += len(batch)
+    
+    def stats(self) -> Dict[str, Any]:
+        return {
+            'workers': len(self._threads),
+            'batches': self.batches,
+            'items': self.items,
+            'avg_batch_size': self.items / self.batches if self.batches else 0,
+            'queued': self._queue.qsize()
+        }
+    
+    def close(self):
+        """Finish queued requests, then stop the workers"""
+        self._closed = True
+        for _ in self._threads:
+            self._queue.put(None)
+        for thread in self._threads:
+            thread.join()
+
+
 class OCRService:
-    """OCR text recognition service with multiple provider support"""
+    """OCR text recognition service with multiple provider support.
+    
+    Requests go through a MicroBatcher: concurrent extract_text calls are
+    grouped into one model call per batch (EasyOCR readtext_batched, one
+    Vision batch request), and EasyOCR/PaddleOCR models stay loaded per
+    worker thread. Configure with 'workers', 'max_batch_size' and
+    'max_latency_ms' in the provider config.
+    """
     
     def __init__(self):
         self.providers = {
@@ -22,6 +229,7 @@ class OCRService:
         }
         self.active_provider = None
         self.provider_config = {}
+        self.batcher = None
     
     def _init_tesseract(self, config: Dict) -> bool:
         """Initialize Tesseract OCR"""
@@ -50,8 +258,12 @@ class OCRService:
             languages = config.get('languages', ['en'])
             gpu = config.get('gpu', False)
             
+            def reader():
+                return easyocr.Reader(languages, gpu=gpu)
+            
             self.provider_config['easyocr'] = {
-                'reader': easyocr.Reader(languages, gpu=gpu),
+                'reader': reader(),
+                'factory': reader,
                 'detail': config.get('detail', 1),
                 'paragraph': config.get('paragraph', False)
             }
@@ -64,12 +276,16 @@ class OCRService:
         try:
             from paddleocr import PaddleOCR
             
-            self.provider_config['paddleocr'] = {
-                'ocr': PaddleOCR(
+            def ocr():
+                return PaddleOCR(
                     use_angle_cls=config.get('use_angle_cls', True),
                     lang=config.get('lang', 'en'),
                     use_gpu=config.get('use_gpu', False)
-                ),
+                )
+            
+            self.provider_config['paddleocr'] = {
+                'ocr': ocr(),
+                'factory': ocr,
                 'cls': config.get('cls', True)
             }
             return True
@@ -102,102 +318,124 @@ class OCRService:
         success = self.providers[provider_name](config)
         
         if success:
+            self.close()
             self.active_provider = provider_name
+            self.batcher = MicroBatcher(
+                self._run_batch,
+                worker_state=self._worker_model,
+                workers=config.get('workers', DEFAULT_OCR_WORKERS),
+                max_batch_size=config.get('max_batch_size', DEFAULT_MAX_BATCH_SIZE),
+                max_latency_ms=config.get('max_latency_ms', DEFAULT_MAX_LATENCY_MS),
+                name=f"flashflow-ocr-{provider_name}"
+            )
             return True
         return False
     
-    def extract_text(self, image_path: str, options: Dict = None) -> Dict:
-        """Extract text from image"""
+    def _worker_model(self, index: int):
+        """Model instance pinned to batch worker `index`; worker 0 keeps the one loaded at setup"""
+        factory = self.provider_config[self.active_provider].get('factory')
+        return factory() if factory is not None and index > 0 else None
+    
+    def extract_text(self, image: Union[ImageInput, str, bytes], options: Dict = None) -> Dict:
+        """Extract text from an image path, encoded image bytes or ImageInput"""
+        return self.extract_text_batch([image], options)[0]
+    
+    def extract_text_batch(self, images: List[Union[ImageInput, str, bytes]], options: Dict = None) -> List[Dict]:
+        """Extract text from several images; they may share model batches with concurrent callers"""
         if not self.active_provider:
             raise RuntimeError("No OCR provider configured")
         
-        options = options or {}
+        items = [(ImageInput.coerce(image), options or {}) for image in images]
+        if self.batcher is None:
+            return self._run_batch(None, items)
+        return self.batcher.map(items)
+    
+    def _run_batch(self, model, items: List[tuple]) -> List[Dict]:
+        """OCR one batch of (ImageInput, options) on the calling worker's model"""
+        images = [image for image, _ in items]
         
         try:
-            if self.active_provider == 'tesseract':
-                return self._extract_tesseract(image_path, options)
-            elif self.active_provider == 'easyocr':
-                return self._extract_easyocr(image_path, options)
-            elif self.active_provider == 'paddleocr':
-                return self._extract_paddleocr(image_path, options)
+            if self.active_provider == 'easyocr':
+                return self._extract_easyocr(images, model)
             elif self.active_provider == 'google_vision':
-                return self._extract_google_vision(image_path, options)
+                return self._extract_google_vision(images)
         except Exception as e:
-            return {
-                'success': False,
-                'error': str(e),
-                'text': '',
-                'confidence': 0,
-                'words': [],
-                'blocks': []
-            }
+            return [self._failure(e) for _ in images]
+        
+        extract = self._extract_tesseract if self.active_provider == 'tesseract' else self._extract_paddleocr
+        results = []
+        for image, options in items:
+            try:
+                results.append(extract(image, options, model))
+            except Exception as e:
+                results.append(self._failure(e))
+        return results
+    
+    def _failure(self, error: Exception) -> Dict:
+        return {
+            'success': False,
+            'error': str(error),
+            'text': '',
+            'confidence': 0,
+            'words': [],
+            'blocks': []
+        }
     
-    def _extract_tesseract(self, image_path: str, options: Dict) -> Dict:
+    def _extract_tesseract(self, image: ImageInput, options: Dict, model=None) -> Dict:
         """Extract text using Tesseract"""
         import pytesseract
-        from PIL import Image
         
         config = self.provider_config['tesseract']
         
-        with Image.open(image_path) as img:
-            # Extract text
-            text = pytesseract.image_to_string(
-                img,
-                lang='+'.join(config['languages']),
-                config=config['config'],
-                timeout=config['timeout']
-            )
-            
-            # Get detailed data
-            data = pytesseract.image_to_data(
-                img,
-                lang='+'.join(config['languages']),
-                config=config['config'],
-                output_type=pytesseract.Output.DICT
-            )
-            
-            # Process words and confidence
-            words = []
-            for i in range(len(data['text'])):
-                if int(data['conf'][i]) > 0:
-                    words.append({
-                        'text': data['text'][i],
-                        'confidence': int(data['conf'][i]),
-                        'bbox': [
-                            data['left'][i],
-                            data['top'][i],
-                            data['left'][i] + data['width'][i],
-                            data['top'][i] + data['height'][i]
-                        ]
-                    })
-            
-            avg_confidence = sum(w['confidence'] for w in words) / len(words) if words else 0
-            
-            return {
-                'success': True,
-                'text': text.strip(),
-                'confidence': avg_confidence,
-                'words': words,
-                'blocks': [],
-                'provider': 'tesseract'
-            }
-    
-    def _extract_easyocr(self, image_path: str, options: Dict) -> Dict:
-        """Extract text using EasyOCR"""
-        config = self.provider_config['easyocr']
-        reader = config['reader']
-        
-        results = reader.readtext(
-            image_path,
-            detail=config['detail'],
-            paragraph=config['paragraph']
+        # One tesseract run: the text is rebuilt from the word data instead of a second image_to_string pass
+        data = pytesseract.image_to_data(
+            image.pil(),
+            lang='+'.join(config['languages']),
+            config=config['config'],
+            timeout=config['timeout'],
+            output_type=pytesseract.Output.DICT
         )
         
+        # Process words and confidence
+        words = []
+        lines = {}
+        for i in range(len(data['text'])):
+            text = data['text'][i]
+            if text.strip():
+                lines.setdefault((data['block_num'][i], data['par_num'][i], data['line_num'][i]), []).append(text)
+            if int(float(data['conf'][i])) > 0:
+                words.append({
+                    'text': text,
+                    'confidence': int(float(data['conf'][i])),
+                    'bbox': [
+                        data['left'][i],
+                        data['top'][i],
+                        data['left'][i] + data['width'][i],
+                        data['top'][i] + data['height'][i]
+                    ]
+                })
+        
+        paragraphs = {}
+        for (block, paragraph, _), line_words in lines.items():
+            paragraphs.setdefault((block, paragraph), []).append(' '.join(line_words))
+        
+        avg_confidence = sum(w['confidence'] for w in words) / len(words) if words else 0
+        
+        return {
+            'success': True,
+            'text': '\n\n'.join('\n'.join(paragraph) for paragraph in paragraphs.values()),
+            'confidence': avg_confidence,
+            'words': words,
+            'blocks': [],
+            'provider': 'tesseract'
+        }
+    
+    def _easyocr_result(self, results: list, detail: int) -> Dict:
         words = []
         all_text = []
         
         for result in results:
-            if config['detail']:
+            if detail:
                 bbox, text, confidence = result
                 words.append({
                     'text': text,
@@ -219,12 +457,45 @@ class OCRService:
             'provider': 'easyocr'
         }
     
-    def _extract_paddleocr(self, image_path: str, options: Dict) -> Dict:
+    def _extract_easyocr(self, images: List[ImageInput], model=None) -> List[Dict]:
+        """Extract text using EasyOCR, one readtext_batched call per group of same-sized images"""
+        config = self.provider_config['easyocr']
+        reader = model or config['reader']
+        
+        # Decode up front so an unreadable image fails alone instead of taking its batch with it
+        results = [None] * len(images)
+        groups = {}
+        for index, image in enumerate(images):
+            try:
+                groups.setdefault(image.bgr().shape, []).append(index)
+            except Exception as e:
+                results[index] = self._failure(e)
+        
+        for indexes in groups.values():
+            try:
+                if len(indexes) > 1 and hasattr(reader, 'readtext_batched'):
+                    batch = reader.readtext_batched(
+                        [images[index].bgr() for index in indexes],
+                        batch_size=len(indexes),
+                        detail=config['detail'],
+                        paragraph=config['paragraph']
+                    )
+                else:
+                    batch = [reader.readtext(images[index].bgr(), detail=config['detail'],
+                                             paragraph=config['paragraph']) for index in indexes]
+                for index, found in zip(indexes, batch):
+                    results[index] = self._easyocr_result(found, config['detail'])
+            except Exception as e:
+                for index in indexes:
+                    results[index] = self._failure(e)
+        return results
+    
+    def _extract_paddleocr(self, image: ImageInput, options: Dict, model=None) -> Dict:
         """Extract text using PaddleOCR"""
         config = self.provider_config['paddleocr']
-        ocr = config['ocr']
+        ocr = model or config['ocr']
         
-        result = ocr.ocr(image_path, cls=config['cls'])
+        result = ocr.ocr(image.bgr(), cls=config['cls'])
         
         words = []
         all_text = []
@@ -251,52 +522,71 @@ class OCRService:
             'provider': 'paddleocr'
         }
     
-    def _extract_google_vision(self, image_path: str, options: Dict) -> Dict:
-        """Extract text using Google Cloud Vision"""
+    def _extract_google_vision(self, images: List[ImageInput]) -> List[Dict]:
+        """Extract text using Google Cloud Vision, up to GOOGLE_VISION_BATCH images per request"""
         from google.cloud import vision
         
         config = self.provider_config['google_vision']
         client = config['client']
+        feature = vision.Feature(type_=vision.Feature.Type.TEXT_DETECTION)
         
-        with open(image_path, 'rb') as image_file:
-            content = image_file.read()
-        
-        image = vision.Image(content=content)
-        response = client.text_detection(image=image)
-        
-        if response.error.message:
-            raise Exception(f"Google Vision API error: {response.error.message}")
-        
-        texts = response.text_annotations
-        words = []
-        full_text = ""
-        
-        if texts:
-            full_text = texts[0].description
+        # Read each image on its own so an unreadable one fails alone and is left out of the requests
+        results = [None] * len(images)
+        readable = []
+        for index, image in enumerate(images):
+            try:
+                readable.append((index, image.bytes()))
+            except Exception as e:
+                results[index] = self._failure(e)
+        
+        for start in range(0, len(readable), GOOGLE_VISION_BATCH):
+            chunk = readable[start:start + GOOGLE_VISION_BATCH]
+            requests = [vision.AnnotateImageRequest(image=vision.Image(content=content), features=[feature])
+                        for _, content in chunk]
+            batch = client.batch_annotate_images(requests=requests)
             
-            for text in texts[1:]:  # Skip the first one (full text)
-                vertices = text.bounding_poly.vertices
-                bbox = [
-                    min(v.x for v in vertices),
-                    min(v.y for v in vertices),
-                    max(v.x for v in vertices),
-                    max(v.y for v in vertices)
-                ]
+            for (index, _), response in zip(chunk, batch.responses):
+                if response.error.message:
+                    results[index] = self._failure(Exception(f"Google Vision API error: {response.error.message}"))
+                    continue
                 
-                words.append({
-                    'text': text.description,
-                    'confidence': 95,  # Google doesn't provide word-level confidence
-                    'bbox': bbox
-                })
-        
-        return {
-            'success': True,
-            'text': full_text,
-            'confidence': 95,
-            'words': words,
-            'blocks': [],
-            'provider': 'google_vision'
-        }
+                texts = response.text_annotations
+                words = []
+                full_text = ""
+                
+                if texts:
+                    full_text = texts[0].description
+                    
+                    for text in texts[1:]:  # Skip the first one (full text)
+                        vertices = text.bounding_poly.vertices
+                        bbox = [
+                            min(v.x for v in vertices),
+                            min(v.y for v in vertices),
+                            max(v.x for v in vertices),
+                            max(v.y for v in vertices)
+                        ]
+                        
+                        words.append({
+                            'text': text.description,
+                            'confidence': 95,  # Google doesn't provide word-level confidence
+                            'bbox': bbox
+                        })
+                
+                results[index] = {
+                    'success': True,
+                    'text': full_text,
+                    'confidence': 95,
+                    'words': words,
+                    'blocks': [],
+                    'provider': 'google_vision'
+                }
+        return results
+    
+    def close(self):
+        """Stop the batch workers (queued requests finish first)"""
+        if self.batcher is not None:
+            self.batcher.close()
+            self.batcher = None
 
 
 class QRCodeService:
@@ -361,20 +651,21 @@ class QRCodeService:
             return True
         return False
     
-    def scan_codes(self, image_path: str, options: Dict = None) -> Dict:
-        """Scan QR codes and barcodes from image"""
+    def scan_codes(self, image: Union[ImageInput, str, bytes], options: Dict = None) -> Dict:
+        """Scan QR codes and barcodes from an image path, encoded image bytes or ImageInput"""
         if not self.active_provider:
             raise RuntimeError("No QR code provider configured")
         
+        image = ImageInput.coerce(image)
         options = options or {}
         
         try:
             if self.active_provider == 'pyzbar':
-                return self._scan_pyzbar(image_path, options)
+                return self._scan_pyzbar(image, options)
             elif self.active_provider == 'opencv':
-                return self._scan_opencv(image_path, options)
+                return self._scan_opencv(image, options)
             elif self.active_provider == 'zxing':
-                return self._scan_zxing(image_path, options)
+                return self._scan_zxing(image, options)
         except Exception as e:
             return {
                 'success': False,
@@ -382,15 +673,17 @@ class QRCodeService:
                 'codes': []
             }
     
-    def _scan_pyzbar(self, image_path: str, options: Dict) -> Dict:
+    def scan_codes_batch(self, images: List[Union[ImageInput, str, bytes]], options: Dict = None) -> List[Dict]:
+        """Scan several images"""
+        return [self.scan_codes(image, options) for image in images]
+    
+    def _scan_pyzbar(self, image: ImageInput, options: Dict) -> Dict:
         """Scan codes using pyzbar"""
         from pyzbar import pyzbar
-        from PIL import Image
         
         config = self.provider_config['pyzbar']
         
-        with Image.open(image_path) as img:
-            decoded_objects = pyzbar.decode(img, symbols=config['symbols'])
+        decoded_objects = pyzbar.decode(image.pil(), symbols=config['symbols'])
         
         codes = []
         for obj in decoded_objects:
@@ -398,8 +691,8 @@ class QRCodeService:
                 'data': obj.data.decode('utf-8'),
                 'type': obj.type,
                 'quality': obj.quality if hasattr(obj, 'quality') else None,
-                'bbox': [obj.rect.left, obj.rect.top, 
-                        obj.rect.left + obj.rect.width, 
+                'bbox': [obj.rect.left, obj.rect.top,
+                        obj.rect.left + obj.rect.width,
                         obj.rect.top + obj.rect.height],
                 'polygon': [[p.x, p.y] for p in obj.polygon] if obj.polygon else None
             })
@@ -411,15 +704,12 @@ class QRCodeService:
             'provider': 'pyzbar'
         }
     
-    def _scan_opencv(self, image_path: str, options: Dict) -> Dict:
+    def _scan_opencv(self, image: ImageInput, options: Dict) -> Dict:
         """Scan QR codes using OpenCV"""
-        import cv2
-        
         config = self.provider_config['opencv']
         detector = config['detector']
         
-        img = cv2.imread(image_path)
-        data, points, _ = detector.detectAndDecode(img)
+        data, points, _ = detector.detectAndDecode(image.bgr())
         
         codes = []
         if data:
@@ -449,12 +739,13 @@ class QRCodeService:
             'provider': 'opencv'
         }
     
-    def _scan_zxing(self, image_path: str, options: Dict) -> Dict:
+    def _scan_zxing(self, image: ImageInput, options: Dict) -> Dict:
         """Scan codes using ZXing"""
         config = self.provider_config['zxing']
         reader = config['reader']
         
-        result = reader.decode(image_path)
+        # pyzxing runs the ZXing jar on a file, so bytes inputs get a temporary file here only
+        result = reader.decode(image.file_path())
         codes = []
         
         if result:
@@ -498,45 +789,43 @@ class FlashFlowOCRQRService:
             if self.qr.setup_provider(provider, self.config.get('qr', {})):
                 break
     
-    def process_image(self, image_path: str, operations: List[str] = None) -> Dict:
-        """Process image with OCR and/or QR scanning"""
+    def process_image(self, image: Union[ImageInput, str, bytes], operations: List[str] = None) -> Dict:
+        """Process an image path or encoded bytes with OCR and/or QR scanning, decoding it once"""
+        return self.process_batch([image], operations)[0]
+    
+    def process_batch(self, images: List[Union[ImageInput, str, bytes]], operations: List[str] = None) -> List[Dict]:
+        """Process several images; OCR runs as one batch and QR reuses each OCR decode"""
         operations = operations or ['ocr', 'qr']
-        results = {}
-        
-        if 'ocr' in operations:
-            results['ocr'] = self.ocr.extract_text(image_path)
+        inputs = [ImageInput.coerce(image) for image in images]
+        results = [{} for _ in inputs]
         
-        if 'qr' in operations:
-            results['qr'] = self.qr.scan_codes(image_path)
+        try:
+            if 'ocr' in operations:
+                for result, ocr in zip(results, self.ocr.extract_text_batch(inputs)):
+                    result['ocr'] = ocr
+            
+            if 'qr' in operations:
+                for result, image in zip(results, inputs):
+                    result['qr'] = self.qr.scan_codes(image)
+        finally:
+            for image, original in zip(inputs, images):
+                if image is not original:
+                    image.close()
         
-        return {
+        return [{
             'success': True,
-            'image_path': image_path,
+            'image_path': image.path,
             'operations': operations,
-            'results': results,
+            'results': result,
             'timestamp': json.dumps(None, default=str)
-        }
+        } for image, result in zip(inputs, results)]
     
-    def process_base64(self, base64_data: str, operations: List[str] = None, 
+    def process_base64(self, base64_data: str, operations: List[str] = None,
                       image_format: str = 'png') -> Dict:
-        """Process base64 encoded image"""
-        # Decode base64 and save to temporary file
-        image_data = base64.b64decode(base64_data)
-        
-        with tempfile.NamedTemporaryFile(suffix=f'.{image_format}', delete=False) as tmp_file:
-            tmp_file.write(image_data)
-            tmp_path = tmp_file.name
-        
-        try:
-            result = self.process_image(tmp_path, operations)
-            result['input_type'] = 'base64'
-            return result
-        finally:
-            # Clean up temporary file
-            try:
-                os.unlink(tmp_path)
-            except:
-                pass
+        """Process base64 encoded image in memory (the format is detected from its content)"""
+        result = self.process_image(base64.b64decode(base64_data), operations)
+        result['input_type'] = 'base64'
+        return result
     
     def get_provider_info(self) -> Dict:
         """Get information about active providers"""
@@ -544,5 +833,23 @@ class FlashFlowOCRQRService:
             'ocr_provider': self.ocr.active_provider,
             'qr_provider': self.qr.active_provider,
             'available_ocr': list(self.ocr.providers.keys()),
-            'available_qr': list(self.qr.providers.keys())
-        }
\ No newline at end of file
+            'available_qr': list(self.qr.providers.keys()),
+            'ocr_batching': self.ocr.batcher.stats() if self.ocr.batcher else None
+        }
+    
+    def close(self):
+        """Stop OCR batch workers"""
+        self.ocr.close()
+
+
+_service = None
+_service_lock = threading.Lock()
+
+
+def get_ocr_qr_service(config: Dict = None) -> FlashFlowOCRQRService:
+    """Process-wide service, so routes reuse warm models instead of loading them per request"""
+    global _service
+    with _service_lock:
+        if _service is None:
+            _service = FlashFlowOCRQRService(config)
+        return _service
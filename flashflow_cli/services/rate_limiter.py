@@ -0,0 +1,407 @@
+"""
+Rate Limiter Services for FlashFlow
+In-memory token buckets with a precompiled rule matcher, SQLite checkpoints and an optional shared-memory table
+"""
+
+import os
+import sys
+import time
+import struct
+import hashlib
+import logging
+import sqlite3
+import threading
+from collections import OrderedDict
+from typing import Any, Dict, List, Optional, Sequence, Tuple
+
+logger = logging.getLogger(__name__)
+
+DEFAULT_SHARDS = 16                 # Lock shards for local buckets
+DEFAULT_CHECKPOINT_INTERVAL = 5.0   # Seconds between SQLite checkpoints
+DEFAULT_MATCH_CACHE = 4096          # (endpoint, method) -> rules lookups remembered
+DEFAULT_SHARED_SLOTS = 65536        # Buckets in a shared-memory table
+SHARED_PROBES = 8                   # Slots probed per key before evicting the stalest
+
+SLOT = struct.Struct("<Qdd")        # key hash, tokens, monotonic stamp
+ALL_METHODS = "ALL"
+
+
+class RuleMatcher:
+    """Rate limit rules compiled for lookup by (endpoint, method).
+
+    Exact patterns live in a dict and trailing-"*" patterns in a character
+    trie, so a lookup costs one walk along the endpoint instead of a test
+    against every rule. Matches keep the rules' original order and are
+    cached, since an API sees the same few endpoints over and over.
+    """
+
+    def __init__(self, rules: Sequence[Any], cache_size: int = DEFAULT_MATCH_CACHE):
+        self.rules = [rule for rule in rules if getattr(rule, 'enabled', True)]
+        self.cache_size = cache_size
+        self._exact: Dict[str, List[int]] = {}
+        self._trie: Dict[str, Any] = {}
+        self._cache: "OrderedDict[Tuple[str, str], Tuple[Any, ...]]" = OrderedDict()
+        self._lock = threading.Lock()
+
+        for index, rule in enumerate(self.rules):
+            pattern = rule.endpoint_pattern
+            if pattern.endswith("*"):
+                node = self._trie
+                for char in pattern[:-1]:
+                    node = node.setdefault(char, {})
+                node.setdefault("", []).append(index)
+            else:
+                self._exact.setdefault(pattern, []).append(index)
+
+    def _lookup(self, endpoint: str, method: str) -> Tuple[Any, ...]:
+        indexes = list(self._exact.get(endpoint, ()))
+        node = self._trie
+        indexes.extend(node.get("", ()))
+        for char in endpoint:
+            node = node.get(char)
+            if node is None:
+                break
+            indexes.extend(node.get("", ()))
+
+        return tuple(self.rules[index] for index in sorted(indexes)
+                     if self.rules[index].method in (ALL_METHODS, method))
+
+    def match(self, endpoint: str, method: str) -> Tuple[Any, ...]:
+        """Enabled rules applying to a request, in rule order"""
+        key = (endpoint, method.upper())
+        with self._lock:
+            rules = self._cache.get(key)
+            if rules is not None:
+                self._cache.move_to_end(key)
+                return rules
+
+        rules = self._lookup(*key)
+        with self._lock:
+            self._cache[key] = rules
+            while len(self._cache) > self.cache_size:
+                self._cache.popitem(last=False)
+        return rules
+
+
+class _LocalBuckets:
+    """Token buckets in a process-local dict, split across lock shards"""
+
+    def __init__(self, shards: int):
+        self._shards = [(threading.Lock(), {}) for _ in range(max(1, shards))]
+
+    def _shard(self, key: str):
+        return self._shards[hash(key) % len(self._shards)]
+
+    def take(self, key: str, capacity: float, rate: float, cost: float, now: float) -> bool:
+        lock, buckets = self._shard(key)
+        with lock:
+            bucket = buckets.get(key)
+            if bucket is None:
+                tokens = capacity
+            else:
+                tokens = min(capacity, bucket[0] + (now - bucket[1]) * rate)
+            allowed = tokens >= cost
+            if allowed:
+                tokens -= cost
+            buckets[key] = [tokens, now, capacity, rate]
+            return allowed
+
+    def reset(self, key: Optional[str] = None):
+        for lock, buckets in self._shards:
+            with lock:
+                if key is None:
+                    buckets.clear()
+                else:
+                    buckets.pop(key, None)
+
+    def snapshot(self, now: float) -> List[Tuple[str, float, float, float, float]]:
+        """(key, tokens, stamp, capacity, rate) of buckets not yet full again; full ones are dropped"""
+        rows = []
+        for lock, buckets in self._shards:
+            with lock:
+                for key in list(buckets):
+                    tokens, stamp, capacity, rate = buckets[key]
+                    if tokens + (now - stamp) * rate >= capacity:
+                        del buckets[key]
+                    else:
+                        rows.append((key, tokens, stamp, capacity, rate))
+        return rows
+
+    def load(self, key: str, tokens: float, stamp: float, capacity: float, rate: float):
+        lock, buckets = self._shard(key)
+        with lock:
+            buckets[key] = [tokens, stamp, capacity, rate]
+
+    def __len__(self):
+        return sum(len(buckets) for _, buckets in self._shards)
+
+
+class _SharedBuckets:
+    """Token buckets in a named shared-memory table used by every process on the host.
+
+    Keys are hashed to a stable 64-bit value and placed by linear probing;
+    when SHARED_PROBES slots are taken the stalest one is reused, which
+    at worst forgets a bucket that has mostly refilled. Slots are grouped
+    into shards guarded by fcntl byte-range locks on a lock file named
+    after the segment, so unrelated workers (not forked from one parent)
+    can share it; a key only probes slots inside its own shard. Stamps use
+    time.monotonic(), which is system-wide on Linux.
+    """
+
+    def __init__(self, name: str, slots: int, shards: int):
+        import fcntl
+
+        self._fcntl = fcntl
+        self.name = name
+        self.shards = max(1, shards)
+        self.shard_slots = max(SHARED_PROBES, slots // self.shards)
+        self.slots = self.shard_slots * self.shards
+        size = self.slots * SLOT.size
+        try:
+            self._memory = _attach(name, create=True, size=size)
+            self._memory.buf[:size] = bytes(size)
+            self.created = True
+        except FileExistsError:
+            self._memory = _attach(name)
+            self.created = False
+            if self._memory.size < size:
+                raise ValueError(f"Shared rate limit table {name} is smaller than {self.slots} slots")
+        lock_dir = _lock_dir()
+        os.makedirs(lock_dir, exist_ok=True)
+        self._lock_path = os.path.join(lock_dir, f"{name}.lock")
+        self._lock_file = open(self._lock_path, 'a+b')
+        # fcntl locks exclude other processes only, so threads also take a per-shard lock
+        self._locks = [threading.Lock() for _ in range(self.shards)]
+
+    def _hash(self, key: str) -> int:
+        return int.from_bytes(hashlib.blake2b(key.encode('utf-8'), digest_size=8).digest(), 'little') | 1
+
+    def _slots(self, key_hash: int):
+        """Shard of a key and the slot indexes it may occupy, all inside that shard"""
+        shard = key_hash % self.shards
+        base = shard * self.shard_slots
+        home = (key_hash // self.shards) % self.shard_slots
+        return shard, [base + (home + probe) % self.shard_slots for probe in range(SHARED_PROBES)]
+
+    def _locked(self, shard: int):
+        fcntl, lock_file, lock = self._fcntl, self._lock_file, self._locks[shard]
+
+        class _ShardLock:
+            def __enter__(self):
+                lock.acquire()
+                fcntl.lockf(lock_file, fcntl.LOCK_EX, 1, shard)
+
+            def __exit__(self, *exc):
+                fcntl.lockf(lock_file, fcntl.LOCK_UN, 1, shard)
+                lock.release()
+
+        return _ShardLock()
+
+    def take(self, key: str, capacity: float, rate: float, cost: float, now: float) -> bool:
+        key_hash = self._hash(key)
+        shard, indexes = self._slots(key_hash)
+        buf = self._memory.buf
+
+        with self._locked(shard):
+            slot, stalest, stalest_stamp, tokens = None, indexes[0], None, capacity
+            for index in indexes:
+                stored_hash, stored_tokens, stamp = SLOT.unpack_from(buf, index * SLOT.size)
+                if stored_hash == key_hash:
+                    slot = index
+                    tokens = min(capacity, stored_tokens + (now - stamp) * rate)
+                    break
+                if stored_hash == 0:
+                    slot = index
+                    break
+                if stalest_stamp is None or stamp < stalest_stamp:
+                    stalest, stalest_stamp = index, stamp
+            if slot is None:
+                slot = stalest
+
+            allowed = tokens >= cost
+            if allowed:
+                tokens -= cost
+            SLOT.pack_into(buf, slot * SLOT.size, key_hash, tokens, now)
+            return allowed
+
+    def reset(self, key: Optional[str] = None):
+        buf = self._memory.buf
+        if key is None:
+            size = self.shard_slots * SLOT.size
+            for shard in range(self.shards):
+                with self._locked(shard):
+                    buf[shard * size:(shard + 1) * size] = bytes(size)
+            return
+
+        key_hash = self._hash(key)
+        shard, indexes = self._slots(key_hash)
+        with self._locked(shard):
+            for index in indexes:
+                if SLOT.unpack_from(buf, index * SLOT.size)[0] == key_hash:
+                    # Infinite tokens read back as a full bucket of whatever capacity the rule has
+                    SLOT.pack_into(buf, index * SLOT.size, key_hash, float('inf'), time.monotonic())
+
+    def __len__(self):
+        buf = self._memory.buf
+        return sum(1 for index in range(self.slots) if SLOT.unpack_from(buf, index * SLOT.size)[0])
+
+    def close(self, unlink: bool = False):
+        self._lock_file.close()
+        self._memory.close()
+        if unlink:
+            if sys.version_info < (3, 13):
+                from multiprocessing import resource_tracker
+                # unlink() unregisters the segment, which _attach already did
+                resource_tracker.register(self._memory._name, "shared_memory")
+            self._memory.unlink()
+            try:
+                os.unlink(self._lock_path)
+            except FileNotFoundError:
+                pass
+
+
+def _attach(name: str, create: bool = False, size: int = 0):
+    """A shared-memory segment that stays until unlinked, whichever process attached to it exits.
+
+    Before Python 3.13 every attaching process registers the segment with
+    its resource tracker, which unlinks it when that process exits, so the
+    table would not outlive the worker that happened to open it.
+    """
+    from multiprocessing import resource_tracker, shared_memory
+    if sys.version_info >= (3, 13):
+        return shared_memory.SharedMemory(name=name, create=create, size=size, track=False)
+    memory = shared_memory.SharedMemory(name=name, create=create, size=size)
+    resource_tracker.unregister(memory._name, "shared_memory")
+    return memory
+
+
+def _lock_dir() -> str:
+    return "/dev/shm" if os.path.isdir("/dev/shm") else os.path.join(os.path.expanduser("~"), ".flashflow")
+
+
+class RateLimiter:
+    """Token-bucket rate limiting without disk I/O on the request path.
+
+    A bucket holds up to `limit` tokens and refills at limit/window_seconds,
+    so sustained traffic is held to the rule's rate while short bursts up to
+    the limit still pass. Local buckets are checkpointed to SQLite every
+    checkpoint_interval seconds by a background thread and restored on
+    start, so a restart doesn't hand every client a fresh allowance. With
+    shared_name set, buckets live in a shared-memory table instead, which
+    every worker on the host opens by name and which outlives individual
+    workers; checkpointing is not used in that mode.
+    """
+
+    def __init__(self, db_path: Optional[str] = None, shards: int = DEFAULT_SHARDS,
+                 checkpoint_interval: float = DEFAULT_CHECKPOINT_INTERVAL,
+                 shared_name: Optional[str] = None, shared_slots: int = DEFAULT_SHARED_SLOTS):
+        self.db_path = db_path
+        self.checkpoint_interval = checkpoint_interval
+        self.stats = {'allowed': 0, 'limited': 0, 'checkpoints': 0}
+        self._stats_lock = threading.Lock()
+        self._stop = threading.Event()
+        self._thread = None
+
+        if shared_name:
+            self.buckets = _SharedBuckets(shared_name, shared_slots, shards)
+        else:
+            self.buckets = _LocalBuckets(shards)
+            if db_path:
+                self.setup()
+                self.restore()
+                if checkpoint_interval > 0:
+                    self._thread = threading.Thread(target=self._checkpoint_loop, daemon=True,
+                                                    name="flashflow-ratelimit")
+                    self._thread.start()
+
+    @property
+    def shared(self) -> bool:
+        return isinstance(self.buckets, _SharedBuckets)
+
+    def allow(self, key: str, limit: int, window_seconds: float, cost: float = 1) -> bool:
+        """Take cost tokens from key's bucket; False if it doesn't hold that many"""
+        if limit <= 0:
+            return False
+        rate = limit / window_seconds if window_seconds > 0 else float('inf')
+        allowed = self.buckets.take(key, float(limit), rate, cost, time.monotonic())
+        with self._stats_lock:
+            self.stats['allowed' if allowed else 'limited'] += 1
+        return allowed
+
+    def reset(self, key: Optional[str] = None):
+        """Refill one bucket, or all of them"""
+        self.buckets.reset(key)
+
+    def setup(self):
+        conn = sqlite3.connect(self.db_path)
+        conn.execute('''
+            CREATE TABLE IF NOT EXISTS rate_limit_buckets (
+                key TEXT PRIMARY KEY,
+                tokens REAL,
+                updated_at REAL,
+                capacity REAL,
+                rate REAL
+            )
+        ''')
+        conn.commit()
+        conn.close()
+
+    def restore(self) -> int:
+        """Load checkpointed buckets, aging them by the time spent offline"""
+        try:
+            conn = sqlite3.connect(self.db_path)
+            rows = conn.execute("SELECT key, tokens, updated_at, capacity, rate FROM rate_limit_buckets").fetchall()
+            conn.close()
+        except Exception as e:
+            logger.error(f"Error restoring rate limit state: {e}")
+            return 0
+
+        offset = time.monotonic() - time.time()
+        for key, tokens, updated_at, capacity, rate in rows:
+            self.buckets.load(key, tokens, updated_at + offset, capacity, rate)
+        return len(rows)
+
+    def checkpoint(self) -> int:
+        """Replace the stored state with buckets that are still draining"""
+        if self.shared or not self.db_path:
+            return 0
+        now = time.monotonic()
+        offset = time.time() - now
+        rows = [(key, tokens, stamp + offset, capacity, rate)
+                for key, tokens, stamp, capacity, rate in self.buckets.snapshot(now)]
+
+        try:
+            conn = sqlite3.connect(self.db_path)
+            with conn:
+                conn.execute("DELETE FROM rate_limit_buckets")
+                conn.executemany("INSERT INTO rate_limit_buckets VALUES (?, ?, ?, ?, ?)", rows)
+            conn.close()
+        except Exception as e:
+            logger.error(f"Error checkpointing rate limit state: {e}")
+            return 0
+
+        with self._stats_lock:
+            self.stats['checkpoints'] += 1
+        return len(rows)
+
+    def _checkpoint_loop(self):
+        while not self._stop.wait(self.checkpoint_interval):
+            self.checkpoint()
+
+    def get_stats(self) -> Dict[str, Any]:
+        with self._stats_lock:
+            stats = dict(self.stats)
+        stats['buckets'] = len(self.buckets)
+        stats['shared'] = self.shared
+        return stats
+
+    def close(self, unlink: bool = False):
+        """Stop checkpointing and write a final checkpoint; unlink removes a shared table"""
+        self._stop.set()
+        if self._thread is not None:
+            self._thread.join()
+            self._thread = None
+        if self.shared:
+            self.buckets.close(unlink)
+        else:
+            self.checkpoint()
@@ -3,31 +3,47 @@ Scientific Instruments Service for FlashFlow
 Provides laboratory equipment connectivity and scientific data acquisition
 """
 
+import csv
+import io
 import json
 import os
-from typing import Dict, Any, List
+import logging
+from typing import Dict, Any, List, Optional, Sequence
 import uuid
 from datetime import datetime
 import hashlib
 import math
 
+from .measurement_store import DEFAULT_CHUNK_RECORDS, DEFAULT_PERCENTILES, MeasurementStore, SeriesStats, measurement_dict
+from .telemetry_store import from_micros, to_micros
+
+logger = logging.getLogger(__name__)
+
+EXPORT_COLUMNS = ["Measurement ID", "Experiment ID", "Instrument ID", "Type", "Value", "Unit", "Timestamp"]
+EXPERIMENT_MEASUREMENT_IDS = 100  # Most recent measurement ids listed by get_experiment
+
 
 class ScientificService:
     """Service for managing scientific instruments and data acquisition"""
     
-    def __init__(self, storage_path: str = "storage/scientific"):
+    def __init__(self, storage_path: str = "storage/scientific",
+                 chunk_records: int = DEFAULT_CHUNK_RECORDS):
         """
         Initialize Scientific service
         
         Args:
             storage_path (str): Path to store scientific data
+            chunk_records (int): Measurements per sealed columnar chunk
         """
         self.storage_path = storage_path
         self.instruments_file = os.path.join(storage_path, "instruments.json")
         self.experiments_file = os.path.join(storage_path, "experiments.json")
         self.measurements_file = os.path.join(storage_path, "measurements.json")
         self.calibrations_file = os.path.join(storage_path, "calibrations.json")
+        self.measurement_store = MeasurementStore(os.path.join(storage_path, "measurements"), chunk_records)
+        self._active_instruments = set()
         self._ensure_storage()
+        self._migrate_measurements()
     
     def _ensure_storage(self):
         """Ensure storage directory exists"""
@@ -35,12 +51,34 @@ class ScientificService:
             os.makedirs(self.storage_path)
         
         # Initialize files if they don't exist
-        for file_path in [self.instruments_file, self.experiments_file, 
-                         self.measurements_file, self.calibrations_file]:
+        for file_path in [self.instruments_file, self.experiments_file, self.calibrations_file]:
             if not os.path.exists(file_path):
                 with open(file_path, 'w') as f:
                     json.dump({"data": []}, f)
     
+    def _migrate_measurements(self):
+        """Move measurements from the old measurements.json into the measurement store once"""
+        if not os.path.exists(self.measurements_file):
+            return
+        
+        with open(self.measurements_file, 'r') as f:
+            legacy = json.load(f)["data"]
+        
+        series = {}
+        for m in legacy:
+            if not math.isfinite(float(m["value"])):
+                logger.warning(f"Skipped migrating measurement {m['measurement_id']} with value {m['value']}")
+                continue
+            key = (m["experiment_id"], m["instrument_id"], m["measurement_type"], m["unit"])
+            series.setdefault(key, []).append((to_micros(m["timestamp"]), float(m["value"]),
+                                               m["measurement_id"], m.get("metadata") or None))
+        for key, measurements in series.items():
+            self.measurement_store.append_many(*key, measurements)
+        
+        os.replace(self.measurements_file, self.measurements_file + ".migrated")
+        if legacy:
+            logger.info(f"Migrated {len(legacy)} measurements to columnar storage")
+    
     def register_instrument(self, name: str, instrument_type: str,
                            vendor: str, model: str) -> str:
         """
@@ -193,13 +231,16 @@ class ScientificService:
             experiment_id (str): Experiment ID
             
         Returns:
-            dict: Experiment data
+            dict: Experiment data, with the measurement count and the most recent measurement ids
         """
         with open(self.experiments_file, 'r') as f:
             data = json.load(f)
         
         for experiment in data["data"]:
             if experiment["experiment_id"] == experiment_id:
+                experiment["measurement_count"] = self.measurement_store.count(experiment_id)
+                experiment["measurements"] = [m["measurement_id"] for m in self.measurement_store.recent(
+                    experiment_id, limit=EXPERIMENT_MEASUREMENT_IDS)]
                 return experiment
         
         raise ValueError(f"Experiment with ID {experiment_id} not found")
@@ -274,69 +315,56 @@ class ScientificService:
             value (float): Measurement value
             unit (str): Measurement unit
             metadata (dict): Additional metadata
-            
+        
         Returns:
             str: Measurement ID
-        """
-        measurement_id = str(uuid.uuid4())
-        measurement = {
-            "measurement_id": measurement_id,
-            "experiment_id": experiment_id,
-            "instrument_id": instrument_id,
-            "measurement_type": measurement_type,
-            "value": value,
-            "unit": unit,
-            "timestamp": datetime.now().isoformat(),
-            "metadata": metadata or {}
-        }
-        
-        # Load existing measurements
-        with open(self.measurements_file, 'r') as f:
-            data = json.load(f)
-        
-        # Add new measurement
-        data["data"].append(measurement)
-        
-        # Save updated measurements
-        with open(self.measurements_file, 'w') as f:
-            json.dump(data, f, indent=2)
-        
-        # Update instrument last used
-        self.update_instrument_status(instrument_id, "active")
-        
-        # Add measurement to experiment
-        self._add_measurement_to_experiment(experiment_id, measurement_id)
         
+        Raises:
+            ValueError: If the value is not a finite number
+        """
+        measurement_id = self.measurement_store.append(
+            experiment_id, instrument_id, measurement_type, unit, value, metadata=metadata
+        )
+        self._mark_instrument_active(instrument_id)
         return measurement_id
     
-    def _add_measurement_to_experiment(self, experiment_id: str, measurement_id: str) -> bool:
+    def record_measurements(self, experiment_id: str, instrument_id: str,
+                           measurement_type: str, values: Sequence[float], unit: str,
+                           timestamps: Optional[Sequence[Any]] = None) -> List[str]:
         """
-        Add measurement to experiment
+        Record a run of measurements from one instrument in a single write
         
         Args:
             experiment_id (str): Experiment ID
-            measurement_id (str): Measurement ID
-            
-        Returns:
-            bool: True if added successfully
-        """
-        with open(self.experiments_file, 'r') as f:
-            data = json.load(f)
-        
-        updated = False
-        for experiment in data["data"]:
-            if experiment["experiment_id"] == experiment_id:
-                if measurement_id not in experiment["measurements"]:
-                    experiment["measurements"].append(measurement_id)
-                    updated = True
-                break
-        
-        if updated:
-            with open(self.experiments_file, 'w') as f:
-                json.dump(data, f, indent=2)
-            return True
+            instrument_id (str): Instrument ID
+            measurement_type (str): Type of measurement
+            values (list): Measurement values
+            unit (str): Measurement unit
+            timestamps (list): Timestamp per value (datetime, ISO string or epoch µs); now if omitted
         
-        return False
+        Returns:
+            list: Measurement IDs
+        
+        Raises:
+            ValueError: If a value is not a finite number, or timestamps don't match values
+        """
+        if timestamps is not None and len(timestamps) != len(values):
+            raise ValueError("Need one timestamp per value")
+        
+        now = to_micros(None)
+        measurement_ids = [str(uuid.uuid4()) for _ in values]
+        self.measurement_store.append_many(experiment_id, instrument_id, measurement_type, unit, [
+            (to_micros(timestamps[i]) if timestamps is not None else now, float(value), measurement_ids[i], None)
+            for i, value in enumerate(values)
+        ])
+        self._mark_instrument_active(instrument_id)
+        return measurement_ids
+    
+    def _mark_instrument_active(self, instrument_id: str):
+        """Set an instrument active on its first measurement, not rewriting instruments.json per measurement"""
+        if instrument_id not in self._active_instruments:
+            self.update_instrument_status(instrument_id, "active")
+            self._active_instruments.add(instrument_id)
     
     def get_measurements(self, experiment_id: str = None, 
                         instrument_id: str = None, limit: int = 100) -> List[Dict[str, Any]]:
@@ -347,24 +375,12 @@ class ScientificService:
             experiment_id (str): Filter by experiment ID
             instrument_id (str): Filter by instrument ID
             limit (int): Maximum number of records to return
-            
+        
         Returns:
             list: Measurements
         """
-        with open(self.measurements_file, 'r') as f:
-            data = json.load(f)
-        
-        measurements = data["data"]
-        
-        # Apply filters
-        if experiment_id:
-            measurements = [m for m in measurements if m["experiment_id"] == experiment_id]
-        
-        if instrument_id:
-            measurements = [m for m in measurements if m["instrument_id"] == instrument_id]
-        
-        # Return most recent records up to limit
-        return measurements[-limit:] if len(measurements) > limit else measurements
+        # Most recent records up to limit, reading only the newest chunks of each series
+        return self.measurement_store.recent(experiment_id, instrument_id, limit)
     
     def calibrate_instrument(self, instrument_id: str, calibration_data: Dict[str, Any]) -> str:
         """
@@ -446,74 +462,145 @@ class ScientificService:
         
         return [c for c in data["data"] if c["instrument_id"] == instrument_id]
     
-    def analyze_data(self, measurement_ids: List[str]) -> Dict[str, Any]:
+    def analyze_data(self, measurement_ids: List[str] = None, experiment_id: str = None,
+                     instrument_id: str = None, measurement_type: str = None,
+                     start: Any = None, end: Any = None, window_seconds: float = None,
+                     percentiles: Sequence[float] = DEFAULT_PERCENTILES) -> Dict[str, Any]:
         """
         Perform basic data analysis on measurements
         
+        Statistics over a series come from merging the count/mean/M2/min/max
+        summaries stored with each sealed chunk, so only chunks cut by the
+        time range are decoded. Percentiles come from mergeable quantile
+        sketches and are within 1% of the exact value.
+        
         Args:
-            measurement_ids (list): List of measurement IDs to analyze
-            
+            measurement_ids (list): Measurement IDs to analyze (exact, scans stored chunks)
+            experiment_id (str): Analyze an experiment's measurements instead
+            instrument_id (str): Filter by instrument ID
+            measurement_type (str): Filter by measurement type
+            start: Earliest timestamp to include
+            end: Latest timestamp to include
+            window_seconds (float): Also return tumbling-window aggregates of this width
+            percentiles (list): Percentiles to estimate
+        
         Returns:
             dict: Analysis results
         """
-        measurements = []
-        for measurement_id in measurement_ids:
-            # In a real implementation, we would fetch each measurement
-            # For now, we'll simulate by generating random data
-            import random
-            random.seed(hash(measurement_id))
-            measurements.append({
-                "id": measurement_id,
-                "value": random.uniform(0, 100)
-            })
-        
-        if not measurements:
+        if measurement_ids:
+            stats = SeriesStats.of(self.measurement_store.lookup(measurement_ids))
+        elif experiment_id or instrument_id or measurement_type:
+            stats = self.measurement_store.stats(experiment_id, instrument_id, measurement_type,
+                                                 start, end, sketch=bool(percentiles))
+        else:
             return {"error": "No measurements provided"}
         
-        values = [m["value"] for m in measurements]
-        
-        # Calculate basic statistics
-        mean = sum(values) / len(values)
-        variance = sum((x - mean) ** 2 for x in values) / len(values)
-        std_dev = math.sqrt(variance)
+        if not stats.count:
+            return {"error": "No measurements found"}
         
-        return {
-            "count": len(values),
-            "mean": round(mean, 4),
-            "std_dev": round(std_dev, 4),
-            "min": min(values),
-            "max": max(values),
-            "range": max(values) - min(values)
-        }
+        result = stats.to_dict(percentiles)
+        if window_seconds and not measurement_ids:
+            result["windows"] = self.measurement_store.windows(
+                window_seconds, experiment_id, instrument_id, measurement_type, start, end
+            )
+        return result
     
-    def export_data(self, experiment_id: str, format: str = "csv") -> str:
+    def export_data(self, experiment_id: str, format: str = "csv", output_path: str = None) -> str:
         """
         Export experiment data
         
+        Rows stream from the stored chunks one chunk at a time. With
+        output_path they are written straight to that file.
+        
         Args:
             experiment_id (str): Experiment ID
-            format (str): Export format (csv, json, etc.)
-            
+            format (str): Export format (csv, json or parquet)
+            output_path (str): File to write; required for parquet
+        
         Returns:
             str: Export file path or content
         """
         experiment = self.get_experiment(experiment_id)
-        measurements = self.get_measurements(experiment_id=experiment_id)
+        chunks = self.measurement_store.rows(experiment_id=experiment_id)
         
         if format == "json":
             export_data = {
                 "experiment": experiment,
-                "measurements": measurements
+                "measurements": [m for measurements in self._measurement_dicts(chunks) for m in measurements]
             }
-            return json.dumps(export_data, indent=2)
+            content = json.dumps(export_data, indent=2)
         elif format == "csv":
-            # Create CSV content
-            csv_content = "Measurement ID,Experiment ID,Instrument ID,Type,Value,Unit,Timestamp\n"
-            for measurement in measurements:
-                csv_content += f"{measurement['measurement_id']},{measurement['experiment_id']},{measurement['instrument_id']},{measurement['measurement_type']},{measurement['value']},{measurement['unit']},{measurement['timestamp']}\n"
-            return csv_content
+            if output_path:
+                with open(output_path, 'w', newline='') as f:
+                    self._write_csv(f, chunks)
+                return output_path
+            buffer = io.StringIO()
+            self._write_csv(buffer, chunks)
+            return buffer.getvalue()
+        elif format == "parquet":
+            if not output_path:
+                return "Export format parquet requires an output path"
+            try:
+                self._write_parquet(output_path, chunks)
+            except ImportError:
+                return "Export format parquet requires pyarrow"
+            return output_path
         else:
             return f"Export format {format} not supported"
+        
+        if output_path:
+            with open(output_path, 'w') as f:
+                f.write(content)
+            return output_path
+        return content
+    
+    @staticmethod
+    def _measurement_dicts(chunks):
+        for manifest, chunk in chunks:
+            yield [measurement_dict(manifest, chunk, i) for i in range(len(chunk.values))]
+    
+    @staticmethod
+    def _write_csv(f, chunks):
+        writer = csv.writer(f, lineterminator="\n")
+        writer.writerow(EXPORT_COLUMNS)
+        for manifest, chunk in chunks:
+            series = (manifest["experiment_id"], manifest["instrument_id"], manifest["measurement_type"])
+            unit = manifest["unit"]
+            writer.writerows(
+                (chunk.measurement_id(i), *series, chunk.values[i], unit, from_micros(chunk.timestamps[i]))
+                for i in range(len(chunk.values))
+            )
+    
+    @staticmethod
+    def _write_parquet(output_path: str, chunks):
+        """One row group per chunk; value, timestamp and id columns wrap the chunk buffers without copying"""
+        import pyarrow as pa
+        import pyarrow.parquet as pq
+        
+        schema = pa.schema([
+            ("measurement_id", pa.binary(16)),
+            ("experiment_id", pa.string()),
+            ("instrument_id", pa.string()),
+            ("measurement_type", pa.string()),
+            ("value", pa.float64()),
+            ("unit", pa.string()),
+            ("timestamp", pa.timestamp("us", tz="UTC")),
+            ("metadata", pa.string())
+        ])
+        with pq.ParquetWriter(output_path, schema) as writer:
+            for manifest, chunk in chunks:
+                n = len(chunk.values)
+                metadata = [json.dumps(chunk.metadata[i], default=str) if i in chunk.metadata else None for i in range(n)]
+                writer.write_table(pa.Table.from_arrays([
+                    pa.Array.from_buffers(pa.binary(16), n, [None, pa.py_buffer(chunk.ids)]),
+                    pa.array([manifest["experiment_id"]] * n),
+                    pa.array([manifest["instrument_id"]] * n),
+                    pa.array([manifest["measurement_type"]] * n),
+                    pa.Array.from_buffers(pa.float64(), n, [None, pa.py_buffer(chunk.values)]),
+                    pa.array([manifest["unit"]] * n),
+                    pa.Array.from_buffers(pa.timestamp("us", tz="UTC"), n, [None, pa.py_buffer(chunk.timestamps)]),
+                    pa.array(metadata, type=pa.string())
+                ], schema=schema))
     
     def delete_instrument(self, instrument_id: str) -> bool:
         """
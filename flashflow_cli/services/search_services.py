@@ -6,16 +6,42 @@ Provides advanced search functionality with multiple backends and AI-powered fea
 import os
 import json
 import re
+import time
 import sqlite3
 import logging
-from typing import Dict, Any, List, Optional, Union, Tuple
-from dataclasses import dataclass, asdict
+import threading
+import queue
+from typing import Dict, Any, List, Optional, Union, Tuple, Callable, Iterator
+from dataclasses import dataclass, asdict, field
 from datetime import datetime, timedelta
-from collections import defaultdict, Counter
+from collections import defaultdict, Counter, OrderedDict
+from concurrent.futures import ThreadPoolExecutor
+from contextlib import contextmanager
 import hashlib
+import secrets
+
+from .analytics_services import EventRingBuffer, DROP_OLDEST
 
 logger = logging.getLogger(__name__)
 
+DEFAULT_STATEMENT_CACHE = 256             # Prepared statements kept per connection
+DEFAULT_READER_POOL_SIZE = 4              # Read-only connections shared by searching threads
+DEFAULT_ANALYTICS_BUFFER = 10000          # Search analytics rows buffered before the oldest are dropped
+DEFAULT_ANALYTICS_BATCH_SIZE = 500        # Rows per analytics write
+DEFAULT_ANALYTICS_FLUSH_INTERVAL = 1.0    # Max seconds a row waits before being written
+DEFAULT_CURSOR_WINDOW = 1000              # Ranked rows fetched at once for cursor pages
+DEFAULT_CURSOR_TTL = 300.0                # Seconds a pagination cursor stays valid
+DEFAULT_CURSOR_CACHE_SIZE = 128           # Pagination cursors kept
+DEFAULT_SNIPPET_TOKENS = 16               # Tokens per content snippet
+DEFAULT_REBUILD_BATCH = 1000              # Documents embedded at once when the vector index is rebuilt
+
+ANALYTICS_INSERT = "INSERT INTO search_analytics (query, results_count, query_time) VALUES (?, ?, ?)"
+MATCH_START, MATCH_END = "\x02", "\x03"  # Marks FTS5 puts around matches, swapped for highlight_markers
+SUGGESTION_UPSERT = """
+    INSERT INTO search_suggestions (query, count, last_used) VALUES (?, 1, CURRENT_TIMESTAMP)
+    ON CONFLICT(query) DO UPDATE SET count = count + 1, last_used = CURRENT_TIMESTAMP
+"""
+
 @dataclass
 class SearchResult:
     """Search result item"""
@@ -38,6 +64,7 @@ class SearchQuery:
     per_page: int
     facets: List[str]
     suggest: bool
+    cursor: Optional[str] = None  # next_cursor of a previous page; page is ignored when set
 
 @dataclass
 class SearchStats:
@@ -47,6 +74,19 @@ class SearchStats:
     facets: Dict[str, List[Dict[str, Any]]]
     suggestions: List[str]
     related_queries: List[str]
+    stage_times: Dict[str, float] = field(default_factory=dict)  # Seconds per pipeline stage
+    next_cursor: Optional[str] = None  # Pass as SearchQuery.cursor for the following page
+
+@dataclass
+class _SearchCursor:
+    """A search kept for cursor pagination: its total, facets and a window of ranked rows"""
+    fts_query: str
+    total: int
+    facets: Dict[str, List[Dict[str, Any]]]
+    window: List[Tuple[int, float, str, str]] = field(default_factory=list)  # (rowid, rank, highlight, snippet)
+    window_start: int = 0
+    key: Optional[str] = None
+    expires: float = 0.0
 
 class SearchEngineBase:
     """Base class for search engines"""
@@ -76,90 +116,165 @@ class SearchEngineBase:
         raise NotImplementedError
 
 class SQLiteSearchEngine(SearchEngineBase):
-    """SQLite-based search engine with FTS support"""
+    """SQLite-based search engine with FTS support
+    
+    Connections are opened once and reused: searches check a read-only WAL
+    connection out of a pool of at most reader_pool_size (waiting when all
+    are busy) and hand it back afterwards, and index writes go through a
+    single writer connection. sqlite3 keeps prepared statements per connection, so
+    the fixed SQL below is compiled once per connection instead of on every
+    call. Analytics rows and suggestion counts are buffered and written in
+    batches by a background thread rather than inside search(). Highlights
+    come from FTS5's highlight()/snippet(); highlight_markers wraps matched
+    terms and defaults to none, since the generated UI renders plain text.
+    """
     
     def __init__(self, config: Dict[str, Any]):
         super().__init__(config)
         self.name = "sqlite"
         self.db_path = config.get('db_path', 'search.db')
+        self._in_memory = self.db_path == ':memory:'  # One connection only; readers share the writer
+        # Slots start empty and are filled with a connection on first checkout
+        self._reader_pool: "queue.LifoQueue[Optional[sqlite3.Connection]]" = queue.LifoQueue()
+        for _ in range(max(1, config.get('reader_pool_size', DEFAULT_READER_POOL_SIZE))):
+            self._reader_pool.put(None)
+        self._write_lock = threading.RLock()
+        self._writer_conn = None
         self.setup_database()
+        
+        self.flush_interval = config.get('analytics_flush_interval', DEFAULT_ANALYTICS_FLUSH_INTERVAL)
+        self.analytics_queue = EventRingBuffer(config.get('analytics_buffer', DEFAULT_ANALYTICS_BUFFER),
+                                               DROP_OLDEST,
+                                               config.get('analytics_batch_size', DEFAULT_ANALYTICS_BATCH_SIZE))
+        self.analytics_errors = 0
+        self._flush_active = True
+        self._flush_thread = threading.Thread(target=self._flush_analytics_loop, daemon=True,
+                                              name="flashflow-search-analytics")
+        self._flush_thread.start()
+        
+        self.cursor_window = config.get('cursor_window', DEFAULT_CURSOR_WINDOW)
+        self.cursor_ttl = config.get('cursor_ttl', DEFAULT_CURSOR_TTL)
+        self.cursor_cache_size = config.get('cursor_cache_size', DEFAULT_CURSOR_CACHE_SIZE)
+        self.snippet_tokens = config.get('snippet_tokens', DEFAULT_SNIPPET_TOKENS)
+        self.highlight_markers = tuple(config.get('highlight_markers', ("", "")))  # e.g. ("<mark>", "</mark>")
+        self._cursors: "OrderedDict[str, _SearchCursor]" = OrderedDict()
+        self._cursor_lock = threading.Lock()
+        self._executor = ThreadPoolExecutor(max_workers=config.get('facet_workers', 2),
+                                            thread_name_prefix="search-facets")
+    
+    def _writer(self) -> sqlite3.Connection:
+        if self._writer_conn is None:
+            conn = sqlite3.connect(self.db_path, check_same_thread=False,
+                                   cached_statements=DEFAULT_STATEMENT_CACHE)
+            conn.execute('PRAGMA journal_mode=WAL')
+            conn.execute('PRAGMA synchronous=NORMAL')
+            self._writer_conn = conn
+        return self._writer_conn
+    
+    @contextmanager
+    def _reading(self):
+        """A pooled read connection, checked back in when the block exits"""
+        if self._in_memory:
+            with self._write_lock:
+                yield self._writer()
+            return
+        
+        conn = self._reader_pool.get()
+        try:
+            if conn is None:
+                conn = sqlite3.connect(self.db_path, check_same_thread=False,
+                                       cached_statements=DEFAULT_STATEMENT_CACHE)
+                conn.execute('PRAGMA query_only=ON')
+            yield conn
+        finally:
+            self._reader_pool.put(conn)
+    
+    @contextmanager
+    def _writing(self):
+        """The writer connection inside a transaction, committed on success"""
+        with self._write_lock:
+            conn = self._writer()
+            with conn:
+                yield conn
     
     def setup_database(self):
         """Initialize SQLite FTS database"""
         try:
-            conn = sqlite3.connect(self.db_path)
-            cursor = conn.cursor()
-            
-            # Create FTS virtual table
-            cursor.execute('''
-                CREATE VIRTUAL TABLE IF NOT EXISTS search_index 
-                USING fts5(id, title, content, type, metadata, tokenize='porter')
-            ''')
-            
-            # Create suggestions table
-            cursor.execute('''
-                CREATE TABLE IF NOT EXISTS search_suggestions (
-                    query TEXT PRIMARY KEY,
-                    count INTEGER DEFAULT 1,
-                    last_used TIMESTAMP DEFAULT CURRENT_TIMESTAMP
-                )
-            ''')
-            
-            # Create analytics table
-            cursor.execute('''
-                CREATE TABLE IF NOT EXISTS search_analytics (
-                    id INTEGER PRIMARY KEY AUTOINCREMENT,
-                    query TEXT,
-                    results_count INTEGER,
-                    query_time REAL,
-                    user_id TEXT,
-                    timestamp TIMESTAMP DEFAULT CURRENT_TIMESTAMP
-                )
-            ''')
+            with self._writing() as conn:
+                cursor = conn.cursor()
+                
+                # Create FTS virtual table
+                cursor.execute('''
+                    CREATE VIRTUAL TABLE IF NOT EXISTS search_index
+                    USING fts5(id, title, content, type, metadata, tokenize='porter')
+                ''')
+                
+                # Facet columns by FTS rowid, so facet counts don't read rows back out of the FTS table
+                facets_exist = cursor.execute(
+                    "SELECT 1 FROM sqlite_master WHERE name = 'search_facets'"
+                ).fetchone()
+                cursor.execute('''
+                    CREATE TABLE IF NOT EXISTS search_facets (
+                        rowid INTEGER PRIMARY KEY,
+                        type TEXT,
+                        metadata TEXT
+                    )
+                ''')
+                if not facets_exist:
+                    cursor.execute('INSERT INTO search_facets SELECT rowid, type, metadata FROM search_index')
+                
+                # Create suggestions table
+                cursor.execute('''
+                    CREATE TABLE IF NOT EXISTS search_suggestions (
+                        query TEXT PRIMARY KEY,
+                        count INTEGER DEFAULT 1,
+                        last_used TIMESTAMP DEFAULT CURRENT_TIMESTAMP
+                    )
+                ''')
+                
+                # Create analytics table
+                cursor.execute('''
+                    CREATE TABLE IF NOT EXISTS search_analytics (
+                        id INTEGER PRIMARY KEY AUTOINCREMENT,
+                        query TEXT,
+                        results_count INTEGER,
+                        query_time REAL,
+                        user_id TEXT,
+                        timestamp TIMESTAMP DEFAULT CURRENT_TIMESTAMP
+                    )
+                ''')
             
-            conn.commit()
-            conn.close()
             logger.info("SQLite search database initialized")
-            
+        
         except Exception as e:
             logger.error(f"Failed to setup SQLite search database: {e}")
             raise
     
-    def index_document(self, doc_id: str, document: Dict[str, Any]) -> bool:
-        """Index a single document"""
+    def index_document(self, doc_id: str, document: Dict[str, Any], rowid: Optional[int] = None) -> bool:
+        """Index a single document, optionally under an explicit FTS rowid"""
         try:
-            conn = sqlite3.connect(self.db_path)
-            cursor = conn.cursor()
-            
-            cursor.execute('''
-                INSERT OR REPLACE INTO search_index 
-                (id, title, content, type, metadata)
-                VALUES (?, ?, ?, ?, ?)
-            ''', (
-                doc_id,
-                document.get('title', ''),
-                document.get('content', ''),
-                document.get('type', 'document'),
-                json.dumps(document.get('metadata', {}))
-            ))
-            
-            conn.commit()
-            conn.close()
+            with self._writing() as conn:
+                self._insert(conn, [(
+                    rowid,
+                    doc_id,
+                    document.get('title', ''),
+                    document.get('content', ''),
+                    document.get('type', 'document'),
+                    json.dumps(document.get('metadata', {}))
+                )])
             return True
-            
+        
         except Exception as e:
             logger.error(f"Failed to index document {doc_id}: {e}")
             return False
     
     def bulk_index(self, documents: List[Dict[str, Any]]) -> bool:
-        """Index multiple documents"""
+        """Index multiple documents (a document may carry an explicit 'rowid')"""
         try:
-            conn = sqlite3.connect(self.db_path)
-            cursor = conn.cursor()
-            
             data = []
             for doc in documents:
                 data.append((
+                    doc.get('rowid'),
                     doc.get('id', ''),
                     doc.get('title', ''),
                     doc.get('content', ''),
@@ -167,90 +282,86 @@ class SQLiteSearchEngine(SearchEngineBase):
                     json.dumps(doc.get('metadata', {}))
                 ))
             
-            cursor.executemany('''
-                INSERT OR REPLACE INTO search_index 
-                (id, title, content, type, metadata)
-                VALUES (?, ?, ?, ?, ?)
-            ''', data)
+            with self._writing() as conn:
+                self._insert(conn, data)
             
-            conn.commit()
-            conn.close()
             logger.info(f"Bulk indexed {len(documents)} documents")
             return True
-            
+        
         except Exception as e:
             logger.error(f"Failed to bulk index documents: {e}")
             return False
     
+    def _insert(self, conn: sqlite3.Connection, rows: List[tuple]):
+        """Write (rowid, id, title, content, type, metadata) rows to the FTS and facet tables"""
+        cursor = conn.cursor()
+        facet_rows = []
+        for row in rows:
+            cursor.execute('''
+                INSERT OR REPLACE INTO search_index
+                (rowid, id, title, content, type, metadata)
+                VALUES (?, ?, ?, ?, ?, ?)
+            ''', row)
+            facet_rows.append((cursor.lastrowid, row[4], row[5]))
+        cursor.executemany('INSERT OR REPLACE INTO search_facets (rowid, type, metadata) VALUES (?, ?, ?)', facet_rows)
+    
     def search(self, query: SearchQuery) -> Tuple[List[SearchResult], SearchStats]:
-        """Perform search with FTS"""
-        start_time = datetime.now()
+        """Perform search with FTS
+        
+        The ranked page is read with FTS5 highlight()/snippet() while the
+        total and facets are aggregated on another connection. A returned
+        next_cursor keeps the total and facets; the first page fetched
+        through it ranks the next cursor_window matches once, and every page
+        inside that window is then served from rowids without another MATCH.
+        """
+        started = time.perf_counter()
         
         try:
-            conn = sqlite3.connect(self.db_path)
-            cursor = conn.cursor()
-            
             # Build FTS query
             fts_query = self._build_fts_query(query.query)
+            if query.filters and query.filters.get('type'):
+                fts_query = self._restrict_type(fts_query, query.filters['type'])
+            entry, offset = self._resume(query.cursor, fts_query)
+            stage_times = {}
             
-            # Execute search
-            cursor.execute('''
-                SELECT id, title, content, type, metadata, rank
-                FROM search_index
-                WHERE search_index MATCH ?
-                ORDER BY rank
-                LIMIT ? OFFSET ?
-            ''', (fts_query, query.per_page, query.page * query.per_page))
+            if entry is None:
+                offset = query.page * query.per_page
+                aggregate = self._executor.submit(self._aggregate, fts_query, query.facets)
+                ranked = self._ranked(fts_query, query.per_page, offset)
+                stage_times['rank'] = time.perf_counter() - started
+                total_count, facets, stage_times['facets'] = aggregate.result()
+                entry = _SearchCursor(fts_query, total_count, facets)
+            else:
+                ranked = self._window(entry, offset, query.per_page)
+                stage_times['rank'] = time.perf_counter() - started
             
-            rows = cursor.fetchall()
+            fetch_started = time.perf_counter()
+            results = self._documents(ranked)
+            stage_times['fetch'] = time.perf_counter() - fetch_started
             
-            # Convert to SearchResult objects
-            results = []
-            for row in rows:
-                doc_id, title, content, doc_type, metadata_json, rank = row
-                metadata = json.loads(metadata_json) if metadata_json else {}
-                
-                # Generate highlights
-                highlights = self._generate_highlights(query.query, title + " " + content)
-                
-                results.append(SearchResult(
-                    id=doc_id,
-                    title=title,
-                    content=content[:200] + "..." if len(content) > 200 else content,
-                    type=doc_type,
-                    score=1.0 / (rank + 1),  # Convert rank to score
-                    highlights=highlights,
-                    metadata=metadata
-                ))
-            
-            # Get total count
-            cursor.execute('''
-                SELECT COUNT(*) FROM search_index WHERE search_index MATCH ?
-            ''', (fts_query,))
-            total_count = cursor.fetchone()[0]
-            
-            # Generate facets
-            facets = self._generate_facets(cursor, fts_query)
+            next_cursor = None
+            if offset + query.per_page < entry.total:
+                next_cursor = self._remember(entry, offset + query.per_page)
             
             # Get suggestions
             suggestions = self.suggest(query.query) if query.suggest else []
             
-            conn.close()
-            
             # Record analytics
-            query_time = (datetime.now() - start_time).total_seconds()
-            self._record_analytics(query.query, total_count, query_time)
+            query_time = time.perf_counter() - started
+            self._record_analytics(query.query, entry.total, query_time)
             
             stats = SearchStats(
-                total_results=total_count,
+                total_results=entry.total,
                 query_time=query_time,
-                facets=facets,
+                facets=entry.facets,
                 suggestions=suggestions,
-                related_queries=[]
+                related_queries=[],
+                stage_times=stage_times,
+                next_cursor=next_cursor
             )
             
             return results, stats
-            
+        
         except Exception as e:
             logger.error(f"Search failed: {e}")
             return [], SearchStats(
@@ -261,32 +372,167 @@ class SQLiteSearchEngine(SearchEngineBase):
                 related_queries=[]
             )
     
+    def _ranked(self, fts_query: str, limit: int, offset: int) -> List[Tuple[int, float, str, str]]:
+        """(rowid, rank, title highlight, content snippet) of matches in rank order"""
+        start, end = MATCH_START, MATCH_END
+        with self._reading() as conn:
+            return conn.execute('''
+                SELECT rowid, rank,
+                       highlight(search_index, 1, ?, ?),
+                       snippet(search_index, 2, ?, ?, '...', ?)
+                FROM search_index
+                WHERE search_index MATCH ?
+                ORDER BY rank
+                LIMIT ? OFFSET ?
+            ''', (start, end, start, end, self.snippet_tokens, fts_query, limit, offset)).fetchall()
+    
+    def _window(self, entry: '_SearchCursor', offset: int, count: int) -> List[Tuple[int, float, str, str]]:
+        """Ranked rows for a cursor page, ranking a new window only when the page falls outside it"""
+        window_end = entry.window_start + len(entry.window)
+        covered = entry.window_start <= offset and (offset + count <= window_end or window_end >= entry.total)
+        if not entry.window or not covered:
+            entry.window = self._ranked(entry.fts_query, max(self.cursor_window, count), offset)
+            entry.window_start = offset
+        position = offset - entry.window_start
+        return entry.window[position:position + count]
+    
+    def _documents(self, ranked: List[Tuple[int, float, str, str]]) -> List[SearchResult]:
+        """SearchResults for ranked rows, with stored fields looked up by rowid"""
+        if not ranked:
+            return []
+        
+        placeholders = ",".join("?" * len(ranked))
+        with self._reading() as conn:
+            rows = conn.execute(f'''
+                SELECT rowid, id, title, content, type, metadata
+                FROM search_index
+                WHERE rowid IN ({placeholders})
+            ''', [row[0] for row in ranked]).fetchall()
+        
+        start, end = self.highlight_markers
+        by_rowid = {row[0]: row for row in rows}
+        results = []
+        for rowid, rank, title_highlight, snippet in ranked:
+            row = by_rowid.get(rowid)
+            if row is None:  # Deleted since the cursor was created
+                continue
+            _, doc_id, title, content, doc_type, metadata_json = row
+            highlights = [text.replace(MATCH_START, start).replace(MATCH_END, end)
+                          for text in (title_highlight, snippet) if text and MATCH_START in text]
+            
+            results.append(SearchResult(
+                id=doc_id,
+                title=title,
+                content=content[:200] + "..." if len(content) > 200 else content,
+                type=doc_type,
+                score=1.0 / (rank + 1),  # Convert rank to score
+                highlights=highlights,
+                metadata=json.loads(metadata_json) if metadata_json else {}
+            ))
+        return results
+    
+    def _aggregate(self, fts_query: str, facet_fields: List[str]) -> Tuple[int, Dict[str, List[Dict[str, Any]]], float]:
+        """Total and facet counts from one GROUP BY pass over the matched rowids
+        
+        Facet values are read from search_facets, a rowid-keyed table, since
+        reading columns back out of the FTS table costs far more than the
+        match itself.
+        """
+        started = time.perf_counter()
+        fields = list(dict.fromkeys(facet_fields or []))
+        columns, params = [], []
+        for name in fields:
+            if name == 'type':
+                columns.append("f.type")
+            else:
+                columns.append("json_extract(f.metadata, ?)")
+                params.append(f'$."{name}"')
+        
+        select = ", ".join(columns + ["COUNT(*)"])
+        group_by = f"GROUP BY {', '.join(str(i + 1) for i in range(len(columns)))}" if columns else ""
+        try:
+            with self._reading() as conn:
+                rows = conn.execute(f'''
+                    SELECT {select}
+                    FROM search_index s JOIN search_facets f ON f.rowid = s.rowid
+                    WHERE search_index MATCH ?
+                    {group_by}
+                ''', (*params, fts_query)).fetchall()
+        except Exception as e:
+            logger.error(f"Failed to generate facets: {e}")
+            return 0, {}, time.perf_counter() - started
+        
+        total = sum(row[-1] for row in rows)
+        counters = [Counter() for _ in fields]
+        for row in rows:
+            count = row[-1]
+            for counter, value in zip(counters, row[:-1]):
+                for item in self._facet_values(value):
+                    counter[item] += count
+        
+        facets = {}
+        for name, counter in zip(fields, counters):
+            if counter:
+                facets[name] = [{'value': value, 'count': count} for value, count in counter.most_common()]
+        return total, facets, time.perf_counter() - started
+    
+    @staticmethod
+    def _facet_values(value: Any) -> List[Any]:
+        """A facet column's values; JSON arrays (e.g. tags) count once per element"""
+        if value is None:
+            return []
+        if isinstance(value, str) and value.startswith('['):
+            try:
+                items = json.loads(value)
+            except ValueError:
+                return [value]
+            return [item for item in items if isinstance(item, (str, int, float))]
+        return [value]
+    
+    def _resume(self, cursor: Optional[str], fts_query: str) -> Tuple[Optional['_SearchCursor'], int]:
+        """The cached search a cursor points into, and its offset"""
+        if not cursor:
+            return None, 0
+        key, _, offset = cursor.partition(":")
+        with self._cursor_lock:
+            entry = self._cursors.get(key)
+            if entry is None or entry.expires < time.monotonic() or entry.fts_query != fts_query:
+                self._cursors.pop(key, None)
+                return None, 0
+            self._cursors.move_to_end(key)
+        try:
+            return entry, max(0, int(offset))
+        except ValueError:
+            return None, 0
+    
+    def _remember(self, entry: '_SearchCursor', offset: int) -> str:
+        """Keep a search for cursor pagination and return a cursor for offset"""
+        with self._cursor_lock:
+            if entry.key is None:
+                entry.key = secrets.token_hex(8)
+            entry.expires = time.monotonic() + self.cursor_ttl
+            self._cursors[entry.key] = entry
+            self._cursors.move_to_end(entry.key)
+            while len(self._cursors) > self.cursor_cache_size:
+                self._cursors.popitem(last=False)
+        return f"{entry.key}:{offset}"
+
     def suggest(self, query: str, limit: int = 5) -> List[str]:
-        """Get search suggestions"""
+        """Get search suggestions (the query's own count is updated by the next analytics flush)"""
         try:
-            conn = sqlite3.connect(self.db_path)
-            cursor = conn.cursor()
-            
-            # Update suggestion count
-            cursor.execute('''
-                INSERT OR REPLACE INTO search_suggestions (query, count, last_used)
-                VALUES (?, COALESCE((SELECT count + 1 FROM search_suggestions WHERE query = ?), 1), CURRENT_TIMESTAMP)
-            ''', (query, query))
+            self.analytics_queue.put((SUGGESTION_UPSERT, (query,)))
             
             # Get popular suggestions
-            cursor.execute('''
-                SELECT query FROM search_suggestions
-                WHERE query LIKE ? AND query != ?
-                ORDER BY count DESC, last_used DESC
-                LIMIT ?
-            ''', (f"{query}%", query, limit))
-            
-            suggestions = [row[0] for row in cursor.fetchall()]
-            conn.commit()
-            conn.close()
-            
-            return suggestions
+            with self._reading() as conn:
+                rows = conn.execute('''
+                    SELECT query FROM search_suggestions
+                    WHERE query LIKE ? AND query != ?
+                    ORDER BY count DESC, last_used DESC
+                    LIMIT ?
+                ''', (f"{query}%", query, limit)).fetchall()
             
+            return [row[0] for row in rows]
+        
         except Exception as e:
             logger.error(f"Failed to get suggestions: {e}")
             return []
@@ -294,19 +540,74 @@ class SQLiteSearchEngine(SearchEngineBase):
     def delete_document(self, doc_id: str) -> bool:
         """Delete document from index"""
         try:
-            conn = sqlite3.connect(self.db_path)
-            cursor = conn.cursor()
-            
-            cursor.execute('DELETE FROM search_index WHERE id = ?', (doc_id,))
-            
-            conn.commit()
-            conn.close()
+            with self._writing() as conn:
+                conn.execute('''
+                    DELETE FROM search_facets
+                    WHERE rowid IN (SELECT rowid FROM search_index WHERE id = ?)
+                ''', (doc_id,))
+                conn.execute('DELETE FROM search_index WHERE id = ?', (doc_id,))
             return True
-            
+        
         except Exception as e:
             logger.error(f"Failed to delete document {doc_id}: {e}")
             return False
     
+    def get_documents_by_rowid(self, rowids: List[int]) -> Dict[int, SearchResult]:
+        """Fetch indexed documents by FTS rowid, keyed by rowid"""
+        if not rowids:
+            return {}
+        
+        try:
+            placeholders = ",".join("?" * len(rowids))
+            with self._reading() as conn:
+                rows = conn.execute(f'''
+                    SELECT rowid, id, title, content, type, metadata
+                    FROM search_index
+                    WHERE rowid IN ({placeholders})
+                ''', rowids).fetchall()
+            
+            documents = {}
+            for rowid, doc_id, title, content, doc_type, metadata_json in rows:
+                documents[rowid] = SearchResult(
+                    id=doc_id,
+                    title=title,
+                    content=content[:200] + "..." if len(content) > 200 else content,
+                    type=doc_type,
+                    score=0.0,
+                    highlights=[],
+                    metadata=json.loads(metadata_json) if metadata_json else {}
+                )
+            
+            return documents
+        
+        except Exception as e:
+            logger.error(f"Failed to fetch documents: {e}")
+            return {}
+    
+    def scan_documents(self, batch_size: int = DEFAULT_REBUILD_BATCH) -> Iterator[List[Tuple[int, Dict[str, Any]]]]:
+        """Every indexed document as (rowid, document) pairs, batch_size at a time in rowid order"""
+        last = None
+        while True:
+            with self._reading() as conn:
+                rows = conn.execute('''
+                    SELECT rowid, id, title, content, type, metadata
+                    FROM search_index
+                    WHERE ? IS NULL OR rowid > ?
+                    ORDER BY rowid
+                    LIMIT ?
+                ''', (last, last, batch_size)).fetchall()
+            if not rows:
+                return
+            yield [(rowid, {'id': doc_id, 'title': title, 'content': content, 'type': doc_type,
+                            'metadata': json.loads(metadata_json) if metadata_json else {}})
+                   for rowid, doc_id, title, content, doc_type, metadata_json in rows]
+            last = rows[-1][0]
+    
+    def rowids_for(self, doc_id: str) -> List[int]:
+        """FTS rowids holding a document id"""
+        with self._reading() as conn:
+            return [row[0] for row in conn.execute('SELECT rowid FROM search_index WHERE id = ?', (doc_id,))]
+
     def _build_fts_query(self, query: str) -> str:
         """Build FTS query from user input"""
         # Clean and escape query
@@ -324,6 +625,14 @@ class SQLiteSearchEngine(SearchEngineBase):
         
         return " OR ".join(fts_terms) if fts_terms else "*"
     
+    @staticmethod
+    def _restrict_type(fts_query: str, types: Any) -> str:
+        """Limit an FTS query to documents of the given type(s) with an FTS5 column filter"""
+        values = types if isinstance(types, (list, tuple, set)) else [types]
+        phrases = " OR ".join('"' + str(value).replace('"', '""') + '"' for value in values)
+        column_filter = f"type : ({phrases})"
+        return column_filter if fts_query == "*" else f"{column_filter} AND ({fts_query})"
+    
     def _generate_highlights(self, query: str, text: str, max_highlights: int = 3) -> List[str]:
         """Generate text highlights"""
         highlights = []
@@ -349,51 +658,254 @@ class SQLiteSearchEngine(SearchEngineBase):
         
         return highlights
     
-    def _generate_facets(self, cursor, fts_query: str) -> Dict[str, List[Dict[str, Any]]]:
-        """Generate search facets"""
-        facets = {}
+    def _record_analytics(self, query: str, results_count: int, query_time: float):
+        """Queue a search analytics row for the background writer"""
+        self.analytics_queue.put((ANALYTICS_INSERT, (query, results_count, query_time)))
+    
+    def flush_analytics(self) -> int:
+        """Write buffered analytics rows and suggestion counts now; returns the rows written"""
+        written = 0
+        while True:
+            batch = self.analytics_queue.drain(self.analytics_queue.batch_size)
+            if not batch:
+                return written
+            
+            by_statement = defaultdict(list)
+            for statement, row in batch:
+                by_statement[statement].append(row)
+            try:
+                with self._writing() as conn:
+                    for statement, rows in by_statement.items():
+                        conn.executemany(statement, rows)
+                written += len(batch)
+            except Exception as e:
+                self.analytics_errors += 1
+                logger.error(f"Failed to record analytics: {e}")
+    
+    def _flush_analytics_loop(self):
+        """Background writer: flush when a batch fills up or flush_interval passes"""
+        while self._flush_active:
+            self.analytics_queue.batch_ready.wait(self.flush_interval)
+            if self._flush_active:
+                self.flush_analytics()
+    
+    def close(self):
+        """Flush analytics and close every pooled connection"""
+        self._flush_active = False
+        self.analytics_queue.batch_ready.set()
+        self._flush_thread.join()
+        self._executor.shutdown(wait=True)
+        self.flush_analytics()
+        
+        readers = []
+        while True:
+            try:
+                readers.append(self._reader_pool.get_nowait())
+            except queue.Empty:
+                break
+        for conn in readers:
+            if conn is not None:
+                conn.close()
+            self._reader_pool.put(None)
+        with self._write_lock:
+            if self._writer_conn is not None:
+                self._writer_conn.close()
+                self._writer_conn = None
+
+def hash_embedding(text: str, dim: int):
+    """Deterministic bag-of-words embedding via feature hashing.
+
+    Used by HybridSearchEngine when no model embedder is configured; pass a
+    real embedding function (e.g. backed by ModelServingService) for
+    semantic recall.
+    """
+    import numpy as np
+    
+    vector = np.zeros(dim, dtype=np.float32)
+    for term in re.findall(r'\w+', text.lower()):
+        digest = hashlib.blake2b(term.encode('utf-8'), digest_size=8).digest()
+        bucket = int.from_bytes(digest[:4], 'little') % dim
+        vector[bucket] += 1.0 if digest[4] & 1 else -1.0
+    return vector
+
+class HybridSearchEngine(SearchEngineBase):
+    """BM25 (SQLite FTS5) + vector retrieval fused with reciprocal-rank fusion.
+    
+    Both retrievers run concurrently for every query; sqlite3 and NumPy
+    release the GIL while they work, so the wall time is the slower of the
+    two rather than their sum. Vector ids double as FTS rowids, so vector
+    hits are resolved to documents with a rowid lookup. The vector index
+    lives in memory and is rebuilt from the FTS table on start, so it also
+    covers documents indexed earlier or through a plain SQLiteSearchEngine.
+    """
+    
+    def __init__(self, config: Dict[str, Any], lexical: Optional[SQLiteSearchEngine] = None):
+        super().__init__(config)
+        from .vector_index import VectorIndex
+        
+        self.name = "hybrid"
+        self.lexical = lexical or SQLiteSearchEngine(config.get('sqlite', {'db_path': config.get('db_path', 'search.db')}))
+        self.dim = config.get('dim', 128)
+        self.embedder: Callable[[str], Any] = config.get('embedder') or (lambda text: hash_embedding(text, self.dim))
+        self.rrf_k = config.get('rrf_k', 60)  # RRF damping constant
+        self.candidates = config.get('candidates', 100)  # Hits taken from each retriever
+        self.weights = config.get('weights', {'bm25': 1.0, 'vector': 1.0})
+        self.filter_fields = config.get('filter_fields', ['type'])  # Document fields filterable in both retrievers
+        self.vector_index = VectorIndex(self.dim, config.get('max_elements', 10000),
+                                        metric=config.get('metric', 'cosine'))
+        self._executor = ThreadPoolExecutor(max_workers=2, thread_name_prefix="hybrid-search")
+        self.rebuild_vector_index(config.get('rebuild_batch', DEFAULT_REBUILD_BATCH))
+    
+    @staticmethod
+    def vector_id(doc_id: str) -> int:
+        """Stable positive 63-bit id for a document, shared by the FTS rowid and the vector index"""
+        digest = hashlib.blake2b(doc_id.encode('utf-8'), digest_size=8).digest()
+        return int.from_bytes(digest, 'little') >> 1
+    
+    def _document_text(self, document: Dict[str, Any]) -> str:
+        return f"{document.get('title', '')} {document.get('content', '')}"
+    
+    def _attributes(self, documents: List[Dict[str, Any]]) -> Dict[str, List[Any]]:
+        attributes = {}
+        for name in self.filter_fields:
+            values = [doc.get(name, doc.get('metadata', {}).get(name)) for doc in documents]
+            attributes[name] = ["" if value is None else value for value in values]
+        return attributes
+    
+    def _add_vectors(self, documents: List[Dict[str, Any]], rowids: List[int]):
+        import numpy as np
         
+        vectors = np.stack([np.asarray(self.embedder(self._document_text(doc)), dtype=np.float32)
+                            for doc in documents])
+        self.vector_index.add_vectors(vectors, np.asarray(rowids, dtype=np.int64),
+                                      attributes=self._attributes(documents))
+    
+    def rebuild_vector_index(self, batch_size: int = DEFAULT_REBUILD_BATCH) -> int:
+        """Embed every document already in the FTS table under its rowid; returns the count added"""
+        added = 0
         try:
-            # Type facets
-            cursor.execute('''
-                SELECT type, COUNT(*) as count
-                FROM search_index
-                WHERE search_index MATCH ?
-                GROUP BY type
-                ORDER BY count DESC
-            ''', (fts_query,))
-            
-            type_facets = []
-            for row in cursor.fetchall():
-                type_facets.append({
-                    'value': row[0],
-                    'count': row[1]
-                })
-            
-            if type_facets:
-                facets['type'] = type_facets
-            
+            for batch in self.lexical.scan_documents(batch_size):
+                self._add_vectors([doc for _, doc in batch], [rowid for rowid, _ in batch])
+                added += len(batch)
         except Exception as e:
-            logger.error(f"Failed to generate facets: {e}")
+            logger.error(f"Failed to rebuild the vector index after {added} documents: {e}")
+        if added:
+            logger.info(f"Rebuilt vector index from {added} indexed documents")
+        return added
+    
+    def index_document(self, doc_id: str, document: Dict[str, Any]) -> bool:
+        """Index a single document in both retrievers"""
+        return self.bulk_index([{**document, 'id': doc_id}])
+    
+    def bulk_index(self, documents: List[Dict[str, Any]]) -> bool:
+        """Index multiple documents in both retrievers"""
+        if not documents:
+            return True
         
-        return facets
+        try:
+            rowids = [self.vector_id(doc.get('id', '')) for doc in documents]
+            if not self.lexical.bulk_index([{**doc, 'rowid': rowid} for doc, rowid in zip(documents, rowids)]):
+                return False
+            self._add_vectors(documents, rowids)
+            return True
+            
+        except Exception as e:
+            logger.error(f"Failed to hybrid index documents: {e}")
+            return False
     
-    def _record_analytics(self, query: str, results_count: int, query_time: float):
-        """Record search analytics"""
+    def delete_document(self, doc_id: str) -> bool:
+        """Delete document from both retrievers"""
         try:
-            conn = sqlite3.connect(self.db_path)
-            cursor = conn.cursor()
+            rowids = self.lexical.rowids_for(doc_id)
+        except Exception as e:
+            logger.error(f"Failed to look up document {doc_id}: {e}")
+            return False
+        for rowid in rowids:
+            self.vector_index.mark_deleted(rowid)
+        return self.lexical.delete_document(doc_id)
+    
+    def suggest(self, query: str, limit: int = 5) -> List[str]:
+        """Get search suggestions"""
+        return self.lexical.suggest(query, limit)
+    
+    def _lexical_search(self, query: SearchQuery) -> Tuple[List[SearchResult], SearchStats, float]:
+        started = time.perf_counter()
+        lexical_query = SearchQuery(
+            query=query.query, filters={}, sort=query.sort, page=0,
+            per_page=self.candidates, facets=query.facets, suggest=query.suggest
+        )
+        results, stats = self.lexical.search(lexical_query)
+        results = [result for result in results if self._matches(result, query.filters)]
+        return results, stats, time.perf_counter() - started
+    
+    def _vector_search(self, query: SearchQuery) -> Tuple[List[int], float]:
+        started = time.perf_counter()
+        filters = {name: value for name, value in query.filters.items() if name in self.filter_fields}
+        hits = self.vector_index.search(self.embedder(query.query), self.candidates, filter=filters or None)
+        return [hit['id'] for hit in hits], time.perf_counter() - started
+    
+    def _matches(self, result: SearchResult, filters: Dict[str, Any]) -> bool:
+        """Apply filterable-field filters to a lexical result"""
+        for name, wanted in filters.items():
+            if name not in self.filter_fields:
+                continue
+            value = getattr(result, name, None) if name == 'type' else result.metadata.get(name)
+            allowed = wanted if isinstance(wanted, (list, tuple, set)) else [wanted]
+            if value not in allowed:
+                return False
+        return True
+    
+    def search(self, query: SearchQuery) -> Tuple[List[SearchResult], SearchStats]:
+        """Run BM25 and vector retrieval in parallel and fuse them with RRF"""
+        started = time.perf_counter()
+        
+        try:
+            lexical_future = self._executor.submit(self._lexical_search, query)
+            vector_future = self._executor.submit(self._vector_search, query)
+            lexical_results, lexical_stats, lexical_time = lexical_future.result()
+            vector_rowids, vector_time = vector_future.result()
             
-            cursor.execute('''
-                INSERT INTO search_analytics (query, results_count, query_time)
-                VALUES (?, ?, ?)
-            ''', (query, results_count, query_time))
+            # Reciprocal-rank fusion: score = sum over retrievers of weight / (rrf_k + rank)
+            fusion_started = time.perf_counter()
+            scores: Dict[str, float] = defaultdict(float)
+            documents: Dict[str, SearchResult] = {}
+            
+            for rank, result in enumerate(lexical_results, start=1):
+                scores[result.id] += self.weights.get('bm25', 1.0) / (self.rrf_k + rank)
+                documents[result.id] = result
             
-            conn.commit()
-            conn.close()
+            vector_documents = self.lexical.get_documents_by_rowid(vector_rowids)
+            for rank, rowid in enumerate(vector_rowids, start=1):
+                result = vector_documents.get(rowid)
+                if result is None:
+                    continue
+                scores[result.id] += self.weights.get('vector', 1.0) / (self.rrf_k + rank)
+                documents.setdefault(result.id, result)
+            
+            ranked = sorted(scores.items(), key=lambda item: item[1], reverse=True)
+            page = ranked[query.page * query.per_page:(query.page + 1) * query.per_page]
+            results = []
+            for doc_id, score in page:
+                result = documents[doc_id]
+                result.score = score
+                if not result.highlights:
+                    result.highlights = self.lexical._generate_highlights(query.query, result.title + " " + result.content)
+                results.append(result)
+            fusion_time = time.perf_counter() - fusion_started
+            
+            stats = SearchStats(
+                total_results=len(ranked),
+                query_time=time.perf_counter() - started,
+                facets=lexical_stats.facets,
+                suggestions=lexical_stats.suggestions,
+                related_queries=[],
+                stage_times={'bm25': lexical_time, 'vector': vector_time, 'fusion': fusion_time}
+            )
+            return results, stats
             
         except Exception as e:
-            logger.error(f"Failed to record analytics: {e}")
+            logger.error(f"Hybrid search failed: {e}")
+            return [], SearchStats(0, 0.0, {}, [], [])
 
 class IntelligentSearchManager:
     """Main search management class"""
@@ -420,6 +932,12 @@ class IntelligentSearchManager:
         sqlite_engine = SQLiteSearchEngine(sqlite_config)
         self.add_engine('sqlite', sqlite_engine, is_default=True)
         
+        # Optional hybrid BM25 + vector engine over the same FTS database
+        hybrid_config = config.get('hybrid')
+        if hybrid_config:
+            hybrid_engine = HybridSearchEngine({'sqlite': sqlite_config, **hybrid_config}, lexical=sqlite_engine)
+            self.add_engine('hybrid', hybrid_engine, is_default=hybrid_config.get('default', False))
+        
         logger.info("Search system configured")
     
     def index_content(self, content_type: str, items: List[Dict[str, Any]]) -> bool:
@@ -446,7 +964,10 @@ class IntelligentSearchManager:
             }
             documents.append(doc)
         
-        return self.default_engine.bulk_index(documents)
+        # Every engine gets the documents, except FTS tables a hybrid engine already writes through to
+        wrapped = {id(engine.lexical) for engine in self.engines.values() if isinstance(engine, HybridSearchEngine)}
+        indexed = [engine.bulk_index(documents) for engine in self.engines.values() if id(engine) not in wrapped]
+        return all(indexed)
     
     def search(self, 
                query: str,
@@ -456,7 +977,8 @@ class IntelligentSearchManager:
                page: int = 0,
                per_page: int = 20,
                facets: Optional[List[str]] = None,
-               suggest: bool = True) -> Tuple[List[SearchResult], SearchStats]:
+               suggest: bool = True,
+               cursor: Optional[str] = None) -> Tuple[List[SearchResult], SearchStats]:
         """Perform intelligent search"""
         
         if not self.default_engine:
@@ -470,7 +992,8 @@ class IntelligentSearchManager:
             page=page,
             per_page=per_page,
             facets=facets or ['type'],
-            suggest=suggest
+            suggest=suggest,
+            cursor=cursor
         )
         
         # Record search intent
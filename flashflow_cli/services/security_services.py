@@ -21,6 +21,8 @@ import re
 import jwt
 from functools import wraps
 
+from .rate_limiter import RateLimiter, RuleMatcher, DEFAULT_CHECKPOINT_INTERVAL
+
 logger = logging.getLogger(__name__)
 
 @dataclass
@@ -48,13 +50,6 @@ class RateLimitRule:
     enabled: bool = True
     description: str = ""
 
-@dataclass
-class RateLimitEntry:
-    """Represents a rate limit entry for tracking"""
-    key: str
-    count: int
-    reset_time: datetime
-
 @dataclass
 class SecurityConfig:
     """Security configuration"""
@@ -62,6 +57,8 @@ class SecurityConfig:
     jwt_algorithm: str = "HS256"
     jwt_expiration_hours: int = 24
     rate_limit_enabled: bool = True
+    rate_limit_checkpoint_seconds: float = DEFAULT_CHECKPOINT_INTERVAL
+    rate_limit_shared_memory: Optional[str] = None  # Shared-memory table name, for one limit across workers
     max_login_attempts: int = 5
     login_lockout_minutes: int = 30
     password_min_length: int = 8
@@ -88,7 +85,13 @@ class SecurityManager:
         self.db_path = db_path
         self.config = config or SecurityConfig(jwt_secret=secrets.token_urlsafe(32))
         self.setup_database()
-        self.rate_limit_cache = {}  # key -> RateLimitEntry
+        self.rate_limiter = RateLimiter(
+            db_path=db_path,
+            checkpoint_interval=self.config.rate_limit_checkpoint_seconds,
+            shared_name=self.config.rate_limit_shared_memory
+        )
+        self._rule_matcher: Optional[RuleMatcher] = None
+        self._rate_limit_logged = {}  # key -> monotonic time until which rejections aren't logged again
         self.failed_login_attempts = defaultdict(int)  # ip/user -> count
         self.lockout_until = {}  # ip/user -> datetime
         self.security_events = deque(maxlen=1000)
@@ -120,7 +123,7 @@ class SecurityManager:
                     name TEXT,
                     endpoint_pattern TEXT,
                     method TEXT,
-                    limit INTEGER,
+                    "limit" INTEGER,
                     window_seconds INTEGER,
                     scope TEXT,
                     enabled BOOLEAN,
@@ -128,6 +131,9 @@ class SecurityManager:
                 )
             ''')
             
+            # Counters of the old per-request limiter; buckets now live in rate_limit_buckets
+            cursor.execute('DROP TABLE IF EXISTS rate_limit_entries')
+            
             # User security data table
             cursor.execute('''
                 CREATE TABLE IF NOT EXISTS user_security (
@@ -172,6 +178,7 @@ class SecurityManager:
                     description="Default rate limit for all API endpoints"
                 ),
                 RateLimitRule(
+                    id="login",
                     name="Login Rate Limit",
                     endpoint_pattern="/api/auth/login",
                     method="POST",
@@ -181,6 +188,12 @@ class SecurityManager:
                     description="Rate limit for login attempts"
                 )
             ]
+            cursor.executemany('''
+                INSERT OR IGNORE INTO rate_limit_rules
+                (id, name, endpoint_pattern, method, "limit", window_seconds, scope, enabled, description)
+                VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?)
+            ''', [(rule.id, rule.name, rule.endpoint_pattern, rule.method, rule.limit, rule.window_seconds,
+                   rule.scope, rule.enabled, rule.description) for rule in default_rules])
             
             conn.commit()
             conn.close()
@@ -191,148 +204,68 @@ class SecurityManager:
             raise
     
     def check_rate_limit(self, endpoint: str, method: str, ip_address: str, user_id: Optional[str] = None) -> bool:
-        """Check if request is within rate limits"""
+        """Check if request is within rate limits (in memory; rules are reloaded only when changed)"""
         if not self.config.rate_limit_enabled:
             return True
         
         try:
-            conn = sqlite3.connect(self.db_path)
-            cursor = conn.cursor()
-            
-            # Get applicable rate limit rules
-            cursor.execute('''
-                SELECT id, name, endpoint_pattern, method, limit, window_seconds, scope
-                FROM rate_limit_rules 
-                WHERE enabled = 1
-            ''')
-            rules = cursor.fetchall()
-            
-            conn.close()
-            
-            # Check each rule
-            for rule in rules:
-                rule_id, name, pattern, rule_method, limit, window_seconds, scope = rule
-                
-                # Check if rule applies to this request
-                if rule_method != "ALL" and rule_method != method:
-                    continue
-                
-                # Check endpoint pattern match
-                if not self._matches_pattern(endpoint, pattern):
-                    continue
-                
+            for rule in self._rate_limit_matcher().match(endpoint, method):
                 # Determine rate limit key based on scope
-                if scope == "ip":
-                    key = f"{rule_id}:{ip_address}"
-                elif scope == "user" and user_id:
-                    key = f"{rule_id}:{user_id}"
-                elif scope == "global":
-                    key = f"{rule_id}:global"
+                if rule.scope == "ip":
+                    key = f"{rule.id}:{ip_address}"
+                elif rule.scope == "user" and user_id:
+                    key = f"{rule.id}:{user_id}"
+                elif rule.scope == "global":
+                    key = f"{rule.id}:global"
                 else:
                     continue
                 
                 # Check rate limit
-                if not self._check_rate_limit_key(key, limit, window_seconds):
-                    # Log rate limit exceeded event
-                    self.log_security_event(
-                        event_type="rate_limit_exceeded",
-                        ip_address=ip_address,
-                        user_id=user_id,
-                        details={
-                            "rule_name": name,
-                            "endpoint": endpoint,
-                            "method": method,
-                            "limit": limit,
-                            "window_seconds": window_seconds
-                        },
-                        severity="warning"
-                    )
+                if not self._check_rate_limit_key(key, rule.limit, rule.window_seconds):
+                    # Log rate limit exceeded event, once per key and window so a flood doesn't write per request
+                    if self._should_log_rate_limit(key, rule.window_seconds):
+                        self.log_security_event(
+                            event_type="rate_limit_exceeded",
+                            ip_address=ip_address,
+                            user_id=user_id,
+                            details={
+                                "rule_name": rule.name,
+                                "endpoint": endpoint,
+                                "method": method,
+                                "limit": rule.limit,
+                                "window_seconds": rule.window_seconds
+                            },
+                            severity="warning"
+                        )
                     return False
             
             return True
-            
+        
         except Exception as e:
             logger.error(f"Error checking rate limit: {e}")
             return True  # Allow request on error
     
-    def _matches_pattern(self, endpoint: str, pattern: str) -> bool:
-        """Check if endpoint matches pattern"""
-        if pattern == "*":
-            return True
-        
-        # Simple pattern matching (could be enhanced with regex)
-        if pattern.endswith("*"):
-            return endpoint.startswith(pattern[:-1])
-        return endpoint == pattern
+    def _rate_limit_matcher(self) -> RuleMatcher:
+        """Compiled enabled rules, loaded from the database on first use and after changes"""
+        matcher = self._rule_matcher
+        if matcher is None:
+            matcher = self._rule_matcher = RuleMatcher(self.get_rate_limit_rules())
+        return matcher
+    
+    def _should_log_rate_limit(self, key: str, window_seconds: int) -> bool:
+        """True for the first rejection of a key in each window"""
+        now = time.monotonic()
+        if self._rate_limit_logged.get(key, 0) > now:
+            return False
+        if len(self._rate_limit_logged) >= 10000:
+            self._rate_limit_logged = {k: until for k, until in self._rate_limit_logged.items() if until > now}
+        self._rate_limit_logged[key] = now + window_seconds
+        return True
     
     def _check_rate_limit_key(self, key: str, limit: int, window_seconds: int) -> bool:
         """Check rate limit for a specific key"""
-        now = datetime.now()
-        
-        # Check cache first
-        if key in self.rate_limit_cache:
-            entry = self.rate_limit_cache[key]
-            if entry.reset_time > now:
-                if entry.count >= limit:
-                    return False
-                else:
-                    entry.count += 1
-                    return True
-            else:
-                # Reset expired entry
-                del self.rate_limit_cache[key]
-        
-        # Check database
-        try:
-            conn = sqlite3.connect(self.db_path)
-            cursor = conn.cursor()
-            
-            cursor.execute('''
-                SELECT count, reset_time FROM rate_limit_entries 
-                WHERE key = ? AND reset_time > ?
-            ''', (key, now))
-            result = cursor.fetchone()
-            
-            if result:
-                count, reset_time_str = result
-                reset_time = datetime.fromisoformat(reset_time_str)
-                
-                if count >= limit:
-                    conn.close()
-                    return False
-                else:
-                    # Update count
-                    cursor.execute('''
-                        UPDATE rate_limit_entries 
-                        SET count = count + 1 
-                        WHERE key = ?
-                    ''', (key,))
-                    conn.commit()
-                    conn.close()
-                    return True
-            else:
-                # Create new entry
-                reset_time = now + timedelta(seconds=window_seconds)
-                cursor.execute('''
-                    INSERT OR REPLACE INTO rate_limit_entries 
-                    (key, count, reset_time) 
-                    VALUES (?, 1, ?)
-                ''', (key, reset_time.isoformat()))
-                conn.commit()
-                conn.close()
-                
-                # Cache the entry
-                self.rate_limit_cache[key] = RateLimitEntry(
-                    key=key,
-                    count=1,
-                    reset_time=reset_time
-                )
-                return True
-                
-        except Exception as e:
-            logger.error(f"Error checking rate limit key: {e}")
-            return True
-    
+        return self.rate_limiter.allow(key, limit, window_seconds)
+
     def check_login_attempts(self, identifier: str) -> bool:
         """Check if login attempts are within limits"""
         now = datetime.now()
@@ -539,7 +472,7 @@ class SecurityManager:
             
             cursor.execute('''
                 INSERT OR REPLACE INTO rate_limit_rules 
-                (id, name, endpoint_pattern, method, limit, window_seconds, scope, enabled, description)
+                (id, name, endpoint_pattern, method, "limit", window_seconds, scope, enabled, description)
                 VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?)
             ''', (
                 rule.id,
@@ -555,6 +488,7 @@ class SecurityManager:
             
             conn.commit()
             conn.close()
+            self._rule_matcher = None
             return True
         except Exception as e:
             logger.error(f"Error adding rate limit rule: {e}")
@@ -567,7 +501,7 @@ class SecurityManager:
             cursor = conn.cursor()
             
             cursor.execute('''
-                SELECT id, name, endpoint_pattern, method, limit, window_seconds, scope, enabled, description
+                SELECT id, name, endpoint_pattern, method, "limit", window_seconds, scope, enabled, description
                 FROM rate_limit_rules
             ''')
             rows = cursor.fetchall()
@@ -0,0 +1,133 @@
+"""
+Segment Log Services for FlashFlow
+Sequence-numbered head logs sealed into checksummed segment frames, shared by the append-only stores
+"""
+
+import os
+import json
+import zlib
+import struct
+import logging
+import threading
+from typing import Callable, List, Sequence, Tuple
+
+logger = logging.getLogger(__name__)
+
+HEAD_NAME = "head.log"
+
+Entry = Tuple[int, tuple]   # (seq, item)
+
+
+def scan_frames(path: str, header: struct.Struct, magic: bytes,
+                frame_length: Callable[[tuple], int]) -> List[Tuple[int, tuple]]:
+    """(offset, header fields) of each intact frame in a segment, cutting the file after the last one.
+
+    A frame is a header starting with magic and ending with the crc32 of
+    the bytes that follow it. The first torn or corrupt frame ends the
+    segment and is truncated away, so the next append follows the last
+    intact frame instead of bytes no later scan can get past.
+    """
+    frames = []
+    size = os.path.getsize(path)
+    offset = 0
+    with open(path, 'rb') as f:
+        while offset + header.size <= size:
+            fields = header.unpack(f.read(header.size))
+            length = frame_length(fields)
+            if fields[0] != magic or length < header.size or offset + length > size \
+                    or zlib.crc32(f.read(length - header.size)) != fields[-1]:
+                break
+            frames.append((offset, fields))
+            offset += length
+    if offset < size:
+        logger.warning(f"Truncated segment {path} from {size} to {offset} bytes")
+        os.truncate(path, offset)
+    return frames
+
+
+class SegmentLog:
+    """Sequence numbering and head log of an append-only store.
+
+    Appended items get consecutive sequence numbers and go to head.log as
+    JSON lines [seq, *item]. Every batch_records pending entries are passed
+    to _seal, which writes them as sealed frames, and the head is then
+    rewritten with the remainder. A crash between the two leaves sealed
+    entries in the head, which replay skips by seq.
+    """
+
+    item_fields = 0  # Fields of an item, after the seq
+
+    def __init__(self, directory: str, batch_records: int):
+        self.directory = directory
+        self.batch_records = batch_records
+        self.lock = threading.Lock()
+        self.head: List[Entry] = []
+        self.seq = 0
+        self.head_path = os.path.join(directory, HEAD_NAME)
+
+    def _replay_head(self, sealed_seq: int):
+        """Number on from the last sealed seq and reload unsealed entries, cutting a torn final line"""
+        self.seq = sealed_seq
+        if not os.path.exists(self.head_path):
+            return
+        offset = 0
+        with open(self.head_path, 'rb') as f:
+            for line in f:
+                if not line.endswith(b"\n"):
+                    break  # Torn final write
+                try:
+                    seq, *item = json.loads(line)
+                except (ValueError, TypeError):
+                    break
+                if len(item) != self.item_fields:
+                    break
+                if seq > self.seq:
+                    self.head.append((seq, tuple(item)))
+                offset += len(line)
+        if offset < os.path.getsize(self.head_path):
+            logger.warning(f"Truncated head log {self.head_path} at offset {offset}")
+            os.truncate(self.head_path, offset)
+        if self.head:
+            self.seq = self.head[-1][0]
+
+    def append(self, items: Sequence[tuple]):
+        new = []
+        for item in items:
+            self.seq += 1
+            new.append((self.seq, tuple(item)))
+
+        pending = self.head + new
+        sealable = len(pending) - len(pending) % self.batch_records
+        if not sealable:
+            self._write_head(new, append=True)
+            self.head = pending
+            return
+
+        # Seal full batches straight from memory, then keep only the remainder in the head
+        self._seal([pending[i:i + self.batch_records] for i in range(0, sealable, self.batch_records)])
+        self._write_head(pending[sealable:], append=False)
+        self.head = pending[sealable:]
+
+    def _write_head(self, entries: Sequence[Entry], append: bool):
+        lines = "".join(json.dumps([seq, *item], separators=(',', ':'), default=str) + "\n"
+                        for seq, item in entries)
+        if append:
+            with open(self.head_path, 'a', encoding='utf-8') as f:
+                f.write(lines)
+            return
+
+        temp_path = self.head_path + ".tmp"
+        with open(temp_path, 'w', encoding='utf-8') as f:
+            f.write(lines)
+        os.replace(temp_path, self.head_path)
+
+    def _seal(self, batches: Sequence[Sequence[Entry]]):
+        """Write each batch of entries as one sealed frame"""
+        raise NotImplementedError
+
+    def flush(self):
+        """Seal the head even if it is not full"""
+        if self.head:
+            self._seal([self.head])
+            self._write_head([], append=False)
+            self.head = []
@@ -0,0 +1,509 @@
+"""
+Telemetry Store Services for FlashFlow
+Append-only, per-device time-series storage with compressed columnar blocks
+"""
+
+import os
+import json
+import zlib
+import struct
+import hashlib
+import logging
+import threading
+from datetime import datetime
+from typing import Any, Dict, Iterable, List, Optional, Sequence, Tuple
+
+from .segment_log import SegmentLog, scan_frames
+
+logger = logging.getLogger(__name__)
+
+DEFAULT_BLOCK_RECORDS = 1024          # Head records sealed into one columnar block
+DEFAULT_SEGMENT_BYTES = 32 << 20      # Segment files roll over past this size
+
+BLOCK_MAGIC = b"FFTB"
+BLOCK_VERSION = 1
+# magic, version, record count, t_min, t_max (epoch µs), last sequence number, payload bytes, payload crc32
+BLOCK_HEADER = struct.Struct("<4sBIqqQII")
+
+# Column encodings
+COLUMN_FLOAT = b"f"   # Gorilla XOR
+COLUMN_INT = b"i"     # Zigzag delta varints
+COLUMN_BOOL = b"b"    # Bitmap
+COLUMN_JSON = b"j"    # Anything else, as a JSON list
+
+Record = Tuple[int, Dict[str, Any]]   # (timestamp in epoch µs, data)
+
+
+def to_micros(timestamp: Any) -> int:
+    """Epoch microseconds from a datetime, ISO string, int epoch µs, float epoch seconds or None (now)"""
+    if timestamp is None:
+        timestamp = datetime.now()
+    elif isinstance(timestamp, str):
+        timestamp = datetime.fromisoformat(timestamp)
+    elif isinstance(timestamp, int):
+        return timestamp
+    elif isinstance(timestamp, float):
+        return int(timestamp * 1_000_000)
+    return int(timestamp.timestamp() * 1_000_000)
+
+
+def from_micros(micros: int) -> str:
+    return datetime.fromtimestamp(micros / 1_000_000).isoformat()
+
+
+# Varints
+
+def _zigzag(value: int) -> int:
+    return (value << 1) ^ (value >> 63)
+
+
+def _unzigzag(value: int) -> int:
+    return (value >> 1) ^ -(value & 1)
+
+
+def _write_varint(out: bytearray, value: int):
+    while value > 0x7F:
+        out.append((value & 0x7F) | 0x80)
+        value >>= 7
+    out.append(value)
+
+
+def _read_varint(data: memoryview, pos: int) -> Tuple[int, int]:
+    result = shift = 0
+    while True:
+        byte = data[pos]
+        pos += 1
+        result |= (byte & 0x7F) << shift
+        if not byte & 0x80:
+            return result, pos
+        shift += 7
+
+
+def _write_bytes(out: bytearray, chunk: bytes):
+    _write_varint(out, len(chunk))
+    out += chunk
+
+
+def _read_bytes(data: memoryview, pos: int) -> Tuple[memoryview, int]:
+    length, pos = _read_varint(data, pos)
+    return data[pos:pos + length], pos + length
+
+
+# Column codecs
+
+def encode_delta_of_delta(values: Sequence[int]) -> bytes:
+    """Timestamps: regular intervals encode to ~1 byte per value"""
+    out = bytearray()
+    previous = delta = 0
+    for value in values:
+        new_delta = value - previous
+        _write_varint(out, _zigzag(new_delta - delta))
+        previous, delta = value, new_delta
+    return bytes(out)
+
+
+def decode_delta_of_delta(data: memoryview, count: int) -> List[int]:
+    values = []
+    previous = delta = pos = 0
+    for _ in range(count):
+        encoded, pos = _read_varint(data, pos)
+        delta += _unzigzag(encoded)
+        previous += delta
+        values.append(previous)
+    return values
+
+
+def encode_deltas(values: Sequence[int]) -> bytes:
+    out = bytearray()
+    previous = 0
+    for value in values:
+        _write_varint(out, _zigzag(value - previous))
+        previous = value
+    return bytes(out)
+
+
+def decode_deltas(data: memoryview, count: int) -> List[int]:
+    values = []
+    previous = pos = 0
+    for _ in range(count):
+        encoded, pos = _read_varint(data, pos)
+        previous += _unzigzag(encoded)
+        values.append(previous)
+    return values
+
+
+class _BitWriter:
+    __slots__ = ('out', 'acc', 'bits')
+
+    def __init__(self):
+        self.out = bytearray()
+        self.acc = 0
+        self.bits = 0
+
+    def write(self, value: int, width: int):
+        self.acc = (self.acc << width) | value
+        self.bits += width
+        if self.bits >= 64:
+            spill = self.bits - (self.bits % 8)
+            self.out += (self.acc >> (self.bits - spill)).to_bytes(spill // 8, 'big')
+            self.bits -= spill
+            self.acc &= (1 << self.bits) - 1
+
+    def getvalue(self) -> bytes:
+        if self.bits:
+            pad = -self.bits % 8
+            return bytes(self.out) + (self.acc << pad).to_bytes((self.bits + pad) // 8, 'big')
+        return bytes(self.out)
+
+
+class _BitReader:
+    __slots__ = ('value', 'remaining')
+
+    def __init__(self, data: bytes):
+        self.value = int.from_bytes(data, 'big')
+        self.remaining = len(data) * 8
+
+    def read(self, width: int) -> int:
+        self.remaining -= width
+        return (self.value >> self.remaining) & ((1 << width) - 1)
+
+
+_DOUBLE = struct.Struct('>d')
+_BITS = struct.Struct('>Q')
+
+
+def encode_gorilla(values: Sequence[float]) -> bytes:
+    """Gorilla XOR float compression: slowly changing readings cost a few bits each"""
+    writer = _BitWriter()
+    previous = None
+    window = (65, 0)  # (leading zeros, meaningful bits) of the last written XOR; invalid at start
+    for value in values:
+        bits = _BITS.unpack(_DOUBLE.pack(value))[0]
+        if previous is None:
+            writer.write(bits, 64)
+        else:
+            xor = bits ^ previous
+            if not xor:
+                writer.write(0, 1)
+            else:
+                leading = min(64 - xor.bit_length(), 31)
+                trailing = (xor & -xor).bit_length() - 1
+                lead, meaningful = window
+                if leading >= lead and trailing >= 64 - lead - meaningful:
+                    writer.write(0b10, 2)
+                    writer.write(xor >> (64 - lead - meaningful), meaningful)
+                else:
+                    meaningful = 64 - leading - trailing
+                    writer.write(0b11, 2)
+                    writer.write(leading, 5)
+                    writer.write(meaningful & 0x3F, 6)  # 64 is stored as 0
+                    writer.write(xor >> trailing, meaningful)
+                    window = (leading, meaningful)
+        previous = bits
+    return writer.getvalue()
+
+
+def decode_gorilla(data: memoryview, count: int) -> List[float]:
+    if not count:
+        return []
+    reader = _BitReader(bytes(data))
+    previous = reader.read(64)
+    values = [_DOUBLE.unpack(_BITS.pack(previous))[0]]
+    lead = meaningful = 0
+    for _ in range(count - 1):
+        if reader.read(1):
+            if reader.read(1):
+                lead = reader.read(5)
+                meaningful = reader.read(6) or 64
+            previous ^= reader.read(meaningful) << (64 - lead - meaningful)
+        values.append(_DOUBLE.unpack(_BITS.pack(previous))[0])
+    return values
+
+
+def _pack_bits(flags: Sequence[bool]) -> bytes:
+    out = bytearray((len(flags) + 7) // 8)
+    for i, flag in enumerate(flags):
+        if flag:
+            out[i >> 3] |= 1 << (i & 7)
+    return bytes(out)
+
+
+def _unpack_bits(data: memoryview, count: int) -> List[bool]:
+    return [bool(data[i >> 3] & (1 << (i & 7))) for i in range(count)]
+
+
+def _column_kind(values: Sequence[Any]) -> bytes:
+    if all(isinstance(value, bool) for value in values):
+        return COLUMN_BOOL
+    if any(isinstance(value, bool) for value in values):
+        return COLUMN_JSON
+    if all(isinstance(value, int) and -(1 << 62) <= value < (1 << 62) for value in values):
+        return COLUMN_INT
+    if all(isinstance(value, (int, float)) for value in values):
+        return COLUMN_FLOAT
+    return COLUMN_JSON
+
+
+def encode_block(records: Sequence[Record], last_seq: int) -> bytes:
+    """Header plus zlib-compressed columns for records in arrival order"""
+    timestamps = [timestamp for timestamp, _ in records]
+    names: Dict[str, None] = {}
+    for _, data in records:
+        for name in data:
+            names.setdefault(name, None)
+
+    payload = bytearray()
+    _write_varint(payload, len(names))
+    _write_bytes(payload, encode_delta_of_delta(timestamps))
+    for name in names:
+        present = [name in data for _, data in records]
+        values = [data[name] for _, data in records if name in data]
+        kind = _column_kind(values)
+        if kind == COLUMN_FLOAT:
+            encoded = encode_gorilla([float(value) for value in values])
+        elif kind == COLUMN_INT:
+            encoded = encode_deltas(values)
+        elif kind == COLUMN_BOOL:
+            encoded = _pack_bits(values)
+        else:
+            encoded = json.dumps(values, separators=(',', ':'), default=str).encode('utf-8')
+
+        _write_bytes(payload, name.encode('utf-8'))
+        payload += kind
+        _write_bytes(payload, b"" if all(present) else _pack_bits(present))
+        _write_varint(payload, len(values))
+        _write_bytes(payload, encoded)
+
+    compressed = zlib.compress(bytes(payload), 6)
+    header = BLOCK_HEADER.pack(BLOCK_MAGIC, BLOCK_VERSION, len(records), min(timestamps), max(timestamps),
+                               last_seq, len(compressed), zlib.crc32(compressed))
+    return header + compressed
+
+
+def decode_block(payload: bytes, count: int, fields: Optional[Iterable[str]] = None) -> List[Record]:
+    """Decode a block payload; only columns in fields are materialized when given"""
+    wanted = set(fields) if fields is not None else None
+    data = memoryview(zlib.decompress(payload))
+    columns, pos = _read_varint(data, 0)
+    chunk, pos = _read_bytes(data, pos)
+    timestamps = decode_delta_of_delta(chunk, count)
+    rows: List[Dict[str, Any]] = [{} for _ in range(count)]
+
+    for _ in range(columns):
+        name_bytes, pos = _read_bytes(data, pos)
+        kind = bytes(data[pos:pos + 1])
+        pos += 1
+        presence, pos = _read_bytes(data, pos)
+        present_count, pos = _read_varint(data, pos)
+        encoded, pos = _read_bytes(data, pos)
+        name = bytes(name_bytes).decode('utf-8')
+        if wanted is not None and name not in wanted:
+            continue
+
+        if kind == COLUMN_FLOAT:
+            values = decode_gorilla(encoded, present_count)
+        elif kind == COLUMN_INT:
+            values = decode_deltas(encoded, present_count)
+        elif kind == COLUMN_BOOL:
+            values = _unpack_bits(encoded, present_count)
+        else:
+            values = json.loads(bytes(encoded).decode('utf-8'))
+
+        indices = range(count) if not len(presence) else [i for i, flag in enumerate(_unpack_bits(presence, count)) if flag]
+        for index, value in zip(indices, values):
+            rows[index][name] = value
+
+    return list(zip(timestamps, rows))
+
+
+class _BlockRef:
+    __slots__ = ('t_min', 't_max', 'count', 'last_seq', 'path', 'offset', 'length')
+
+    def __init__(self, t_min, t_max, count, last_seq, path, offset, length):
+        self.t_min, self.t_max, self.count, self.last_seq = t_min, t_max, count, last_seq
+        self.path, self.offset, self.length = path, offset, length
+
+
+class _DevicePartition(SegmentLog):
+    """One device's segments, block index and head log"""
+
+    item_fields = 2  # timestamp, data
+
+    def __init__(self, directory: str, block_records: int, segment_bytes: int):
+        super().__init__(directory, block_records)
+        self.segment_bytes = segment_bytes
+        self.blocks: List[_BlockRef] = []
+        os.makedirs(directory, exist_ok=True)
+        self._load()
+
+    def _segments(self) -> List[str]:
+        return sorted(name for name in os.listdir(self.directory) if name.endswith(".ffts"))
+
+    def _load(self):
+        """Index the intact blocks of each segment, then replay the head log"""
+        for name in self._segments():
+            path = os.path.join(self.directory, name)
+            for offset, (_, _, count, t_min, t_max, last_seq, length, _) in scan_frames(
+                    path, BLOCK_HEADER, BLOCK_MAGIC, lambda header: BLOCK_HEADER.size + header[6]):
+                self.blocks.append(_BlockRef(t_min, t_max, count, last_seq, path, offset, BLOCK_HEADER.size + length))
+        self._replay_head(self.blocks[-1].last_seq if self.blocks else 0)
+
+    def _next_segment(self, size: int) -> str:
+        segments = self._segments()
+        if segments:
+            path = os.path.join(self.directory, segments[-1])
+            if os.path.getsize(path) + size <= self.segment_bytes:
+                return path
+            index = int(segments[-1].split('-')[1].split('.')[0]) + 1
+        else:
+            index = 0
+        return os.path.join(self.directory, f"seg-{index:06d}.ffts")
+
+    def _seal(self, chunks: Sequence[Sequence[Tuple[int, Record]]]):
+        """Encode and append blocks, rolling segments as they fill, with one fsync per segment"""
+        blocks = [encode_block([record for _, record in chunk], chunk[-1][0]) for chunk in chunks]
+        f = None
+        try:
+            for block, chunk in zip(blocks, chunks):
+                if f is None or f.tell() + len(block) > self.segment_bytes:
+                    if f is not None:
+                        f.flush()
+                        os.fsync(f.fileno())
+                        f.close()
+                    f = open(self._next_segment(len(block)), 'ab')
+                offset = f.tell()
+                f.write(block)
+                _, _, _, t_min, t_max, last_seq, _, _ = BLOCK_HEADER.unpack_from(block)
+                self.blocks.append(_BlockRef(t_min, t_max, len(chunk), last_seq, f.name, offset, len(block)))
+            f.flush()
+            os.fsync(f.fileno())
+        finally:
+            if f is not None:
+                f.close()
+
+    def _read_block(self, ref: _BlockRef, fields: Optional[Iterable[str]]) -> List[Record]:
+        with open(ref.path, 'rb') as f:
+            f.seek(ref.offset)
+            raw = f.read(ref.length)
+        *_, length, crc = BLOCK_HEADER.unpack_from(raw)
+        payload = raw[BLOCK_HEADER.size:]
+        if zlib.crc32(payload) != crc:
+            raise ValueError(f"Corrupt telemetry block in {ref.path} at offset {ref.offset}")
+        return decode_block(payload, ref.count, fields)
+
+    def query(self, start: Optional[int], end: Optional[int], fields: Optional[Iterable[str]]) -> List[Record]:
+        """Records with start <= timestamp <= end, in arrival order"""
+        low = start if start is not None else -(1 << 63)
+        high = end if end is not None else (1 << 63) - 1
+        results: List[Record] = []
+        for ref in self.blocks:
+            if ref.t_max < low or ref.t_min > high:
+                continue  # Skipped without reading or decompressing
+            records = self._read_block(ref, fields)
+            if ref.t_min >= low and ref.t_max <= high:
+                results.extend(records)
+            else:
+                results.extend(record for record in records if low <= record[0] <= high)
+        for _, (timestamp, data) in self.head:
+            if low <= timestamp <= high:
+                results.append((timestamp, data if fields is None else {k: v for k, v in data.items() if k in fields}))
+        return results
+
+    def tail(self, limit: int, fields: Optional[Iterable[str]]) -> List[Record]:
+        """The last `limit` records in arrival order, reading only as many blocks as needed"""
+        results: List[Record] = [(timestamp, data) for _, (timestamp, data) in self.head[-limit:]]
+        index = len(self.blocks)
+        while len(results) < limit and index > 0:
+            index -= 1
+            results = self._read_block(self.blocks[index], fields) + results
+        if fields is not None:
+            results = [(timestamp, {k: v for k, v in data.items() if k in fields}) for timestamp, data in results]
+        return results[-limit:] if limit else []
+
+    def stats(self) -> Dict[str, Any]:
+        return {
+            'blocks': len(self.blocks),
+            'sealed_records': sum(ref.count for ref in self.blocks),
+            'head_records': len(self.head),
+            'bytes': sum(ref.length for ref in self.blocks),
+        }
+
+
+class TelemetryStore:
+    """Time-series store partitioned by device.
+
+    Writes append to a per-device head log (O(batch), never a rewrite).
+    Every block_records records the head is sealed into a compressed
+    columnar block appended to the device's current segment file:
+    delta-of-delta timestamps, Gorilla XOR floats, zigzag-delta integers
+    and bitmap booleans. Block headers carry their time range, so range
+    queries only decompress blocks that overlap.
+    """
+
+    def __init__(self, root: str, block_records: int = DEFAULT_BLOCK_RECORDS,
+                 segment_bytes: int = DEFAULT_SEGMENT_BYTES):
+        self.root = root
+        self.block_records = max(1, block_records)
+        self.segment_bytes = segment_bytes
+        self._lock = threading.Lock()
+        self._partitions: Dict[str, _DevicePartition] = {}
+        os.makedirs(root, exist_ok=True)
+
+    @staticmethod
+    def _directory_name(device_id: str) -> str:
+        safe = "".join(ch for ch in device_id if ch.isalnum() or ch in "-_")
+        if safe == device_id and safe:
+            return safe
+        return f"{safe[:32]}-{hashlib.sha1(device_id.encode('utf-8')).hexdigest()[:12]}"
+
+    def _partition(self, device_id: str) -> _DevicePartition:
+        with self._lock:
+            partition = self._partitions.get(device_id)
+            if partition is None:
+                directory = os.path.join(self.root, self._directory_name(device_id))
+                partition = _DevicePartition(directory, self.block_records, self.segment_bytes)
+                self._partitions[device_id] = partition
+            return partition
+
+    def append(self, device_id: str, data: Dict[str, Any], timestamp: Any = None):
+        """Record one data point"""
+        self.append_many(device_id, [(to_micros(timestamp), data)])
+
+    def append_many(self, device_id: str, records: Sequence[Record]):
+        """Record many (epoch µs, data) points in one write"""
+        if not records:
+            return
+        partition = self._partition(device_id)
+        with partition.lock:
+            partition.append(records)
+
+    def query(self, device_id: str, start: Any = None, end: Any = None,
+              fields: Optional[Iterable[str]] = None, limit: Optional[int] = None) -> List[Record]:
+        """Points in [start, end] (inclusive, None is open) sorted by timestamp"""
+        partition = self._partition(device_id)
+        fields = list(fields) if fields is not None else None
+        with partition.lock:
+            records = partition.query(None if start is None else to_micros(start),
+                                      None if end is None else to_micros(end), fields)
+        records.sort(key=lambda record: record[0])
+        return records[:limit] if limit is not None else records
+
+    def tail(self, device_id: str, limit: int = 100, fields: Optional[Iterable[str]] = None) -> List[Record]:
+        """The most recently recorded points, oldest first"""
+        partition = self._partition(device_id)
+        with partition.lock:
+            return partition.tail(limit, list(fields) if fields is not None else None)
+
+    def flush(self, device_id: Optional[str] = None):
+        """Seal partially filled heads, for one device or all opened ones"""
+        with self._lock:
+            partitions = [self._partitions[device_id]] if device_id in self._partitions else (
+                list(self._partitions.values()) if device_id is None else [])
+        for partition in partitions:
+            with partition.lock:
+                partition.flush()
+
+    def stats(self, device_id: str) -> Dict[str, Any]:
+        partition = self._partition(device_id)
+        with partition.lock:
+            return partition.stats()
@@ -0,0 +1,282 @@
+"""
+Tracing Services for FlashFlow
+Scoped spans in per-thread buffers, exported as one Chrome trace or OTLP JSON timeline
+"""
+
+import os
+import json
+import time
+import atexit
+import logging
+import secrets
+import functools
+import itertools
+import threading
+from collections import deque
+from typing import Any, Callable, Dict, List, Optional
+
+logger = logging.getLogger(__name__)
+
+DEFAULT_BUFFER_EVENTS = 200000  # Spans kept per thread; the oldest are dropped beyond this
+TRACE_ENV = "FLASHFLOW_TRACE"   # Path to export to at exit; setting it enables tracing
+
+_enabled = False
+_local = threading.local()
+_buffers: List['_ThreadBuffer'] = []
+_buffers_lock = threading.Lock()
+_span_ids = itertools.count(1)
+_trace_id = secrets.token_hex(16)
+_epoch_ns = time.perf_counter_ns()
+_epoch_unix_ns = time.time_ns()
+_buffer_events = DEFAULT_BUFFER_EVENTS
+
+
+class _ThreadBuffer:
+    """Spans finished on one thread; only that thread appends, readers copy"""
+
+    __slots__ = ("tid", "name", "events", "stack", "recorded")
+
+    def __init__(self, thread: threading.Thread, size: int):
+        self.tid = thread.ident
+        self.name = thread.name
+        self.events: deque = deque(maxlen=size)
+        self.stack: List[int] = []
+        self.recorded = 0
+
+
+def _thread_buffer() -> _ThreadBuffer:
+    buffer = getattr(_local, "buffer", None)
+    if buffer is None:
+        # Taken once per thread, never on the span path
+        buffer = _local.buffer = _ThreadBuffer(threading.current_thread(), _buffer_events)
+        with _buffers_lock:
+            _buffers.append(buffer)
+    return buffer
+
+
+class Span:
+    """One timed scope; use through span() or traced()"""
+
+    __slots__ = ("name", "cat", "args", "start", "span_id", "parent_id", "buffer")
+
+    def __init__(self, name: str, cat: str, args: Dict[str, Any]):
+        self.name = name
+        self.cat = cat
+        self.args = args
+
+    def set(self, **attrs) -> 'Span':
+        """Attach attributes known only once the span is running"""
+        self.args.update(attrs)
+        return self
+
+    def __enter__(self) -> 'Span':
+        buffer = self.buffer = _thread_buffer()
+        self.parent_id = buffer.stack[-1] if buffer.stack else 0
+        self.span_id = next(_span_ids)
+        buffer.stack.append(self.span_id)
+        self.start = time.perf_counter_ns()
+        return self
+
+    def __exit__(self, exc_type, exc, tb):
+        end = time.perf_counter_ns()
+        buffer = self.buffer
+        buffer.stack.pop()
+        if exc_type is not None:
+            self.args["error"] = f"{exc_type.__name__}: {exc}"
+        buffer.events.append((self.name, self.cat, self.start - _epoch_ns, end - self.start,
+                              self.span_id, self.parent_id, self.args))
+        buffer.recorded += 1
+        return False
+
+
+class _NoopSpan:
+    """Shared stand-in returned while tracing is off"""
+
+    __slots__ = ()
+
+    def set(self, **attrs) -> '_NoopSpan':
+        return self
+
+    def __enter__(self) -> '_NoopSpan':
+        return self
+
+    def __exit__(self, exc_type, exc, tb):
+        return False
+
+
+_NOOP = _NoopSpan()
+
+
+def span(name: str, cat: str = "flashflow", **attrs):
+    """Context manager timing the enclosed block; costs one flag check when tracing is off"""
+    if not _enabled:
+        return _NOOP
+    return Span(name, cat, attrs)
+
+
+def traced(name: Optional[str] = None, cat: str = "flashflow") -> Callable:
+    """Decorator recording every call of a function as a span named after it"""
+
+    def decorate(fn: Callable) -> Callable:
+        span_name = name or fn.__qualname__
+
+        @functools.wraps(fn)
+        def wrapper(*args, **kwargs):
+            if not _enabled:
+                return fn(*args, **kwargs)
+            with Span(span_name, cat, {}):
+                return fn(*args, **kwargs)
+
+        return wrapper
+
+    return decorate
+
+
+def enable(buffer_events: int = DEFAULT_BUFFER_EVENTS):
+    """Start recording spans; threads that already traced keep their buffer size"""
+    global _enabled, _buffer_events
+    _buffer_events = max(1, buffer_events)
+    _enabled = True
+
+
+def disable():
+    """Stop recording spans; recorded ones stay until clear()"""
+    global _enabled
+    _enabled = False
+
+
+def is_enabled() -> bool:
+    return _enabled
+
+
+def clear():
+    """Drop every recorded span"""
+    with _buffers_lock:
+        for buffer in _buffers:
+            buffer.events.clear()
+            buffer.recorded = 0
+
+
+def collect() -> List[Dict[str, Any]]:
+    """Recorded spans of every thread, oldest first"""
+    with _buffers_lock:
+        buffers = list(_buffers)
+
+    spans = []
+    for buffer in buffers:
+        for name, cat, start, duration, span_id, parent_id, args in list(buffer.events):
+            spans.append({"name": name, "cat": cat, "start_ns": start, "duration_ns": duration,
+                          "span_id": span_id, "parent_id": parent_id, "tid": buffer.tid,
+                          "thread": buffer.name, "args": args})
+    spans.sort(key=lambda item: item["start_ns"])
+    return spans
+
+
+def stats() -> Dict[str, Any]:
+    """Span counts per thread, including spans dropped from full buffers"""
+    with _buffers_lock:
+        buffers = list(_buffers)
+    return {
+        "enabled": _enabled,
+        "threads": len(buffers),
+        "spans": sum(len(buffer.events) for buffer in buffers),
+        "dropped": sum(buffer.recorded - len(buffer.events) for buffer in buffers)
+    }
+
+
+def _json_safe(args: Dict[str, Any]) -> Dict[str, Any]:
+    return {key: value if isinstance(value, (str, int, float, bool)) or value is None else str(value)
+            for key, value in args.items()}
+
+
+def chrome_trace(spans: Optional[List[Dict[str, Any]]] = None) -> Dict[str, Any]:
+    """Spans as Chrome trace events (chrome://tracing, Perfetto)"""
+    spans = collect() if spans is None else spans
+    pid = os.getpid()
+    threads: Dict[int, str] = {}
+    events = []
+    for item in spans:
+        threads.setdefault(item["tid"], item["thread"])
+        events.append({
+            "name": item["name"],
+            "cat": item["cat"],
+            "ph": "X",
+            "ts": round(item["start_ns"] / 1000, 3),
+            "dur": round(item["duration_ns"] / 1000, 3),
+            "pid": pid,
+            "tid": item["tid"],
+            "args": _json_safe(item["args"])
+        })
+    for tid, thread_name in threads.items():
+        events.append({"name": "thread_name", "ph": "M", "pid": pid, "tid": tid, "args": {"name": thread_name}})
+    return {"traceEvents": events, "displayTimeUnit": "ms"}
+
+
+def _otlp_value(value: Any) -> Dict[str, Any]:
+    if isinstance(value, bool):
+        return {"boolValue": value}
+    if isinstance(value, int):
+        return {"intValue": str(value)}
+    if isinstance(value, float):
+        return {"doubleValue": value}
+    return {"stringValue": str(value)}
+
+
+def otlp_trace(spans: Optional[List[Dict[str, Any]]] = None, service_name: str = "flashflow") -> Dict[str, Any]:
+    """Spans as an OTLP/JSON ExportTraceServiceRequest, one scope per category"""
+    spans = collect() if spans is None else spans
+    scopes: Dict[str, List[Dict[str, Any]]] = {}
+    for item in spans:
+        start = _epoch_unix_ns + item["start_ns"]
+        attributes = [{"key": key, "value": _otlp_value(value)} for key, value in item["args"].items()]
+        attributes.append({"key": "thread.id", "value": _otlp_value(item["tid"])})
+        attributes.append({"key": "thread.name", "value": _otlp_value(item["thread"])})
+        otlp_span = {
+            "traceId": _trace_id,
+            "spanId": f"{item['span_id']:016x}",
+            "name": item["name"],
+            "kind": 1,
+            "startTimeUnixNano": str(start),
+            "endTimeUnixNano": str(start + item["duration_ns"]),
+            "attributes": attributes,
+            "status": {"code": 2, "message": item["args"]["error"]} if "error" in item["args"] else {}
+        }
+        if item["parent_id"]:
+            otlp_span["parentSpanId"] = f"{item['parent_id']:016x}"
+        scopes.setdefault(item["cat"], []).append(otlp_span)
+
+    return {"resourceSpans": [{
+        "resource": {"attributes": [
+            {"key": "service.name", "value": {"stringValue": service_name}},
+            {"key": "process.pid", "value": {"intValue": str(os.getpid())}}
+        ]},
+        "scopeSpans": [{"scope": {"name": f"flashflow.{cat}"}, "spans": items} for cat, items in scopes.items()]
+    }]}
+
+
+def export(path: str, trace_format: Optional[str] = None) -> int:
+    """Write recorded spans to path as 'chrome' or 'otlp' (default: otlp for *.otlp.json); returns the span count"""
+    spans = collect()
+    trace_format = trace_format or ("otlp" if str(path).endswith(".otlp.json") else "chrome")
+    document = otlp_trace(spans) if trace_format == "otlp" else chrome_trace(spans)
+
+    directory = os.path.dirname(os.path.abspath(path))
+    os.makedirs(directory, exist_ok=True)
+    temp_path = f"{path}.tmp"
+    with open(temp_path, "w", encoding="utf-8") as f:
+        json.dump(document, f, separators=(",", ":"))
+    os.replace(temp_path, path)
+    return len(spans)
+
+
+def _export_at_exit(path: str):
+    try:
+        count = export(path)
+        logger.info(f"Wrote {count} trace spans to {path}")
+    except Exception as e:
+        logger.error(f"Failed to write trace {path}: {e}")
+
+
+if os.environ.get(TRACE_ENV):
+    enable()
+    atexit.register(_export_at_exit, os.environ[TRACE_ENV])
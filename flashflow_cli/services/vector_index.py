@@ -0,0 +1,869 @@
+"""
+Vector Index Services for FlashFlow
+NumPy implementation of the FlashCore HNSWIndex API, used whenever the native
+flashcore module has not been built
+"""
+
+import os
+import json
+import struct
+import logging
+import threading
+from concurrent.futures import ThreadPoolExecutor
+from typing import Dict, Any, List, NamedTuple, Optional, Tuple
+
+import numpy as np
+
+logger = logging.getLogger(__name__)
+
+# Supported distance metrics (same names as the FlashCore HNSWIndex)
+METRICS = ("l2", "ip", "cosine")
+
+# Supported vector compression schemes
+QUANTIZATIONS = ("sq8", "pq")
+
+# SIMD extensions in order of preference, as reported by NumPy's CPU dispatcher
+SIMD_LEVELS = ("AVX512F", "AVX2", "ASIMD", "NEON", "SSE42", "SSE2")
+
+# Upper bound on the (queries x vectors) distance block scored by one task
+MAX_BLOCK_FLOATS = 16 * 1024 * 1024
+
+# Number of striped locks guarding in-place overwrites of existing rows
+ROW_LOCK_STRIPES = 64
+
+# On-disk format: fixed header, then vectors, squared norms, ids and one
+# int32 column per attribute, each section starting on a SECTION_ALIGNMENT
+# boundary so it can be mapped as-is. Version 2 appends a JSON metadata block
+# naming the attribute columns and their value dictionaries.
+FILE_MAGIC = b"FFVI"
+FILE_VERSION = 2
+FILE_PREFIX = struct.Struct("<4sI")  # magic, version
+FILE_HEADER_V1 = struct.Struct("<4sIIIQQQQ")  # ..., dim, metric, count, 3 section offsets
+FILE_HEADER = struct.Struct("<4sIIIQQQQQQ")  # ..., metadata offset and size
+SECTION_ALIGNMENT = 64
+
+# Filters matching at most this fraction of rows are scored on a gathered copy
+FILTER_GATHER_RATIO = 0.25
+
+# Stored rows decoded per step when scoring scalar-quantized codes
+CODE_BLOCK_ROWS = 65536
+
+# Training rows sampled for product quantization codebooks
+PQ_TRAIN_ROWS = 65536
+
+# Fewest vectors a quantizer is trained on: one per PQ centroid, and enough for a real SQ range
+MIN_TRAIN_ROWS = 256
+
+
+def detect_simd_level() -> str:
+    """Return the widest SIMD extension NumPy dispatches to on this CPU"""
+    features = {}
+    try:
+        from numpy._core._multiarray_umath import __cpu_features__ as features
+    except ImportError:
+        try:
+            from numpy.core._multiarray_umath import __cpu_features__ as features
+        except ImportError:
+            pass
+
+    for level in SIMD_LEVELS:
+        if features.get(level):
+            return level.lower()
+    return "scalar"
+
+
+def _kmeans(points: np.ndarray, k: int, iterations: int, rng: np.random.Generator) -> np.ndarray:
+    """Lloyd's k-means, returning k centroids"""
+    centroids = points[rng.choice(points.shape[0], k, replace=False)].copy()
+    point_norms = np.einsum("ij,ij->i", points, points)[:, np.newaxis]
+
+    for _ in range(iterations):
+        distances = point_norms - 2.0 * (points @ centroids.T) + np.einsum("ij,ij->i", centroids, centroids)
+        assignment = distances.argmin(axis=1)
+        counts = np.bincount(assignment, minlength=k)
+        sums = np.zeros_like(centroids)
+        np.add.at(sums, assignment, points)
+        filled = counts > 0
+        centroids[filled] = sums[filled] / counts[filled, np.newaxis]
+
+    return centroids
+
+
+class ScalarQuantizer:
+    """8-bit scalar quantization: one byte per dimension over a per-dimension range"""
+
+    name = "sq8"
+
+    def __init__(self, dim: int):
+        self.dim = dim
+        self.code_size = dim
+        self.offset: Optional[np.ndarray] = None
+        self.scale: Optional[np.ndarray] = None
+
+    @property
+    def trained(self) -> bool:
+        return self.offset is not None
+
+    def train(self, vectors: np.ndarray):
+        low = vectors.min(axis=0)
+        high = vectors.max(axis=0)
+        self.offset = low.astype(np.float32)
+        self.scale = np.maximum((high - low) / 255.0, 1e-12).astype(np.float32)
+
+    def encode(self, vectors: np.ndarray) -> np.ndarray:
+        codes = np.rint((vectors - self.offset) / self.scale)
+        np.clip(codes, 0, 255, out=codes)
+        return codes.astype(np.uint8)
+
+    def decode(self, codes: np.ndarray) -> np.ndarray:
+        return codes.astype(np.float32) * self.scale + self.offset
+
+    def distances(self, queries: np.ndarray, codes: np.ndarray, sq_norms: np.ndarray, metric: str) -> np.ndarray:
+        """Asymmetric distances from float queries to encoded rows.
+
+        q.x' = q.offset + (q * scale).code, so queries are folded into the
+        code space once and each code block is widened to float32 only while
+        it is being multiplied.
+        """
+        scaled = queries * self.scale
+        distances = np.empty((queries.shape[0], codes.shape[0]), dtype=np.float32)
+        for start in range(0, codes.shape[0], CODE_BLOCK_ROWS):
+            end = min(start + CODE_BLOCK_ROWS, codes.shape[0])
+            distances[:, start:end] = scaled @ codes[start:end].T.astype(np.float32)
+        distances += (queries @ self.offset)[:, np.newaxis]
+
+        if metric == "l2":
+            # sq_norms holds ||x'||^2 of the decoded rows
+            distances *= -2.0
+            distances += sq_norms[np.newaxis, :]
+            distances += np.einsum("ij,ij->i", queries, queries)[:, np.newaxis]
+            np.maximum(distances, 0.0, out=distances)
+            return distances
+
+        np.subtract(1.0, distances, out=distances)
+        return distances
+
+    def memory_usage(self) -> int:
+        return 2 * self.dim * 4
+
+
+class ProductQuantizer:
+    """Product quantization: m sub-vectors, each encoded as one of 256 centroids"""
+
+    name = "pq"
+
+    def __init__(self, dim: int, subvectors: int, iterations: int = 20):
+        if dim % subvectors:
+            raise ValueError(f"Dimension {dim} is not divisible into {subvectors} sub-vectors")
+
+        self.dim = dim
+        self.subvectors = subvectors
+        self.sub_dim = dim // subvectors
+        self.code_size = subvectors
+        self.iterations = iterations
+        self.codebooks: Optional[np.ndarray] = None  # [subvectors, 256, sub_dim]
+
+    @property
+    def trained(self) -> bool:
+        return self.codebooks is not None
+
+    def _split(self, vectors: np.ndarray) -> np.ndarray:
+        return vectors.reshape(vectors.shape[0], self.subvectors, self.sub_dim)
+
+    def train(self, vectors: np.ndarray, seed: int = 0):
+        rng = np.random.default_rng(seed)
+        if vectors.shape[0] > PQ_TRAIN_ROWS:
+            vectors = vectors[rng.choice(vectors.shape[0], PQ_TRAIN_ROWS, replace=False)]
+
+        parts = self._split(vectors)
+        centroids = min(256, vectors.shape[0])
+        codebooks = np.zeros((self.subvectors, 256, self.sub_dim), dtype=np.float32)
+        for j in range(self.subvectors):
+            codebooks[j, :centroids] = _kmeans(np.ascontiguousarray(parts[:, j]), centroids, self.iterations, rng)
+            # Unused centroids repeat the first one, which argmin always prefers
+            codebooks[j, centroids:] = codebooks[j, 0]
+        self.codebooks = codebooks
+
+    def encode(self, vectors: np.ndarray) -> np.ndarray:
+        parts = self._split(vectors)
+        codes = np.empty((vectors.shape[0], self.subvectors), dtype=np.uint8)
+        for j in range(self.subvectors):
+            book = self.codebooks[j]
+            distances = (book * book).sum(axis=1) - 2.0 * (parts[:, j] @ book.T)
+            codes[:, j] = distances.argmin(axis=1)
+        return codes
+
+    def decode(self, codes: np.ndarray) -> np.ndarray:
+        parts = self.codebooks[np.arange(self.subvectors), codes]
+        return parts.reshape(codes.shape[0], self.dim)
+
+    def distances(self, queries: np.ndarray, codes: np.ndarray, sq_norms: np.ndarray, metric: str) -> np.ndarray:
+        """Asymmetric distances via one [subvectors, 256] lookup table per query"""
+        distances = np.empty((queries.shape[0], codes.shape[0]), dtype=np.float32)
+        columns = np.arange(self.subvectors)
+
+        for i, parts in enumerate(self._split(queries)):
+            dots = np.einsum("jcd,jd->jc", self.codebooks, parts)
+            if metric == "l2":
+                table = (self.codebooks ** 2).sum(axis=2) - 2.0 * dots + (parts ** 2).sum(axis=1)[:, np.newaxis]
+            else:
+                table = dots
+            distances[i] = table[columns, codes].sum(axis=1)
+
+        if metric != "l2":
+            np.subtract(1.0, distances, out=distances)
+        else:
+            np.maximum(distances, 0.0, out=distances)
+        return distances
+
+    def memory_usage(self) -> int:
+        return self.subvectors * 256 * self.sub_dim * 4
+
+
+class _View(NamedTuple):
+    """Published rows as seen by one search"""
+    vectors: np.ndarray
+    sq_norms: np.ndarray
+    ids: np.ndarray
+    codes: np.ndarray
+    deleted: Optional[np.ndarray]  # Rows to skip, or None when every row is eligible
+    attributes: Dict[str, np.ndarray]
+
+
+class _Storage:
+    """Row-aligned arrays backing a VectorIndex, replaced as a whole on growth"""
+
+    def __init__(self, capacity: int, dim: int, code_size: int = 0):
+        self.capacity = capacity
+        self.vectors = np.zeros((capacity, dim), dtype=np.float32)
+        self.sq_norms = np.zeros(capacity, dtype=np.float32)
+        self.ids = np.full(capacity, -1, dtype=np.int64)
+        self.codes = np.zeros((capacity, code_size), dtype=np.uint8)
+        self.deleted = np.zeros(capacity, dtype=bool)
+        self.num_deleted = 0
+        self.attributes: Dict[str, np.ndarray] = {}  # field -> value code per row, -1 when unset
+        self.read_only = False
+
+    @classmethod
+    def mapped(cls, vectors: np.ndarray, sq_norms: np.ndarray, ids: np.ndarray,
+               attributes: Dict[str, np.ndarray]) -> "_Storage":
+        """Storage over read-only arrays mapped from an index file"""
+        storage = cls.__new__(cls)
+        storage.capacity = ids.shape[0]
+        storage.vectors = vectors
+        storage.sq_norms = sq_norms
+        storage.ids = ids
+        storage.codes = np.zeros((storage.capacity, 0), dtype=np.uint8)
+        storage.deleted = np.zeros(storage.capacity, dtype=bool)
+        storage.num_deleted = 0
+        storage.attributes = attributes
+        storage.read_only = True
+        return storage
+
+    def add_field(self, name: str):
+        self.attributes[name] = np.full(self.capacity, -1, dtype=np.int32)
+
+    def copy_rows(self, capacity: int, rows) -> "_Storage":
+        """New storage of the given capacity holding the selected rows at the front"""
+        storage = _Storage(capacity, self.vectors.shape[1], self.codes.shape[1])
+        selected = self.ids[rows]
+        count = selected.shape[0]
+        storage.vectors[:count] = self.vectors[rows]
+        storage.sq_norms[:count] = self.sq_norms[rows]
+        storage.ids[:count] = selected
+        storage.codes[:count] = self.codes[rows]
+        storage.deleted[:count] = self.deleted[rows]
+        storage.num_deleted = int(np.count_nonzero(storage.deleted[:count]))
+        for name, column in self.attributes.items():
+            storage.add_field(name)
+            storage.attributes[name][:count] = column[rows]
+        return storage
+
+    def write_rows(self, slots: np.ndarray, rows: "_Rows"):
+        if self.vectors.shape[1]:
+            self.vectors[slots] = rows.vectors
+        if self.codes.shape[1]:
+            self.codes[slots] = rows.codes
+        self.sq_norms[slots] = rows.sq_norms
+        self.ids[slots] = rows.ids
+        for name, codes in rows.attributes.items():
+            self.attributes[name][slots] = codes
+
+    def memory_usage(self) -> int:
+        usage = self.vectors.nbytes + self.sq_norms.nbytes + self.ids.nbytes + self.codes.nbytes + self.deleted.nbytes
+        return usage + sum(column.nbytes for column in self.attributes.values())
+
+
+class _Rows(NamedTuple):
+    """One batch of rows on its way into storage"""
+    vectors: np.ndarray
+    sq_norms: np.ndarray
+    ids: np.ndarray
+    codes: np.ndarray
+    attributes: Dict[str, np.ndarray]
+
+    def select(self, mask: np.ndarray) -> "_Rows":
+        attributes = {name: codes[mask] for name, codes in self.attributes.items()}
+        return _Rows(self.vectors[mask], self.sq_norms[mask], self.ids[mask], self.codes[mask], attributes)
+
+
+class VectorIndex:
+    """Exact k-NN index exposing the flashcore.HNSWIndex interface.
+
+    Vectors live in one contiguous float32 matrix so every query is a single
+    matrix-vector product. NumPy and its BLAS pick AVX2/AVX-512/NEON kernels
+    at import time by CPUID, which is the runtime dispatch FlashCore does
+    natively.
+
+    The index is safe to share between threads. Inserts reserve their slots
+    under a short lock, copy rows without it, and then publish the reserved
+    range. Searches take no lock at all; they read one (storage, count) pair
+    that writers replace atomically, so they only ever see published rows.
+    Overwrites of an existing id serialize on a striped per-row lock, and a
+    search racing with an overwrite may see either version of that row.
+
+    max_elements is the initial capacity. When it is exceeded the storage
+    doubles in the background of running searches, unless allow_growth is
+    off. Deleted ids are tombstoned and skipped by searches until compact()
+    reclaims their slots.
+
+    quantization="sq8" stores one byte per dimension and "pq" stores
+    pq_subvectors bytes per vector. Searches score the codes directly and,
+    when rerank > 0, re-rank the best max(k, rerank) candidates with exact
+    float distances. Float vectors are only kept when they are needed for
+    the re-rank, so rerank=0 gives the smallest footprint.
+
+    Each vector can carry categorical attributes such as type or tenant,
+    stored as one int32 value code per row and field. search(filter=...)
+    turns the filter into a row mask before ranking, so results are the
+    exact top-k among matching rows however selective the filter is.
+    """
+
+    def __init__(self, dim: int, max_elements: int, metric: str = "l2",
+                 num_threads: Optional[int] = None, batch_size: int = 256,
+                 allow_growth: bool = True, quantization: Optional[str] = None,
+                 pq_subvectors: int = 16, rerank: int = 0):
+        if metric not in METRICS:
+            raise ValueError(f"Unsupported metric '{metric}', expected one of {METRICS}")
+        if quantization is not None and quantization not in QUANTIZATIONS:
+            raise ValueError(f"Unsupported quantization '{quantization}', expected one of {QUANTIZATIONS}")
+
+        self.dim = dim
+        self.metric = metric
+        self.allow_growth = allow_growth
+        self.simd_level = detect_simd_level()
+        self.num_threads = num_threads or os.cpu_count() or 1
+        self.batch_size = batch_size  # Queries scored per thread pool task
+        self._executor: Optional[ThreadPoolExecutor] = None
+
+        if quantization == "sq8":
+            self.quantizer = ScalarQuantizer(dim)
+        elif quantization == "pq":
+            self.quantizer = ProductQuantizer(dim, pq_subvectors)
+        else:
+            self.quantizer = None
+        self.rerank = rerank if self.quantizer is not None else 0
+        self._train_lock = threading.Lock()
+
+        keep_vectors = self.quantizer is None or self.rerank > 0
+        code_size = self.quantizer.code_size if self.quantizer is not None else 0
+        self._storage = _Storage(max_elements, dim if keep_vectors else 0, code_size)
+        self._published: Tuple[_Storage, int] = (self._storage, 0)
+        self._id_to_slot: Optional[Dict[int, int]] = {}  # Built lazily after load_mmap
+        self._attribute_values: Dict[str, Dict[Any, int]] = {}  # field -> value -> code
+
+        # _reserved slots have been handed to writers; compact() waits for _writers to drain
+        self._lock = threading.Lock()
+        self._writers_done = threading.Condition(self._lock)
+        self._row_locks = [threading.Lock() for _ in range(ROW_LOCK_STRIPES)]
+        self._reserved = 0
+        self._completed: Dict[int, int] = {}
+        self._writers = 0
+        self._exclusive = False
+
+        logger.info(f"Vector index ready: dim={dim}, metric={metric}, simd={self.simd_level}")
+
+    @property
+    def max_elements(self) -> int:
+        """Current capacity of the storage"""
+        return self._storage.capacity
+
+    def __len__(self) -> int:
+        """Number of live (published, not deleted) vectors"""
+        storage, count = self._published
+        return count - storage.num_deleted
+
+    def _prepare(self, vectors: np.ndarray) -> np.ndarray:
+        """Validate a vector or matrix and bring it into the stored representation.
+
+        float32 input is used as-is (no copy) unless it has to be normalized.
+        """
+        vectors = np.asarray(vectors, dtype=np.float32)
+        if vectors.ndim == 1:
+            vectors = vectors.reshape(1, -1)
+        if vectors.ndim != 2 or vectors.shape[1] != self.dim:
+            raise ValueError(f"Expected vectors of dimension {self.dim}, got shape {vectors.shape}")
+
+        if self.metric == "cosine":
+            norms = np.linalg.norm(vectors, axis=1, keepdims=True)
+            norms[norms == 0.0] = 1.0
+            vectors = vectors / norms
+        return vectors
+
+    def _snapshot(self) -> _View:
+        """Views over the published rows, taken without locking"""
+        storage, count = self._published
+        deleted = storage.deleted[:count] if storage.num_deleted else None
+        return _View(storage.vectors[:count], storage.sq_norms[:count], storage.ids[:count],
+                     storage.codes[:count], deleted, dict(storage.attributes))
+
+    def _filter_mask(self, view: _View, filter: Dict[str, Any]) -> np.ndarray:
+        """Rows matching every field of filter; a list value matches any of its items"""
+        count = view.ids.shape[0]
+        mask = np.ones(count, dtype=bool)
+
+        for field, wanted in filter.items():
+            if not isinstance(wanted, (list, tuple, set, frozenset)):
+                wanted = [wanted]
+            values = self._attribute_values.get(field, {})
+            codes = [values[value] for value in wanted if value in values]
+            column = view.attributes.get(field)
+            if column is None or not codes:
+                return np.zeros(count, dtype=bool)
+            mask &= np.isin(column[:count], codes)
+
+        return mask
+
+    def _filtered(self, view: _View, filter: Dict[str, Any]) -> _View:
+        """Restrict a view to the rows matching filter"""
+        allowed = self._filter_mask(view, filter)
+        if view.deleted is not None:
+            allowed &= ~view.deleted
+
+        selected = np.flatnonzero(allowed)
+        if selected.shape[0] <= view.ids.shape[0] * FILTER_GATHER_RATIO:
+            # Selective filter: score only the matching rows
+            return _View(view.vectors[selected], view.sq_norms[selected], view.ids[selected],
+                         view.codes[selected], None, {})
+        return view._replace(deleted=~allowed)
+
+    def _distances(self, queries: np.ndarray, vectors: np.ndarray, sq_norms: np.ndarray) -> np.ndarray:
+        """Distance block from each query row to every vector in the snapshot"""
+        distances = queries @ vectors.T
+
+        if self.metric == "l2":
+            # ||v - q||^2 = ||v||^2 - 2 v.q + ||q||^2, with ||v||^2 cached at insert
+            distances *= -2.0
+            distances += sq_norms[np.newaxis, :]
+            distances += np.einsum("ij,ij->i", queries, queries)[:, np.newaxis]
+            np.maximum(distances, 0.0, out=distances)
+            return distances
+
+        # Inner product and cosine (on normalized vectors) share the same kernel
+        np.subtract(1.0, distances, out=distances)
+        return distances
+
+    def _exact_distances(self, queries: np.ndarray, vectors: np.ndarray, top: np.ndarray,
+                         coarse: np.ndarray) -> np.ndarray:
+        """Float distances for the candidate rows picked from quantized codes"""
+        candidates = vectors[top]  # [queries, candidates, dim]
+        if self.metric == "l2":
+            diff = candidates - queries[:, np.newaxis, :]
+            exact = np.einsum("qcd,qcd->qc", diff, diff)
+        else:
+            exact = 1.0 - np.einsum("qcd,qd->qc", candidates, queries)
+        # Keep deleted rows out of the results
+        exact[np.isinf(coarse)] = np.inf
+        return exact.astype(np.float32, copy=False)
+
+    def _get_executor(self) -> ThreadPoolExecutor:
+        if self._executor is None:
+            self._executor = ThreadPoolExecutor(max_workers=self.num_threads,
+                                                thread_name_prefix="vector-index")
+        return self._executor
+
+    def _id_map_locked(self) -> Dict[int, int]:
+        """id -> slot map, built on first use for mapped indexes; caller holds the lock"""
+        if self._id_to_slot is None:
+            storage = self._storage
+            ids = storage.ids[:self._reserved].tolist()
+            deleted = storage.deleted[:self._reserved].tolist()
+            self._id_to_slot = {id: slot for slot, id in enumerate(ids) if not deleted[slot]}
+        return self._id_to_slot
+
+    def _resize_locked(self, capacity: int):
+        """Swap in storage of a new capacity; caller holds the lock.
+
+        Rows of in-flight writers are copied as they are and rewritten by
+        those writers when they publish.
+        """
+        self._storage = self._storage.copy_rows(capacity, slice(0, self._reserved))
+        self._published = (self._storage, self._published[1])
+        logger.info(f"Vector index resized to {capacity} elements")
+
+    def resize_index(self, max_elements: int):
+        """Change the capacity without blocking searches"""
+        with self._lock:
+            if max_elements < self._reserved:
+                raise ValueError(f"Cannot shrink below the {self._reserved} stored elements, call compact() first")
+            self._resize_locked(max_elements)
+
+    def train(self, vectors: np.ndarray):
+        """Fit the quantizer on at least MIN_TRAIN_ROWS representative vectors.
+
+        Called automatically with the first inserted batch when that batch
+        is large enough; an untrained index rejects smaller first batches,
+        since a quantizer fitted to a few rows ruins recall for every
+        vector added later.
+        """
+        if self.quantizer is None:
+            return
+        if self._reserved:
+            raise ValueError("train() must be called before any vectors are added")
+        vectors = self._prepare(vectors)
+        if vectors.shape[0] < MIN_TRAIN_ROWS:
+            raise ValueError(f"Training needs at least {MIN_TRAIN_ROWS} vectors, got {vectors.shape[0]}")
+        with self._train_lock:
+            self.quantizer.train(vectors)
+        logger.info(f"Trained {self.quantizer.name} quantizer")
+
+    def memory_usage(self) -> int:
+        """Bytes held by the vector storage and quantizer"""
+        usage = self._storage.memory_usage()
+        if self.quantizer is not None:
+            usage += self.quantizer.memory_usage()
+        return usage
+
+    def add_vector(self, vector: np.ndarray, id: int):
+        """Add a vector, replacing any vector already stored under the same id"""
+        self.add_vectors(vector, [id])
+
+    def add_vectors(self, vectors: np.ndarray, ids, attributes: Optional[Dict[str, Any]] = None) -> int:
+        """Add a [n, dim] matrix of vectors under ids[n] in one call.
+
+        attributes maps a field name to n values, e.g. {"type": types,
+        "tenant": tenants}. Ids that already exist are overwritten in place,
+        keeping any attribute fields not given. Returns the number of rows
+        written.
+        """
+        vectors = self._prepare(vectors)
+        ids = np.asarray(ids, dtype=np.int64).reshape(-1)
+        if ids.shape[0] != vectors.shape[0]:
+            raise ValueError(f"Got {vectors.shape[0]} vectors but {ids.shape[0]} ids")
+
+        id_list = ids.tolist()
+        if self.quantizer is None:
+            codes = np.zeros((vectors.shape[0], 0), dtype=np.uint8)
+            sq_norms = np.einsum("ij,ij->i", vectors, vectors)
+        else:
+            with self._train_lock:
+                if not self.quantizer.trained:
+                    if vectors.shape[0] < MIN_TRAIN_ROWS:
+                        raise ValueError(f"First batch of {vectors.shape[0]} vectors is too small to train the "
+                                         f"{self.quantizer.name} quantizer; call train() with at least "
+                                         f"{MIN_TRAIN_ROWS} vectors first")
+                    self.quantizer.train(vectors)
+                    logger.info(f"Trained {self.quantizer.name} quantizer on the first batch")
+            codes = self.quantizer.encode(vectors)
+            decoded = self.quantizer.decode(codes)
+            sq_norms = np.einsum("ij,ij->i", decoded, decoded)
+
+        attribute_values = {}
+        for field, values in (attributes or {}).items():
+            values = values.tolist() if isinstance(values, np.ndarray) else list(values)
+            if len(values) != len(id_list):
+                raise ValueError(f"Got {len(values)} values for attribute '{field}' but {len(id_list)} ids")
+            attribute_values[field] = values
+
+        with self._lock:
+            while self._exclusive:
+                self._writers_done.wait()
+
+            id_to_slot = self._id_map_locked()
+            new_ids = [id for id in dict.fromkeys(id_list) if id not in id_to_slot]
+            needed = self._reserved + len(new_ids)
+            if needed > self._storage.capacity:
+                if not self.allow_growth:
+                    raise RuntimeError(f"Vector index is full ({self._storage.capacity} elements)")
+                self._resize_locked(max(needed, self._storage.capacity * 2))
+            elif self._storage.read_only:
+                # First write to a mapped index moves it into private memory
+                self._resize_locked(self._storage.capacity)
+
+            start = self._reserved
+            for id in new_ids:
+                id_to_slot[id] = self._reserved
+                self._reserved += 1
+            end = self._reserved
+            slots = np.fromiter((id_to_slot[id] for id in id_list), dtype=np.int64, count=len(id_list))
+
+            attribute_codes = {}
+            for field, values in attribute_values.items():
+                value_codes = self._attribute_values.setdefault(field, {})
+                attribute_codes[field] = np.fromiter((value_codes.setdefault(value, len(value_codes)) for value in values),
+                                                     dtype=np.int32, count=len(values))
+                if field not in self._storage.attributes:
+                    self._storage.add_field(field)
+            rows = _Rows(vectors, sq_norms, ids, codes, attribute_codes)
+
+            storage = self._storage
+            self._writers += 1
+
+        try:
+            # Fresh slots are invisible to readers until published, so no lock is needed
+            fresh = slots >= start
+            if fresh.all():
+                storage.write_rows(slots, rows)
+            else:
+                storage.write_rows(slots[fresh], rows.select(fresh))
+
+                # Existing rows may be hit by other writers; lock each stripe touched
+                existing = ~fresh
+                stripes = slots % ROW_LOCK_STRIPES
+                for stripe in np.unique(stripes[existing]).tolist():
+                    mask = existing & (stripes == stripe)
+                    with self._row_locks[stripe]:
+                        storage.write_rows(slots[mask], rows.select(mask))
+        finally:
+            self._publish(storage, start, end, slots, rows)
+
+        return len(id_list)
+
+    def _publish(self, storage: _Storage, start: int, end: int, slots: np.ndarray, rows: _Rows):
+        """Mark [start, end) as written and expose the contiguous written prefix"""
+        with self._lock:
+            if self._storage is not storage:
+                # The index grew while we were copying; repeat the writes on the new arrays
+                self._storage.write_rows(slots, rows)
+
+            count = self._published[1]
+            if end > start:
+                self._completed[start] = end
+                while count in self._completed:
+                    count = self._completed.pop(count)
+            self._published = (self._storage, count)
+
+            self._writers -= 1
+            self._writers_done.notify_all()
+
+    def mark_deleted(self, id: int) -> bool:
+        """Hide a vector from searches. Its slot is reclaimed by compact()"""
+        with self._lock:
+            slot = self._id_map_locked().pop(int(id), None)
+            if slot is None:
+                return False
+            self._storage.deleted[slot] = True
+            self._storage.num_deleted += 1
+            return True
+
+    def compact(self) -> int:
+        """Reclaim the slots of deleted vectors, returning how many were freed.
+
+        Live rows are copied into fresh storage of the same capacity, so
+        searches keep running on the old arrays until the swap. Inserts wait
+        for the compaction to finish.
+        """
+        with self._lock:
+            self._exclusive = True
+            try:
+                while self._writers:
+                    self._writers_done.wait()
+
+                freed = self._storage.num_deleted
+                if freed == 0:
+                    return 0
+
+                live = np.flatnonzero(~self._storage.deleted[:self._reserved])
+                self._storage = self._storage.copy_rows(self._storage.capacity, live)
+                self._reserved = live.shape[0]
+                self._id_to_slot = {id: slot for slot, id in enumerate(self._storage.ids[:self._reserved].tolist())}
+                self._published = (self._storage, self._reserved)
+            finally:
+                self._exclusive = False
+                self._writers_done.notify_all()
+
+        logger.info(f"Vector index compacted, freed {freed} slots")
+        return freed
+
+    def save(self, path: str):
+        """Write the live vectors to path in the versioned FFVI layout.
+
+        The file is written next to path and renamed into place, so readers
+        that map the old file keep a consistent view.
+        """
+        if self.quantizer is not None:
+            raise ValueError("save() supports unquantized indexes only")
+
+        storage, count = self._published
+        rows = np.flatnonzero(~storage.deleted[:count]) if storage.num_deleted else slice(0, count)
+        vectors, sq_norms, ids = storage.vectors[rows], storage.sq_norms[rows], storage.ids[rows]
+        columns = [(name, column[rows]) for name, column in dict(storage.attributes).items()]
+        count = ids.shape[0]
+
+        def aligned(offset: int) -> int:
+            return (offset + SECTION_ALIGNMENT - 1) // SECTION_ALIGNMENT * SECTION_ALIGNMENT
+
+        sections = []
+        offset = FILE_HEADER.size
+        for array in [vectors, sq_norms, ids] + [column for _, column in columns]:
+            offset = aligned(offset)
+            sections.append((offset, array))
+            offset += array.nbytes
+
+        metadata = json.dumps({
+            "attributes": [
+                {"name": name, "offset": section_offset, "values": list(self._attribute_values.get(name, {}))}
+                for (name, _), (section_offset, _) in zip(columns, sections[3:])
+            ]
+        }).encode("utf-8")
+
+        tmp_path = f"{path}.tmp"
+        with open(tmp_path, "wb") as f:
+            f.write(FILE_HEADER.pack(FILE_MAGIC, FILE_VERSION, self.dim, METRICS.index(self.metric), count,
+                                     sections[0][0], sections[1][0], sections[2][0], offset, len(metadata)))
+            for section_offset, array in sections:
+                f.write(b"\0" * (section_offset - f.tell()))
+                f.write(np.ascontiguousarray(array).data)
+            f.write(metadata)
+        os.replace(tmp_path, path)
+
+        logger.info(f"Saved vector index to {path} ({count} vectors)")
+
+    @classmethod
+    def load_mmap(cls, path: str, **kwargs) -> "VectorIndex":
+        """Open an index file written by save() without reading it into memory.
+
+        The sections are mapped read-only, so every process that loads the
+        same file shares its page-cache pages. Loading does no per-vector
+        work; the id map is built on the first insert or delete, which also
+        moves the index into private memory.
+        """
+        with open(path, "rb") as f:
+            prefix = f.read(FILE_PREFIX.size)
+            if len(prefix) < FILE_PREFIX.size or FILE_PREFIX.unpack(prefix)[0] != FILE_MAGIC:
+                raise ValueError(f"{path} is not a vector index file")
+
+            version = FILE_PREFIX.unpack(prefix)[1]
+            if version == 1:
+                header_struct = FILE_HEADER_V1
+            elif version == FILE_VERSION:
+                header_struct = FILE_HEADER
+            else:
+                raise ValueError(f"Unsupported vector index file version {version} in {path}")
+
+            f.seek(0)
+            header = f.read(header_struct.size)
+            if len(header) < header_struct.size:
+                raise ValueError(f"{path} is truncated")
+            fields = header_struct.unpack(header)
+            _, _, dim, metric, count, vectors_offset, sq_norms_offset, ids_offset = fields[:8]
+
+            metadata = {"attributes": []}
+            if version >= 2:
+                metadata_offset, metadata_size = fields[8:]
+                f.seek(metadata_offset)
+                metadata = json.loads(f.read(metadata_size).decode("utf-8"))
+
+        index = cls(dim, 0, metric=METRICS[metric], **kwargs)
+        for attribute in metadata["attributes"]:
+            index._attribute_values[attribute["name"]] = {value: code for code, value in enumerate(attribute["values"])}
+
+        if count:
+            vectors = np.memmap(path, dtype=np.float32, mode="r", offset=vectors_offset, shape=(count, dim))
+            sq_norms = np.memmap(path, dtype=np.float32, mode="r", offset=sq_norms_offset, shape=(count,))
+            ids = np.memmap(path, dtype=np.int64, mode="r", offset=ids_offset, shape=(count,))
+            attributes = {
+                attribute["name"]: np.memmap(path, dtype=np.int32, mode="r", offset=attribute["offset"], shape=(count,))
+                for attribute in metadata["attributes"]
+            }
+            index._storage = _Storage.mapped(vectors, sq_norms, ids, attributes)
+            index._published = (index._storage, count)
+            index._reserved = count
+            index._id_to_slot = None
+
+        logger.info(f"Mapped vector index from {path} ({count} vectors)")
+        return index
+
+    def search(self, query: np.ndarray, k: int = 5, filter: Optional[Dict[str, Any]] = None) -> List[Dict[str, Any]]:
+        """Return the k nearest vectors as [{'id', 'distance'}], closest first.
+
+        filter restricts the results to vectors whose attributes match, e.g.
+        {"type": "post", "tenant": [1, 2]}.
+        """
+        labels, distances = self.search_batch(query, k, filter=filter)
+        return [
+            {"id": int(label), "distance": float(distance)}
+            for label, distance in zip(labels[0], distances[0])
+            if label >= 0
+        ]
+
+    def search_batch(self, queries: np.ndarray, k: int = 5,
+                     filter: Optional[Dict[str, Any]] = None) -> Tuple[np.ndarray, np.ndarray]:
+        """Search a [m, dim] matrix of queries, optionally under one shared filter.
+
+        Returns preallocated (ids[m, k], distances[m, k]) arrays, closest first.
+        Rows are padded with id -1 and distance inf when fewer than k vectors
+        match. Query blocks are scored on the thread pool; NumPy drops the
+        GIL inside the matrix products so the blocks run in parallel.
+        """
+        queries = self._prepare(queries)
+        m = queries.shape[0]
+        k = max(int(k), 0)
+
+        labels = np.full((m, k), -1, dtype=np.int64)
+        distances = np.full((m, k), np.inf, dtype=np.float32)
+
+        snapshot = self._snapshot()
+        if filter:
+            snapshot = self._filtered(snapshot, filter)
+        count = snapshot.ids.shape[0]
+        if count == 0 or k == 0 or m == 0:
+            return labels, distances
+
+        rows = max(1, min(self.batch_size, MAX_BLOCK_FLOATS // count))
+        blocks = [(start, min(start + rows, m)) for start in range(0, m, rows)]
+
+        if len(blocks) == 1 or self.num_threads == 1:
+            for start, end in blocks:
+                self._search_block(snapshot, queries, start, end, k, labels, distances)
+        else:
+            futures = [
+                self._get_executor().submit(self._search_block, snapshot, queries, start, end, k, labels, distances)
+                for start, end in blocks
+            ]
+            for future in futures:
+                future.result()
+
+        return labels, distances
+
+    def _search_block(self, snapshot: _View, queries: np.ndarray, start: int, end: int, k: int,
+                      labels: np.ndarray, distances: np.ndarray):
+        """Score queries[start:end] and write their top-k into the output rows"""
+        queries = queries[start:end]
+        if self.quantizer is None:
+            block = self._distances(queries, snapshot.vectors, snapshot.sq_norms)
+        else:
+            block = self.quantizer.distances(queries, snapshot.codes, snapshot.sq_norms, self.metric)
+        if snapshot.deleted is not None:
+            block[:, snapshot.deleted] = np.inf
+
+        count = block.shape[1]
+        k = min(k, count)
+        candidates = min(max(k, self.rerank), count)
+
+        # Partial selection first, then sort only the surviving candidates
+        top = np.argpartition(block, candidates - 1, axis=1)[:, :candidates]
+        top_distances = np.take_along_axis(block, top, axis=1)
+        if self.rerank:
+            top_distances = self._exact_distances(queries, snapshot.vectors, top, top_distances)
+        order = np.argsort(top_distances, axis=1)[:, :k]
+        top = np.take_along_axis(top, order, axis=1)
+        top_distances = np.take_along_axis(top_distances, order, axis=1)
+
+        if self.metric == "l2":
+            np.sqrt(top_distances, out=top_distances)
+
+        top_labels = snapshot.ids[top]
+        top_labels[np.isinf(top_distances)] = -1
+        labels[start:end, :k] = top_labels
+        distances[start:end, :k] = top_distances
@@ -9,11 +9,173 @@ import os
 import wave
 import io
 import re
-from typing import Dict, List, Optional, Any, Union
+import math
+import array
+import queue
+from collections import deque
+from typing import Dict, List, Optional, Any, Union, Iterator, Tuple
 from pathlib import Path
 import threading
 import time
 
+import _sre
+
+try:
+    import re._parser as _sre_parse
+    from re._casefix import _EXTRA_CASES as _CASE_FIXES
+except ImportError:  # Python < 3.11
+    import sre_parse as _sre_parse
+    from sre_compile import _ignorecase_fixes as _CASE_FIXES
+
+DEFAULT_FRAME_MS = 30           # VAD frame length (10, 20 or 30 ms for the WebRTC VAD)
+DEFAULT_BUFFER_SECONDS = 10     # Ring buffer capacity before new audio is dropped
+DEFAULT_MIN_SPEECH_MS = 90      # Voiced audio needed before an utterance starts
+DEFAULT_PRE_ROLL_MS = 300       # Audio kept from before the start so first syllables reach the recognizer
+DEFAULT_PARTIAL_INTERVAL = 1.0  # Seconds of new speech between Whisper partial transcripts
+
+
+class PatternAutomaton:
+    """Many regexes behind one Aho-Corasick scan for their required literals.
+    
+    Each pattern's longest literal that every match must contain (or a set
+    of alternatives, for a group like (phone|laptop)) goes into one
+    automaton. A query scans the text once and only runs the regexes whose
+    literal occurred, in priority (insertion) order, so cost follows the
+    text length and the number of plausible patterns rather than the
+    number registered. Patterns with no usable literal are always run.
+    Literals and text are folded one character to one character the way
+    re.IGNORECASE compares them (casefold() would turn 'İ' into two), which
+    only ever adds candidates, so results are the same as trying every
+    regex in order.
+    """
+    
+    _REPEATS = {op for op in (getattr(_sre_parse, 'MAX_REPEAT', None), getattr(_sre_parse, 'MIN_REPEAT', None),
+                              getattr(_sre_parse, 'POSSESSIVE_REPEAT', None)) if op is not None}
+    class _Fold(dict):
+        """str.translate table mapping a character to one representative of its re.IGNORECASE class"""
+        
+        def __missing__(self, code: int) -> str:
+            folded = chr(code).casefold()
+            lowered = ord(folded) if len(folded) == 1 else _sre.unicode_tolower(code)
+            self[code] = value = chr(min((lowered, *_CASE_FIXES.get(lowered, ()))))  # e.g. dotless i -> i
+            return value
+    
+    _FOLD = _Fold()
+    
+    def __init__(self):
+        self.patterns: List[re.Pattern] = []
+        self._goto: List[Dict[str, int]] = []
+        self._fail: List[int] = []
+        self._out: List[Tuple[int, ...]] = []
+        self._always: List[int] = []
+        self._dirty = True
+    
+    def add(self, pattern: Union[str, re.Pattern], flags: int = re.IGNORECASE) -> int:
+        """Add a pattern; returns its priority index"""
+        compiled = pattern if isinstance(pattern, re.Pattern) else re.compile(pattern, flags)
+        self.patterns.append(compiled)
+        self._dirty = True
+        return len(self.patterns) - 1
+    
+    @classmethod
+    def _required(cls, items) -> Optional[List[str]]:
+        """Literals one of which every match contains, or None if none can be derived"""
+        best = None
+        
+        def better(current, candidate):
+            if not candidate or any(not literal for literal in candidate):
+                return current
+            if current is None:
+                return candidate
+            return candidate if (min(map(len, candidate)), -len(candidate)) > (min(map(len, current)), -len(current)) else current
+        
+        run = []
+        for op, av in items:
+            if op == _sre_parse.LITERAL and av < 128:
+                run.append(chr(av))
+                continue
+            best = better(best, [''.join(run)] if run else None)
+            run = []
+            if op == _sre_parse.SUBPATTERN:
+                best = better(best, cls._required(av[-1]))
+            elif op == _sre_parse.BRANCH:
+                alternatives = []
+                for branch in av[1]:
+                    found = cls._required(branch)
+                    if found is None:
+                        alternatives = None
+                        break
+                    alternatives.extend(found)
+                best = better(best, alternatives)
+            elif op in cls._REPEATS and av[0] >= 1:
+                best = better(best, cls._required(av[2]))
+        return better(best, [''.join(run)] if run else None)
+    
+    def _build(self):
+        self._goto, self._fail, self._out, self._always = [{}], [0], [()], []
+        for index, pattern in enumerate(self.patterns):
+            try:
+                literals = self._required(_sre_parse.parse(pattern.pattern, pattern.flags))
+            except Exception:
+                literals = None
+            if not literals:
+                self._always.append(index)
+                continue
+            for literal in literals:
+                state = 0
+                for char in literal.translate(self._FOLD):
+                    if char not in self._goto[state]:
+                        self._goto.append({})
+                        self._fail.append(0)
+                        self._out.append(())
+                        self._goto[state][char] = len(self._goto) - 1
+                    state = self._goto[state][char]
+                if index not in self._out[state]:
+                    self._out[state] += (index,)
+        
+        # Breadth-first failure links; outputs inherit those of their failure state
+        pending = deque(self._goto[0].values())
+        while pending:
+            state = pending.popleft()
+            for char, child in self._goto[state].items():
+                pending.append(child)
+                fallback = self._fail[state]
+                while fallback and char not in self._goto[fallback]:
+                    fallback = self._fail[fallback]
+                self._fail[child] = self._goto[fallback].get(char, 0)
+                self._out[child] += self._out[self._fail[child]]
+        self._dirty = False
+    
+    def candidates(self, text: str) -> List[int]:
+        """Indexes of patterns that can match text, in priority order"""
+        if self._dirty:
+            self._build()
+        goto, fail, out = self._goto, self._fail, self._out
+        found = set(self._always)
+        state = 0
+        for char in text.translate(self._FOLD):
+            while state and char not in goto[state]:
+                state = fail[state]
+            state = goto[state].get(char, 0)
+            if out[state]:
+                found.update(out[state])
+        return sorted(found)
+    
+    def first(self, text: str, anchored: bool = False) -> Optional[Tuple[int, re.Match]]:
+        """The highest-priority pattern that matches (from the start with anchored) and its match"""
+        for index in self.candidates(text):
+            pattern = self.patterns[index]
+            match = pattern.match(text) if anchored else pattern.search(text)
+            if match:
+                return index, match
+        return None
+    
+    def finditer(self, text: str) -> Iterator[Tuple[int, re.Match]]:
+        """Every match of every pattern, pattern by pattern in priority order"""
+        for index in self.candidates(text):
+            for match in self.patterns[index].finditer(text):
+                yield index, match
+
 
 class VoiceCommandRegistry:
     """Registry for voice commands and pattern matching"""
@@ -21,7 +183,8 @@ class VoiceCommandRegistry:
     def __init__(self):
         self.commands = {}
         self.patterns = {}
-    
+        self._automaton = PatternAutomaton()
+
     def register_command(self, name: str, patterns: List[str], description: str, parameters: Dict = None):
         """Register a voice command with patterns"""
         self.commands[name] = {
@@ -31,22 +194,24 @@ class VoiceCommandRegistry:
             'parameters': parameters or {}
         }
         
-        # Compile patterns for matching
+        # Compile patterns for matching; a pattern registered again keeps its place but changes command
         for pattern in patterns:
-            regex_pattern = pattern.replace('*', '(.+)')
-            self.patterns[re.compile(regex_pattern, re.IGNORECASE)] = name
+            regex_pattern = re.compile(pattern.replace('*', '(.+)'), re.IGNORECASE)
+            if regex_pattern not in self.patterns:
+                self._automaton.add(regex_pattern)
+            self.patterns[regex_pattern] = name
     
     def match_command(self, text: str) -> Optional[Dict]:
-        """Match input text to registered commands"""
-        for pattern, command_name in self.patterns.items():
-            match = pattern.match(text.strip())
-            if match:
-                return {
-                    'command': command_name,
-                    'matches': match.groups(),
-                    'confidence': 0.9,
-                    'original_text': text
-                }
+        """Match input text to registered commands (one automaton scan, then only candidate patterns)"""
+        found = self._automaton.first(text.strip(), anchored=True)
+        if found:
+            index, match = found
+            return {
+                'command': self.patterns[self._automaton.patterns[index]],
+                'matches': match.groups(),
+                'confidence': 0.9,
+                'original_text': text
+            }
         return None
     
     def get_all_commands(self) -> Dict:
@@ -73,20 +238,49 @@ class VoiceIntentClassifier:
             'number': [r'\b([0-9]+)\b'],
             'size': [r'\b(small|medium|large|xl|xxl)\b']
         }
+        self._intents = None
+        self._entities = None
+    
+    def add_intent_pattern(self, intent: str, pattern: str):
+        """Add a pattern for an intent (new intents rank after existing ones)"""
+        self.intent_patterns.setdefault(intent, []).append(pattern)
+        self._intents = None
+    
+    def add_entity_pattern(self, entity_type: str, pattern: str):
+        """Add a pattern for an entity type"""
+        self.entity_patterns.setdefault(entity_type, []).append(pattern)
+        self._entities = None
+    
+    def compile_patterns(self):
+        """Rebuild the matchers; call after editing intent_patterns or entity_patterns directly"""
+        self._intents = self._compile(self.intent_patterns)
+        self._entities = self._compile(self.entity_patterns)
+    
+    def _compile(self, groups: Dict[str, List[str]]) -> Tuple[PatternAutomaton, List[Tuple[str, str]]]:
+        automaton = PatternAutomaton()
+        labels = []
+        for label, patterns in groups.items():
+            for pattern in patterns:
+                automaton.add(pattern)
+                labels.append((label, pattern))
+        return automaton, labels
     
     def classify_intent(self, text: str) -> Optional[Dict]:
         """Classify the intent of the voice input"""
         text = text.lower().strip()
         
-        for intent, patterns in self.intent_patterns.items():
-            for pattern in patterns:
-                if re.search(pattern, text, re.IGNORECASE):
-                    return {
-                        'intent': intent,
-                        'confidence': 0.8,
-                        'text': text,
-                        'pattern_matched': pattern
-                    }
+        if self._intents is None:
+            self._intents = self._compile(self.intent_patterns)
+        automaton, labels = self._intents
+        found = automaton.first(text)
+        if found:
+            intent, pattern = labels[found[0]]
+            return {
+                'intent': intent,
+                'confidence': 0.8,
+                'text': text,
+                'pattern_matched': pattern
+            }
         
         return {
             'intent': 'unknown',
@@ -100,23 +294,134 @@ class VoiceIntentClassifier:
         entities = []
         text = text.lower()
         
-        for entity_type, patterns in self.entity_patterns.items():
-            for pattern in patterns:
-                matches = re.finditer(pattern, text, re.IGNORECASE)
-                for match in matches:
-                    entities.append({
-                        'type': entity_type,
-                        'value': match.group(1) if match.groups() else match.group(0),
-                        'start': match.start(),
-                        'end': match.end(),
-                        'confidence': 0.9
-                    })
+        if self._entities is None:
+            self._entities = self._compile(self.entity_patterns)
+        automaton, labels = self._entities
+        for index, match in automaton.finditer(text):
+            entities.append({
+                'type': labels[index][0],
+                'value': match.group(1) if match.groups() else match.group(0),
+                'start': match.start(),
+                'end': match.end(),
+                'confidence': 0.9
+            })
         
         return entities
 
 
+class AudioRingBuffer:
+    """Single-producer, single-consumer ring of PCM bytes.
+    
+    The producer only advances the write count and the consumer only the
+    read count, so the data path takes no lock: each count is one int
+    store (atomic under the GIL), published after its bytes are copied.
+    A producer that gets a whole buffer ahead drops the new audio and
+    counts it in overruns instead of overwriting what is still unread.
+    """
+    
+    def __init__(self, capacity: int):
+        self.capacity = capacity
+        self._buffer = bytearray(capacity)
+        self._view = memoryview(self._buffer)
+        self._written = 0
+        self._read = 0
+        self._ready = threading.Event()
+        self.overruns = 0
+    
+    def available(self) -> int:
+        return self._written - self._read
+    
+    def write(self, data: bytes) -> int:
+        """Append audio; returns the bytes accepted"""
+        data = memoryview(data).cast('B')
+        size = min(len(data), self.capacity - (self._written - self._read))
+        if size < len(data):
+            self.overruns += len(data) - size
+        position = self._written % self.capacity
+        first = min(size, self.capacity - position)
+        self._view[position:position + first] = data[:first]
+        self._view[:size - first] = data[first:size]
+        self._written += size
+        self._ready.set()
+        return size
+    
+    def read(self, size: int) -> Optional[bytes]:
+        """Remove and return exactly size bytes, or None if fewer are buffered"""
+        if self._written - self._read < size:
+            return None
+        position = self._read % self.capacity
+        first = min(size, self.capacity - position)
+        data = bytes(self._view[position:position + first]) + bytes(self._view[:size - first])
+        self._read += size
+        return data
+    
+    def wait(self, size: int, timeout: Optional[float] = None) -> bool:
+        """Block until size bytes are buffered; False on timeout"""
+        deadline = None if timeout is None else time.monotonic() + timeout
+        while self._written - self._read < size:
+            self._ready.clear()
+            if self._written - self._read >= size:
+                break
+            remaining = None if deadline is None else deadline - time.monotonic()
+            if remaining is not None and remaining <= 0:
+                return False
+            self._ready.wait(remaining)
+        return True
+    
+    def wake(self):
+        self._ready.set()
+
+
+class VoiceActivityDetector:
+    """Per-frame speech detection on 16-bit mono PCM.
+    
+    Uses the WebRTC VAD (webrtcvad package) when it is installed and an
+    aggressiveness is configured; otherwise frame RMS energy against
+    silence_threshold, computed with NumPy when available.
+    """
+    
+    def __init__(self, sample_rate: int, frame_ms: int, silence_threshold: float, aggressiveness: Optional[int] = None):
+        self.sample_rate = sample_rate
+        self.frame_ms = frame_ms
+        self.silence_threshold = silence_threshold
+        self.last_level = 0.0
+        self._webrtc = None
+        if aggressiveness is not None:
+            try:
+                import webrtcvad
+                self._webrtc = webrtcvad.Vad(aggressiveness)
+            except ImportError:
+                pass
+        try:
+            import numpy
+            self._np = numpy
+        except ImportError:
+            self._np = None
+    
+    def level(self, frame: bytes) -> float:
+        """RMS amplitude of a frame"""
+        if self._np is not None:
+            samples = self._np.frombuffer(frame, dtype=self._np.int16).astype(self._np.float32)
+            return float(self._np.sqrt(self._np.mean(samples * samples))) if samples.size else 0.0
+        samples = array.array('h', frame)
+        return math.sqrt(sum(sample * sample for sample in samples) / len(samples)) if samples else 0.0
+    
+    def is_speech(self, frame: bytes) -> bool:
+        self.last_level = self.level(frame)
+        if self._webrtc is not None:
+            return self._webrtc.is_speech(frame, self.sample_rate)
+        return self.last_level > self.silence_threshold
+
+
 class RealTimeVoiceProcessor:
-    """Real-time voice processing and activity detection"""
+    """Real-time voice processing and activity detection.
+    
+    feed() pushes PCM (16-bit mono at sample_rate) into a ring buffer.
+    The processing thread blocks on it, splits frames, and runs VAD with
+    a pre-roll and a silence_duration hangover. Only speech frames go to
+    the recognizer thread, which streams them into the recognizer and
+    reports partial and final transcripts. Callbacks arrive from both threads.
+    """
     
     def __init__(self, config: Dict = None):
         self.config = config or {}
@@ -125,32 +430,208 @@ class RealTimeVoiceProcessor:
         self.silence_threshold = self.config.get('silence_threshold', 500)
         self.silence_duration = self.config.get('silence_duration', 1.0)
         self.is_listening = False
-        self.audio_buffer = []
         
-    def _detect_voice_activity(self, audio_data: Dict) -> bool:
-        """Detect if audio contains voice activity"""
+        self.frame_ms = self.config.get('frame_ms', DEFAULT_FRAME_MS)
+        self.frame_bytes = self.sample_rate * self.frame_ms // 1000 * 2
+        self.ring = AudioRingBuffer(int(self.config.get('buffer_seconds', DEFAULT_BUFFER_SECONDS) * self.sample_rate) * 2)
+        self.vad = VoiceActivityDetector(self.sample_rate, self.frame_ms, self.silence_threshold,
+                                         self.config.get('vad_aggressiveness'))
+        self.start_frames = max(1, math.ceil(self.config.get('min_speech_ms', DEFAULT_MIN_SPEECH_MS) / self.frame_ms))
+        self.hangover_frames = max(1, math.ceil(self.silence_duration * 1000 / self.frame_ms))
+        self.pre_roll_frames = self.config.get('pre_roll_ms', DEFAULT_PRE_ROLL_MS) // self.frame_ms
+        self._speech = queue.Queue()
+        self._threads = []
+    
+    def _detect_voice_activity(self, audio_data: Union[Dict, bytes]) -> bool:
+        """Detect if audio (a PCM frame, or a dict with a measured audio_level) contains voice activity"""
+        if isinstance(audio_data, (bytes, bytearray, memoryview)):
+            return self.vad.is_speech(bytes(audio_data))
         audio_level = audio_data.get('audio_level', 0)
         return audio_level > self.silence_threshold
     
-    def start_processing(self, callback: callable):
-        """Start real-time voice processing"""
+    def feed(self, pcm: bytes) -> int:
+        """Queue captured audio for processing; returns the bytes accepted"""
+        return self.ring.write(pcm)
+    
+    def start_processing(self, callback: callable, recognizer_factory: callable = None):
+        """Start real-time voice processing.
+        
+        recognizer_factory (e.g. SpeechRecognitionService.create_stream) is
+        called with the capture sample rate and returns a fresh streaming
+        recognizer per utterance. Without one,
+        speech_end events carry the utterance audio instead.
+        """
+        if self.is_listening:
+            return
         self.is_listening = True
         
-        def process_audio():
-            while self.is_listening:
-                # Simulate audio processing
-                audio_data = {'audio_level': 600}  # Simulated
-                if self._detect_voice_activity(audio_data):
-                    callback({'status': 'voice_detected', 'data': audio_data})
-                time.sleep(0.1)
+        self._threads = [threading.Thread(target=self._process_audio, args=(callback, recognizer_factory is not None), daemon=True)]
+        if recognizer_factory is not None:
+            self._threads.append(threading.Thread(target=self._recognize, args=(callback, recognizer_factory), daemon=True))
+        for thread in self._threads:
+            thread.start()
+    
+    def _process_audio(self, callback: callable, forward: bool):
+        """VAD loop: frames from the ring buffer in, utterance boundaries and speech frames out"""
+        pre_roll = deque(maxlen=max(self.pre_roll_frames, self.start_frames))
+        utterance = []
+        in_speech = False
+        voiced = silent = frames = 0
+        
+        def end_utterance():
+            duration = frames * self.frame_ms / 1000.0
+            if forward:
+                self._speech.put(('end', None))
+                callback({'status': 'speech_end', 'duration': duration})
+            else:
+                callback({'status': 'speech_end', 'duration': duration, 'audio': b''.join(utterance)})
+                utterance.clear()
+        
+        while self.is_listening:
+            if not self.ring.wait(self.frame_bytes, timeout=0.1):
+                continue
+            frame = self.ring.read(self.frame_bytes)
+            if frame is None:
+                continue
+            speech = self.vad.is_speech(frame)
+            
+            if not in_speech:
+                pre_roll.append(frame)
+                voiced = voiced + 1 if speech else 0
+                if voiced >= self.start_frames:
+                    in_speech, silent, frames = True, 0, len(pre_roll)
+                    callback({'status': 'voice_detected', 'data': {'audio_level': self.vad.last_level}})
+                    if forward:
+                        self._speech.put(('start', None))
+                        for buffered in pre_roll:
+                            self._speech.put(('audio', buffered))
+                    else:
+                        utterance.extend(pre_roll)
+                    pre_roll.clear()
+                continue
+            
+            frames += 1
+            if forward:
+                self._speech.put(('audio', frame))
+            else:
+                utterance.append(frame)
+            silent = 0 if speech else silent + 1
+            if silent >= self.hangover_frames:
+                in_speech, voiced = False, 0
+                end_utterance()
         
-        thread = threading.Thread(target=process_audio)
-        thread.daemon = True
-        thread.start()
+        if in_speech:
+            end_utterance()
+        self._speech.put(None)
+    
+    def _recognize(self, callback: callable, recognizer_factory: callable):
+        """Recognizer loop: stream speech frames and report partial and final transcripts"""
+        stream = None
+        while True:
+            item = self._speech.get()
+            if item is None:
+                break
+            kind, frame = item
+            try:
+                if kind == 'start':
+                    stream = recognizer_factory(self.sample_rate)
+                elif stream is None:
+                    continue
+                elif kind == 'audio':
+                    partial = stream.accept(frame)
+                    if partial:
+                        callback({'status': 'partial', **partial})
+                else:
+                    callback({'status': 'final', **stream.finish()})
+                    stream = None
+            except Exception as e:
+                stream = None
+                callback({'status': 'error', 'error': str(e)})
     
     def stop_processing(self):
-        """Stop real-time voice processing"""
+        """Stop real-time voice processing, finishing any utterance in progress"""
         self.is_listening = False
+        self.ring.wake()
+        for thread in self._threads:
+            thread.join(timeout=5)
+        self._threads = []
+
+
+class VoskStream:
+    """Streaming Vosk recognition for one utterance"""
+    
+    def __init__(self, model, sample_rate: int = 16000):
+        import vosk
+        
+        self.recognizer = vosk.KaldiRecognizer(model, sample_rate)
+        self.segments = []
+        self._last_partial = ''
+    
+    def accept(self, pcm: bytes) -> Optional[Dict]:
+        """Feed audio; returns a partial (or endpointed segment) transcript when it changes"""
+        if self.recognizer.AcceptWaveform(pcm):
+            text = json.loads(self.recognizer.Result()).get('text', '')
+            if text:
+                self.segments.append(text)
+            self._last_partial = ''
+            return {'text': ' '.join(self.segments), 'is_final': False, 'provider': 'vosk'} if text else None
+        partial = json.loads(self.recognizer.PartialResult()).get('partial', '')
+        if partial and partial != self._last_partial:
+            self._last_partial = partial
+            return {'text': ' '.join(self.segments + [partial]), 'is_final': False, 'provider': 'vosk'}
+        return None
+    
+    def finish(self) -> Dict:
+        text = json.loads(self.recognizer.FinalResult()).get('text', '')
+        if text:
+            self.segments.append(text)
+        return {'success': True, 'text': ' '.join(self.segments), 'is_final': True,
+                'confidence': 85, 'provider': 'vosk'}
+
+
+class WhisperStream:
+    """Pseudo-streaming Whisper for one utterance.
+    
+    Whisper decodes whole windows, so speech is accumulated in memory and
+    re-transcribed every partial_interval seconds of new audio for partial
+    results; the final pass runs once when the utterance ends. Audio is
+    handed to the model as float32 samples, never through a file.
+    """
+    
+    def __init__(self, model, language: str = 'en', temperature: float = 0.0, sample_rate: int = 16000,
+                 partial_interval: float = DEFAULT_PARTIAL_INTERVAL):
+        self.model = model
+        self.language = language
+        self.temperature = temperature
+        self.sample_rate = sample_rate
+        self.partial_bytes = int(partial_interval * sample_rate) * 2 if partial_interval else 0
+        self.audio = bytearray()
+        self._transcribed = 0
+    
+    def _samples(self):
+        import numpy as np
+        
+        samples = np.frombuffer(bytes(self.audio), dtype=np.int16).astype(np.float32) / 32768.0
+        if self.sample_rate != 16000 and samples.size:
+            # Whisper expects 16 kHz
+            count = int(samples.size * 16000 / self.sample_rate)
+            samples = np.interp(np.linspace(0, samples.size - 1, count), np.arange(samples.size), samples).astype(np.float32)
+        return samples
+    
+    def _transcribe(self) -> str:
+        self._transcribed = len(self.audio)
+        result = self.model.transcribe(self._samples(), language=self.language, temperature=self.temperature)
+        return result['text'].strip()
+    
+    def accept(self, pcm: bytes) -> Optional[Dict]:
+        self.audio += pcm
+        if self.partial_bytes and len(self.audio) - self._transcribed >= self.partial_bytes:
+            return {'text': self._transcribe(), 'is_final': False, 'provider': 'whisper'}
+        return None
+    
+    def finish(self) -> Dict:
+        text = self._transcribe() if self.audio else ''
+        return {'success': True, 'text': text, 'is_final': True, 'confidence': 90, 'provider': 'whisper'}
 
 class SpeechRecognitionService:
     """Speech recognition service with multiple provider support"""
@@ -321,6 +802,17 @@ class SpeechRecognitionService:
             return True
         return False
     
+    def create_stream(self, sample_rate: int = 16000, options: Dict = None):
+        """A streaming recognizer (accept(pcm) -> partial, finish() -> final) for one utterance"""
+        options = options or {}
+        if self.active_provider == 'vosk':
+            return VoskStream(self.provider_config['vosk']['model'], sample_rate)
+        if self.active_provider == 'whisper':
+            config = self.provider_config['whisper']
+            return WhisperStream(config['model'], config['language'], config['temperature'], sample_rate,
+                                 options.get('partial_interval', DEFAULT_PARTIAL_INTERVAL))
+        raise RuntimeError(f"Streaming recognition not supported for provider: {self.active_provider}")
+    
     def get_available_providers(self) -> List[str]:
         """Get list of available speech recognition providers"""
         available = []
@@ -561,6 +1053,24 @@ class SpeechRecognitionService:
                 'confidence': 0
             }
     
+    def _recognize_vosk(self, audio_data: Union[str, bytes], options: Dict) -> Dict:
+        """Recognize speech using Vosk (a WAV path or 16 kHz 16-bit mono PCM bytes)"""
+        config = self.provider_config['vosk']
+        sample_rate = config['sample_rate']
+        
+        if isinstance(audio_data, str):
+            with wave.open(audio_data, 'rb') as wav:
+                sample_rate = wav.getframerate()
+                audio_data = wav.readframes(wav.getnframes())
+        
+        stream = VoskStream(config['model'], sample_rate)
+        chunk = config['chunk_size']
+        for start in range(0, len(audio_data), chunk):
+            stream.accept(audio_data[start:start + chunk])
+        result = stream.finish()
+        result.update({'alternatives': [], 'language': options.get('language', 'en')})
+        return result
+    
     def _listen_speech_recognition(self, options: Dict) -> Dict:
         """Listen using speech_recognition library"""
         import speech_recognition as sr
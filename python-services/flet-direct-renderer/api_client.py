@@ -0,0 +1,208 @@
+"""
+Backend API Client for the FlashFlow Direct Renderer
+Pooled keep-alive HTTP to the Laravel backend with request coalescing and a short-lived read cache
+"""
+
+import copy
+import json
+import time
+import asyncio
+import logging
+import threading
+from collections import OrderedDict, deque
+from concurrent.futures import Future, ThreadPoolExecutor
+from typing import Any, Callable, Deque, Dict, Optional, Tuple
+from urllib.parse import urljoin, urlsplit
+
+import requests
+from requests.adapters import HTTPAdapter
+from urllib3.util.retry import Retry
+
+logger = logging.getLogger(__name__)
+
+DEFAULT_TIMEOUT = (3.05, 10.0)   # (connect, read) seconds
+DEFAULT_POOL_SIZE = 16           # Keep-alive connections to the backend
+DEFAULT_ENDPOINT_LIMIT = 4       # Concurrent requests per endpoint path
+DEFAULT_RETRIES = 2              # Retries for idempotent requests on connect errors and 502/503/504
+DEFAULT_CACHE_TTL = 2.0          # Seconds a GET response is reused
+DEFAULT_CACHE_SIZE = 256         # Cached GET responses kept
+
+IDEMPOTENT_METHODS = frozenset({'GET', 'HEAD', 'PUT', 'DELETE', 'OPTIONS'})
+
+
+class BackendClient:
+    """Shared HTTP client for backend calls.
+
+    One requests.Session holds a keep-alive pool, so repeated calls reuse
+    TCP/TLS connections instead of handshaking each time. Requests run on a
+    worker pool: submit() returns a Future and arequest() can be awaited, so
+    UI handlers don't block while waiting. A request takes its endpoint's
+    slot before it is handed to the pool; requests over endpoint_limit wait
+    in a per-endpoint queue rather than holding a worker, so one slow
+    endpoint cannot starve the others. Identical GETs in flight share one
+    request, and successful GETs are cached for cache_ttl seconds; callers
+    always get their own copy of a shared or cached response. Any non-GET
+    request bumps the cache version and clears the cache, since it may have
+    changed what reads return, so a GET that started before it is neither
+    joined nor cached.
+    """
+
+    def __init__(self, base_url: str, timeout: Tuple[float, float] = DEFAULT_TIMEOUT,
+                 pool_size: int = DEFAULT_POOL_SIZE, endpoint_limit: int = DEFAULT_ENDPOINT_LIMIT,
+                 retries: int = DEFAULT_RETRIES, cache_ttl: float = DEFAULT_CACHE_TTL,
+                 cache_size: int = DEFAULT_CACHE_SIZE):
+        self.base_url = base_url
+        self.timeout = timeout
+        self.endpoint_limit = max(1, endpoint_limit)
+        self.cache_ttl = cache_ttl
+        self.cache_size = cache_size
+
+        retry = Retry(total=retries, connect=retries, read=retries, backoff_factor=0.2,
+                      status_forcelist=(502, 503, 504), allowed_methods=IDEMPOTENT_METHODS,
+                      raise_on_status=False)
+        adapter = HTTPAdapter(pool_connections=1, pool_maxsize=pool_size, max_retries=retry)
+        self.session = requests.Session()
+        self.session.headers.update({'Content-Type': 'application/json', 'Accept': 'application/json'})
+        self.session.mount('http://', adapter)
+        self.session.mount('https://', adapter)
+
+        self._executor = ThreadPoolExecutor(max_workers=pool_size, thread_name_prefix="flashflow-api")
+        self._lock = threading.Lock()
+        self._limits: Dict[str, threading.BoundedSemaphore] = {}
+        self._waiting: Dict[str, Deque[Tuple[Future, str, str, Optional[Dict]]]] = {}
+        self._inflight: Dict[Tuple, Future] = {}
+        self._cache: "OrderedDict[Tuple, Tuple[float, Dict]]" = OrderedDict()
+        self._version = 0  # Bumped by every write; GETs started under an older version are not cached
+        self.stats = {'requests': 0, 'coalesced': 0, 'cache_hits': 0, 'errors': 0}
+
+    def _dispatch(self, future: Future, method: str, url: str, data: Optional[Dict]) -> Future:
+        """Hand a request to the pool once it holds an endpoint slot, queueing it otherwise"""
+        path = urlsplit(url).path
+        with self._lock:
+            limit = self._limits.get(path)
+            if limit is None:
+                limit = self._limits[path] = threading.BoundedSemaphore(self.endpoint_limit)
+            if not limit.acquire(blocking=False):
+                self._waiting.setdefault(path, deque()).append((future, method, url, data))
+                return future
+        self._executor.submit(self._run, path, future, method, url, data)
+        return future
+
+    def _run(self, path: str, future: Future, method: str, url: str, data: Optional[Dict]):
+        """Send on a worker, then pass the endpoint slot to the next queued request or free it"""
+        while future is not None:
+            if future.set_running_or_notify_cancel():
+                future.set_result(self._send(method, url, data))
+            with self._lock:
+                waiting = self._waiting.get(path)
+                if waiting:
+                    future, method, url, data = waiting.popleft()
+                else:
+                    self._limits[path].release()
+                    future = None
+
+    def _send(self, method: str, url: str, data: Optional[Dict]) -> Dict:
+        with self._lock:
+            self.stats['requests'] += 1
+        try:
+            if method == 'GET':
+                response = self.session.get(url, timeout=self.timeout)
+            else:
+                response = self.session.request(method, url, json=data, timeout=self.timeout)
+            response.raise_for_status()
+            return response.json() if response.content else {}
+        except Exception as e:
+            with self._lock:
+                self.stats['errors'] += 1
+            logger.error(f"API request failed: {e}")
+            return {"error": str(e)}
+
+    def _cached(self, key: Tuple) -> Optional[Dict]:
+        entry = self._cache.get(key)
+        if entry is None:
+            return None
+        if entry[0] < time.monotonic():
+            del self._cache[key]
+            return None
+        self._cache.move_to_end(key)
+        return entry[1]
+
+    @staticmethod
+    def _copy(source: Future) -> Future:
+        """A Future resolving to a private copy of source's result"""
+        future = Future()
+        source.add_done_callback(lambda done: future.cancel() if done.cancelled()
+                                 else future.set_result(copy.deepcopy(done.result())))
+        return future
+
+    def _finish_get(self, key: Tuple, version: int, future: Future):
+        with self._lock:
+            if self._inflight.get(key) is future:
+                del self._inflight[key]
+            result = future.result() if not future.cancelled() else None
+            if self.cache_ttl > 0 and version == self._version and isinstance(result, dict) \
+                    and "error" not in result:
+                self._cache[key] = (time.monotonic() + self.cache_ttl, copy.deepcopy(result))
+                self._cache.move_to_end(key)
+                while len(self._cache) > self.cache_size:
+                    self._cache.popitem(last=False)
+
+    def submit(self, method: str, endpoint: str, data: Optional[Dict] = None) -> Future:
+        """Start a request and return a Future for its decoded JSON ({"error": ...} on failure)"""
+        method = method.upper()
+        if method not in ('GET', 'POST', 'PUT', 'PATCH', 'DELETE'):
+            raise ValueError(f"Unsupported HTTP method: {method}")
+        url = urljoin(self.base_url, endpoint)
+
+        if method != 'GET':
+            self.clear_cache()
+            return self._dispatch(Future(), method, url, data)
+
+        key = (url, json.dumps(data, sort_keys=True, default=str) if data else None)
+        with self._lock:
+            cached = self._cached(key)
+            if cached is not None:
+                self.stats['cache_hits'] += 1
+                future = Future()
+                future.set_result(copy.deepcopy(cached))
+                return future
+
+            shared = self._inflight.get(key)
+            if shared is not None:
+                self.stats['coalesced'] += 1
+                return self._copy(shared)
+            shared = self._inflight[key] = Future()
+            version = self._version
+
+        future = self._copy(shared)
+        shared.add_done_callback(lambda done: self._finish_get(key, version, done))
+        self._dispatch(shared, method, url, data)
+        return future
+
+    def request(self, method: str, endpoint: str, data: Optional[Dict] = None) -> Dict:
+        """Blocking request"""
+        return self.submit(method, endpoint, data).result()
+
+    async def arequest(self, method: str, endpoint: str, data: Optional[Dict] = None) -> Dict:
+        """Awaitable request for async handlers"""
+        return await asyncio.wrap_future(self.submit(method, endpoint, data))
+
+    def request_in_background(self, method: str, endpoint: str, data: Optional[Dict] = None,
+                              callback: Optional[Callable[[Dict], Any]] = None) -> Future:
+        """Fire a request and hand its result to callback on a worker thread"""
+        future = self.submit(method, endpoint, data)
+        if callback is not None:
+            future.add_done_callback(lambda done: callback(done.result()))
+        return future
+
+    def clear_cache(self):
+        """Drop cached GETs and detach in-flight ones, so later reads go back to the backend"""
+        with self._lock:
+            self._version += 1
+            self._cache.clear()
+            self._inflight.clear()
+
+    def close(self):
+        """Finish queued requests and close pooled connections"""
+        self._executor.shutdown(wait=True)
+        self.session.close()
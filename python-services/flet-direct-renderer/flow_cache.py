@@ -0,0 +1,161 @@
+"""
+Flow Cache for the FlashFlow Direct Renderer
+Keeps parsed .flow data and built page trees in memory until their source file changes
+"""
+
+import os
+import logging
+import threading
+import weakref
+from pathlib import Path
+from typing import Any, Callable, Dict, Optional, Tuple
+
+from core.parser.flow_loader import load_flow
+
+logger = logging.getLogger(__name__)
+
+Signature = Tuple[int, int]  # (mtime_ns, size)
+
+
+def _key(path: Path) -> Path:
+    return Path(os.path.abspath(path))
+
+
+def _signature(path: Path) -> Signature:
+    stat = os.stat(path)
+    return (stat.st_mtime_ns, stat.st_size)
+
+
+class FlowCache:
+    """Parsed flows keyed by path, and page trees keyed by (route, platform) per Flet page.
+
+    While a FlowWatcher is running (`watching` is True) entries are trusted
+    until the watcher invalidates them, so cache hits never touch the disk.
+    Without one, each hit is revalidated against the file's mtime and size.
+    Trees are held per page because Flet controls belong to a single page.
+    """
+
+    def __init__(self):
+        self.watching = False
+        self.hits = 0
+        self.misses = 0
+        self._lock = threading.RLock()
+        self._flows: Dict[Path, Tuple[Signature, Dict[str, Any]]] = {}
+        self._trees: "weakref.WeakKeyDictionary[Any, Dict[Tuple[str, str], Tuple[Path, Any]]]" = \
+            weakref.WeakKeyDictionary()
+
+    def _fresh(self, path: Path) -> bool:
+        entry = self._flows.get(path)
+        if entry is None:
+            return False
+        if self.watching:
+            return True
+        try:
+            return entry[0] == _signature(path)
+        except OSError:
+            return False
+
+    def flow(self, path: Path) -> Dict[str, Any]:
+        """Parsed data for a .flow file, reparsed only when it changed"""
+        path = _key(path)
+        with self._lock:
+            if self._fresh(path):
+                self.hits += 1
+                return self._flows[path][1]
+
+            # Take the signature before reading so a write racing the read is seen next time
+            signature = _signature(path)
+            with open(path, 'r', encoding='utf-8') as f:
+                data = load_flow(f.read(), path)
+            self._flows[path] = (signature, data)
+            self.misses += 1
+            return data
+
+    def tree(self, page: Any, route: str, platform: str) -> Optional[Any]:
+        """The tree built for route on this page and platform, if its flow is unchanged"""
+        with self._lock:
+            entry = self._trees.get(page, {}).get((route, platform))
+            if entry is None or not self._fresh(entry[0]):
+                return None
+            self.hits += 1
+            return entry[1]
+
+    def store_tree(self, page: Any, route: str, platform: str, path: Path, tree: Any):
+        """Remember the tree built for route from the flow at path"""
+        with self._lock:
+            self._trees.setdefault(page, {})[(route, platform)] = (_key(path), tree)
+
+    def invalidate(self, path: Optional[Path] = None):
+        """Drop one flow and every tree built from it, or everything"""
+        with self._lock:
+            if path is None:
+                self._flows.clear()
+                self._trees.clear()
+                return
+
+            path = _key(path)
+            self._flows.pop(path, None)
+            for trees in self._trees.values():
+                for key in [key for key, (source, _) in trees.items() if source == path]:
+                    del trees[key]
+
+    def invalidate_trees(self):
+        """Drop built trees but keep parsed flows, e.g. when app state changes visibility"""
+        with self._lock:
+            self._trees.clear()
+
+    def stats(self) -> Dict[str, int]:
+        with self._lock:
+            return {
+                'flows': len(self._flows),
+                'pages': len(self._trees),
+                'hits': self.hits,
+                'misses': self.misses,
+            }
+
+
+class FlowWatcher:
+    """Watchdog observer calling on_change(path, event_type) for .flow file events"""
+
+    def __init__(self, directory: Path, on_change: Callable[[Path, str], None]):
+        self.directory = Path(directory)
+        self.on_change = on_change
+        self._observer = None
+
+    def start(self) -> bool:
+        """Start watching; returns False if watchdog is unavailable"""
+        try:
+            from watchdog.observers import Observer
+            from watchdog.events import FileSystemEventHandler
+        except ImportError:
+            logger.warning("watchdog not installed, flow cache falls back to mtime checks")
+            return False
+
+        if not self.directory.exists():
+            return False
+
+        watcher = self
+
+        class FlowFileHandler(FileSystemEventHandler):
+            def on_any_event(self, event):
+                if event.is_directory or event.event_type not in ('created', 'modified', 'deleted', 'moved'):
+                    return
+                for path in (event.src_path, getattr(event, 'dest_path', None)):
+                    if path and Path(str(path)).suffix == ".flow":
+                        try:
+                            watcher.on_change(_key(Path(str(path))), event.event_type)
+                        except Exception as e:
+                            logger.error(f"Error handling change to {path}: {e}")
+
+        self._observer = Observer()
+        self._observer.schedule(FlowFileHandler(), str(self.directory), recursive=False)
+        self._observer.daemon = True
+        self._observer.start()
+        logger.info(f"Watching {self.directory} for .flow changes")
+        return True
+
+    def stop(self):
+        if self._observer is not None:
+            self._observer.stop()
+            self._observer.join()
+            self._observer = None
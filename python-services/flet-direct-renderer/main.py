@@ -7,14 +7,12 @@ This replaces the HTML/CSS/JS approach with pure Python Flet components
 import os
 import sys
 import json
-import yaml
 import flet as ft
 from pathlib import Path
-from typing import Dict, Any, List, Union
+from typing import Dict, Any, List, Optional, Union
 import asyncio
 import logging
-import requests
-from urllib.parse import urljoin
+import weakref
 import numpy as np
 
 # Import platform-adaptive components
@@ -27,6 +25,17 @@ except ImportError:
     FLASHCORE_AVAILABLE = False
     print("Warning: FlashCore not available, using fallback implementations")
 
+# NumPy vector index behind the engine's vector search
+try:
+    from flashflow_cli.services.vector_index import VectorIndex
+except ImportError:
+    sys.path.insert(0, str(Path(__file__).resolve().parents[2]))
+    from flashflow_cli.services.vector_index import VectorIndex
+from flashflow_cli.services.tracing import traced
+from core.parser.flow_loader import load_flow
+from flow_cache import FlowCache, FlowWatcher
+from api_client import BackendClient
+
 # Configure logging
 logging.basicConfig(level=logging.INFO)
 logger = logging.getLogger(__name__)
@@ -34,11 +43,16 @@ logger = logging.getLogger(__name__)
 class FlashFlowEngine:
     """FlashFlow Engine using Python Flet for all UI components"""
     
-    def __init__(self, project_root: str, backend_url: str = "http://localhost:8000"):
+    @traced("FlashFlowEngine.__init__", cat="engine")
+    def __init__(self, project_root: str, backend_url: str = "http://localhost:8000", vector_metric: str = "l2"):
         self.project_root = Path(project_root).resolve()
         self.flow_files_dir = self.project_root / "src" / "flows"
         self.page_registry = {}  # Maps routes to .flow files
+        self.flow_cache = FlowCache()  # Parsed flows and built page trees
+        self.flow_watcher = None  # Invalidates flow_cache on .flow changes
+        self._page_routes = weakref.WeakKeyDictionary()  # Route each open page is showing
         self.backend_url = backend_url  # Laravel backend URL
+        self.api_client = BackendClient(backend_url)  # Pooled keep-alive client for backend calls
         self.deployment_env = self._detect_deployment_environment()  # Auto-detect deployment environment
         self.current_platform = "desktop"  # Default platform
         self.app_state = {}  # Application state for temporary visibility controls
@@ -46,7 +60,9 @@ class FlashFlowEngine:
         
         # FlashFlow Engine with FlashCore acceleration
         self.flashcore_enabled = FLASHCORE_AVAILABLE
-        self.vector_index = None  # FlashCore HNSW index for vector search
+        self.vector_metric = vector_metric  # Distance metric: l2, ip or cosine
+        self.vector_index = None  # VectorIndex for vector search (metric, filters, mmap persistence)
+        self.vector_index_path = self.project_root / ".flashflow" / "vector_index.ffvi"  # Saved index, mapped at startup
         self.inference_runtime = None  # FlashCore ONNX runtime for ML inference
         self.security_vault = None  # FlashCore AES vault for encryption
         
@@ -54,6 +70,17 @@ class FlashFlowEngine:
         if self.flashcore_enabled:
             self._initialize_flashcore()
         
+        # The native HNSWIndex takes no metric and has no batch, filter or mmap API, so search uses VectorIndex
+        self._initialize_vector_index()
+        
+        # Fall back to the AES-256-GCM vault when FlashCore is unavailable
+        if self.security_vault is None and self._vault_key():
+            try:
+                from flashflow_cli.services.crypto_vault import create_vault
+                self.security_vault = create_vault(None)
+            except ImportError:
+                logger.warning("cryptography not installed, encryption unavailable")
+        
         # Validate project
         if not (self.project_root / "flashflow.json").exists():
             raise ValueError("Not in a FlashFlow project directory")
@@ -65,8 +92,7 @@ class FlashFlowEngine:
         self._configure_for_environment()
         
         # Initialize FlashCore-powered features
-        if self.flashcore_enabled:
-            self._initialize_flashcore_features()
+        self._initialize_flashcore_features()
     
     def _detect_deployment_environment(self) -> str:
         """Detect the deployment environment (local, cPanel, VPS, etc.)"""
@@ -151,131 +177,76 @@ class FlashFlowEngine:
         # Local development uses default settings
         pass
     
-    def _initialize_flashcore(self):
-        """Initialize FlashCore components"""
-        try:
-            # Initialize vector search index (128-dimensional for embeddings, max 10000 elements)
-            self.vector_index = flashcore.HNSWIndex(128, 10000)
-            logger.info("Initialized FlashCore HNSW vector index")
-            
-            # Initialize inference runtime (will be configured with specific models as needed)
-            self.inference_runtime = flashcore.ONNXRuntime("")
-            logger.info("Initialized FlashCore ONNX runtime")
-            
-            # Initialize security vault with default key
-            self.security_vault = flashcore.AESVault("flashflow_default_key")
-            logger.info("Initialized FlashCore AES security vault")
-            
-        except Exception as e:
-            logger.error(f"Failed to initialize FlashCore components: {e}")
-            self.flashcore_enabled = False
-    
-    def _initialize_flashcore_features(self):
-        """Initialize FlashCore-powered features"""
-        # Pre-populate vector index with sample data for demonstration
-        if self.vector_index:
-            try:
-                # Add some sample vectors (in a real app, these would come from actual data)
-                sample_vectors = [
-                    (np.random.rand(128).astype(np.float32), 1),
-                    (np.random.rand(128).astype(np.float32), 2),
-                    (np.random.rand(128).astype(np.float32), 3),
-                ]
-                
-                for vector, id in sample_vectors:
-                    self.vector_index.add_vector(vector, id)
-                
-                logger.info("Pre-populated FlashCore vector index with sample data")
-            except Exception as e:
-                logger.error(f"Failed to pre-populate vector index: {e}")
-    
-    def vector_search(self, query_vector: np.ndarray, k: int = 5):
-        """Perform vector search using FlashCore"""
-        if not self.flashcore_enabled or not self.vector_index:
-            # Fallback implementation
-            logger.warning("FlashCore not available, using fallback vector search")
-            return [{"id": i, "distance": 0.0} for i in range(min(k, 3))]
-        
-        try:
-            return self.vector_index.search(query_vector, k)
-        except Exception as e:
-            logger.error(f"Vector search failed: {e}")
-            return []
-    
-    def run_inference(self, input_data: np.ndarray, output_size: int = 10):
-        """Run ML inference using FlashCore"""
-        if not self.flashcore_enabled or not self.inference_runtime:
-            # Fallback implementation
-            logger.warning("FlashCore not available, using fallback inference")
-            return np.zeros(output_size, dtype=np.float32)
-        
-        try:
-            return self.inference_runtime.run_inference(input_data, output_size)
-        except Exception as e:
-            logger.error(f"Inference failed: {e}")
-            return np.zeros(output_size, dtype=np.float32)
-    
-    def encrypt_data(self, plaintext: bytes) -> bytes:
-        """Encrypt data using FlashCore"""
-        if not self.flashcore_enabled or not self.security_vault:
-            # Fallback implementation (no encryption)
-            logger.warning("FlashCore not available, skipping encryption")
-            return plaintext
-        
-        try:
-            return self.security_vault.encrypt(plaintext)
-        except Exception as e:
-            logger.error(f"Encryption failed: {e}")
-            return plaintext
-    
-    def decrypt_data(self, ciphertext: bytes) -> bytes:
-        """Decrypt data using FlashCore"""
-        if not self.flashcore_enabled or not self.security_vault:
-            # Fallback implementation (no decryption)
-            logger.warning("FlashCore not available, skipping decryption")
-            return ciphertext
-        
-        try:
-            return self.security_vault.decrypt(ciphertext)
-        except Exception as e:
-            logger.error(f"Decryption failed: {e}")
-            return ciphertext
-    
+    @traced("FlashFlowEngine._load_route_mappings", cat="engine")
     def _load_route_mappings(self):
         """Load route mappings from .flow files"""
         if not self.flow_files_dir.exists():
             logger.warning(f"No flows directory found at {self.flow_files_dir}")
             return
-            
+        
+        registry = {}
         for flow_file in self.flow_files_dir.glob("*.flow"):
             try:
-                with open(flow_file, 'r') as f:
-                    content = f.read()
-                    
-                # Parse YAML content
-                flow_data = yaml.safe_load(content)
+                # Parse .flow content into the flow cache (native parser when available)
+                flow_data = self.flow_cache.flow(flow_file)
                 
                 # Extract page information
                 if isinstance(flow_data, dict) and 'page' in flow_data:
                     page_info = flow_data['page']
                     if isinstance(page_info, dict) and 'path' in page_info:
                         route = page_info['path']
-                        self.page_registry[route] = flow_file
-                        logger.info(f"Registered route {route} -> {flow_file.name}")
+                        registry[route] = flow_file
+                        if self.page_registry.get(route) != flow_file:
+                            logger.info(f"Registered route {route} -> {flow_file.name}")
                         
             except Exception as e:
                 logger.error(f"Error parsing {flow_file}: {e}")
+        
+        self.page_registry = registry
     
+    @traced("FlashFlowEngine._parse_flow_file", cat="engine")
     def _parse_flow_file(self, file_path: Path) -> Dict[str, Any]:
-        """Parse a .flow file and return structured data"""
+        """Parse a .flow file and return structured data (cached until the file changes)"""
         try:
-            with open(file_path, 'r') as f:
-                content = f.read()
-            return yaml.safe_load(content) or {}
+            return self.flow_cache.flow(file_path)
         except Exception as e:
             logger.error(f"Error parsing flow file {file_path}: {e}")
             return {}
     
+    def start_watching(self) -> bool:
+        """Watch the flows directory so cached pages are served without stat calls and hot-reload on edit"""
+        if self.flow_watcher is None:
+            self.flow_watcher = FlowWatcher(self.flow_files_dir, self._on_flow_changed)
+            self.flow_cache.watching = self.flow_watcher.start()
+        return self.flow_cache.watching
+    
+    def stop_watching(self):
+        """Stop the watcher; the flow cache goes back to mtime checks"""
+        if self.flow_watcher is not None:
+            self.flow_watcher.stop()
+            self.flow_watcher = None
+        self.flow_cache.watching = False
+    
+    def _on_flow_changed(self, path: Path, event_type: str):
+        """Invalidate a changed .flow file and re-render the pages showing it"""
+        logger.info(f"🔄 .flow file {event_type}: {path.name}")
+        self.flow_cache.invalidate(path)
+        
+        pages = list(self._page_routes.items())
+        if event_type != 'modified' or path not in self.page_registry.values():
+            # Files were added, removed or renamed, or a page changed its path
+            self._load_route_mappings()
+            affected = pages
+        else:
+            affected = [(page, route) for page, route in pages
+                        if self._resolve_flow_file(self._flow_route(route)) == path]
+        
+        for page, route in affected:
+            try:
+                self._show_route(page, route)
+            except Exception as e:
+                logger.error(f"Error reloading route {route}: {e}")
+    
     def _should_render_component(self, component_data: Dict[str, Any], platform: str) -> bool:
         """Determine if a component should be rendered based on platform visibility rules"""
         visibility = component_data.get('visibility', {})
@@ -334,6 +305,10 @@ class FlashFlowEngine:
         old_value = self.app_state.get(key)
         self.app_state[key] = value
         
+        # Cached trees were built against the old state's visibility rules
+        if old_value != value:
+            self.flow_cache.invalidate_trees()
+        
         # Notify listeners of state change
         if key in self.state_listeners:
             for listener in self.state_listeners[key]:
@@ -357,54 +332,101 @@ class FlashFlowEngine:
     def _initialize_flashcore(self):
         """Initialize FlashCore components"""
         try:
-            # Initialize vector search index (128-dimensional for embeddings, max 10000 elements)
-            self.vector_index = flashcore.HNSWIndex(128, 10000)
-            logger.info("Initialized FlashCore HNSW vector index")
-            
             # Initialize inference runtime (will be configured with specific models as needed)
             self.inference_runtime = flashcore.ONNXRuntime("")
             logger.info("Initialized FlashCore ONNX runtime")
             
-            # Initialize security vault with default key
-            self.security_vault = flashcore.AESVault("flashflow_default_key")
-            logger.info("Initialized FlashCore AES security vault")
+            # The vault is only as secret as its key, so there is no built-in default
+            key = self._vault_key()
+            if key:
+                self.security_vault = flashcore.AESVault(key)
+                logger.info("Initialized FlashCore AES security vault")
             
         except Exception as e:
             logger.error(f"Failed to initialize FlashCore components: {e}")
             self.flashcore_enabled = False
     
+    @staticmethod
+    def _vault_key() -> Optional[str]:
+        """The vault passphrase from FLASHFLOW_VAULT_KEY; without it encryption stays disabled"""
+        key = os.environ.get("FLASHFLOW_VAULT_KEY")
+        if not key:
+            logger.warning("FLASHFLOW_VAULT_KEY is not set, encryption disabled")
+        return key or None
+    
+    def _initialize_vector_index(self):
+        """Map the saved vector index, or create an empty one (128-dimensional, 10000 elements to start)"""
+        try:
+            if self.vector_index_path.exists():
+                self.vector_index = VectorIndex.load_mmap(str(self.vector_index_path))
+            else:
+                self.vector_index = VectorIndex(128, 10000, metric=self.vector_metric)
+            logger.info(f"Initialized vector index (metric={self.vector_index.metric})")
+        except Exception as e:
+            logger.error(f"Failed to initialize vector index: {e}")
+            self.vector_index = None
+    
     def _initialize_flashcore_features(self):
         """Initialize FlashCore-powered features"""
         # Pre-populate vector index with sample data for demonstration
-        if self.vector_index:
+        if self.vector_index is not None and not self.vector_index_path.exists():
             try:
                 # Add some sample vectors (in a real app, these would come from actual data)
-                sample_vectors = [
-                    (np.random.rand(128).astype(np.float32), 1),
-                    (np.random.rand(128).astype(np.float32), 2),
-                    (np.random.rand(128).astype(np.float32), 3),
-                ]
-                
-                for vector, id in sample_vectors:
-                    self.vector_index.add_vector(vector, id)
+                sample_vectors = np.random.rand(3, 128).astype(np.float32)
+                sample_ids = np.arange(1, 4, dtype=np.int64)
+                self.vector_index.add_vectors(sample_vectors, sample_ids)
                 
-                logger.info("Pre-populated FlashCore vector index with sample data")
+                logger.info("Pre-populated vector index with sample data")
             except Exception as e:
                 logger.error(f"Failed to pre-populate vector index: {e}")
     
-    def vector_search(self, query_vector: np.ndarray, k: int = 5):
-        """Perform vector search using FlashCore"""
-        if not self.flashcore_enabled or not self.vector_index:
-            # Fallback implementation
-            logger.warning("FlashCore not available, using fallback vector search")
-            return [{"id": i, "distance": 0.0} for i in range(min(k, 3))]
+    @traced("FlashFlowEngine.vector_search", cat="engine")
+    def vector_search(self, query_vector: np.ndarray, k: int = 5, filter: Dict[str, Any] = None):
+        """Perform vector search using FlashCore, optionally restricted by attribute filter"""
+        if self.vector_index is None:
+            logger.warning("No vector index available")
+            return []
         
         try:
-            return self.vector_index.search(query_vector, k)
+            return self.vector_index.search(query_vector, k, filter=filter)
         except Exception as e:
             logger.error(f"Vector search failed: {e}")
             return []
     
+    @traced("FlashFlowEngine.save_vector_index", cat="engine")
+    def save_vector_index(self) -> bool:
+        """Persist the vector index so later starts can map it instead of re-populating"""
+        if self.vector_index is None:
+            return False
+        
+        try:
+            self.vector_index_path.parent.mkdir(parents=True, exist_ok=True)
+            self.vector_index.save(str(self.vector_index_path))
+            return True
+        except Exception as e:
+            logger.error(f"Failed to save vector index: {e}")
+            return False
+    
+    @traced("FlashFlowEngine.vector_search_batch", cat="engine")
+    def vector_search_batch(self, query_vectors: np.ndarray, k: int = 5, filter: Dict[str, Any] = None):
+        """Search a [m, 128] query matrix, returning (ids[m, k], distances[m, k]) arrays"""
+        if self.vector_index is None:
+            logger.warning("No vector index available")
+            m = len(query_vectors)
+            return np.full((m, k), -1, dtype=np.int64), np.full((m, k), np.inf, dtype=np.float32)
+        
+        return self.vector_index.search_batch(query_vectors, k, filter=filter)
+    
+    @traced("FlashFlowEngine.add_vectors", cat="engine")
+    def add_vectors(self, vectors: np.ndarray, ids: np.ndarray, attributes: Dict[str, Any] = None) -> int:
+        """Bulk-insert a [n, 128] matrix of embeddings under ids[n], with optional filterable attributes"""
+        if self.vector_index is None:
+            logger.warning("No vector index available")
+            return 0
+        
+        return self.vector_index.add_vectors(vectors, ids, attributes)
+    
+    @traced("FlashFlowEngine.run_inference", cat="engine")
     def run_inference(self, input_data: np.ndarray, output_size: int = 10):
         """Run ML inference using FlashCore"""
         if not self.flashcore_enabled or not self.inference_runtime:
@@ -418,11 +440,12 @@ class FlashFlowEngine:
             logger.error(f"Inference failed: {e}")
             return np.zeros(output_size, dtype=np.float32)
     
+    @traced("FlashFlowEngine.encrypt_data", cat="engine")
     def encrypt_data(self, plaintext: bytes) -> bytes:
-        """Encrypt data using FlashCore"""
-        if not self.flashcore_enabled or not self.security_vault:
+        """Encrypt data with AES-256-GCM"""
+        if self.security_vault is None:
             # Fallback implementation (no encryption)
-            logger.warning("FlashCore not available, skipping encryption")
+            logger.warning("No AES vault available, skipping encryption")
             return plaintext
         
         try:
@@ -431,11 +454,12 @@ class FlashFlowEngine:
             logger.error(f"Encryption failed: {e}")
             return plaintext
     
+    @traced("FlashFlowEngine.decrypt_data", cat="engine")
     def decrypt_data(self, ciphertext: bytes) -> bytes:
-        """Decrypt data using FlashCore"""
-        if not self.flashcore_enabled or not self.security_vault:
+        """Decrypt data with AES-256-GCM"""
+        if self.security_vault is None:
             # Fallback implementation (no decryption)
-            logger.warning("FlashCore not available, skipping decryption")
+            logger.warning("No AES vault available, skipping decryption")
             return ciphertext
         
         try:
@@ -566,8 +590,10 @@ class FlashFlowEngine:
                             method = component_data.get('method', 'GET')
                             data = component_data.get('data', {})
                             if endpoint:
-                                result = self._make_api_request(method, endpoint, data)
-                                print(f"API call result: {result}")
+                                # Don't block the event handler while the backend responds
+                                self.api_client.request_in_background(
+                                    method, endpoint, data,
+                                    lambda result: print(f"API call result: {result}"))
                         elif action == 'set_state':
                             # Special action to set application state
                             state_changes = component_data.get('state_changes', {})
@@ -595,8 +621,10 @@ class FlashFlowEngine:
                             method = component_data.get('method', 'GET')
                             data = component_data.get('data', {})
                             if endpoint:
-                                result = self._make_api_request(method, endpoint, data)
-                                print(f"API call result: {result}")
+                                # Don't block the event handler while the backend responds
+                                self.api_client.request_in_background(
+                                    method, endpoint, data,
+                                    lambda result: print(f"API call result: {result}"))
                         elif action == 'set_state':
                             # Special action to set application state
                             state_changes = component_data.get('state_changes', {})
@@ -629,8 +657,10 @@ class FlashFlowEngine:
                             method = component_data.get('method', 'GET')
                             data = component_data.get('data', {})
                             if endpoint:
-                                result = self._make_api_request(method, endpoint, data)
-                                print(f"API call result: {result}")
+                                # Don't block the event handler while the backend responds
+                                self.api_client.request_in_background(
+                                    method, endpoint, data,
+                                    lambda result: print(f"API call result: {result}"))
                         elif action == 'set_state':
                             # Special action to set application state
                             state_changes = component_data.get('state_changes', {})
@@ -658,8 +688,10 @@ class FlashFlowEngine:
                             method = component_data.get('method', 'GET')
                             data = component_data.get('data', {})
                             if endpoint:
-                                result = self._make_api_request(method, endpoint, data)
-                                print(f"API call result: {result}")
+                                # Don't block the event handler while the backend responds
+                                self.api_client.request_in_background(
+                                    method, endpoint, data,
+                                    lambda result: print(f"API call result: {result}"))
                         elif action == 'set_state':
                             # Special action to set application state
                             state_changes = component_data.get('state_changes', {})
@@ -858,6 +890,7 @@ class FlashFlowEngine:
                 border_radius=5
             )
     
+    @traced("FlashFlowEngine._render_page", cat="engine")
     def _render_page(self, flow_data: Dict[str, Any], platform: str = "desktop") -> List[ft.Control]:
         """Render a page from flow data with platform-specific and temporary visibility"""
         controls = []
@@ -919,50 +952,71 @@ class FlashFlowEngine:
         )
         page.theme = theme
         
-        # Store page reference for adaptive components
-        self._current_page = page
-        
         # Detect current platform
         self.current_platform = self._detect_platform(page)
         logger.info(f"Detected platform: {self.current_platform}")
         
-        # Route handling
-        route = page.route or "/"
+        # Later navigation is served from the flow cache
+        page.on_route_change = lambda e: self._show_route(page, e.route)
+        
+        self._show_route(page, page.route or "/")
+    
+    @staticmethod
+    def _flow_route(route: str) -> str:
+        """Preview routes show the root page"""
+        return "/" if route.startswith("/preview/") else route
+    
+    def _resolve_flow_file(self, route: str) -> Optional[Path]:
+        """Find the flow file serving a route"""
+        if route in self.page_registry:
+            return self.page_registry[route]
+        elif route == "/" and "/app" in self.page_registry:
+            return self.page_registry["/app"]
+        else:
+            # Try to find default app.flow
+            default_flow = self.flow_files_dir / "app.flow"
+            if default_flow.exists():
+                return default_flow
+        return None
+    
+    @traced("FlashFlowEngine._show_route", cat="engine")
+    def _show_route(self, page: ft.Page, route: str):
+        """Render a route onto the page, reusing its cached tree when the flow is unchanged"""
+        # Store page reference for adaptive components
+        self._current_page = page
+        self._page_routes[page] = route
         logger.info(f"Navigating to route: {route}")
         
+        platform = self._detect_platform(page)
+        flow_route = route
+        
         # Handle preview routes
         if route.startswith("/preview/"):
             # Extract platform from preview route
             platform = route.split("/")[2] if len(route.split("/")) > 2 else "web"
-            # Set the platform for rendering
-            self.current_platform = platform
             # Use the root route to show the main page with the specified platform
-            route = "/"
+            flow_route = self._flow_route(route)
+        self.current_platform = platform
         
-        # Find matching flow file
-        flow_file_path = None
-        if route in self.page_registry:
-            flow_file_path = self.page_registry[route]
-        elif route == "/" and "/app" in self.page_registry:
-            flow_file_path = self.page_registry["/app"]
-        else:
-            # Try to find default app.flow
-            default_flow = self.flow_files_dir / "app.flow"
-            if default_flow.exists():
-                flow_file_path = default_flow
+        tree = self.flow_cache.tree(page, route, platform)
+        flow_file_path = None if tree is not None else self._resolve_flow_file(flow_route)
         
-        if flow_file_path and flow_file_path.exists():
+        if tree is None and flow_file_path and flow_file_path.exists():
             # Parse and render the flow file
             flow_data = self._parse_flow_file(flow_file_path)
-            controls = self._render_page(flow_data, self.current_platform)
+            controls = self._render_page(flow_data, platform)
             
             # Add navigation info
             controls.append(
-                ft.Text(f"Route: {route} | Platform: {self.current_platform}", size=12, color=ft.colors.GREY)
+                ft.Text(f"Route: {flow_route} | Platform: {platform}", size=12, color=ft.colors.GREY)
             )
             
+            tree = ft.Column(controls, spacing=20)
+            self.flow_cache.store_tree(page, route, platform, flow_file_path, tree)
+        
+        if tree is not None:
             page.controls.clear()
-            page.add(ft.Column(controls, spacing=20))
+            page.add(tree)
         else:
             # Show error page
             page.controls.clear()
@@ -971,31 +1025,24 @@ class FlashFlowEngine:
                     ft.Text("Page Not Found", size=32, color=ft.colors.RED),
                     ft.Text(f"No .flow file found for route: {route}", size=16),
                     ft.Text("Available routes:", size=18, weight=ft.FontWeight.BOLD),
-                    *[ft.Text(f"- {route}") for route in self.page_registry.keys()]
+                    *[ft.Text(f"- {registered}") for registered in self.page_registry.keys()]
                 ], spacing=20)
             )
         
         page.update()
     
     def _make_api_request(self, method: str, endpoint: str, data: Dict = None) -> Dict:
-        """Make API request to Laravel backend"""
+        """Make API request to Laravel backend over the pooled client"""
         try:
-            url = urljoin(self.backend_url, endpoint)
-            headers = {'Content-Type': 'application/json'}
-            
-            if method.upper() == 'GET':
-                response = requests.get(url, headers=headers)
-            elif method.upper() == 'POST':
-                response = requests.post(url, json=data, headers=headers)
-            elif method.upper() == 'PUT':
-                response = requests.put(url, json=data, headers=headers)
-            elif method.upper() == 'DELETE':
-                response = requests.delete(url, headers=headers)
-            else:
-                raise ValueError(f"Unsupported HTTP method: {method}")
-            
-            response.raise_for_status()
-            return response.json() if response.content else {}
+            return self.api_client.request(method, endpoint, data)
+        except Exception as e:
+            logger.error(f"API request failed: {e}")
+            return {"error": str(e)}
+    
+    async def _make_api_request_async(self, method: str, endpoint: str, data: Dict = None) -> Dict:
+        """Awaitable _make_api_request for async Flet handlers"""
+        try:
+            return await self.api_client.arequest(method, endpoint, data)
         except Exception as e:
             logger.error(f"API request failed: {e}")
             return {"error": str(e)}
@@ -1024,6 +1071,9 @@ def main():
         for route, file_path in engine.page_registry.items():
             logger.info(f"   {route} -> {file_path.name}")
         
+        # Hot-reload pages when their .flow files change
+        engine.start_watching()
+        
         # Start the Flet app in web mode
         ft.app(target=engine.main, view=ft.AppView.WEB_BROWSER, port=8013)
     except Exception as e:
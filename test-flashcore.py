@@ -5,6 +5,7 @@ Test script for FlashCore integration with FlashFlow
 
 import sys
 import os
+import tempfile
 import numpy as np
 
 # Add the FlashCore bindings to the path
@@ -47,6 +48,278 @@ def test_vector_search():
         print(f"✗ Vector search test failed: {e}")
         return False
 
+def test_vector_metrics():
+    """Test the NumPy vector index with each supported distance metric"""
+    try:
+        from flashflow_cli.services.vector_index import VectorIndex
+        
+        vec1 = np.array([1.0, 0.0, 0.0, 0.0], dtype=np.float32)
+        vec2 = np.array([0.0, 3.0, 0.0, 0.0], dtype=np.float32)
+        query = np.array([0.9, 0.4, 0.0, 0.0], dtype=np.float32)
+        
+        # l2 is squared, ip is 1 - q.v and cosine 1 - cos(q, v); the large vec2 wins only under ip
+        expected = {
+            "l2": (1, 0.1 ** 2 + 0.4 ** 2),
+            "ip": (2, 1.0 - 1.2),
+            "cosine": (1, 1.0 - 0.9 / np.sqrt(0.97)),
+        }
+        for metric, (nearest, distance) in expected.items():
+            index = VectorIndex(4, 100, metric=metric)
+            index.add_vector(vec1, 1)
+            index.add_vector(vec2, 2)
+            results = index.search(query, 2)
+            if results[0]["id"] != nearest or not np.isclose(results[0]["distance"], distance, atol=1e-5):
+                print(f"✗ Wrong nearest neighbour for metric {metric}: {results}")
+                return False
+            if len(results) != 2 or results[1]["distance"] < results[0]["distance"]:
+                print(f"✗ Results for metric {metric} are not ordered closest first: {results}")
+                return False
+            print(f"✓ Vector search with metric {metric} completed")
+        
+        try:
+            VectorIndex(4, 100, metric="hamming")
+            print("✗ Unsupported metric accepted")
+            return False
+        except ValueError:
+            print("✓ Unsupported metric rejected")
+        
+        return True
+    except Exception as e:
+        print(f"✗ Vector metric test failed: {e}")
+        return False
+
+def test_vector_batch():
+    """Test batched add/search on the NumPy vector index against brute force"""
+    try:
+        from flashflow_cli.services.vector_index import VectorIndex
+        
+        index = VectorIndex(4, 100, batch_size=4)
+        vectors = np.random.rand(50, 4).astype(np.float32)
+        ids = np.arange(100, 150, dtype=np.int64)
+        if index.add_vectors(vectors, ids) != 50 or len(index) != 50:
+            print("✗ Batch of vectors not added to index")
+            return False
+        print("✓ Batch of vectors added to index")
+        
+        # batch_size=4 splits the 10 queries over several thread pool blocks
+        queries = vectors[:10] + 0.01
+        labels, distances = index.search_batch(queries, 3)
+        if labels.shape != (10, 3) or distances.shape != (10, 3):
+            print(f"✗ Unexpected result shapes: {labels.shape}, {distances.shape}")
+            return False
+        
+        exact = ((queries[:, None, :] - vectors[None, :, :]) ** 2).sum(axis=2)
+        nearest = np.argsort(exact, axis=1)[:, :3]
+        if not np.array_equal(labels, ids[nearest]):
+            print("✗ Batch search labels differ from brute force")
+            return False
+        if not np.allclose(distances, np.take_along_axis(exact, nearest, axis=1), atol=1e-5):
+            print("✗ Batch search distances differ from brute force")
+            return False
+        print("✓ Batch vector search matches brute force (recall@3 = 1.0)")
+        
+        labels, distances = index.search_batch(queries[:2], 60)
+        if (labels[:, 50:] != -1).any() or not np.isinf(distances[:, 50:]).all():
+            print("✗ Rows beyond the stored vectors were not padded with -1/inf")
+            return False
+        print("✓ Short result rows padded with -1/inf")
+        
+        return True
+    except Exception as e:
+        print(f"✗ Vector batch test failed: {e}")
+        return False
+
+def test_vector_growth_and_delete():
+    """Test NumPy vector index growth past max elements, soft delete and compaction"""
+    try:
+        from flashflow_cli.services.vector_index import VectorIndex
+        
+        index = VectorIndex(4, 10)
+        vectors = np.random.rand(25, 4).astype(np.float32)
+        index.add_vectors(vectors, np.arange(25, dtype=np.int64))
+        if len(index) != 25 or index.max_elements < 25:
+            print(f"✗ Index did not grow (len={len(index)}, capacity={index.max_elements})")
+            return False
+        if [index.search(vectors[i], 1)[0]["id"] for i in (0, 12, 24)] != [0, 12, 24]:
+            print("✗ Vectors stored after growth are not found")
+            return False
+        print(f"✓ Index grew past its initial capacity to {index.max_elements}")
+        
+        fixed = VectorIndex(4, 10, allow_growth=False)
+        try:
+            fixed.add_vectors(vectors, np.arange(25, dtype=np.int64))
+            print("✗ Index with allow_growth=False accepted more than max elements")
+            return False
+        except RuntimeError:
+            print("✓ Fixed-size index rejected the overflow")
+        
+        if not index.mark_deleted(0) or index.mark_deleted(0) or len(index) != 24:
+            print("✗ mark_deleted did not hide exactly one vector")
+            return False
+        results = index.search(vectors[0], 25)
+        if len(results) != 24 or any(result["id"] == 0 for result in results):
+            print("✗ Deleted vector returned by search")
+            return False
+        print("✓ Deleted vector hidden from search")
+        
+        freed = index.compact()
+        if freed != 1 or len(index) != 24 or index.compact() != 0:
+            print(f"✗ Compaction failed (freed {freed})")
+            return False
+        result = index.search(vectors[1], 1)[0]
+        if result["id"] != 1 or result["distance"] > 1e-5:
+            print(f"✗ Compacted index returned wrong neighbour: {result}")
+            return False
+        index.add_vector(vectors[0], 0)
+        if index.search(vectors[0], 1)[0]["id"] != 0:
+            print("✗ Deleted id could not be re-added after compaction")
+            return False
+        print("✓ Index compacted")
+        
+        return True
+    except Exception as e:
+        print(f"✗ Vector growth/delete test failed: {e}")
+        return False
+
+def test_vector_persistence():
+    """Test saving the NumPy vector index and mapping it back from disk"""
+    try:
+        from flashflow_cli.services.vector_index import VectorIndex
+        
+        index = VectorIndex(4, 100, metric="cosine")
+        vectors = np.random.rand(20, 4).astype(np.float32) + 0.1
+        index.add_vectors(vectors, np.arange(20, dtype=np.int64))
+        index.mark_deleted(3)
+        expected_labels, expected_distances = index.search_batch(vectors, 5)
+        
+        with tempfile.TemporaryDirectory() as tmp_dir:
+            path = os.path.join(tmp_dir, "index.ffvi")
+            index.save(path)
+            saved = open(path, "rb").read()
+            print("✓ Index saved")
+            
+            loaded = VectorIndex.load_mmap(path)
+            if loaded.metric != "cosine" or len(loaded) != 19:
+                print(f"✗ Mapped index has metric {loaded.metric} and {len(loaded)} vectors")
+                return False
+            labels, distances = loaded.search_batch(vectors, 5)
+            if not np.array_equal(labels, expected_labels) or not np.allclose(distances, expected_distances, atol=1e-6):
+                print("✗ Mapped index returned different neighbours than the saved one")
+                return False
+            if (labels == 3).any():
+                print("✗ Deleted vector was saved")
+                return False
+            print("✓ Index mapped from disk and searched")
+            
+            # The first write moves the index into private memory and leaves the file unchanged
+            loaded.add_vector(vectors[3], 3)
+            if loaded.search(vectors[3], 1)[0]["id"] != 3 or open(path, "rb").read() != saved:
+                print("✗ Writing to the mapped index failed or modified the file")
+                return False
+            print("✓ Mapped index accepts writes copy-on-write")
+            del loaded
+        
+        return True
+    except Exception as e:
+        print(f"✗ Vector persistence test failed: {e}")
+        return False
+
+def test_vector_filter():
+    """Test filtered search on NumPy vector index attributes"""
+    try:
+        from flashflow_cli.services.vector_index import VectorIndex
+        
+        index = VectorIndex(4, 100)
+        vectors = np.random.rand(40, 4).astype(np.float32)
+        tenants = [i % 4 for i in range(40)]
+        types = ["post" if i % 2 else "page" for i in range(40)]
+        index.add_vectors(vectors, np.arange(40, dtype=np.int64), attributes={"tenant": tenants, "type": types})
+        exact = ((vectors - vectors[0]) ** 2).sum(axis=1)
+        
+        def expected(allowed):
+            rows = [i for i in np.argsort(exact).tolist() if allowed(i)]
+            return rows[:5]
+        
+        cases = [
+            ({"tenant": 3}, lambda i: tenants[i] == 3),
+            ({"tenant": [1, 2]}, lambda i: tenants[i] in (1, 2)),
+            ({"tenant": [1, 2], "type": "post"}, lambda i: tenants[i] in (1, 2) and types[i] == "post"),
+        ]
+        for filter, allowed in cases:
+            results = index.search(vectors[0], 5, filter=filter)
+            if [result["id"] for result in results] != expected(allowed):
+                print(f"✗ Filtered search {filter} returned wrong results: {results}")
+                return False
+        print(f"✓ Filtered vector search matches brute force for {len(cases)} filters")
+        
+        if index.search(vectors[0], 5, filter={"tenant": 9}) or index.search(vectors[0], 5, filter={"colour": "red"}):
+            print("✗ Filter matching nothing returned results")
+            return False
+        index.mark_deleted(3)
+        if any(result["id"] == 3 for result in index.search(vectors[0], 10, filter={"tenant": 3})):
+            print("✗ Filtered search returned a deleted vector")
+            return False
+        print("✓ Unmatched filters and deleted rows return nothing")
+        
+        with tempfile.TemporaryDirectory() as tmp_dir:
+            path = os.path.join(tmp_dir, "index.ffvi")
+            index.save(path)
+            loaded = VectorIndex.load_mmap(path)
+            results = loaded.search(vectors[0], 5, filter={"tenant": [1, 2], "type": "post"})
+            if [result["id"] for result in results] != expected(lambda i: tenants[i] in (1, 2) and types[i] == "post"):
+                print(f"✗ Attributes lost across save/load_mmap: {results}")
+                return False
+            del loaded
+        print("✓ Attributes survive save/load_mmap")
+        
+        return True
+    except Exception as e:
+        print(f"✗ Vector filter test failed: {e}")
+        return False
+
+def test_vector_quantization():
+    """Test that quantized indexes need a real training sample and keep recall"""
+    try:
+        from flashflow_cli.services.vector_index import VectorIndex, MIN_TRAIN_ROWS
+        
+        rng = np.random.default_rng(3)
+        vectors = rng.random((2000, 32), dtype=np.float32)
+        queries = rng.random((50, 32), dtype=np.float32)
+        ids = np.arange(2000, dtype=np.int64)
+        exact = ((queries[:, None, :] - vectors[None, :, :]) ** 2).sum(axis=2)
+        truth = np.argsort(exact, axis=1)[:, :10]
+        
+        for name, options in (("sq8", {"quantization": "sq8"}),
+                              ("pq", {"quantization": "pq", "pq_subvectors": 8, "rerank": 100})):
+            index = VectorIndex(32, 2000, **options)
+            for attempt in (lambda: index.add_vectors(vectors[:1], ids[:1]),
+                            lambda: index.train(vectors[:MIN_TRAIN_ROWS - 1])):
+                try:
+                    attempt()
+                    print(f"✗ {name} index trained on fewer than {MIN_TRAIN_ROWS} vectors")
+                    return False
+                except ValueError:
+                    pass
+            if len(index):
+                print(f"✗ Rejected {name} batch was stored")
+                return False
+            
+            # A tiny first batch is fine once the quantizer saw a representative sample
+            index.train(vectors)
+            index.add_vectors(vectors[:1], ids[:1])
+            index.add_vectors(vectors[1:], ids[1:])
+            labels, _ = index.search_batch(queries, 10)
+            recall = np.mean([len(set(row) & set(expected)) / 10 for row, expected in zip(labels.tolist(), truth.tolist())])
+            if recall < 0.9:
+                print(f"✗ {name} recall@10 after a one-row first batch is {recall:.3f}")
+                return False
+            print(f"✓ {name} rejects undersized training and keeps recall@10={recall:.3f}")
+        
+        return True
+    except Exception as e:
+        print(f"✗ Vector quantization test failed: {e}")
+        return False
+
 def test_inference_engine():
     """Test FlashCore inference engine"""
     try:
@@ -66,6 +339,60 @@ def test_inference_engine():
         print(f"✗ Inference engine test failed: {e}")
         return False
 
+def test_inference_batching():
+    """Test dynamic batching of concurrent inference requests"""
+    try:
+        import threading
+        from flashflow_cli.services.inference_runtime import DynamicBatcher
+        
+        calls = []
+        def run_batch(inputs):
+            calls.append(inputs["x"].shape[0])
+            return [inputs["x"] * 2.0]
+        
+        batcher = DynamicBatcher(run_batch, max_batch_size=8, max_latency_ms=50.0)
+        results = {}
+        def request(i):
+            results[i] = batcher.infer({"x": np.full((1, 4), i, dtype=np.float32)})[0]
+        
+        threads = [threading.Thread(target=request, args=(i,)) for i in range(16)]
+        for thread in threads:
+            thread.start()
+        for thread in threads:
+            thread.join()
+        batcher.close()
+        
+        if any(not np.allclose(results[i], 2.0 * i) for i in range(16)):
+            print("✗ Batched outputs routed to the wrong request")
+            return False
+        if len(calls) >= 16 or max(calls) > 8:
+            print(f"✗ Requests were not batched: {calls}")
+            return False
+        print(f"✓ 16 requests served in {len(calls)} batched forward passes")
+        
+        # Multi-row requests must not push a batch past max_batch_size rows
+        calls.clear()
+        batcher = DynamicBatcher(run_batch, max_batch_size=8, max_latency_ms=50.0)
+        futures = [batcher.submit({"x": np.full((3, 4), i, dtype=np.float32)}) for i in range(6)]
+        oversized = batcher.submit({"x": np.arange(80, dtype=np.float32).reshape(20, 4)})
+        outputs = [future.result(5)[0] for future in futures]
+        large = oversized.result(5)[0]
+        batcher.close()
+        
+        if max(calls) > 8 or sum(calls) != 38:
+            print(f"✗ Forward passes exceeded max_batch_size rows: {calls}")
+            return False
+        if any(not np.allclose(output, 2.0 * i) or output.shape != (3, 4) for i, output in enumerate(outputs)) \
+                or not np.array_equal(large, 2.0 * np.arange(80, dtype=np.float32).reshape(20, 4)):
+            print("✗ Split or capped batches returned wrong rows")
+            return False
+        print(f"✓ Multi-row and oversized requests capped at 8 rows per pass: {calls}")
+        
+        return True
+    except Exception as e:
+        print(f"✗ Inference batching test failed: {e}")
+        return False
+
 def test_encryption():
     """Test FlashCore encryption"""
     try:
@@ -90,6 +417,1462 @@ def test_encryption():
         print(f"✗ Encryption test failed: {e}")
         return False
 
+def test_streaming_encryption():
+    """Test streaming and batched AES-GCM encryption"""
+    try:
+        import io
+        from flashflow_cli.services.crypto_vault import AESVault
+        
+        vault = AESVault("test_key_12345")
+        payload = os.urandom(3 * 1024 * 1024 + 17)
+        
+        encrypted = io.BytesIO()
+        vault.encrypt_stream(io.BytesIO(payload), encrypted, chunk_size=64 * 1024)
+        decrypted = io.BytesIO()
+        encrypted.seek(0)
+        vault.decrypt_stream(encrypted, decrypted, chunk_size=64 * 1024)
+        if decrypted.getvalue() != payload:
+            print("✗ Streamed round trip mismatch")
+            return False
+        print("✓ Streaming encryption/decryption successful")
+        
+        tampered = bytearray(encrypted.getvalue())
+        tampered[100] ^= 1
+        try:
+            vault.decrypt_stream(io.BytesIO(bytes(tampered)), io.BytesIO())
+            print("✗ Tampered stream was accepted")
+            return False
+        except Exception:
+            print("✓ Tampered stream rejected")
+        
+        records = [os.urandom(n) for n in range(64)]
+        if vault.decrypt_many(vault.encrypt_many(records)) != records:
+            print("✗ Batched record round trip mismatch")
+            return False
+        print("✓ Batched record encryption successful")
+        
+        return True
+    except Exception as e:
+        print(f"✗ Streaming encryption test failed: {e}")
+        return False
+
+def test_analytics_ingestion():
+    """Test ring-buffered, batched analytics event ingestion"""
+    try:
+        import sqlite3
+        import threading
+        from flashflow_cli.services.analytics_services import AnalyticsEngine, DROP_NEWEST
+        
+        with tempfile.TemporaryDirectory() as tmp:
+            db_path = os.path.join(tmp, "analytics.db")
+            engine = AnalyticsEngine(db_path, batch_size=500, flush_interval=0.05)
+            
+            def produce(worker):
+                for i in range(2000):
+                    engine.track_event("click", user_id=f"user{worker}", properties={"i": i})
+                engine.track_page_view(user_id=f"user{worker}", page_url="/home")
+            
+            threads = [threading.Thread(target=produce, args=(w,)) for w in range(8)]
+            for thread in threads:
+                thread.start()
+            for thread in threads:
+                thread.join()
+            engine.shutdown()
+            
+            conn = sqlite3.connect(db_path)
+            events = conn.execute("SELECT COUNT(*) FROM events").fetchone()[0]
+            views = conn.execute("SELECT COUNT(*) FROM page_views").fetchone()[0]
+            conn.close()
+            metrics = engine.get_metrics()
+            if events != 16000 or views != 8 or metrics['dropped'] != 0:
+                print(f"✗ Expected 16000 events and 8 page views, got {events} and {views}")
+                return False
+            print(f"✓ 16008 rows written in {metrics['flushes']} batched flushes")
+            
+            summary = engine.get_analytics_summary(days=1)
+            if (summary['total_events'], summary['total_page_views'], summary['unique_users']) != (16000, 8, 8):
+                print(f"✗ Rollup summary disagrees with raw rows: {summary}")
+                return False
+            print("✓ Rollup summary matches raw rows")
+            
+            bounded = AnalyticsEngine(os.path.join(tmp, "bounded.db"), buffer_capacity=10,
+                                      flush_interval=60, backpressure=DROP_NEWEST)
+            accepted = sum(1 for _ in range(25) if bounded.track_event("view"))
+            if accepted != 10 or bounded.get_metrics()['dropped'] != 15:
+                print(f"✗ Backpressure accepted {accepted} of 25 events into a buffer of 10")
+                return False
+            bounded.shutdown()
+            print("✓ Backpressure drops events beyond buffer capacity")
+        
+        return True
+    except Exception as e:
+        print(f"✗ Analytics ingestion test failed: {e}")
+        return False
+
+def test_telemetry_store():
+    """Test columnar telemetry blocks, range queries and recovery"""
+    try:
+        from flashflow_cli.services.telemetry_store import TelemetryStore, BLOCK_HEADER
+        
+        with tempfile.TemporaryDirectory() as tmp:
+            store = TelemetryStore(tmp, block_records=128)
+            start = 1_700_000_000_000_000
+            records = [(start + i * 1_000_000, {"temp": 20.0 + (i % 50) * 0.1, "count": i, "on": i % 2 == 0})
+                       for i in range(1000)]
+            store.append_many("sensor-1", records[:900])
+            for timestamp, data in records[900:]:
+                store.append("sensor-1", data, timestamp)
+            
+            if store.query("sensor-1") != records:
+                print("✗ Telemetry round trip mismatch")
+                return False
+            stats = store.stats("sensor-1")
+            print(f"✓ 1000 points stored in {stats['blocks']} blocks ({stats['bytes']} bytes)")
+            
+            window = store.query("sensor-1", start + 100_000_000, start + 199_000_000)
+            if window != records[100:200]:
+                print("✗ Time-range query returned the wrong points")
+                return False
+            print("✓ Time-range query successful")
+            
+            reopened = TelemetryStore(tmp, block_records=128)
+            if reopened.tail("sensor-1", 10) != records[-10:]:
+                print("✗ Reopened store lost points")
+                return False
+            print("✓ Store recovered from disk")
+            
+            # A block torn mid-write must not hide the blocks sealed after it
+            segment = os.path.join(tmp, "sensor-1", sorted(os.listdir(os.path.join(tmp, "sensor-1")))[-1])
+            with open(segment, 'rb') as f:
+                sealed = f.read()
+            with open(segment, 'ab') as f:
+                f.write(sealed[:BLOCK_HEADER.size + 16])
+            more = [(start + (1000 + i) * 1_000_000, {"temp": 25.0, "count": 1000 + i, "on": True}) for i in range(300)]
+            TelemetryStore(tmp, block_records=128).append_many("sensor-1", more)
+            if os.path.getsize(segment) <= len(sealed):
+                print("✗ New blocks were not sealed after the torn tail")
+                return False
+            recovered = TelemetryStore(tmp, block_records=128).query("sensor-1")
+            if recovered != records + more:
+                print(f"✗ Reload after a torn tail returned {len(recovered)} of {len(records) + len(more)} points")
+                return False
+            print("✓ Torn segment tail truncated on load")
+        
+        return True
+    except Exception as e:
+        print(f"✗ Telemetry store test failed: {e}")
+        return False
+
+def test_rate_limiter():
+    """Test token-bucket rate limiting, rule matching and checkpoint restore"""
+    try:
+        from types import SimpleNamespace
+        from flashflow_cli.services.rate_limiter import RateLimiter, RuleMatcher
+        
+        rules = [
+            SimpleNamespace(id="all", endpoint_pattern="*", method="ALL"),
+            SimpleNamespace(id="api", endpoint_pattern="/api/*", method="GET"),
+            SimpleNamespace(id="login", endpoint_pattern="/api/auth/login", method="POST"),
+        ]
+        matcher = RuleMatcher(rules)
+        matched = {
+            ("/api/auth/login", "POST"): [rule.id for rule in matcher.match("/api/auth/login", "POST")],
+            ("/api/items", "GET"): [rule.id for rule in matcher.match("/api/items", "get")],
+            ("/home", "GET"): [rule.id for rule in matcher.match("/home", "GET")],
+        }
+        if matched != {("/api/auth/login", "POST"): ["all", "login"],
+                       ("/api/items", "GET"): ["all", "api"], ("/home", "GET"): ["all"]}:
+            print(f"✗ Rule matcher returned {matched}")
+            return False
+        print("✓ Rule matcher successful")
+        
+        with tempfile.TemporaryDirectory() as tmp:
+            db_path = os.path.join(tmp, "security.db")
+            limiter = RateLimiter(db_path, checkpoint_interval=0)
+            allowed = [limiter.allow("login:1.2.3.4", 5, 300) for _ in range(8)]
+            if allowed != [True] * 5 + [False] * 3 or not limiter.allow("login:5.6.7.8", 5, 300):
+                print(f"✗ Token bucket allowed {allowed}")
+                return False
+            print("✓ Token bucket limits each key separately")
+            
+            limiter.close()
+            restored = RateLimiter(db_path, checkpoint_interval=0)
+            if restored.allow("login:1.2.3.4", 5, 300) or not restored.allow("login:9.9.9.9", 5, 300):
+                print("✗ Checkpointed buckets were not restored")
+                return False
+            restored.close()
+            print("✓ Buckets restored from checkpoint")
+        
+        return True
+    except Exception as e:
+        print(f"✗ Rate limiter test failed: {e}")
+        return False
+
+def _shared_rate_limit_worker(name, start, results):
+    """Take tokens from a shared-memory limiter opened by name, as a separate worker would"""
+    from flashflow_cli.services.rate_limiter import RateLimiter
+    limiter = RateLimiter(shared_name=name)
+    start.wait()
+    results.put(sum(limiter.allow("api:1.2.3.4", 10, 3600) for _ in range(15)))
+    limiter.close()
+
+def test_shared_rate_limiter():
+    """Test that worker processes sharing a rate limit table enforce one combined limit"""
+    try:
+        import multiprocessing
+        from flashflow_cli.services.rate_limiter import RateLimiter
+        
+        if os.name != "posix":
+            print("✓ Shared-memory rate limiting skipped (needs fcntl locks)")
+            return True
+        
+        name = f"ff-ratelimit-test-{os.getpid()}"
+        limiter = RateLimiter(shared_name=name)
+        try:
+            context = multiprocessing.get_context("fork")
+            start, results = context.Event(), context.Queue()
+            workers = [context.Process(target=_shared_rate_limit_worker, args=(name, start, results))
+                       for _ in range(2)]
+            for worker in workers:
+                worker.start()
+            start.set()
+            allowed = [results.get(timeout=30) for _ in workers]
+            for worker in workers:
+                worker.join(timeout=30)
+            
+            if sum(allowed) != 10 or limiter.allow("api:1.2.3.4", 10, 3600):
+                print(f"✗ Two workers were allowed {allowed} requests against one limit of 10")
+                return False
+            if not limiter.allow("api:5.6.7.8", 10, 3600):
+                print("✗ Shared table limited an unrelated key")
+                return False
+            print(f"✓ Two workers shared one limit of 10 (allowed {allowed[0]} + {allowed[1]})")
+        finally:
+            limiter.close(unlink=True)
+        
+        # Independently started workers each run their own resource tracker, and the table
+        # must survive every one of them exiting (multiprocessing children share the parent's)
+        import subprocess
+        name = f"ff-ratelimit-spawn-{os.getpid()}"
+        worker = (f"import sys; sys.path.insert(0, {os.path.dirname(os.path.abspath(__file__))!r})\n"
+                  "from flashflow_cli.services.rate_limiter import RateLimiter\n"
+                  f"limiter = RateLimiter(shared_name={name!r})\n"
+                  "print(sum(limiter.allow('api:1.2.3.4', 10, 3600) for _ in range(6)))\n"
+                  "limiter.close()\n")
+        try:
+            allowed = [int(subprocess.run([sys.executable, "-c", worker], capture_output=True, text=True,
+                                          timeout=60, check=True).stdout) for _ in range(2)]
+        finally:
+            RateLimiter(shared_name=name).close(unlink=True)
+        if allowed != [6, 4]:
+            print(f"✗ Workers that exited in turn were allowed {allowed} against one limit of 10")
+            return False
+        print("✓ Shared table outlived the workers that opened it")
+        
+        return True
+    except Exception as e:
+        print(f"✗ Shared rate limiter test failed: {e}")
+        return False
+
+def test_sqlite_search():
+    """Test pooled SQLite FTS search with batched analytics"""
+    try:
+        import sqlite3
+        import threading
+        from flashflow_cli.services.search_services import SQLiteSearchEngine, SearchQuery
+        
+        with tempfile.TemporaryDirectory() as tmp:
+            db_path = os.path.join(tmp, "search.db")
+            engine = SQLiteSearchEngine({'db_path': db_path, 'reader_pool_size': 2})
+            documents = [{'id': f"doc{i}", 'title': f"Post {i} about python", 'content': "search engines " * 10,
+                          'type': 'post' if i % 2 else 'page'} for i in range(200)]
+            if not engine.bulk_index(documents):
+                print("✗ Bulk index failed")
+                return False
+            
+            query = SearchQuery("python search", {}, "relevance", 0, 10, ['type'], True)
+            totals = []
+            
+            def run():
+                for _ in range(25):
+                    totals.append(engine.search(query)[1].total_results)
+            
+            threads = [threading.Thread(target=run) for _ in range(4)]
+            for thread in threads:
+                thread.start()
+            for thread in threads:
+                thread.join()
+            if set(totals) != {200}:
+                print(f"✗ Concurrent searches returned totals {set(totals)}")
+                return False
+            pooled = list(engine._reader_pool.queue)
+            opened = [conn for conn in pooled if conn is not None]
+            if len(pooled) != 2 or not 1 <= len(opened) <= 2:
+                print(f"✗ Reader pool not bounded or not checked back in: {len(pooled)} slots, {len(opened)} open")
+                return False
+            print(f"✓ 100 concurrent searches from 4 threads over {len(opened)} pooled connections")
+            
+            faceted = SearchQuery("python", {}, "relevance", 0, 30, ['type'], False)
+            results, stats = engine.search(faceted)
+            seen = [result.id for result in results]
+            while stats.next_cursor:
+                faceted.cursor = stats.next_cursor
+                results, stats = engine.search(faceted)
+                seen.extend(result.id for result in results)
+            type_counts = {facet['value']: facet['count'] for facet in stats.facets.get('type', [])}
+            if sorted(seen) != sorted(doc['id'] for doc in documents) or type_counts != {'post': 100, 'page': 100}:
+                print(f"✗ Cursor pages returned {len(seen)} documents, facets {stats.facets}")
+                return False
+            if not any("python" in highlight.lower() for highlight in results[0].highlights):
+                print(f"✗ Highlights missing the matched term: {results[0].highlights}")
+                return False
+            print("✓ Cursor pagination, facets and highlights successful")
+            
+            engine.close()
+            conn = sqlite3.connect(db_path)
+            logged = conn.execute("SELECT COUNT(*) FROM search_analytics").fetchone()[0]
+            counted = conn.execute("SELECT count FROM search_suggestions WHERE query = ?", (query.query,)).fetchone()
+            conn.close()
+            if logged != 107 or counted != (100,):
+                print(f"✗ Expected 107 analytics rows and a suggestion count of 100, got {logged} and {counted}")
+                return False
+            print("✓ Analytics written in batches after the queries")
+        
+        return True
+    except Exception as e:
+        print(f"✗ SQLite search test failed: {e}")
+        return False
+
+def test_hybrid_search():
+    """Test that hybrid vectors survive a restart and that the manager indexes every engine"""
+    try:
+        from flashflow_cli.services.search_services import (HybridSearchEngine, IntelligentSearchManager,
+                                                            SearchQuery, SQLiteSearchEngine)
+        
+        with tempfile.TemporaryDirectory() as tmp:
+            db_path = os.path.join(tmp, "search.db")
+            manager = IntelligentSearchManager()
+            manager.configure({'sqlite': {'db_path': db_path}, 'hybrid': {'dim': 64}})
+            items = [{'id': i, 'title': f"Post {i}", 'content': "solar panels" if i % 2 else "wind turbines"}
+                     for i in range(20)]
+            if not manager.index_content('post', items):
+                print("✗ index_content failed")
+                return False
+            hybrid = manager.engines['hybrid']
+            _, stats = manager.engines['sqlite'].search(SearchQuery("solar", {}, "relevance", 0, 50, [], False))
+            if len(hybrid.vector_index) != 20 or stats.total_results != 10:
+                print(f"✗ Expected 20 vectors and 10 unduplicated FTS matches, got "
+                      f"{len(hybrid.vector_index)} and {stats.total_results}")
+                return False
+            print("✓ index_content fills the vector index and the shared FTS table once")
+            
+            manager.engines['sqlite'].close()
+            plain = SQLiteSearchEngine({'db_path': db_path})
+            plain.index_document("note_1", {'title': "Note", 'content': "solar panels on the roof", 'type': 'note'})
+            plain.close()
+            
+            restarted = HybridSearchEngine({'sqlite': {'db_path': db_path}, 'dim': 64})
+            if len(restarted.vector_index) != 21:
+                print(f"✗ Vector index not rebuilt from the FTS table: {len(restarted.vector_index)} vectors")
+                return False
+            hits = restarted.vector_index.search(restarted.embedder("solar panels"), 5)
+            found = restarted.lexical.get_documents_by_rowid([hit['id'] for hit in hits])
+            if len(found) != 5 or any("solar" not in doc.content for doc in found.values()):
+                print(f"✗ Rebuilt vectors do not resolve to matching documents: {[d.content for d in found.values()]}")
+                return False
+            print("✓ Vectors rebuilt on start, including documents indexed without the hybrid engine")
+            
+            if not restarted.delete_document("note_1") or len(restarted.vector_index) != 20:
+                print("✗ Deleting a plainly indexed document left its vector behind")
+                return False
+            print("✓ Deletes reach vectors stored under their FTS rowid")
+            restarted.lexical.close()
+        
+        return True
+    except Exception as e:
+        print(f"✗ Hybrid search test failed: {e}")
+        return False
+
+def test_cron_scheduler():
+    """Test cron expression parsing and pooled job execution"""
+    try:
+        import threading
+        from datetime import datetime, timedelta
+        from flashflow_cli.services.cron_services import CronJobManager, CronSchedule
+        
+        weekday_nine = CronSchedule("0 9 * * mon-fri")
+        fire = weekday_nine.next_after(datetime(2026, 10, 16, 9, 0))  # A Friday
+        if fire != datetime(2026, 10, 19, 9, 0):
+            print(f"✗ Next weekday 09:00 after Friday was {fire}")
+            return False
+        print("✓ Cron expression parsing successful")
+        
+        class ManualClock:
+            def __init__(self):
+                self.wall = datetime(2026, 10, 16, 9, 0)
+                self.mono = 0.0
+            
+            def now(self):
+                return self.wall
+            
+            def monotonic(self):
+                return self.mono
+            
+            def advance(self, seconds):
+                self.wall += timedelta(seconds=seconds)
+                self.mono += seconds
+        
+        with tempfile.TemporaryDirectory() as tmp:
+            clock = ManualClock()
+            manager = CronJobManager(os.path.join(tmp, "cron.db"), workers=4, clock=clock)
+            runs = {'fast': 0, 'slow': 0, 'late': 0}
+            release = threading.Event()
+            
+            def fast():
+                runs['fast'] += 1
+            
+            def slow():
+                runs['slow'] += 1
+                release.wait(5)
+            
+            def late():
+                runs['late'] += 1
+            
+            # Quick jobs allow more instances than they get fire times, so only the slow job overlaps
+            manager.add_job("fast", "every_10_seconds", fast, max_instances=5)
+            manager.add_job("slow", "every_10_seconds", slow)
+            manager.add_job("late", "every_10_seconds", late, max_instances=5, misfire_policy="skip")
+            for bad in ({'schedule': "every now and then"}, {'max_instances': 0}, {'max_instances': "2"}):
+                try:
+                    manager.add_job("broken", bad.get('schedule', "every_minute"), fast, max_instances=bad.get('max_instances', 1))
+                    print(f"✗ Invalid job {bad} was accepted")
+                    return False
+                except ValueError:
+                    pass
+            
+            manager.start_scheduler()
+            if manager.run_pending() != 0:
+                print("✗ Jobs ran before their fire time")
+                return False
+            for _ in range(3):
+                clock.advance(10)
+                manager.run_pending()
+            if (runs['slow'], manager.overlaps) != (1, 2):
+                print(f"✗ Slow job ran {runs['slow']} times with {manager.overlaps} overlaps")
+                return False
+            
+            clock.advance(100)  # Past the misfire grace
+            manager.run_pending()
+            release.set()
+            manager.stop_scheduler()
+            if (runs['fast'], runs['late'], manager.misfires) != (4, 3, 1):
+                print(f"✗ Unexpected runs {runs} with {manager.misfires} misfires")
+                return False
+            print(f"✓ Slow job didn't delay others ({runs['fast']} fast runs, {manager.overlaps} overlaps, {manager.misfires} misfire)")
+
+            logs = manager.get_execution_logs(limit=100)
+            manager.close()
+            if len(logs) != sum(runs.values()) or any(log.status != "success" for log in logs):
+                print(f"✗ Expected {sum(runs.values())} execution logs, got {len(logs)}")
+                return False
+            print("✓ Execution logs written in batches")
+            
+            manager = CronJobManager(os.path.join(tmp, "cron.db"), workers=1)
+            nightly = manager.add_job("nightly", "@daily", fast, max_instances=3, misfire_policy="skip")
+            manager.update_job(nightly, max_instances=2)
+            manager.close()
+            reloaded = CronJobManager(os.path.join(tmp, "cron.db"), workers=1)
+            job = reloaded.get_job(nightly)
+            reloaded.close()
+            if (job.max_instances, job.misfire_policy) != (2, "skip"):
+                print(f"✗ Reloaded job has max_instances={job.max_instances}, misfire_policy={job.misfire_policy}")
+                return False
+            print("✓ Job overlap and misfire settings persisted")
+        
+        return True
+    except Exception as e:
+        print(f"✗ Cron scheduler test failed: {e}")
+        return False
+
+def test_federated_aggregation():
+    """Test sample-weighted FedAvg over memory-mapped weight files"""
+    try:
+        from flashflow_cli.services.federated_aggregation import read_weights
+        from flashflow_cli.services.federated_learning_service import FederatedLearningService
+        
+        with tempfile.TemporaryDirectory() as tmp:
+            service = FederatedLearningService(os.path.join(tmp, "federated"))
+            service.aggregator.chunk = 1024  # Split the dense layer across several tasks
+            model_id = service.register_model("mnist")
+            round_id = service.start_training_round(model_id, num_clients=3)
+            
+            rng = np.random.default_rng(0)
+            updates = []
+            for i, samples in enumerate([10, 30, 60]):
+                weights = {
+                    "dense.weight": rng.standard_normal((64, 100)).astype(np.float32),
+                    "dense.bias": rng.standard_normal(100).astype(np.float32)
+                }
+                updates.append((weights, samples))
+                if not service.submit_client_update(model_id, f"client-{i}", weights, {"loss": 0.5}, num_samples=samples):
+                    print("✗ Client update was rejected")
+                    return False
+            
+            if not service.aggregate_updates(round_id):
+                print("✗ Aggregation failed")
+                return False
+            
+            aggregated = service.get_global_weights(model_id)
+            for name in ("dense.weight", "dense.bias"):
+                expected = sum(weights[name].astype(np.float64) * samples for weights, samples in updates) / 100
+                if not np.allclose(aggregated[name], expected, atol=1e-5):
+                    print(f"✗ Aggregated {name} differs from the weighted average")
+                    return False
+            print("✓ Weighted average matches across 3 clients")
+            
+            model = service.get_model(model_id)
+            if read_weights(model["global_weights"])["dense.bias"].shape != (100,) or len(model["participants"]) != 3:
+                print("✗ Global model not updated")
+                return False
+            
+            mismatched = {"dense.weight": np.zeros((10, 10), dtype=np.float32)}
+            next_round = service.start_training_round(model_id)
+            service.submit_client_update(model_id, "client-0", mismatched, {}, num_samples=1)
+            service.submit_client_update(model_id, "client-1", updates[1][0], {}, num_samples=1)
+            if service.aggregate_updates(next_round):
+                print("✗ Updates with different layers were averaged")
+                return False
+            print("✓ Mismatched updates rejected")
+        
+        return True
+    except Exception as e:
+        print(f"✗ Federated aggregation test failed: {e}")
+        return False
+
+def test_measurement_store():
+    """Test columnar measurement storage, merged statistics and streamed export"""
+    try:
+        import math
+        import random
+        from flashflow_cli.services.scientific_service import ScientificService
+        
+        with tempfile.TemporaryDirectory() as tmp:
+            service = ScientificService(os.path.join(tmp, "scientific"), chunk_records=500)
+            instrument_id = service.register_instrument("UV-Vis", "spectrometer", "Acme", "S1")
+            experiment_id = service.create_experiment("Kinetics", "", "lab", "proj")
+            
+            random.seed(7)
+            values = [random.gauss(50, 10) for _ in range(2250)]
+            start = 1_700_000_000_000_000
+            ids = service.record_measurements(experiment_id, instrument_id, "absorbance", values, "AU",
+                                              timestamps=[start + i * 1000 for i in range(len(values))])
+            
+            analysis = service.analyze_data(experiment_id=experiment_id)
+            mean = sum(values) / len(values)
+            std_dev = math.sqrt(sum((v - mean) ** 2 for v in values) / len(values))
+            p90 = sorted(values)[int(0.9 * (len(values) - 1))]
+            if (analysis["count"] != len(values) or abs(analysis["mean"] - mean) > 1e-3
+                    or abs(analysis["std_dev"] - std_dev) > 1e-3 or analysis["max"] != max(values)):
+                print(f"✗ Merged chunk statistics are wrong: {analysis}")
+                return False
+            if abs(analysis["percentiles"]["p90"] - p90) > 0.02 * abs(p90):
+                print(f"✗ p90 estimate {analysis['percentiles']['p90']} too far from {p90}")
+                return False
+            print("✓ Statistics merged from chunk summaries")
+            
+            ranged = service.analyze_data(experiment_id=experiment_id, start=start + 250_000,
+                                          end=start + 1_749_000, window_seconds=0.5)
+            subset = values[250:1750]
+            if ranged["count"] != 1500 or abs(ranged["mean"] - sum(subset) / 1500) > 1e-3:
+                print(f"✗ Time-range statistics are wrong: {ranged['count']}")
+                return False
+            if [w["count"] for w in ranged["windows"]] != [250, 500, 500, 250]:
+                print(f"✗ Unexpected windows {[w['count'] for w in ranged['windows']]}")
+                return False
+            print("✓ Time-range and windowed aggregates correct")
+            
+            picked = service.analyze_data(ids[:2])
+            if picked["count"] != 2 or picked["min"] != min(values[:2]):
+                print("✗ Analysis by measurement id failed")
+                return False
+            
+            csv_path = os.path.join(tmp, "export.csv")
+            service.export_data(experiment_id, "csv", output_path=csv_path)
+            with open(csv_path) as f:
+                lines = f.read().splitlines()
+            if len(lines) != len(values) + 1 or not lines[1].startswith(ids[0]):
+                print(f"✗ CSV export has {len(lines)} lines")
+                return False
+            print("✓ CSV streamed from chunks")
+            
+            experiment = service.get_experiment(experiment_id)
+            if experiment["measurement_count"] != len(values) or experiment["measurements"] != ids[-100:]:
+                print(f"✗ Experiment lists {len(experiment['measurements'])} recent measurements")
+                return False
+            
+            # inf would break every later seal of the series, NaN would drop out of the sketch
+            for bad in (float("inf"), float("-inf"), float("nan")):
+                try:
+                    service.record_measurement(experiment_id, instrument_id, "absorbance", bad, "AU")
+                    print(f"✗ Non-finite value {bad} was recorded")
+                    return False
+                except ValueError:
+                    pass
+            if service.measurement_store.count(experiment_id) != len(values):
+                print("✗ Rejected non-finite values were stored")
+                return False
+            print("✓ Non-finite measurement values rejected")
+            
+            reopened = ScientificService(os.path.join(tmp, "scientific"), chunk_records=500)
+            if reopened.get_measurements(experiment_id, limit=5)[-1]["measurement_id"] != ids[-1]:
+                print("✗ Head measurements lost on reopen")
+                return False
+            
+            # Torn chunk and head writes are cut on load, so later appends stay reachable
+            series_dir = next(root for root, _, files in os.walk(tmp) if "chunks.ffm" in files)
+            with open(os.path.join(series_dir, "chunks.ffm"), 'ab') as f:
+                f.write(b"FFMC" + b"\0" * 40)
+            with open(os.path.join(series_dir, "head.log"), 'a') as f:
+                f.write('[99999,1700000000')
+            torn = ScientificService(os.path.join(tmp, "scientific"), chunk_records=500)
+            more = torn.record_measurements(experiment_id, instrument_id, "absorbance", [1.0] * 600, "AU",
+                                            timestamps=[start + (len(values) + i) * 1000 for i in range(600)])
+            recovered = ScientificService(os.path.join(tmp, "scientific"), chunk_records=500)
+            if recovered.analyze_data(experiment_id=experiment_id)["count"] != len(values) + 600 \
+                    or recovered.get_measurements(experiment_id, limit=1)[-1]["measurement_id"] != more[-1]:
+                print("✗ Measurements appended after a torn tail were lost")
+                return False
+            print("✓ Torn chunk and head tails truncated on load")
+        
+        return True
+    except Exception as e:
+        print(f"✗ Measurement store test failed: {e}")
+        return False
+
+def test_graphql_batching():
+    """Test batched reference loading, keyset pages and full-text search resolvers"""
+    try:
+        from flashflow_cli.services.graphql_services import GraphQLServiceManager
+        from flashflow_cli.services.search_services import SQLiteSearchEngine
+        
+        with tempfile.TemporaryDirectory() as tmp:
+            manager = GraphQLServiceManager(f"sqlite:///{os.path.join(tmp, 'app.db')}",
+                                            search_engine=SQLiteSearchEngine({'db_path': ':memory:'}))
+            manager.generate_schema_from_models({
+                'Author': {'fields': {'name': {'type': 'string', 'required': True}}},
+                'Post': {'fields': {'title': {'type': 'string'}, 'body': {'type': 'string'},
+                                    'author': {'type': 'reference', 'model': 'Author'}}}
+            })
+            manager.create_tables()
+            
+            Author = manager.generated_types['Author']['sqlalchemy_model']
+            Post = manager.generated_types['Post']['sqlalchemy_model']
+            authors = [Author(name=f"Author {i}") for i in range(3)]
+            manager.session.add_all(authors)
+            manager.session.flush()
+            manager.session.add_all([Post(title=f"Post {i}", body="solar panels" if i % 5 == 0 else "wind",
+                                          author_id=authors[i % 3].id) for i in range(25)])
+            manager.session.commit()
+            manager.rebuild_search_index()
+            
+            response = manager.execute("{ pagePosts(first: 10) { items { title author { name } } nextCursor hasNextPage } }")
+            page = response['data']['pagePosts']
+            report = manager.get_request_reports()[-1]
+            if 'extensions' in response:
+                print("✗ Query report returned without include_report")
+                return False
+            if len(page['items']) != 10 or not page['hasNextPage'] or report['queries'] != 2:
+                print(f"✗ Expected 10 posts in 2 queries, got {len(page['items'])} in {report['queries']}")
+                return False
+            if page['items'][0]['author']['name'] != "Author 0":
+                print("✗ Reference resolved to the wrong row")
+                return False
+            print("✓ Authors of a page loaded with one batched query")
+            
+            debug = manager.execute("{ pagePosts(first: 2) { items { title } } }", include_report=True)
+            if debug['extensions']['report']['queries'] != manager.get_request_reports()[-1]['queries']:
+                print("✗ include_report did not return the recorded report")
+                return False
+            print("✓ Query report kept internally and returned only on request")
+            
+            titles = [item['title'] for item in page['items']]
+            cursor = page['nextCursor']
+            while cursor:
+                response = manager.execute("query($after: String) { pagePosts(first: 10, after: $after) { items { title } nextCursor } }",
+                                           {'after': cursor})
+                page = response['data']['pagePosts']
+                titles.extend(item['title'] for item in page['items'])
+                cursor = page['nextCursor']
+            if sorted(titles) != sorted(f"Post {i}" for i in range(25)):
+                print(f"✗ Keyset pages returned {len(titles)} posts")
+                return False
+            print("✓ Keyset pages cover every row once")
+            
+            response = manager.execute('{ searchPosts(query: "solar") { title } }')
+            found = sorted(item['title'] for item in response['data']['searchPosts'])
+            if found != sorted(f"Post {i}" for i in range(0, 25, 5)):
+                print(f"✗ Search returned {found}")
+                return False
+            print("✓ Search served by the full-text index")
+        
+        return True
+    except Exception as e:
+        print(f"✗ GraphQL batching test failed: {e}")
+        return False
+
+def test_media_pipeline():
+    """Test single-decode variant cascade on the media worker pool"""
+    try:
+        import io
+        from PIL import Image
+        from flashflow_cli.services.media_services import MediaManager
+        
+        with tempfile.TemporaryDirectory() as tmp:
+            manager = MediaManager({'storage': {'path': os.path.join(tmp, 'media')},
+                                    'processing': {'encode_workers': 2, 'optimize_original': False}})
+            
+            photo = io.BytesIO()
+            Image.new('RGB', (2400, 1600), (200, 80, 40)).save(photo, 'JPEG', quality=90)
+            media_file = manager.upload_media(photo.getvalue(), 'photo.jpg', 'image/jpeg')
+            if (media_file.width, media_file.height) != (2400, 1600):
+                print(f"✗ Dimensions not read at upload: {media_file.width}x{media_file.height}")
+                return False
+            if not manager.wait_for_processing(media_file.id, timeout=30):
+                print("✗ Variant processing did not finish")
+                return False
+            
+            sizes = {v['variant_type']: (v['width'], v['height']) for v in media_file.metadata['variants']}
+            expected = {'thumbnail': (150, 100), 'small': (300, 200), 'medium': (600, 400), 'large': (1200, 800)}
+            if sizes != expected or media_file.metadata['processing'] != 'done':
+                print(f"✗ Unexpected variants {sizes}")
+                return False
+            thumbnail = next(v['file_path'] for v in media_file.metadata['variants'] if v['variant_type'] == 'thumbnail')
+            with Image.open(thumbnail) as img:
+                if img.size != (150, 100):
+                    print(f"✗ Thumbnail on disk is {img.size}")
+                    return False
+            print("✓ JPEG variants built as a cascade off the request thread")
+            
+            # Optimizing the original keeps its full-size decode; the variants still get a reduced one
+            from PIL import JpegImagePlugin
+            drafted = []
+            draft = JpegImagePlugin.JpegImageFile.draft
+            
+            def recording_draft(img, mode, size):
+                result = draft(img, mode, size)
+                drafted.append(img.size)
+                return result
+            
+            JpegImagePlugin.JpegImageFile.draft = recording_draft
+            try:
+                optimizing = MediaManager({'storage': {'path': os.path.join(tmp, 'optimized')},
+                                           'processing': {'encode_workers': 1, 'optimize_original': True}})
+                optimized = optimizing.upload_media(photo.getvalue(), 'photo.jpg', 'image/jpeg')
+                optimizing.wait_for_processing(optimized.id, timeout=30)
+                optimizing.close()
+            finally:
+                JpegImagePlugin.JpegImageFile.draft = draft
+            with Image.open(optimized.file_path) as img:
+                original_size = img.size
+            variant_sizes = {v['variant_type']: (v['width'], v['height']) for v in optimized.metadata['variants']}
+            if original_size != (2400, 1600) or (1200, 800) not in drafted or variant_sizes != expected:
+                print(f"✗ Optimized original is {original_size}, drafts {drafted}, variants {variant_sizes}")
+                return False
+            print("✓ Optimized original kept full size with draft-decoded variants")
+            
+            # Transparent PNGs are flattened for JPEG variants instead of failing
+            logo = io.BytesIO()
+            Image.new('RGBA', (640, 320), (0, 0, 255, 128)).save(logo, 'PNG')
+            png_file = manager.upload_media(logo.getvalue(), 'logo.png', 'image/png')
+            manager.wait_for_processing()
+            variants = png_file.metadata['variants']
+            if len(variants) != 4 or max(v['width'] for v in variants) != 640:
+                print(f"✗ PNG variants wrong: {[(v['width'], v['height']) for v in variants]}")
+                return False
+            print("✓ Transparent PNG variants generated")
+            
+            if not manager.delete_media(media_file.id) or os.path.exists(thumbnail):
+                print("✗ Delete left variants behind")
+                return False
+            manager.close()
+        
+        return True
+    except Exception as e:
+        print(f"✗ Media pipeline test failed: {e}")
+        return False
+
+def test_ocr_batching():
+    """Test micro-batched OCR on pinned models over in-memory images"""
+    try:
+        import threading
+        from flashflow_cli.services.ocr_qr_service import ImageInput, MicroBatcher, OCRService
+        
+        states = []
+        batches = []
+        batcher = MicroBatcher(lambda state, items: batches.append(len(items)) or [(state, item * 2) for item in items],
+                               worker_state=lambda index: states.append(index) or f"model-{index}",
+                               workers=2, max_batch_size=8, max_latency_ms=50)
+        results = [None] * 16
+        
+        def call(i):
+            results[i] = batcher.map([i])[0]
+        
+        threads = [threading.Thread(target=call, args=(i,)) for i in range(16)]
+        for thread in threads:
+            thread.start()
+        for thread in threads:
+            thread.join()
+        batcher.close()
+        if [value for _, value in results] != [i * 2 for i in range(16)] or sorted(states) != [0, 1]:
+            print(f"✗ Batched results or worker models wrong: {results}, {states}")
+            return False
+        if len(batches) >= 16:
+            print(f"✗ Concurrent requests were not batched: {batches}")
+            return False
+        print(f"✓ 16 concurrent requests ran in {len(batches)} batches on 2 warm workers")
+        
+        class FakeReader:
+            def __init__(self):
+                self.calls = []
+            
+            def readtext_batched(self, images, batch_size=1, detail=1, paragraph=False):
+                self.calls.append(len(images))
+                return [[([[0, 0], [4, 0], [4, 4], [0, 4]], f"w{i}", 0.9)] for i in range(len(images))]
+            
+            def readtext(self, image, detail=1, paragraph=False):
+                self.calls.append(1)
+                return [([[0, 0], [4, 0], [4, 4], [0, 4]], "solo", 0.8)]
+        
+        ocr = OCRService()
+        reader = FakeReader()
+        ocr.provider_config['easyocr'] = {'reader': reader, 'detail': 1, 'paragraph': False}
+        ocr.active_provider = 'easyocr'
+        images = []
+        for shape in [(32, 64, 3)] * 3 + [(48, 48, 3)]:
+            image = ImageInput(data=b'not decoded in this test')
+            image._bgr = np.zeros(shape, dtype=np.uint8)
+            images.append(image)
+        extracted = ocr.extract_text_batch(images)
+        if sorted(reader.calls) != [1, 3] or [r['text'] for r in extracted] != ['w0', 'w1', 'w2', 'solo']:
+            print(f"✗ EasyOCR batching wrong: {reader.calls}, {[r['text'] for r in extracted]}")
+            return False
+        print("✓ Same-sized images share one readtext_batched call")
+        
+        reader.calls.clear()
+        corrupt = ImageInput(data=b'\x89PNG truncated')
+        valid = ImageInput(data=b'not decoded in this test')
+        valid._bgr = np.zeros((32, 64, 3), dtype=np.uint8)
+        extracted = ocr.extract_text_batch([corrupt, valid])
+        if extracted[0]['success'] or not extracted[1]['success'] or extracted[1]['text'] != 'solo':
+            print(f"✗ A corrupt image failed its neighbours: {extracted}")
+            return False
+        print("✓ A corrupt image fails alone, the valid one is still read")
+        
+        image = ImageInput(data=b'raw bytes')
+        path = image.file_path()
+        image.close()
+        if os.path.exists(path):
+            print("✗ Temporary file left behind")
+            return False
+        
+        return True
+    except Exception as e:
+        print(f"✗ OCR batching test failed: {e}")
+        return False
+
+def test_voice_pipeline():
+    """Test ring-buffered VAD segmentation and automaton-based command/intent matching"""
+    try:
+        import re
+        import math
+        import time
+        import array
+        from flashflow_cli.services.voice_search_service import (
+            AudioRingBuffer, PatternAutomaton, RealTimeVoiceProcessor, VoiceCommandRegistry, VoiceIntentClassifier
+        )
+        
+        classifier = VoiceIntentClassifier()
+        for text in ["Please find me a red phone", "how to reset", "refind it", "what can you do", "nothing here"]:
+            expected = next(((intent, pattern) for intent, patterns in classifier.intent_patterns.items()
+                             for pattern in patterns if re.search(pattern, text.lower().strip(), re.IGNORECASE)),
+                            ('unknown', None))
+            result = classifier.classify_intent(text)
+            if (result['intent'], result['pattern_matched']) != expected:
+                print(f"✗ Intent for '{text}' was {result['intent']}, expected {expected[0]}")
+                return False
+        entities = classifier.extract_entities("a blue laptop under 500 for $12.50")
+        if [(e['type'], e['value']) for e in entities] != [('product', 'laptop'), ('color', 'blue'), ('price', '12.50'),
+                                                           ('price', '500'), ('number', '500'), ('number', '12'), ('number', '50')]:
+            print(f"✗ Unexpected entities {entities}")
+            return False
+        
+        registry = VoiceCommandRegistry()
+        for i in range(1000):
+            registry.register_command(f"open_{i}", [f"open page {i} *"], "Open a page")
+        registry.register_command("search", ["search for *", "find *"], "Search")
+        match = registry.match_command("  Find my keys ")
+        if not match or match['command'] != 'search' or match['matches'] != ('my keys',):
+            print(f"✗ Command match failed: {match}")
+            return False
+        if registry.match_command("open page 42 settings")['command'] != 'open_42' or registry.match_command("refind it"):
+            print("✗ Anchored command matching wrong")
+            return False
+        print("✓ Intents, entities and commands match through one automaton")
+        
+        automaton = PatternAutomaton()
+        automaton.add(r"\bin\b")
+        automaton.add("kelvin")
+        for text, expected in [("İn", 0), ("In stock", 0), ("ın", 0), ("\u212aelvin", 1), ("ink", None)]:
+            found = automaton.first(text)
+            matched = next((index for index, pattern in enumerate(automaton.patterns) if pattern.search(text)), None)
+            if (found[0] if found else None) != expected or matched != expected:
+                print(f"✗ Automaton disagrees with re.IGNORECASE on {text!r}: {found}, expected {expected}")
+                return False
+        print("✓ Case folding matches re.IGNORECASE, including 'İ' and the Kelvin sign")
+        
+        ring = AudioRingBuffer(10)
+        ring.write(b'12345678')
+        ring.read(5)
+        if ring.write(b'abcdefgh') != 7 or ring.overruns != 1 or ring.read(10) != b'678abcdefg':
+            print("✗ Ring buffer wrapped incorrectly")
+            return False
+        
+        def tone(ms, amplitude):
+            count = 16000 * ms // 1000
+            return array.array('h', (int(amplitude * math.sin(2 * math.pi * 440 * i / 16000)) for i in range(count))).tobytes()
+        
+        class CountingStream:
+            def __init__(self, sample_rate):
+                self.sample_rate = sample_rate
+                self.received = 0
+            
+            def accept(self, pcm):
+                self.received += len(pcm)
+            
+            def finish(self):
+                return {'success': True, 'text': str(self.received), 'sample_rate': self.sample_rate}
+        
+        events = []
+        processor = RealTimeVoiceProcessor({'silence_duration': 0.3, 'pre_roll_ms': 0})
+        processor.start_processing(events.append, CountingStream)
+        for chunk in [tone(600, 0), tone(900, 3000), tone(1200, 0), tone(600, 3000)]:
+            processor.feed(chunk)
+            time.sleep(0.05)
+        time.sleep(0.3)
+        processor.stop_processing()
+        finals = [int(e['text']) for e in events if e['status'] == 'final']
+        # Only speech (plus up to the 300 ms hangover) reaches the recognizer, never the leading silence
+        rates = {e['sample_rate'] for e in events if e['status'] == 'final'}
+        if len(finals) != 2 or not all(0 < audio <= 32000 * 1.3 for audio in finals) or rates != {16000}:
+            print(f"✗ Unexpected utterances {finals} at sample rates {rates}")
+            return False
+        print(f"✓ VAD forwarded {len(finals)} utterances ({sum(finals)} of {32000 * 3.3:.0f} bytes) to the recognizer")
+        
+        return True
+    except Exception as e:
+        print(f"✗ Voice pipeline test failed: {e}")
+        return False
+
+def test_build_scheduler():
+    """Test task ordering, failure propagation, batched unchanged-file skipping and flow-shaped model fields"""
+    try:
+        import threading
+        from pathlib import Path
+        from types import SimpleNamespace
+        from flashflow_cli.generators.base import WriteBatch, normalize_fields, write_if_changed
+        from flashflow_cli.generators.scheduler import BuildError, BuildScheduler
+        
+        order = []
+        lock = threading.Lock()
+        
+        def step(name, fail=False):
+            def run():
+                with lock:
+                    order.append(name)
+                if fail:
+                    raise RuntimeError(f"{name} broke")
+            return run
+        
+        scheduler = BuildScheduler(jobs=4)
+        scheduler.add_task("setup", step("setup"))
+        for i in range(6):
+            scheduler.add_task(f"page:{i}", step(f"page:{i}"), deps=("setup",))
+        scheduler.add_task("routes", step("routes"), deps=tuple(f"page:{i}" for i in range(6)))
+        scheduler.run()
+        if order[0] != "setup" or order[-1] != "routes" or sorted(order[1:-1]) != [f"page:{i}" for i in range(6)]:
+            print(f"✗ Tasks ran out of dependency order: {order}")
+            return False
+        print("✓ Tasks start only after their dependencies")
+        
+        order.clear()
+        scheduler = BuildScheduler(jobs=2)
+        scheduler.add_task("setup", step("setup"))
+        scheduler.add_task("model:a", step("model:a", fail=True), deps=("setup",))
+        scheduler.add_task("controller:a", step("controller:a"), deps=("model:a",))
+        scheduler.add_task("routes", step("routes"), deps=("controller:a",))
+        scheduler.add_task("model:b", step("model:b"), deps=("setup",))
+        try:
+            scheduler.run()
+            print("✗ A failed task did not fail the build")
+            return False
+        except BuildError as e:
+            failures = [result.name for result in e.failures]
+        statuses = {name: result.status for name, result in scheduler.results.items()}
+        if failures != ["model:a"] or statuses["controller:a"] != "skipped" or statuses["routes"] != "skipped" \
+                or statuses["model:b"] != "ok" or "controller:a" in order:
+            print(f"✗ Failure not propagated to dependents only: {statuses}")
+            return False
+        print("✓ Dependents of a failed task are skipped, independent tasks still run")
+        
+        with tempfile.TemporaryDirectory() as tmp:
+            outputs = {Path(tmp, "out", f"file{i}.txt"): f"content {i}" for i in range(5)}
+            
+            def build(contents):
+                scheduler = BuildScheduler(jobs=2)
+                for path, content in contents.items():
+                    scheduler.add_task(path.name, lambda path=path, content=content: write_if_changed(path, content))
+                scheduler.run()
+                return scheduler.write_stats
+            
+            first = build(outputs)
+            mtimes = {path: path.stat().st_mtime_ns for path in outputs}
+            second = build(outputs)
+            changed = dict(outputs)
+            changed[Path(tmp, "out", "file0.txt")] = "edited"
+            third = build(changed)
+            untouched = all(path.stat().st_mtime_ns == mtimes[path] for path in outputs if path.name != "file0.txt")
+            if first != (5, 0) or second != (0, 5) or third != (1, 4) or not untouched or WriteBatch._active is not None:
+                print(f"✗ Batched writes not skipping unchanged files: {first}, {second}, {third}")
+                return False
+            print("✓ Batched writes skip unchanged files and keep their mtimes")
+            
+            fields = normalize_fields({'title': {'type': 'string', 'required': True}, 'done': 'boolean', 'notes': None})
+            if fields != [{'name': 'title', 'type': 'string', 'required': True}, {'name': 'done', 'type': 'boolean'},
+                          {'name': 'notes'}] or normalize_fields(['email']) != [{'name': 'email'}]:
+                print(f"✗ Field shapes not normalized: {fields}")
+                return False
+            
+            from flashflow_cli.generators.backend_fixed import BackendGenerator
+            backend = BackendGenerator(SimpleNamespace(dist_path=Path(tmp)), None)
+            backend._generate_single_model('Todo', {'fields': {'title': {'type': 'string'}, 'done': 'boolean'}})
+            model = backend._model_outputs('Todo')[0].read_text(encoding='utf-8')
+            if "'title'," not in model or "'done' => 'boolean'" not in model:
+                print("✗ Backend model ignored mapping-shaped fields")
+                return False
+            print("✓ Backend models generated from the parser's field mapping")
+        
+        return True
+    except Exception as e:
+        print(f"✗ Build scheduler test failed: {e}")
+        return False
+
+def test_tracing():
+    """Test scoped spans, per-thread buffers, the disabled no-op path and Chrome/OTLP export"""
+    try:
+        import json
+        import tempfile
+        import threading
+        from flashflow_cli.services import tracing
+        from flashflow_cli.generators.scheduler import BuildScheduler
+        
+        tracing.disable()
+        tracing.clear()
+        with tracing.span("ignored") as ignored:
+            ignored.set(value=1)
+        if tracing.span("ignored") is not tracing.span("other") or tracing.collect():
+            print("✗ Disabled tracing recorded spans")
+            return False
+        
+        @tracing.traced(cat="test")
+        def work(n):
+            with tracing.span("inner", cat="test", n=n):
+                return n * 2
+        
+        tracing.enable()
+        try:
+            with tracing.span("outer", cat="test") as outer:
+                work(1)
+                outer.set(done=True)
+            threads = [threading.Thread(target=work, args=(i,), name=f"tracer-{i}") for i in range(4)]
+            for thread in threads:
+                thread.start()
+            for thread in threads:
+                thread.join()
+            try:
+                with tracing.span("failing", cat="test"):
+                    raise ValueError("boom")
+            except ValueError:
+                pass
+            
+            scheduler = BuildScheduler(jobs=2)
+            scheduler.add_task("gen:a", lambda: None, category="frontend")
+            scheduler.add_task("gen:b", lambda: None, deps=("gen:a",), category="frontend")
+            scheduler.run()
+        finally:
+            tracing.disable()
+        
+        spans = tracing.collect()
+        by_id = {item["span_id"]: item for item in spans}
+        outer_span = next(item for item in spans if item["name"] == "outer")
+        children = [item for item in spans if item["parent_id"] == outer_span["span_id"]]
+        nested = all(by_id[item["parent_id"]]["name"] == "test_tracing.<locals>.work"
+                     for item in spans if item["name"] == "inner")
+        if [item["name"] for item in children] != ["test_tracing.<locals>.work"] or not nested \
+                or not outer_span["args"].get("done"):
+            print(f"✗ Unexpected span nesting {[(item['name'], item['parent_id']) for item in spans]}")
+            return False
+        print(f"✓ Recorded {len(spans)} nested spans")
+        
+        threads_seen = {item["thread"] for item in spans if item["name"] == "inner"}
+        if len([name for name in threads_seen if name.startswith("tracer-")]) != 4:
+            print(f"✗ Spans missing per-thread buffers: {threads_seen}")
+            return False
+        failing = next(item for item in spans if item["name"] == "failing")
+        if "ValueError" not in failing["args"].get("error", ""):
+            print("✗ Failed span did not record its error")
+            return False
+        if not {"gen:a", "gen:b", "write:flush"} <= {item["name"] for item in spans}:
+            print("✗ Build scheduler tasks missing from the trace")
+            return False
+        print(f"✓ Spans from {tracing.stats()['threads']} threads, errors and build tasks in one timeline")
+        
+        with tempfile.TemporaryDirectory() as tmp:
+            tracing.export(f"{tmp}/trace.json")
+            tracing.export(f"{tmp}/trace.otlp.json")
+            with open(f"{tmp}/trace.json", encoding='utf-8') as f:
+                chrome = json.load(f)
+            with open(f"{tmp}/trace.otlp.json", encoding='utf-8') as f:
+                otlp = json.load(f)
+        
+        complete = [event for event in chrome["traceEvents"] if event["ph"] == "X"]
+        otlp_spans = [item for scope in otlp["resourceSpans"][0]["scopeSpans"] for item in scope["spans"]]
+        parents = {item["spanId"] for item in otlp_spans}
+        if len(complete) != len(spans) or len(otlp_spans) != len(spans) \
+                or not all(item.get("parentSpanId", next(iter(parents))) in parents for item in otlp_spans):
+            print("✗ Exported traces do not match the recorded spans")
+            return False
+        print(f"✓ Exported {len(complete)} Chrome trace events and {len(otlp_spans)} OTLP spans")
+        
+        tracing.clear()
+        return True
+    except Exception as e:
+        print(f"✗ Tracing test failed: {e}")
+        return False
+
+def test_flow_loader():
+    """Test the single-pass .flow loader: comment stripping, empty files and error locations"""
+    try:
+        from core.parser.flow_loader import load_flow, FlowParseError, backend
+        from core.parser.parser import FlowParser
+        
+        content = '# Home page\npage:\n  # Shown in the tab\n  title: Home\n  path: "/"  # root\n'
+        expected = {'page': {'title': 'Home', 'path': '/'}}
+        if load_flow(content) != expected or FlowParser().parse_content(content) != expected:
+            print(f"✗ Parsed {load_flow(content)} with the {backend()} backend")
+            return False
+        if load_flow("") != {} or load_flow("# nothing here\n") != {}:
+            print("✗ Empty .flow content did not parse to {}")
+            return False
+        print(f"✓ Comments stripped and tree built with the {backend()} backend")
+        
+        try:
+            load_flow("# one\n# two\npage:\n  title: a: b\n", "broken.flow")
+            print("✗ Invalid .flow content was accepted")
+            return False
+        except FlowParseError as e:
+            if not isinstance(e, ValueError) or (e.path, e.line) != ("broken.flow", 4) or not e.column:
+                print(f"✗ Error reported at {e.path}:{e.line}:{e.column}")
+                return False
+        print("✓ Parse errors point at the source line behind stripped comments")
+        
+        return True
+    except Exception as e:
+        print(f"✗ Flow loader test failed: {e}")
+        return False
+
+def test_ir_build_cache():
+    """Test the JSON IR build cache: hits across processes, invalidation on edit and unreadable caches"""
+    try:
+        import tempfile
+        from pathlib import Path
+        from core.parser.parser import FlowParser
+        from core.parser.build_cache import IRBuildCache
+        
+        with tempfile.TemporaryDirectory() as tmp:
+            project = Path(tmp)
+            flows = project / "src" / "flows"
+            flows.mkdir(parents=True)
+            (flows / "models.flow").write_text("model:\n  name: Todo\n  fields:\n    title: string\n", encoding='utf-8')
+            (flows / "home.flow").write_text('page:\n  title: "Home"\n  path: "/"\n', encoding='utf-8')
+            
+            def build():
+                cache = IRBuildCache(project)
+                ir = FlowParser().parse_project(project, cache)
+                return cache, ir
+            
+            cache, ir = build()
+            if sorted(cache.changed_files) != ["src/flows/home.flow", "src/flows/models.flow"] \
+                    or not cache.cache_path.name.endswith(".json"):
+                print(f"✗ First build parsed {cache.changed_files} into {cache.cache_path}")
+                return False
+            models = ir.models
+            
+            cache, ir = build()
+            if cache.changed_files or ir.models != models or set(cache.fragments) != {"src/flows/home.flow",
+                                                                                     "src/flows/models.flow"}:
+                print(f"✗ Cache miss on unchanged files: {cache.changed_files}")
+                return False
+            print("✓ A fresh process reuses every fragment from the JSON cache")
+            
+            (flows / "models.flow").write_text("model:\n  name: Todo\n  fields:\n    title: string\n    done: boolean\n",
+                                               encoding='utf-8')
+            cache, ir = build()
+            if cache.changed_files != ["src/flows/models.flow"] or 'models' not in cache.dirty_sections \
+                    or ir.models == models:
+                print(f"✗ Edit not picked up: {cache.changed_files}, {cache.dirty_sections}")
+                return False
+            print("✓ Only the edited file is reparsed")
+            
+            for garbage in ("{not json", '{"version": 2, "fragments": {"x": 1}}', "[]"):
+                cache.cache_path.write_text(garbage, encoding='utf-8')
+                cache, ir = build()
+                if len(cache.changed_files) != 2 or ir.models == {}:
+                    print(f"✗ Unreadable cache {garbage!r} was not treated as a miss: {cache.changed_files}")
+                    return False
+            print("✓ Corrupt or malformed cache files rebuild from source")
+        
+        return True
+    except Exception as e:
+        print(f"✗ IR build cache test failed: {e}")
+        return False
+
+def test_dirty_ir():
+    """Test IR change tracking and that the backend only regenerates dirty models"""
+    try:
+        import tempfile
+        from pathlib import Path
+        from types import SimpleNamespace
+        from core.framework import FlashFlowIR
+        from flashflow_cli.generators.backend_fixed import BackendGenerator
+        
+        ir = FlashFlowIR()
+        ir.add_model('Todo', {'fields': {'title': 'string'}})
+        ir.add_model('Note', {'fields': {'body': 'text'}})
+        if ir.changed('models') != {'Todo', 'Note'}:
+            print(f"✗ New models not tracked: {ir.changed('models')}")
+            return False
+        ir.clear_changes()
+        ir.add_model('Note', {'fields': {'body': 'text'}})
+        ir.add_model('Todo', {'fields': {'title': 'string', 'done': 'boolean'}})
+        if ir.changed('models') != {'Todo'} or ir.is_dirty('models', 'Note'):
+            print(f"✗ Re-adding an identical model marked it dirty: {ir.changed('models')}")
+            return False
+        
+        previous = dict(ir.models, Gone={'fields': {}})
+        ir.clear_changes()
+        ir.record_changes('models', previous)
+        if ir.changed('models') or ir.removed('models') != {'Gone'}:
+            print(f"✗ Diff against the previous section gave {ir.changed('models')}, {ir.removed('models')}")
+            return False
+        print("✓ Only changed and removed models are tracked")
+        
+        with tempfile.TemporaryDirectory() as tmp:
+            backend = BackendGenerator(SimpleNamespace(dist_path=Path(tmp)), ir)
+            backend._create_directory_structure()
+            for name in ('Todo', 'Note', 'Gone'):
+                for output in backend._model_outputs(name):
+                    output.write_text("<?php\n", encoding='utf-8')
+            
+            names = [task.name for task in backend.tasks()]
+            if names != ["backend:setup", "backend:shared"]:
+                print(f"✗ Clean models were regenerated: {names}")
+                return False
+            backend._generate_setup()
+            if any(output.exists() for output in backend._model_outputs('Gone')):
+                print("✗ Outputs of a removed model were left behind")
+                return False
+            
+            ir.add_model('Note', {'fields': {'body': 'text', 'pinned': 'boolean'}})
+            backend._model_outputs('Todo')[1].unlink()
+            names = [task.name for task in backend.tasks()]
+            if names[2:] != ["backend:model:Todo", "backend:model:Note"]:
+                print(f"✗ Expected tasks for the dirty and the missing model, got {names}")
+                return False
+            
+            ir.clear_changes()
+            ir.mark_all_changed()
+            if ir.changed('models') != {'Todo', 'Note'}:
+                print(f"✗ mark_all_changed left {ir.changed('models')}")
+                return False
+            print("✓ Backend regenerates only dirty models and drops removed ones")
+        
+        return True
+    except Exception as e:
+        print(f"✗ Dirty IR test failed: {e}")
+        return False
+
+def test_flow_cache():
+    """Test the renderer's flow and page-tree cache: mtime revalidation and watcher invalidation"""
+    try:
+        import tempfile
+        from pathlib import Path
+        sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)),
+                                        "python-services", "flet-direct-renderer"))
+        from flow_cache import FlowCache
+        
+        class Page:
+            pass
+        
+        with tempfile.TemporaryDirectory() as tmp:
+            flow_file = Path(tmp) / "home.flow"
+            flow_file.write_text('page:\n  title: "Home"\n', encoding='utf-8')
+            cache = FlowCache()
+            page = Page()
+            
+            first = cache.flow(flow_file)
+            if cache.flow(flow_file) is not first or (cache.hits, cache.misses) != (1, 1):
+                print(f"✗ Unchanged flow was reparsed: {cache.stats()}")
+                return False
+            cache.store_tree(page, "/", "web", flow_file, "tree")
+            if cache.tree(page, "/", "web") != "tree" or cache.tree(Page(), "/", "web") is not None:
+                print("✗ Built tree not cached per page")
+                return False
+            print("✓ Parsed flows and page trees served from memory")
+            
+            flow_file.write_text('page:\n  title: "Welcome"\n', encoding='utf-8')
+            if cache.tree(page, "/", "web") is not None or cache.flow(flow_file)['page']['title'] != "Welcome":
+                print("✗ Edited flow served from a stale cache entry")
+                return False
+            
+            cache.watching = True
+            cache.store_tree(page, "/", "web", flow_file, "tree")
+            flow_file.write_text('page:\n  title: "Hello"\n', encoding='utf-8')
+            if cache.flow(flow_file)['page']['title'] != "Welcome":
+                print("✗ Watched cache entries revalidated against the disk")
+                return False
+            cache.invalidate(flow_file)
+            if cache.tree(page, "/", "web") is not None or cache.flow(flow_file)['page']['title'] != "Hello":
+                print("✗ Invalidation left the flow or its tree cached")
+                return False
+            print("✓ Edits invalidate by mtime, or by watcher events while watching")
+        
+        return True
+    except Exception as e:
+        print(f"✗ Flow cache test failed: {e}")
+        return False
+
+def test_backend_client():
+    """Test per-endpoint limits, write invalidation, copied cache entries and GET coalescing"""
+    try:
+        import json
+        import time
+        import threading
+        from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+        sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)),
+                                        "python-services", "flet-direct-renderer"))
+        from api_client import BackendClient
+        
+        state = {'active': {}, 'peak': {}, 'hits': {}, 'version': 0}
+        lock = threading.Lock()
+        gates = {'/slow': threading.Event(), '/item': threading.Event()}
+        
+        class Handler(BaseHTTPRequestHandler):
+            def log_message(self, *args):
+                pass
+            
+            def _reply(self, body):
+                payload = json.dumps(body).encode()
+                self.send_response(200)
+                self.send_header('Content-Type', 'application/json')
+                self.send_header('Content-Length', str(len(payload)))
+                self.end_headers()
+                self.wfile.write(payload)
+            
+            def do_GET(self):
+                path = self.path.split('?')[0]
+                with lock:
+                    version = state['version']
+                    state['hits'][path] = state['hits'].get(path, 0) + 1
+                    state['active'][path] = state['active'].get(path, 0) + 1
+                    state['peak'][path] = max(state['peak'].get(path, 0), state['active'][path])
+                if path in gates:
+                    gates[path].wait(5)
+                with lock:
+                    state['active'][path] -= 1
+                self._reply({'version': version, 'tags': ['a']})
+            
+            def do_POST(self):
+                self.rfile.read(int(self.headers.get('Content-Length', 0)))
+                with lock:
+                    state['version'] += 1
+                self._reply({'ok': True})
+        
+        server = ThreadingHTTPServer(('127.0.0.1', 0), Handler)
+        threading.Thread(target=server.serve_forever, daemon=True).start()
+        client = BackendClient(f"http://127.0.0.1:{server.server_port}/", pool_size=4, endpoint_limit=2,
+                               cache_ttl=30)
+        try:
+            slow = [client.submit('GET', f'/slow?n={i}') for i in range(6)]
+            time.sleep(0.2)
+            fast = client.submit('GET', '/fast').result(2)  # Times out if the queued /slow calls hold every worker
+            gates['/slow'].set()
+            if [future.result(5)['version'] for future in slow] != [0] * 6 or fast.get('version') != 0:
+                print(f"✗ Requests failed: {fast}")
+                return False
+            if state['peak']['/slow'] != 2:
+                print(f"✗ Expected at most 2 concurrent /slow requests, saw {state['peak']['/slow']}")
+                return False
+            print("✓ Endpoint limit holds while other endpoints keep their workers")
+            
+            pending = client.submit('GET', '/item')
+            time.sleep(0.2)
+            client.request('POST', '/item', {'done': True})
+            gates['/item'].set()
+            stale = pending.result(5)
+            fresh = client.request('GET', '/item')
+            if stale['version'] != 0 or fresh['version'] != 1 or state['hits']['/item'] != 2:
+                print(f"✗ A GET finishing after a write was cached: {stale}, {fresh}")
+                return False
+            print("✓ A read that raced a write is not cached")
+            
+            fresh['tags'].append('mutated')
+            again = client.request('GET', '/item')
+            if again['tags'] != ['a'] or state['hits']['/item'] != 2:
+                print(f"✗ Cache handed out a shared object: {again}")
+                return False
+            print("✓ Cache hits are private copies")
+            
+            client.clear_cache()
+            gates['/item'].clear()
+            results = [None] * 8
+            
+            def read(i):
+                results[i] = client.request('GET', '/item')
+            
+            threads = [threading.Thread(target=read, args=(i,)) for i in range(8)]
+            for thread in threads:
+                thread.start()
+            time.sleep(0.2)
+            gates['/item'].set()
+            for thread in threads:
+                thread.join()
+            if state['hits']['/item'] != 3 or len({id(result) for result in results}) != 8 \
+                    or any(result != results[0] for result in results):
+                print(f"✗ Concurrent GETs not coalesced into one request: {state['hits']['/item'] - 2} sent")
+                return False
+            print("✓ 8 concurrent identical GETs sent once, each caller with its own copy")
+        finally:
+            for gate in gates.values():
+                gate.set()
+            client.close()
+            server.shutdown()
+            server.server_close()
+        
+        return True
+    except Exception as e:
+        print(f"✗ Backend client test failed: {e}")
+        return False
+
 def main():
     """Main test function"""
     print("========================================")
@@ -99,8 +1882,36 @@ def main():
     tests = [
         ("Import Test", test_flashcore_import),
         ("Vector Search Test", test_vector_search),
+        ("Vector Metric Test", test_vector_metrics),
+        ("Vector Batch Test", test_vector_batch),
+        ("Vector Growth/Delete Test", test_vector_growth_and_delete),
+        ("Vector Persistence Test", test_vector_persistence),
+        ("Vector Filter Test", test_vector_filter),
+        ("Vector Quantization Test", test_vector_quantization),
         ("Inference Engine Test", test_inference_engine),
-        ("Encryption Test", test_encryption)
+        ("Inference Batching Test", test_inference_batching),
+        ("Encryption Test", test_encryption),
+        ("Streaming Encryption Test", test_streaming_encryption),
+        ("Analytics Ingestion Test", test_analytics_ingestion),
+        ("Telemetry Store Test", test_telemetry_store),
+        ("Rate Limiter Test", test_rate_limiter),
+        ("Shared Rate Limiter Test", test_shared_rate_limiter),
+        ("SQLite Search Test", test_sqlite_search),
+        ("Hybrid Search Test", test_hybrid_search),
+        ("Cron Scheduler Test", test_cron_scheduler),
+        ("Federated Aggregation Test", test_federated_aggregation),
+        ("Measurement Store Test", test_measurement_store),
+        ("GraphQL Batching Test", test_graphql_batching),
+        ("Media Pipeline Test", test_media_pipeline),
+        ("OCR Batching Test", test_ocr_batching),
+        ("Voice Pipeline Test", test_voice_pipeline),
+        ("Build Scheduler Test", test_build_scheduler),
+        ("Tracing Test", test_tracing),
+        ("Flow Loader Test", test_flow_loader),
+        ("IR Build Cache Test", test_ir_build_cache),
+        ("Dirty IR Test", test_dirty_ir),
+        ("Flow Cache Test", test_flow_cache),
+        ("Backend Client Test", test_backend_client)
     ]
     
     passed = 0